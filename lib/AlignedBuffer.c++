@@ -0,0 +1,95 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/AlignedBuffer.h++"
+#include "commonc++/System.h++"
+
+#ifdef CCXX_OS_WINDOWS
+#include <malloc.h>
+#endif
+
+#include <cstdlib>
+#include <new>
+
+namespace ccxx {
+
+/*
+ */
+
+AlignedBuffer::AlignedBuffer(size_t size, size_t alignment /* = 0 */)
+  : _data(NULL),
+    _size(0),
+    _alignment(alignment ? alignment : System::getPageSize())
+{
+  _size = static_cast<size_t>(alignUp(size ? size : 1, _alignment));
+
+#if defined(CCXX_OS_WINDOWS)
+
+  _data = static_cast<byte_t *>(::_aligned_malloc(_size, _alignment));
+  if(_data == NULL)
+    throw std::bad_alloc();
+
+#elif defined(HAVE_POSIX_MEMALIGN)
+
+  void *p = NULL;
+  if(::posix_memalign(&p, _alignment, _size) != 0)
+    throw std::bad_alloc();
+
+  _data = static_cast<byte_t *>(p);
+
+#else
+
+  // over-allocate, and store the original pointer just before the aligned
+  // block
+
+  byte_t *p = static_cast<byte_t *>(std::malloc(_size + _alignment
+                                                + sizeof(void *)));
+  if(p == NULL)
+    throw std::bad_alloc();
+
+  _data = reinterpret_cast<byte_t *>(
+    alignUp(reinterpret_cast<uintptr_t>(p + sizeof(void *)), _alignment));
+  reinterpret_cast<void **>(_data)[-1] = p;
+
+#endif
+}
+
+/*
+ */
+
+AlignedBuffer::~AlignedBuffer()
+{
+#if defined(CCXX_OS_WINDOWS)
+  ::_aligned_free(_data);
+#elif defined(HAVE_POSIX_MEMALIGN)
+  std::free(_data);
+#else
+  std::free(reinterpret_cast<void **>(_data)[-1]);
+#endif
+}
+
+
+} // namespace ccxx
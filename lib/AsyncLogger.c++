@@ -0,0 +1,842 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/AsyncLogger.h++"
+#include "commonc++/BinaryLogCodec.h++"
+#include "commonc++/File.h++"
+#include "commonc++/ScopedLock.h++"
+#include "commonc++/System.h++"
+#include "commonc++/ThreadLocal.h++"
+
+#include <algorithm>
+#include <cstring>
+#include <list>
+
+namespace ccxx {
+
+/*
+ */
+
+const size_t AsyncLogger::DEFAULT_BUFFER_SIZE = 65536;
+
+const timespan_ms_t AsyncLogger::FLUSH_INTERVAL = 100;
+
+/*
+ * A single-producer, single-consumer ring of length-prefixed records. The
+ * owning thread is the only producer; the consumer is whichever thread
+ * holds the drain lock. Positions increase monotonically and wrap modulo
+ * 2^32, so the capacity must be a power of 2. The top bit of a length
+ * prefix marks a binary record. The producer keeps private copies of the
+ * positions, and only rereads the consumer's position when the ring looks
+ * full, so that enqueuing a record costs a single atomic store.
+ */
+
+class AsyncLogger::Ring
+{
+ public:
+
+  Ring(size_t capacity)
+    : scratch(static_cast<uint_t>(Logger::LOG_BUFFER_SIZE)),
+      _data(new char[capacity]),
+      _capacity(static_cast<uint32_t>(capacity)),
+      _producerHead(0),
+      _producerTail(0),
+      _refs(2) // one for the owning thread, one for the logger
+  { }
+
+  ~Ring()
+  { delete[] _data; }
+
+  bool put(const char* data, uint32_t len, bool binary);
+  uint32_t peek(uint32_t pos, bool& binary) const;
+
+  inline void read(uint32_t pos, char* dst, uint32_t len) const
+  { _copyOut(pos + PREFIX_SIZE, dst, len); }
+
+  inline uint32_t getHead() const
+  { return(static_cast<uint32_t>(_head.get())); }
+
+  inline uint32_t getTail() const
+  { return(static_cast<uint32_t>(_tail.get())); }
+
+  inline void setHead(uint32_t head)
+  { _head.set(static_cast<int32_t>(head)); }
+
+  inline uint32_t getUsed() const
+  { return(static_cast<uint32_t>(_tail.get())
+           - static_cast<uint32_t>(_head.get())); }
+
+  bool isFilling();
+
+  inline bool isEmpty() const
+  { return(getUsed() == 0); }
+
+  inline bool isOrphaned() const
+  { return(_refs.get() == 1); }
+
+  inline void release()
+  {
+    if(--_refs == 0)
+      delete this;
+  }
+
+  CharBuffer scratch;
+
+  static const uint32_t PREFIX_SIZE = sizeof(uint32_t);
+  static const uint32_t BINARY_FLAG = 0x80000000;
+
+ private:
+
+  void _copyIn(uint32_t pos, const char* src, uint32_t len);
+  void _copyOut(uint32_t pos, char* dst, uint32_t len) const;
+
+  char* _data;
+  uint32_t _capacity;
+  uint32_t _producerHead;
+  uint32_t _producerTail;
+  AtomicCounter _head;
+  AtomicCounter _tail;
+  AtomicCounter _refs;
+};
+
+/*
+ */
+
+void AsyncLogger::Ring::_copyIn(uint32_t pos, const char* src, uint32_t len)
+{
+  uint32_t off = pos & (_capacity - 1);
+  uint32_t len1 = std::min(len, _capacity - off);
+
+  std::memcpy(_data + off, src, len1);
+  if(len1 < len)
+    std::memcpy(_data, src + len1, len - len1);
+}
+
+/*
+ */
+
+void AsyncLogger::Ring::_copyOut(uint32_t pos, char* dst, uint32_t len) const
+{
+  uint32_t off = pos & (_capacity - 1);
+  uint32_t len1 = std::min(len, _capacity - off);
+
+  std::memcpy(dst, _data + off, len1);
+  if(len1 < len)
+    std::memcpy(dst + len1, _data, len - len1);
+}
+
+/*
+ */
+
+bool AsyncLogger::Ring::put(const char* data, uint32_t len, bool binary)
+{
+  uint32_t tail = _producerTail;
+  uint32_t need = PREFIX_SIZE + len;
+
+  if(_capacity - (tail - _producerHead) < need)
+  {
+    _producerHead = static_cast<uint32_t>(_head.get());
+
+    if(_capacity - (tail - _producerHead) < need)
+      return(false);
+  }
+
+  uint32_t prefix = binary ? (len | BINARY_FLAG) : len;
+
+  _copyIn(tail, reinterpret_cast<const char *>(&prefix), PREFIX_SIZE);
+  _copyIn(tail + PREFIX_SIZE, data, len);
+
+  // publish the record
+  _producerTail = tail + need;
+  _tail.set(static_cast<int32_t>(_producerTail));
+
+  return(true);
+}
+
+/*
+ */
+
+bool AsyncLogger::Ring::isFilling()
+{
+  uint32_t half = _capacity / 2;
+
+  if((_producerTail - _producerHead) <= half)
+    return(false);
+
+  _producerHead = static_cast<uint32_t>(_head.get());
+
+  return((_producerTail - _producerHead) > half);
+}
+
+/*
+ */
+
+uint32_t AsyncLogger::Ring::peek(uint32_t pos, bool& binary) const
+{
+  uint32_t prefix;
+  _copyOut(pos, reinterpret_cast<char *>(&prefix), PREFIX_SIZE);
+
+  binary = ((prefix & BINARY_FLAG) != 0);
+
+  return(prefix & ~BINARY_FLAG);
+}
+
+/*
+ */
+
+class AsyncLogger::RingList : public std::list<Ring *>
+{
+};
+
+/*
+ * The per-thread reference to a ring. It is destroyed when the thread
+ * exits, leaving the ring to be drained and released by the writer.
+ */
+
+class AsyncLogger::RingHandle
+{
+ public:
+
+  RingHandle(Ring* ring)
+    : ring(ring)
+  { }
+
+  ~RingHandle()
+  { ring->release(); }
+
+  Ring* ring;
+};
+
+/*
+ */
+
+class AsyncLogger::RingSlot : public ThreadLocal<RingHandle>
+{
+};
+
+/*
+ */
+
+static size_t __ringSize(size_t bufferSize)
+{
+  // a ring must hold at least a few maximum-length records
+
+  size_t size = 4 * Logger::LOG_BUFFER_SIZE;
+  while(size < bufferSize)
+    size <<= 1;
+
+  return(size);
+}
+
+/*
+ */
+
+static uint32_t __formatDropNotice(char* buf, int32_t count)
+{
+  // formatted by hand, since this may run in a signal handler, where
+  // snprintf() is not safe
+
+  static const char prefix[] = "*** ";
+  static const char suffix[] = " log record(s) dropped ***";
+
+  char digits[12];
+  uint32_t ndigits = 0;
+  uint32_t value = static_cast<uint32_t>(count);
+
+  do
+  {
+    digits[ndigits++] = static_cast<char>('0' + (value % 10));
+    value /= 10;
+  }
+  while(value > 0);
+
+  char *p = buf;
+
+  std::memcpy(p, prefix, sizeof(prefix) - 1);
+  p += sizeof(prefix) - 1;
+
+  while(ndigits > 0)
+    *p++ = digits[--ndigits];
+
+  std::memcpy(p, suffix, sizeof(suffix) - 1);
+  p += sizeof(suffix) - 1;
+
+  size_t eolLen = std::strlen(File::eol);
+  std::memcpy(p, File::eol, eolLen);
+  p += eolLen;
+
+  return(static_cast<uint32_t>(p - buf));
+}
+
+/*
+ */
+
+static void __claim(AtomicCounter& flag)
+{
+  // the flag is only contended by flushOnCrash(), which never waits for it
+
+  while(flag.testAndSet(1, 0) != 0)
+    Thread::sleep(1);
+}
+
+/*
+ */
+
+AsyncLogger::AsyncLogger(Logger* target,
+                         size_t bufferSize /* = DEFAULT_BUFFER_SIZE */,
+                         LogOverflowPolicy policy /* = LogOverflowBlock */,
+                         CriticalSection* targetLock /* = NULL */)
+  : Logger("%m"),
+    _target(target),
+    _bufferSize(__ringSize(bufferSize)),
+    _policy(policy),
+    _targetLock(targetLock),
+    _rings(new RingList()),
+    _slot(new RingSlot()),
+    _batch(static_cast<uint_t>(_bufferSize)),
+    _line(static_cast<uint_t>(Logger::LOG_BUFFER_SIZE)),
+    _record(new char[Logger::LOG_BUFFER_SIZE]),
+    _message(new char[Logger::LOG_BUFFER_SIZE]),
+    _pending(false),
+    _runner(this, &AsyncLogger::_run),
+    _writer(NULL)
+{
+}
+
+/*
+ */
+
+AsyncLogger::~AsyncLogger()
+{
+  stop();
+
+  for(RingList::iterator iter = _rings->begin();
+      iter != _rings->end();
+      ++iter)
+    (*iter)->release();
+
+  delete _slot;
+  delete _rings;
+  delete[] _record;
+  delete[] _message;
+}
+
+/*
+ */
+
+void AsyncLogger::start()
+{
+  if(_writer)
+    return;
+
+  _running.set(1);
+
+  _writer = new Thread(&_runner);
+  _writer->start();
+}
+
+/*
+ */
+
+void AsyncLogger::stop()
+{
+  if(! _writer)
+    return;
+
+  _running.set(0);
+  _wake();
+
+  _writer->join();
+  delete _writer;
+  _writer = NULL;
+
+  _flushTarget(false);
+}
+
+/*
+ */
+
+bool AsyncLogger::isRunning() const
+{
+  return(_running.get() != 0);
+}
+
+/*
+ */
+
+void AsyncLogger::flush()
+{
+  _drain(false);
+  _flushTarget(false);
+}
+
+/*
+ */
+
+void AsyncLogger::flushOnCrash()
+{
+  _drain(true);
+  _flushTarget(true);
+}
+
+/*
+ */
+
+void AsyncLogger::setTarget(Logger* target)
+{
+  if(! _writer)
+    _target = target;
+}
+
+/*
+ */
+
+void AsyncLogger::vlog(LogLevel level, const char* file, int line,
+                       const char* message, va_list args)
+{
+  if(! _target || ! _target->isLogLevelEnabled(level))
+    return;
+
+  Ring *ring = _getRing();
+  if(! ring)
+    return;
+
+  CharBuffer &buf = ring->scratch;
+  buf.clear();
+  _target->getLogFormat().format(buf, level, file, line, message, args);
+  buf.flip();
+
+  _enqueue(ring, buf.getPointer(),
+           static_cast<uint32_t>(buf.getRemaining()), false);
+}
+
+/*
+ */
+
+void AsyncLogger::logBinary(LogLevel level, const LogSite* site, ...)
+{
+  va_list vp;
+  va_start(vp, site);
+  vlogBinary(level, site, vp);
+  va_end(vp);
+}
+
+/*
+ */
+
+void AsyncLogger::vlogBinary(LogLevel level, const LogSite* site,
+                             va_list args)
+{
+  if(! site->isBinary())
+  {
+    vlog(level, site->getFile(), site->getLine(), site->getFormat(), args);
+    return;
+  }
+
+  if(! _target || ! _target->isLogLevelEnabled(level))
+    return;
+
+  Ring *ring = _getRing();
+  if(! ring)
+    return;
+
+  CharBuffer &buf = ring->scratch;
+  size_t len = BinaryLogCodec::encodeRecord(buf.getBase(), buf.getSize(),
+                                            *site, level,
+                                            System::currentTimeMillis(),
+                                            args);
+  if(len > 0)
+    _enqueue(ring, buf.getBase(), static_cast<uint32_t>(len), true);
+}
+
+/*
+ */
+
+bool AsyncLogger::write(CharBuffer& buffer)
+{
+  Ring *ring = _getRing();
+  if(! ring)
+    return(false);
+
+  // records are bounded so that the writer can always buffer one
+
+  uint32_t len = static_cast<uint32_t>(
+    std::min(buffer.getRemaining(), static_cast<uint_t>(LOG_BUFFER_SIZE)));
+
+  return(_enqueue(ring, buffer.getPointer(), len, false));
+}
+
+/*
+ */
+
+AsyncLogger::Ring* AsyncLogger::_getRing()
+{
+  RingHandle *handle = _slot->getValue();
+  if(handle)
+    return(handle->ring);
+
+  Ring *ring = new Ring(_bufferSize);
+
+  synchronized(_ringLock)
+  {
+    __claim(_ringsBusy);
+    _rings->push_back(ring);
+    _ringsBusy.set(0);
+  }
+
+  _slot->setValue(new RingHandle(ring));
+
+  return(ring);
+}
+
+/*
+ */
+
+bool AsyncLogger::_enqueue(Ring* ring, const char* data, uint32_t len,
+                           bool binary)
+{
+  for(;;)
+  {
+    if(ring->put(data, len, binary))
+    {
+      // don't wait for the next pass if the ring is filling up
+      if(ring->isFilling())
+        _wake();
+
+      return(true);
+    }
+
+    // blocking only makes sense if there is a writer to make room
+
+    if((_policy != LogOverflowBlock) || (_running.get() == 0))
+    {
+      ++_dropCount;
+      return(false);
+    }
+
+    _wake();
+    Thread::sleep(1);
+  }
+}
+
+/*
+ */
+
+void AsyncLogger::_wake()
+{
+  synchronized(_waitLock)
+  {
+    _pending = true;
+    _waitCond.notify();
+  }
+}
+
+/*
+ */
+
+void AsyncLogger::_run()
+{
+  while(_running.get() != 0)
+  {
+    _drain(false);
+
+    synchronized(_waitLock)
+    {
+      if(! _pending && (_running.get() != 0))
+        _waitCond.wait(_waitLock, FLUSH_INTERVAL);
+
+      _pending = false;
+    }
+  }
+
+  // final pass, so that nothing logged before stop() is lost
+  _drain(false);
+}
+
+/*
+ */
+
+void AsyncLogger::_drain(bool crashing)
+{
+  // a signal handler can't take the locks, so each one is paired with a
+  // busy flag, which is claimed while the lock is held; when crashing, the
+  // flags are only tested, and if one is set, the rings or the batch may
+  // be in an inconsistent state and nothing can be written safely
+
+  if(crashing)
+  {
+    if(_drainBusy.testAndSet(1, 0) != 0)
+      return;
+
+    if(_ringsBusy.testAndSet(1, 0) != 0)
+    {
+      _drainBusy.set(0);
+      return;
+    }
+  }
+  else
+  {
+    _drainLock.lock();
+    __claim(_drainBusy);
+    _ringLock.lock();
+    __claim(_ringsBusy);
+  }
+
+  _batch.clear();
+
+  for(RingList::iterator iter = _rings->begin();
+      iter != _rings->end();
+    )
+  {
+    Ring *ring = *iter;
+    uint32_t head = ring->getHead();
+    uint32_t tail = ring->getTail();
+
+    while(head != tail)
+    {
+      bool binary;
+      uint32_t len = ring->peek(head, binary);
+
+      // rendering a binary record is not async-signal-safe
+
+      if(crashing && binary && ! (_target && _target->isBinary()))
+      {
+        head += Ring::PREFIX_SIZE + len;
+        continue;
+      }
+
+      if(! _append(ring, head, len, binary) && (_batch.getPosition() > 0))
+      {
+        // out of room; release what has been consumed so far, and retry
+        // the record once the batch has been written
+
+        ring->setHead(head);
+        _writeBatch(crashing);
+        continue;
+      }
+
+      head += Ring::PREFIX_SIZE + len;
+    }
+
+    // release the space
+    ring->setHead(head);
+
+    // never free memory from a signal handler
+
+    if(! crashing && ring->isOrphaned() && ring->isEmpty())
+    {
+      iter = _rings->erase(iter);
+      ring->release();
+    }
+    else
+      ++iter;
+  }
+
+  _ringsBusy.set(0);
+
+  if(! crashing)
+    _ringLock.unlock();
+
+  if(_policy == LogOverflowDropAndReport)
+  {
+    int32_t dropped = _dropCount.get();
+    int32_t delta = dropped - _dropReported.get();
+
+    if(delta > 0)
+    {
+      char text[64];
+      uint32_t n = __formatDropNotice(text, delta);
+
+      if(! _appendText(text, n))
+      {
+        _writeBatch(crashing);
+        _appendText(text, n);
+      }
+
+      _dropReported.set(dropped);
+    }
+  }
+
+  if(_batch.getPosition() > 0)
+    _writeBatch(crashing);
+
+  // complete a log rotation in the target, if one was started, without
+  // holding the target lock
+
+  if(! crashing && _target && _target->hasDeferredWork())
+    _target->completeDeferredWork();
+
+  _drainBusy.set(0);
+
+  if(! crashing)
+    _drainLock.unlock();
+}
+
+/*
+ */
+
+bool AsyncLogger::_append(Ring* ring, uint32_t pos, uint32_t len,
+                          bool binary)
+{
+  if(! _target)
+    return(true); // nowhere to write it
+
+  if(binary && ! _target->isBinary())
+  {
+    // render the record here
+
+    ring->read(pos, _record, len);
+
+    uint32_t siteID;
+    LogLevel level;
+    time_ms_t time;
+    const char *args;
+    size_t argsLen;
+
+    if(! BinaryLogCodec::decodeRecord(_record, len, siteID, level, time,
+                                      args, argsLen))
+      return(true); // skip it
+
+    const LogSite *site = LogSite::lookup(siteID);
+    if(! site)
+      return(true);
+
+    BinaryLogCodec::renderMessage(site->getFormat(), args, argsLen,
+                                  _message, Logger::LOG_BUFFER_SIZE);
+    BinaryLogCodec::formatLine(_target->getLogFormat(), _line, level, time,
+                               site->getFile(), site->getLine(), _message);
+
+    uint32_t lineLen = static_cast<uint32_t>(_line.getRemaining());
+    if(_batch.getRemaining() < lineLen)
+      return(false);
+
+    std::memcpy(_batch.getPointer(), _line.getPointer(), lineLen);
+    _batch.bump(lineLen);
+
+    return(true);
+  }
+
+  if(! binary)
+  {
+    if(_target->isBinary())
+    {
+      ring->read(pos, _record, len);
+      return(_appendText(_record, len));
+    }
+
+    if(_batch.getRemaining() < len)
+      return(false);
+
+    ring->read(pos, _batch.getPointer(), len);
+    _batch.bump(len);
+
+    return(true);
+  }
+
+  // pass the record through to a binary target
+
+  if(_batch.getRemaining() < (BinaryLogCodec::FRAME_HEADER_SIZE + len))
+    return(false);
+
+  BinaryLogCodec::encodeFrameHeader(_batch.getPointer(),
+                                    BinaryLogCodec::FRAME_RECORD, len);
+  _batch.bump(BinaryLogCodec::FRAME_HEADER_SIZE);
+  ring->read(pos, _batch.getPointer(), len);
+  _batch.bump(len);
+
+  return(true);
+}
+
+/*
+ */
+
+bool AsyncLogger::_appendText(const char* text, uint32_t len)
+{
+  bool framed = (_target && _target->isBinary());
+  size_t need = len + (framed ? BinaryLogCodec::FRAME_HEADER_SIZE : 0);
+
+  if(_batch.getRemaining() < need)
+    return(false);
+
+  if(framed)
+  {
+    BinaryLogCodec::encodeFrameHeader(_batch.getPointer(),
+                                      BinaryLogCodec::FRAME_TEXT, len);
+    _batch.bump(BinaryLogCodec::FRAME_HEADER_SIZE);
+  }
+
+  std::memcpy(_batch.getPointer(), text, len);
+  _batch.bump(len);
+
+  return(true);
+}
+
+/*
+ */
+
+void AsyncLogger::_writeBatch(bool crashing)
+{
+  _batch.flip();
+
+  if(_target && _batch.hasRemaining())
+  {
+    // if crashing, the crashing thread may be in the middle of a write to
+    // the target, which writeOnCrash() detects without taking the lock
+
+    if(crashing)
+      _target->writeOnCrash(_batch);
+    else if(_targetLock)
+    {
+      ScopedLock guard(*_targetLock);
+      _target->write(_batch);
+    }
+    else
+      _target->write(_batch);
+  }
+
+  _batch.clear();
+}
+
+/*
+ */
+
+void AsyncLogger::_flushTarget(bool crashing)
+{
+  if(! _target)
+    return;
+
+  if(crashing)
+    _target->flushOnCrash();
+  else if(_targetLock)
+  {
+    ScopedLock guard(*_targetLock);
+    _target->flush();
+  }
+  else
+    _target->flush();
+}
+
+} // namespace ccxx
@@ -0,0 +1,248 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/BinaryFileLogger.h++"
+#include "commonc++/BinaryLogCodec.h++"
+#include "commonc++/File.h++"
+#include "commonc++/LogSite.h++"
+
+#include <cstring>
+
+namespace ccxx {
+
+/*
+ */
+
+static const uint_t __frameBufferSize = 65536;
+
+/*
+ */
+
+BinaryFileLogger::BinaryFileLogger(size_t maxLogSize /* = 2048 */,
+                                   uint_t rotateCount /* = 1 */)
+  : FileLogger("%m", maxLogSize, rotateCount),
+    _frames(__frameBufferSize),
+    _definedSites(0)
+{
+}
+
+/*
+ */
+
+BinaryFileLogger::~BinaryFileLogger()
+{
+}
+
+/*
+ */
+
+bool BinaryFileLogger::isBinary() const
+{
+  return(true);
+}
+
+/*
+ */
+
+void BinaryFileLogger::openFile()
+{
+  FileLogger::openFile();
+
+  // this may be called from write() when the file is rotated, so it can't
+  // use the frame buffer
+
+  CharBuffer defs(__frameBufferSize);
+
+  if(_curLogSize == 0)
+  {
+    BinaryLogCodec::encodeFileHeader(defs.getPointer());
+    defs.bump(BinaryLogCodec::FILE_HEADER_SIZE);
+  }
+
+  // a process appending to an existing file may have assigned different
+  // IDs, so always redefine every site
+
+  uint32_t count = LogSite::getCount();
+
+  for(uint32_t id = 1; id <= count; ++id)
+  {
+    const LogSite *site = LogSite::lookup(id);
+    if(! site)
+      continue;
+
+    size_t n = BinaryLogCodec::encodeSiteFrame(defs.getPointer(),
+                                               defs.getRemaining(), *site);
+    if((n == 0) && (defs.getPosition() > 0))
+    {
+      defs.flip();
+      _curLogSize += _file->write(defs);
+      defs.clear();
+
+      n = BinaryLogCodec::encodeSiteFrame(defs.getPointer(),
+                                          defs.getRemaining(), *site);
+    }
+
+    defs.bump(static_cast<uint_t>(n));
+  }
+
+  defs.flip();
+  if(defs.hasRemaining())
+    _curLogSize += _file->write(defs);
+
+  _definedSites = count;
+}
+
+/*
+ */
+
+bool BinaryFileLogger::write(CharBuffer& buffer)
+{
+  if(! _file)
+    return(false);
+
+  const size_t hdrSize = BinaryLogCodec::FRAME_HEADER_SIZE;
+
+  _frames.clear();
+
+  while(buffer.getRemaining() >= hdrSize)
+  {
+    char type;
+    uint32_t len;
+
+    BinaryLogCodec::decodeFrameHeader(buffer.getPointer(), type, len);
+
+    size_t frameLen = hdrSize + len;
+    if(buffer.getRemaining() < frameLen)
+      break; // truncated frame
+
+    if((type == BinaryLogCodec::FRAME_RECORD) && (len >= sizeof(uint32_t)))
+    {
+      uint32_t id;
+      std::memcpy(&id, buffer.getPointer() + hdrSize, sizeof(id));
+
+      // define any sites that have been registered since the last write
+
+      for(; _definedSites < id; ++_definedSites)
+      {
+        const LogSite *site = LogSite::lookup(_definedSites + 1);
+        if(! site)
+          continue;
+
+        size_t n = BinaryLogCodec::encodeSiteFrame(_frames.getPointer(),
+                                                   _frames.getRemaining(),
+                                                   *site);
+        if(n == 0)
+        {
+          if(! _flushFrames())
+            return(false);
+
+          n = BinaryLogCodec::encodeSiteFrame(_frames.getPointer(),
+                                              _frames.getRemaining(), *site);
+        }
+
+        _frames.bump(static_cast<uint_t>(n));
+      }
+    }
+
+    if((_frames.getRemaining() < frameLen) && ! _flushFrames())
+      return(false);
+
+    if(_frames.getRemaining() >= frameLen)
+    {
+      std::memcpy(_frames.getPointer(), buffer.getPointer(), frameLen);
+      _frames.bump(static_cast<uint_t>(frameLen));
+    }
+
+    buffer.bump(static_cast<uint_t>(frameLen));
+  }
+
+  return(_flushFrames());
+}
+
+/*
+ */
+
+bool BinaryFileLogger::writeOnCrash(CharBuffer& buffer)
+{
+  const size_t hdrSize = BinaryLogCodec::FRAME_HEADER_SIZE;
+
+  // compact the frames that can be written in place, since the frame
+  // buffer may be in use by the crashing thread
+
+  char *base = buffer.getPointer();
+  char *out = base;
+
+  while(buffer.getRemaining() >= hdrSize)
+  {
+    char type;
+    uint32_t len;
+
+    BinaryLogCodec::decodeFrameHeader(buffer.getPointer(), type, len);
+
+    size_t frameLen = hdrSize + len;
+    if(buffer.getRemaining() < frameLen)
+      break; // truncated frame
+
+    bool defined = true;
+
+    if((type == BinaryLogCodec::FRAME_RECORD) && (len >= sizeof(uint32_t)))
+    {
+      uint32_t id;
+      std::memcpy(&id, buffer.getPointer() + hdrSize, sizeof(id));
+
+      defined = (id <= _definedSites);
+    }
+
+    if(defined)
+    {
+      std::memmove(out, buffer.getPointer(), frameLen);
+      out += frameLen;
+    }
+
+    buffer.bump(static_cast<uint_t>(frameLen));
+  }
+
+  CharBuffer frames(base, static_cast<size_t>(out - base), false);
+
+  return(FileLogger::writeOnCrash(frames));
+}
+
+/*
+ */
+
+bool BinaryFileLogger::_flushFrames()
+{
+  if(_frames.getPosition() == 0)
+    return(true);
+
+  _frames.flip();
+  bool ok = FileLogger::write(_frames);
+  _frames.clear();
+
+  return(ok);
+}
+
+} // namespace ccxx
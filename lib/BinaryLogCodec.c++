@@ -0,0 +1,703 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/BinaryLogCodec.h++"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace ccxx {
+
+/*
+ */
+
+const char BinaryLogCodec::FRAME_SITE;
+const char BinaryLogCodec::FRAME_RECORD;
+const char BinaryLogCodec::FRAME_TEXT;
+const size_t BinaryLogCodec::FRAME_HEADER_SIZE;
+const size_t BinaryLogCodec::RECORD_HEADER_SIZE;
+const size_t BinaryLogCodec::FILE_HEADER_SIZE;
+
+const char* BinaryLogCodec::FILE_MAGIC = "CCXXBLG1";
+
+static const uint32_t __byteOrderMark = 0x01020304;
+
+/*
+ * A parsed printf conversion specification. The code is the signature
+ * character for the converted value, or NUL for "%%".
+ */
+
+struct ConvSpec
+{
+  const char* start;
+  const char* end;
+  bool starWidth;
+  bool starPrecision;
+  char code;
+};
+
+/*
+ */
+
+static bool __scanSpec(const char* p, ConvSpec& spec)
+{
+  spec.start = p++;
+  spec.starWidth = spec.starPrecision = false;
+  spec.code = 0;
+
+  if(*p == '%')
+  {
+    spec.end = p + 1;
+    return(true);
+  }
+
+  while(*p && std::strchr("-+ #0'", *p))
+    ++p;
+
+  if(*p == '*')
+  {
+    spec.starWidth = true;
+    ++p;
+  }
+  else
+  {
+    while((*p >= '0') && (*p <= '9'))
+      ++p;
+  }
+
+  if(*p == '.')
+  {
+    ++p;
+    if(*p == '*')
+    {
+      spec.starPrecision = true;
+      ++p;
+    }
+    else
+    {
+      while((*p >= '0') && (*p <= '9'))
+        ++p;
+    }
+  }
+
+  // length modifier; 'H' stands for "hh" and 'q' for "ll"
+
+  char mod = 0;
+  switch(*p)
+  {
+    case 'h':
+      mod = (*++p == 'h') ? (++p, 'H') : 'h';
+      break;
+
+    case 'l':
+      mod = (*++p == 'l') ? (++p, 'q') : 'l';
+      break;
+
+    case 'j':
+    case 'z':
+    case 't':
+    case 'L':
+      mod = *p++;
+      break;
+
+    default:
+      break;
+  }
+
+  switch(*p)
+  {
+    case 'd':
+    case 'i':
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X':
+      if(mod == 'L')
+        return(false);
+      spec.code = ((mod == 0) || (mod == 'h') || (mod == 'H')) ? 'i' : mod;
+      break;
+
+    case 'c':
+      if((mod != 0) && (mod != 'l'))
+        return(false);
+      spec.code = 'i';
+      break;
+
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      if((mod != 0) && (mod != 'l') && (mod != 'L'))
+        return(false);
+      spec.code = (mod == 'L') ? 'D' : 'd';
+      break;
+
+    case 's':
+      if(mod != 0)
+        return(false);
+      spec.code = 's';
+      break;
+
+    case 'p':
+      if(mod != 0)
+        return(false);
+      spec.code = 'p';
+      break;
+
+    default:
+      // %n, %m, wide strings, and anything unknown
+      return(false);
+  }
+
+  spec.end = p + 1;
+
+  return(true);
+}
+
+/*
+ */
+
+static inline void __put(char*& p, const void* value, size_t len)
+{
+  std::memcpy(p, value, len);
+  p += len;
+}
+
+/*
+ */
+
+static inline bool __get(const char*& p, const char* end, void* value,
+                         size_t len)
+{
+  if(static_cast<size_t>(end - p) < len)
+    return(false);
+
+  std::memcpy(value, p, len);
+  p += len;
+
+  return(true);
+}
+
+/*
+ */
+
+bool BinaryLogCodec::parseSignature(const char* format, char* signature,
+                                    size_t size)
+{
+  size_t n = 0;
+
+  for(const char* p = format; *p; )
+  {
+    if(*p != '%')
+    {
+      ++p;
+      continue;
+    }
+
+    ConvSpec spec;
+    if(! __scanSpec(p, spec))
+      return(false);
+
+    p = spec.end;
+
+    if(spec.code == 0)
+      continue;
+
+    size_t count = (spec.starWidth ? 1 : 0) + (spec.starPrecision ? 1 : 0)
+      + 1;
+    if(n + count >= size)
+      return(false);
+
+    if(spec.starWidth)
+      signature[n++] = 'i';
+    if(spec.starPrecision)
+      signature[n++] = 'i';
+
+    signature[n++] = spec.code;
+  }
+
+  if(n >= size)
+    return(false);
+
+  signature[n] = NUL;
+
+  return(true);
+}
+
+/*
+ */
+
+size_t BinaryLogCodec::encodeRecord(char* buf, size_t size,
+                                    const LogSite& site, LogLevel level,
+                                    time_ms_t time, va_list args)
+{
+  if(size < RECORD_HEADER_SIZE)
+    return(0);
+
+  char* p = buf;
+  char* end = buf + size;
+
+  uint32_t id = site.getID();
+  uint8_t lvl = static_cast<uint8_t>(level);
+  int64_t ts = time;
+
+  __put(p, &id, sizeof(id));
+  __put(p, &lvl, sizeof(lvl));
+  __put(p, &ts, sizeof(ts));
+
+  for(const char* sig = site.getSignature(); *sig; ++sig)
+  {
+    if(*sig == 's')
+    {
+      const char* s = va_arg(args, const char *);
+      if(! s)
+        s = "(null)";
+
+      // length, characters, and NUL terminator; truncate to fit
+
+      if(static_cast<size_t>(end - p) < (sizeof(uint16_t) + 1))
+        return(0);
+
+      size_t avail = static_cast<size_t>(end - p) - sizeof(uint16_t) - 1;
+      if(avail > 0xFFFF)
+        avail = 0xFFFF;
+
+      size_t len = 0;
+      while((len < avail) && s[len])
+        ++len;
+
+      uint16_t len16 = static_cast<uint16_t>(len);
+      __put(p, &len16, sizeof(len16));
+      __put(p, s, len);
+      *(p++) = NUL;
+
+      continue;
+    }
+
+    if(static_cast<size_t>(end - p) < sizeof(int64_t))
+      return(0);
+
+    switch(*sig)
+    {
+      case 'i':
+      {
+        int32_t v = static_cast<int32_t>(va_arg(args, int));
+        __put(p, &v, sizeof(v));
+        break;
+      }
+
+      case 'l':
+      {
+        int64_t v = static_cast<int64_t>(va_arg(args, long));
+        __put(p, &v, sizeof(v));
+        break;
+      }
+
+      case 'q':
+      {
+        int64_t v = static_cast<int64_t>(va_arg(args, long long));
+        __put(p, &v, sizeof(v));
+        break;
+      }
+
+      case 'j':
+      {
+        int64_t v = static_cast<int64_t>(va_arg(args, intmax_t));
+        __put(p, &v, sizeof(v));
+        break;
+      }
+
+      case 'z':
+      {
+        uint64_t v = static_cast<uint64_t>(va_arg(args, size_t));
+        __put(p, &v, sizeof(v));
+        break;
+      }
+
+      case 't':
+      {
+        int64_t v = static_cast<int64_t>(va_arg(args, ptrdiff_t));
+        __put(p, &v, sizeof(v));
+        break;
+      }
+
+      case 'p':
+      {
+        uint64_t v = reinterpret_cast<uintptr_t>(va_arg(args, void *));
+        __put(p, &v, sizeof(v));
+        break;
+      }
+
+      case 'd':
+      {
+        double v = va_arg(args, double);
+        __put(p, &v, sizeof(v));
+        break;
+      }
+
+      case 'D':
+      {
+        double v = static_cast<double>(va_arg(args, long double));
+        __put(p, &v, sizeof(v));
+        break;
+      }
+
+      default:
+        return(0);
+    }
+  }
+
+  return(static_cast<size_t>(p - buf));
+}
+
+/*
+ */
+
+bool BinaryLogCodec::decodeRecord(const char* data, size_t len,
+                                  uint32_t& siteID, LogLevel& level,
+                                  time_ms_t& time, const char*& args,
+                                  size_t& argsLen)
+{
+  const char* p = data;
+  const char* end = data + len;
+
+  uint8_t lvl;
+  int64_t ts;
+
+  if(! __get(p, end, &siteID, sizeof(siteID))
+     || ! __get(p, end, &lvl, sizeof(lvl))
+     || ! __get(p, end, &ts, sizeof(ts)))
+    return(false);
+
+  level = static_cast<LogLevel>(lvl);
+  time = ts;
+  args = p;
+  argsLen = static_cast<size_t>(end - p);
+
+  return(true);
+}
+
+/*
+ */
+
+size_t BinaryLogCodec::renderMessage(const char* format, const char* args,
+                                     size_t argsLen, char* output,
+                                     size_t outputLen)
+{
+  if(outputLen == 0)
+    return(0);
+
+  const char* ap = args;
+  const char* aend = args + argsLen;
+  char* q = output;
+  char* qend = output + outputLen - 1;
+
+  for(const char* p = format; *p && (q < qend); )
+  {
+    if(*p != '%')
+    {
+      *(q++) = *(p++);
+      continue;
+    }
+
+    ConvSpec spec;
+    if(! __scanSpec(p, spec))
+      break;
+
+    p = spec.end;
+
+    if(spec.code == 0)
+    {
+      *(q++) = '%';
+      continue;
+    }
+
+    // rebuild the specification, substituting '*' values
+
+    char fmt[64];
+    char* f = fmt;
+    bool ok = true;
+
+    for(const char* s = spec.start; ok && (s < spec.end); ++s)
+    {
+      if(f > (fmt + sizeof(fmt) - 16))
+        ok = false;
+      else if(*s == '*')
+      {
+        int32_t v;
+        ok = __get(ap, aend, &v, sizeof(v));
+        if(ok)
+          f += std::sprintf(f, "%d", static_cast<int>(v));
+      }
+      else
+        *(f++) = *s;
+    }
+
+    if(! ok)
+      break;
+
+    *f = NUL;
+
+    size_t room = static_cast<size_t>(qend - q) + 1;
+    int n = 0;
+
+    switch(spec.code)
+    {
+      case 's':
+      {
+        uint16_t len;
+        if(! __get(ap, aend, &len, sizeof(len))
+           || (static_cast<size_t>(aend - ap) < (size_t(len) + 1u)))
+        {
+          ok = false;
+          break;
+        }
+
+        n = std::snprintf(q, room, fmt, ap);
+        ap += len + 1;
+        break;
+      }
+
+      case 'i':
+      {
+        int32_t v;
+        if((ok = __get(ap, aend, &v, sizeof(v))))
+          n = std::snprintf(q, room, fmt, static_cast<int>(v));
+        break;
+      }
+
+      case 'l':
+      {
+        int64_t v;
+        if((ok = __get(ap, aend, &v, sizeof(v))))
+          n = std::snprintf(q, room, fmt, static_cast<long>(v));
+        break;
+      }
+
+      case 'q':
+      {
+        int64_t v;
+        if((ok = __get(ap, aend, &v, sizeof(v))))
+          n = std::snprintf(q, room, fmt, static_cast<long long>(v));
+        break;
+      }
+
+      case 'j':
+      {
+        int64_t v;
+        if((ok = __get(ap, aend, &v, sizeof(v))))
+          n = std::snprintf(q, room, fmt, static_cast<intmax_t>(v));
+        break;
+      }
+
+      case 'z':
+      {
+        uint64_t v;
+        if((ok = __get(ap, aend, &v, sizeof(v))))
+          n = std::snprintf(q, room, fmt, static_cast<size_t>(v));
+        break;
+      }
+
+      case 't':
+      {
+        int64_t v;
+        if((ok = __get(ap, aend, &v, sizeof(v))))
+          n = std::snprintf(q, room, fmt, static_cast<ptrdiff_t>(v));
+        break;
+      }
+
+      case 'p':
+      {
+        uint64_t v;
+        if((ok = __get(ap, aend, &v, sizeof(v))))
+          n = std::snprintf(q, room, fmt,
+                            reinterpret_cast<void *>(
+                              static_cast<uintptr_t>(v)));
+        break;
+      }
+
+      case 'd':
+      {
+        double v;
+        if((ok = __get(ap, aend, &v, sizeof(v))))
+          n = std::snprintf(q, room, fmt, v);
+        break;
+      }
+
+      case 'D':
+      {
+        double v;
+        if((ok = __get(ap, aend, &v, sizeof(v))))
+          n = std::snprintf(q, room, fmt, static_cast<long double>(v));
+        break;
+      }
+
+      default:
+        ok = false;
+        break;
+    }
+
+    if(! ok || (n < 0))
+      break;
+
+    q += (static_cast<size_t>(n) < room) ? n : (room - 1);
+  }
+
+  *q = NUL;
+
+  return(static_cast<size_t>(q - output));
+}
+
+/*
+ */
+
+static void __formatLine(LogFormat& logFormat, CharBuffer& buffer,
+                         LogLevel level, time_ms_t time, const char* file,
+                         int line, const char* message, ...)
+{
+  va_list vp;
+  va_start(vp, message);
+  logFormat.format(buffer, level, time, file, line, message, vp);
+  va_end(vp);
+}
+
+/*
+ */
+
+void BinaryLogCodec::formatLine(LogFormat& logFormat, CharBuffer& buffer,
+                                LogLevel level, time_ms_t time,
+                                const char* file, int line,
+                                const char* message)
+{
+  buffer.clear();
+  __formatLine(logFormat, buffer, level, time, file, line, "%s", message);
+  buffer.flip();
+}
+
+/*
+ */
+
+size_t BinaryLogCodec::encodeSiteFrame(char* buf, size_t size,
+                                       const LogSite& site)
+{
+  size_t fileLen = std::strlen(site.getFile()) + 1;
+  size_t formatLen = std::strlen(site.getFormat()) + 1;
+  size_t len = sizeof(uint32_t) + sizeof(int32_t) + fileLen + formatLen;
+
+  if(size < (FRAME_HEADER_SIZE + len))
+    return(0);
+
+  encodeFrameHeader(buf, FRAME_SITE, static_cast<uint32_t>(len));
+
+  char* p = buf + FRAME_HEADER_SIZE;
+  uint32_t id = site.getID();
+  int32_t line = site.getLine();
+
+  __put(p, &id, sizeof(id));
+  __put(p, &line, sizeof(line));
+  __put(p, site.getFile(), fileLen);
+  __put(p, site.getFormat(), formatLen);
+
+  return(FRAME_HEADER_SIZE + len);
+}
+
+/*
+ */
+
+bool BinaryLogCodec::decodeSiteFrame(const char* data, size_t len,
+                                     uint32_t& siteID, int& line,
+                                     const char*& file, const char*& format)
+{
+  const char* p = data;
+  const char* end = data + len;
+  int32_t line32;
+
+  if(! __get(p, end, &siteID, sizeof(siteID))
+     || ! __get(p, end, &line32, sizeof(line32)))
+    return(false);
+
+  line = line32;
+
+  const char* nul = static_cast<const char *>(
+    std::memchr(p, NUL, static_cast<size_t>(end - p)));
+  if(! nul)
+    return(false);
+
+  file = p;
+  p = nul + 1;
+
+  if(! std::memchr(p, NUL, static_cast<size_t>(end - p)))
+    return(false);
+
+  format = p;
+
+  return(true);
+}
+
+/*
+ */
+
+void BinaryLogCodec::encodeFrameHeader(char* buf, char type, uint32_t len)
+{
+  buf[0] = type;
+  std::memcpy(buf + 1, &len, sizeof(len));
+}
+
+/*
+ */
+
+void BinaryLogCodec::decodeFrameHeader(const char* buf, char& type,
+                                       uint32_t& len)
+{
+  type = buf[0];
+  std::memcpy(&len, buf + 1, sizeof(len));
+}
+
+/*
+ */
+
+void BinaryLogCodec::encodeFileHeader(char* buf)
+{
+  std::memcpy(buf, FILE_MAGIC, 8);
+  std::memcpy(buf + 8, &__byteOrderMark, sizeof(__byteOrderMark));
+}
+
+/*
+ */
+
+bool BinaryLogCodec::checkFileHeader(const char* buf)
+{
+  return((std::memcmp(buf, FILE_MAGIC, 8) == 0)
+         && (std::memcmp(buf + 8, &__byteOrderMark,
+                         sizeof(__byteOrderMark)) == 0));
+}
+
+} // namespace ccxx
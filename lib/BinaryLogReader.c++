@@ -0,0 +1,256 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/BinaryLogReader.h++"
+#include "commonc++/BinaryLogCodec.h++"
+#include "commonc++/IOException.h++"
+#include "commonc++/Logger.h++"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+
+namespace ccxx {
+
+/*
+ */
+
+static const size_t __initialDataSize = 65536;
+
+// a sanity limit, well beyond any frame that a logger will write
+static const uint32_t __maxFrameSize = 16 * 1024 * 1024;
+
+/*
+ */
+
+struct BinaryLogSite
+{
+  int line;
+  std::string file;
+  std::string format;
+};
+
+/*
+ */
+
+class BinaryLogReader::SiteMap : public std::map<uint32_t, BinaryLogSite>
+{
+};
+
+/*
+ */
+
+BinaryLogReader::BinaryLogReader(
+  const String& path, const String& format /* = "[%D %T] %F:%L %m" */)
+  : _file(path),
+    _format(format),
+    _sites(new SiteMap()),
+    _data(new char[__initialDataSize]),
+    _dataSize(__initialDataSize),
+    _dataPos(0),
+    _dataLen(0),
+    _message(new char[Logger::LOG_BUFFER_SIZE]),
+    _unknownSites(0)
+{
+}
+
+/*
+ */
+
+BinaryLogReader::~BinaryLogReader()
+{
+  close();
+
+  delete _sites;
+  delete[] _data;
+  delete[] _message;
+}
+
+/*
+ */
+
+void BinaryLogReader::open()
+{
+  _file.open(IORead, FileOpen);
+
+  _dataPos = _dataLen = 0;
+  _sites->clear();
+  _unknownSites = 0;
+
+  if(! _fill(BinaryLogCodec::FILE_HEADER_SIZE)
+     || ! BinaryLogCodec::checkFileHeader(_data))
+    throw DataFormatException("Not a binary log file, or wrong byte order");
+
+  _dataPos += BinaryLogCodec::FILE_HEADER_SIZE;
+}
+
+/*
+ */
+
+void BinaryLogReader::close()
+{
+  if(_file.isOpen())
+    _file.close();
+}
+
+/*
+ */
+
+bool BinaryLogReader::read(CharBuffer& buffer)
+{
+  const size_t hdrSize = BinaryLogCodec::FRAME_HEADER_SIZE;
+
+  for(;;)
+  {
+    if(! _fill(hdrSize))
+      return(false);
+
+    char type;
+    uint32_t len;
+
+    BinaryLogCodec::decodeFrameHeader(_data + _dataPos, type, len);
+    if(len > __maxFrameSize)
+      throw DataFormatException("Invalid frame length");
+
+    if(! _fill(hdrSize + len))
+      throw DataFormatException("Truncated frame");
+
+    const char *payload = _data + _dataPos + hdrSize;
+    _dataPos += hdrSize + len;
+
+    switch(type)
+    {
+      case BinaryLogCodec::FRAME_SITE:
+      {
+        uint32_t id;
+        BinaryLogSite site;
+        const char *file, *format;
+
+        if(! BinaryLogCodec::decodeSiteFrame(payload, len, id, site.line,
+                                             file, format))
+          throw DataFormatException("Invalid site frame");
+
+        site.file = file;
+        site.format = format;
+        (*_sites)[id] = site;
+        break;
+      }
+
+      case BinaryLogCodec::FRAME_RECORD:
+      {
+        uint32_t id;
+        LogLevel level;
+        time_ms_t time;
+        const char *args;
+        size_t argsLen;
+
+        if(! BinaryLogCodec::decodeRecord(payload, len, id, level, time,
+                                          args, argsLen))
+          throw DataFormatException("Invalid record frame");
+
+        SiteMap::const_iterator iter = _sites->find(id);
+        if(iter == _sites->end())
+        {
+          ++_unknownSites;
+          break;
+        }
+
+        const BinaryLogSite& site = iter->second;
+
+        BinaryLogCodec::renderMessage(site.format.c_str(), args, argsLen,
+                                      _message, Logger::LOG_BUFFER_SIZE);
+        BinaryLogCodec::formatLine(_format, buffer, level, time,
+                                   site.file.c_str(), site.line, _message);
+        return(true);
+      }
+
+      case BinaryLogCodec::FRAME_TEXT:
+      {
+        buffer.clear();
+
+        size_t n = std::min(static_cast<size_t>(len),
+                            static_cast<size_t>(buffer.getRemaining()));
+        std::memcpy(buffer.getPointer(), payload, n);
+        buffer.bump(static_cast<uint_t>(n));
+        buffer.flip();
+        return(true);
+      }
+
+      default:
+        // skip unknown frame types, for forward compatibility
+        break;
+    }
+  }
+}
+
+/*
+ */
+
+bool BinaryLogReader::_fill(size_t count)
+{
+  if((_dataLen - _dataPos) >= count)
+    return(true);
+
+  // compact, and grow the buffer if necessary
+
+  if(_dataPos > 0)
+  {
+    std::memmove(_data, _data + _dataPos, _dataLen - _dataPos);
+    _dataLen -= _dataPos;
+    _dataPos = 0;
+  }
+
+  if(count > _dataSize)
+  {
+    size_t size = _dataSize;
+    while(size < count)
+      size <<= 1;
+
+    char *data = new char[size];
+    std::memcpy(data, _data, _dataLen);
+    delete[] _data;
+    _data = data;
+    _dataSize = size;
+  }
+
+  try
+  {
+    while(_dataLen < count)
+    {
+      _dataLen += _file.read(reinterpret_cast<byte_t *>(_data + _dataLen),
+                             _dataSize - _dataLen);
+    }
+  }
+  catch(EOFException& ex)
+  {
+    return(false);
+  }
+
+  return(true);
+}
+
+} // namespace ccxx
@@ -0,0 +1,378 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/BlockReader.h++"
+#include "commonc++/ScopedLock.h++"
+#include "commonc++/System.h++"
+
+#ifdef CCXX_OS_POSIX
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+#include <unistd.h>
+#endif
+
+namespace ccxx {
+
+/*
+ */
+
+const size_t BlockReader::DEFAULT_BLOCK_SIZE = 1024 * 1024;
+
+/*
+ */
+
+BlockReader::BlockReader(Stream& stream,
+                         size_t blockSize /* = DEFAULT_BLOCK_SIZE */,
+                         bool readahead /* = false */,
+                         size_t alignment /* = 0 */)
+  : _stream(stream),
+    _fillIndex(0),
+    _useIndex(0),
+    _busy(false),
+    _paused(false),
+    _stopping(false),
+    _eof(false),
+    _failed(false),
+    _runner(this, &BlockReader::_run),
+    _thread(NULL)
+{
+  _wakeHandle[0] = _wakeHandle[1] = CCXX_INVALID_FILE_HANDLE;
+
+#ifdef CCXX_OS_POSIX
+
+  // A read from a pipe or socket may block indefinitely, so the reader
+  // thread waits for data and for a wakeup at the same time. Reads from
+  // files always complete.
+
+  if(readahead && ! stream.isSeekable())
+  {
+#ifdef HAVE_SYS_EVENTFD_H
+
+    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(fd < 0)
+      throw IOException(System::getErrorString("eventfd"));
+
+    _wakeHandle[0] = _wakeHandle[1] = fd;
+
+#else
+
+    if(::pipe(_wakeHandle) != 0)
+      throw IOException(System::getErrorString("pipe"));
+
+    ::fcntl(_wakeHandle[0], F_SETFL, O_NONBLOCK);
+    ::fcntl(_wakeHandle[1], F_SETFL, O_NONBLOCK);
+
+#endif
+  }
+
+#endif
+
+  _blocks[0].buffer = new AlignedBuffer(blockSize, alignment);
+  _blocks[0].length = 0;
+  _blocks[0].state = BlockFree;
+
+  _blocks[1].buffer = readahead ? new AlignedBuffer(blockSize, alignment)
+    : NULL;
+  _blocks[1].length = 0;
+  _blocks[1].state = BlockFree;
+
+  if(readahead)
+  {
+    _thread = new Thread(&_runner);
+    _thread->start();
+  }
+}
+
+/*
+ */
+
+BlockReader::~BlockReader()
+{
+  if(_thread)
+  {
+    {
+      ScopedLock guard(_lock);
+      _stopping = true;
+      _cond.notifyAll();
+
+      if(_busy)
+        _interrupt();
+    }
+
+    _thread->join();
+    delete _thread;
+  }
+
+#ifdef CCXX_OS_POSIX
+
+  if(_wakeHandle[0] != CCXX_INVALID_FILE_HANDLE)
+  {
+    ::close(_wakeHandle[0]);
+    if(_wakeHandle[1] != _wakeHandle[0])
+      ::close(_wakeHandle[1]);
+  }
+
+#endif
+
+  delete _blocks[0].buffer;
+  delete _blocks[1].buffer;
+}
+
+/*
+ */
+
+size_t BlockReader::next(byte_t*& data)
+{
+  if(! _thread)
+  {
+    Block &block = _blocks[0];
+    data = block.buffer->getData();
+
+    try
+    {
+      return(_stream.read(data, block.buffer->getSize()));
+    }
+    catch(EOFException &)
+    {
+      return(0);
+    }
+  }
+
+  ScopedLock guard(_lock);
+
+  // release the block that the caller was consuming
+
+  for(uint_t i = 0; i < CCXX_LENGTHOF(_blocks); ++i)
+  {
+    if(_blocks[i].state == BlockInUse)
+      _blocks[i].state = BlockFree;
+  }
+
+  _paused = false;
+  _cond.notifyAll();
+
+  Block &block = _blocks[_useIndex];
+
+  while((block.state != BlockFilled) && ! _eof && ! _failed)
+    _cond.wait(_lock);
+
+  if(block.state == BlockFilled)
+  {
+    block.state = BlockInUse;
+    _useIndex ^= 1;
+
+    data = block.buffer->getData();
+    return(block.length);
+  }
+
+  if(_failed)
+    throw IOException(_error);
+
+  return(0);
+}
+
+/*
+ */
+
+void BlockReader::discard()
+{
+  if(! _thread)
+    return;
+
+  ScopedLock guard(_lock);
+
+  _paused = true;
+
+  if(_busy)
+    _interrupt();
+
+  while(_busy)
+    _cond.wait(_lock);
+
+  _blocks[0].state = _blocks[1].state = BlockFree;
+  _fillIndex = _useIndex = 0;
+  _eof = _failed = false;
+  _error = String::null;
+}
+
+/*
+ */
+
+void BlockReader::_run()
+{
+  ScopedLock guard(_lock);
+
+  for(;;)
+  {
+    while(! _stopping && (_paused || _eof || _failed
+                          || (_blocks[_fillIndex].state != BlockFree)))
+      _cond.wait(_lock);
+
+    if(_stopping)
+      break;
+
+    Block &block = _blocks[_fillIndex];
+    size_t n = 0;
+    bool eof = false;
+    bool interrupted = false;
+    String error;
+
+    _busy = true;
+    _lock.unlock();
+
+    try
+    {
+      if(_waitForData())
+        n = _stream.read(block.buffer->getData(), block.buffer->getSize());
+      else
+        interrupted = true;
+    }
+    catch(EOFException &)
+    {
+      eof = true;
+    }
+    catch(IOException &ex)
+    {
+      error = ex.getMessage();
+      if(error.isEmpty())
+        error = "read failed";
+    }
+
+    _lock.lock();
+    _busy = false;
+
+    // the data is stale if discard() was called while the read was in
+    // progress; a wakeup that arrives after the read has started is left
+    // pending, so an interrupted wait is simply retried
+
+    if(! _paused && ! interrupted)
+    {
+      if(eof)
+        _eof = true;
+      else if(! error.isEmpty())
+      {
+        _failed = true;
+        _error = error;
+      }
+      else
+      {
+        block.length = n;
+        block.state = BlockFilled;
+        _fillIndex ^= 1;
+      }
+    }
+
+    _cond.notifyAll();
+  }
+}
+
+/*
+ */
+
+bool BlockReader::_waitForData()
+{
+#ifdef CCXX_OS_POSIX
+
+  if(_wakeHandle[0] == CCXX_INVALID_FILE_HANDLE)
+    return(true);
+
+  struct pollfd fds[2];
+  fds[0].fd = _stream._handle;
+  fds[0].events = POLLIN;
+  fds[1].fd = _wakeHandle[0];
+  fds[1].events = POLLIN;
+
+  timespan_ms_t timeout = _stream.getTimeout();
+
+  for(;;)
+  {
+    fds[0].revents = fds[1].revents = 0;
+
+    int r = ::poll(fds, 2, (timeout > 0) ? static_cast<int>(timeout) : -1);
+    if(r < 0)
+    {
+      if(errno == EINTR)
+        continue;
+      else
+        throw IOException(System::getErrorString("poll"));
+    }
+    else if(r == 0)
+      throw TimeoutException();
+
+    break;
+  }
+
+  if(fds[1].revents & POLLIN)
+  {
+    // consume the wakeup
+
+    byte_t buf[64];
+    while(::read(_wakeHandle[0], buf, sizeof(buf)) > 0)
+      ;
+
+    return(false);
+  }
+
+#endif
+
+  return(true);
+}
+
+/*
+ */
+
+void BlockReader::_interrupt()
+{
+#if defined(CCXX_OS_WINDOWS)
+
+  // the pending read is overlapped, so it can be cancelled from here
+  ::CancelIoEx(_stream._handle, NULL);
+
+#elif defined(HAVE_SYS_EVENTFD_H)
+
+  if(_wakeHandle[1] != CCXX_INVALID_FILE_HANDLE)
+  {
+    uint64_t one = 1;
+    if(::write(_wakeHandle[1], &one, sizeof(one)) != sizeof(one)) { }
+  }
+
+#else
+
+  // if the pipe is full, a wakeup is already pending
+  if(_wakeHandle[1] != CCXX_INVALID_FILE_HANDLE)
+  {
+    static const char data[1] = { '!' };
+    if(::write(_wakeHandle[1], data, sizeof(data)) != 1) { }
+  }
+
+#endif
+}
+
+} // namespace ccxx
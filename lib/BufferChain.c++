@@ -0,0 +1,271 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/BufferChain.h++"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ccxx {
+
+/*
+ */
+
+const size_t BufferChain::DEFAULT_BLOCK_SIZE = 4096;
+
+/*
+ */
+
+BufferChain::BufferChain(size_t blockSize /* = DEFAULT_BLOCK_SIZE */)
+  : _blockSize(blockSize ? blockSize : DEFAULT_BLOCK_SIZE),
+    _length(0)
+{
+}
+
+/*
+ */
+
+BufferChain::~BufferChain()
+{
+  clear();
+
+  for(std::vector<ByteBuffer*>::iterator iter = _spare.begin();
+      iter != _spare.end();
+      ++iter)
+    delete *iter;
+}
+
+/*
+ */
+
+byte_t* BufferChain::_reserve(size_t& count)
+{
+  // continue in the last buffer, if there is room in it
+
+  if(! _segments.empty())
+  {
+    Segment& last = _segments.back();
+
+    if(last.buffer != NULL)
+    {
+      size_t avail = last.buffer->getSize() - last.length;
+      if(avail > 0)
+      {
+        count = std::min(count, avail);
+        byte_t *p = last.data + last.length;
+        last.length += count;
+        _length += count;
+
+        return(p);
+      }
+    }
+  }
+
+  ByteBuffer *buffer;
+
+  if(_spare.empty())
+    buffer = new ByteBuffer(static_cast<uint_t>(_blockSize));
+  else
+  {
+    buffer = _spare.back();
+    _spare.pop_back();
+  }
+
+  count = std::min(count, _blockSize);
+  _segments.push_back(Segment(buffer->getBase(), count, buffer));
+  _length += count;
+
+  return(buffer->getBase());
+}
+
+/*
+ */
+
+void BufferChain::append(const byte_t* data, size_t count)
+{
+  while(count > 0)
+  {
+    size_t n = count;
+    byte_t *p = _reserve(n);
+
+    std::memcpy(p, data, n);
+    data += n;
+    count -= n;
+  }
+}
+
+/*
+ */
+
+void BufferChain::fill(byte_t value, size_t count)
+{
+  while(count > 0)
+  {
+    size_t n = count;
+    byte_t *p = _reserve(n);
+
+    std::memset(p, value, n);
+    count -= n;
+  }
+}
+
+/*
+ */
+
+void BufferChain::appendView(const byte_t* data, size_t count)
+{
+  if(count == 0)
+    return;
+
+  _segments.push_back(Segment(const_cast<byte_t *>(data), count, NULL));
+  _length += count;
+}
+
+/*
+ */
+
+void BufferChain::overwrite(size_t offset, const byte_t* data, size_t count)
+{
+  if((offset > _length) || (count > _length - offset))
+    throw OutOfBoundsException();
+
+  if(count == 0)
+    return; // the offset may be the end of the chain
+
+  std::vector<Segment>::iterator iter = _segments.begin();
+
+  // find the segment containing the offset
+
+  while(offset >= iter->length)
+  {
+    offset -= iter->length;
+    ++iter;
+  }
+
+  while(count > 0)
+  {
+    if(iter->buffer == NULL)
+      throw IOException("cannot overwrite a view");
+
+    size_t n = std::min(count, iter->length - offset);
+    std::memcpy(iter->data + offset, data, n);
+
+    data += n;
+    count -= n;
+    offset = 0;
+    ++iter;
+  }
+}
+
+/*
+ */
+
+void BufferChain::truncate(size_t length)
+{
+  while((_length > length) && ! _segments.empty())
+  {
+    Segment& last = _segments.back();
+    size_t excess = _length - length;
+
+    if(excess < last.length)
+    {
+      last.length -= excess;
+      _length = length;
+      break;
+    }
+
+    _length -= last.length;
+
+    if(last.buffer != NULL)
+      _spare.push_back(last.buffer);
+
+    _segments.pop_back();
+  }
+}
+
+/*
+ */
+
+uint_t BufferChain::getSegments(MemoryBlock* vec, uint_t count,
+                                uint_t index /* = 0 */) const
+{
+  uint_t n = 0;
+
+  for(; (n < count) && (index < _segments.size()); ++n, ++index)
+  {
+    const Segment& seg = _segments[index];
+    vec[n] = MemoryBlock(seg.data, seg.length);
+  }
+
+  return(n);
+}
+
+/*
+ */
+
+size_t BufferChain::write(Stream& stream)
+{
+  MemoryBlock vec[16];
+  uint_t maxBlocks = std::min(Stream::MAX_IOBLOCK_COUNT,
+                              static_cast<uint_t>(CCXX_LENGTHOF(vec)));
+  uint_t index = 0;
+  size_t offset = 0; // offset within the segment at index
+  size_t total = 0;
+
+  while(total < _length)
+  {
+    uint_t n = getSegments(vec, maxBlocks, index);
+
+    // the first segment may have been partially written
+
+    vec[0] = MemoryBlock(vec[0].getBase() + offset,
+                         vec[0].getSize() - offset);
+
+    size_t r = stream.write(vec, n);
+    if(r == 0)
+      throw IOException("short write");
+
+    total += r;
+
+    // advance past the data written
+
+    r += offset;
+    while((index < _segments.size()) && (r >= _segments[index].length))
+    {
+      r -= _segments[index].length;
+      ++index;
+    }
+
+    offset = r;
+  }
+
+  clear();
+
+  return(total);
+}
+
+
+} // namespace ccxx
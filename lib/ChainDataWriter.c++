@@ -0,0 +1,167 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#include "commonc++/ChainDataWriter.h++"
+
+#include <algorithm>
+
+namespace ccxx {
+
+/*
+ */
+
+ChainDataWriter::ChainDataWriter(BufferChain& chain,
+                                 Stream* stream /* = NULL */)
+  : _chain(chain),
+    _stream(stream),
+    _start(chain.getLength()),
+    _base(static_cast<int64_t>(_start))
+{
+}
+
+/*
+ */
+
+ChainDataWriter::~ChainDataWriter()
+{
+}
+
+/*
+ */
+
+void ChainDataWriter::reset()
+{
+  DataWriter::reset();
+
+  // discard everything written through this writer since the last flush
+  _chain.truncate(_start);
+  _base = static_cast<int64_t>(_start);
+}
+
+/*
+ */
+
+size_t ChainDataWriter::_overwrite(const byte_t* buf, size_t count,
+                                   byte_t fillByte)
+{
+  // overwrite whatever portion of the range is already in the chain (after
+  // a backward seek), and return the number of bytes so consumed
+
+  int64_t off = _base + getCumulativeOffset();
+  if(off < 0)
+    throw IOException("data already flushed");
+
+  size_t pos = static_cast<size_t>(off);
+  size_t len = _chain.getLength();
+
+  if(pos >= len)
+    return(0);
+
+  size_t n = std::min(count, len - pos);
+
+  if(buf)
+    _chain.overwrite(pos, buf, n);
+  else
+  {
+    byte_t fill[256];
+    std::fill(fill, fill + sizeof(fill), fillByte);
+
+    for(size_t done = 0; done < n;)
+    {
+      size_t k = std::min(n - done, sizeof(fill));
+      _chain.overwrite(pos + done, fill, k);
+      done += k;
+    }
+  }
+
+  return(n);
+}
+
+/*
+ */
+
+void ChainDataWriter::skip(size_t count)
+{
+  skip(count, 0);
+}
+
+/*
+ */
+
+void ChainDataWriter::skip(size_t count, byte_t fillByte)
+{
+  Context &ctx = currentContext();
+
+  checkRemaining(ctx, count);
+
+  size_t n = _overwrite(NULL, count, fillByte);
+  _chain.fill(fillByte, count - n);
+  ctx.bumpOffset(count);
+}
+
+/*
+ */
+
+void ChainDataWriter::flush()
+{
+  if(_stream)
+  {
+    // the chain is emptied; data at offsets before the current one can no
+    // longer be overwritten
+
+    _chain.write(*_stream);
+    _start = 0;
+    _base = -getCumulativeOffset();
+  }
+}
+
+/*
+ */
+
+void ChainDataWriter::setOffset(int64_t offset)
+{
+  Context &ctx = currentContext();
+
+  if((offset >= 0) && (offset <= ctx.maxOffset))
+    ctx.offset = offset;
+  else
+    throw IOException("out of bounds");
+}
+
+/*
+ */
+
+size_t ChainDataWriter::write(const byte_t* buf, size_t count)
+{
+  Context &ctx = currentContext();
+
+  checkRemaining(ctx, count);
+
+  size_t n = _overwrite(buf, count, 0);
+  _chain.append(buf + n, count - n);
+  ctx.bumpOffset(count);
+
+  return(count);
+}
+
+
+} // namespace ccxx
@@ -0,0 +1,516 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/ConnectionPool.h++"
+#include "commonc++/ScopedLock.h++"
+#include "commonc++/System.h++"
+
+#include <algorithm>
+#include <list>
+#include <map>
+
+namespace ccxx {
+
+/*
+ */
+
+class ConnectionPool::PoolState
+{
+ public:
+
+  enum EntryState { Connecting, InUse, Idle, Evicted };
+
+  struct Entry
+  {
+    Entry()
+      : handler(NULL), state(Connecting), idleSince(INT64_CONST(0)),
+        pins(0), closed(false)
+    { }
+
+    String key;
+    EventHandler<Connection*>* handler;
+    EntryState state;
+    time_ms_t idleSince;
+    // the number of acquire() calls passing the connection to a handler
+    uint_t pins;
+    // set if the connection was closed while it was pinned
+    bool closed;
+  };
+
+  typedef std::map<Connection*, Entry> EntryMap;
+  typedef std::list<Connection*> IdleList;
+  typedef std::map<String, IdleList> IdleMap;
+
+  EntryMap entries;
+  IdleMap idle;
+  bool sweeping;
+};
+
+/*
+ */
+
+ConnectionPool::ConnectionPool(uint_t maxConnections /* = 64 */,
+                               uint_t maxIdlePerEndpoint /* = 4 */,
+                               timespan_ms_t connectTimeout /* = 5000 */,
+                               timespan_ms_t maxIdleTime /* = 60000 */)
+  : SocketSelector(maxConnections, 0),
+    _state(new PoolState()),
+    _maxIdle(maxIdlePerEndpoint),
+    _connectTimeout(connectTimeout),
+    _maxIdleTime(maxIdleTime),
+    _sweeper(this, &ConnectionPool::_sweep)
+{
+  _state->sweeping = false;
+}
+
+/*
+ */
+
+ConnectionPool::~ConnectionPool()
+{
+  delete _state;
+}
+
+/*
+ */
+
+bool ConnectionPool::init()
+{
+  if(! SocketSelector::init())
+    return(false);
+
+  bool sweep = false;
+
+  {
+    ScopedLock lock(_lock);
+
+    if((_maxIdleTime > 0) && ! _state->sweeping)
+      sweep = _state->sweeping = true;
+  }
+
+  // the pool lock is never held while calling into the selector
+
+  if(sweep)
+    schedule(std::max(_maxIdleTime / 2, 100), &_sweeper);
+
+  return(true);
+}
+
+/*
+ */
+
+bool ConnectionPool::acquire(const SocketAddress& endpoint,
+                             EventHandler<Connection*>* handler)
+{
+  String key = endpoint.toString();
+  Connection* conn = NULL;
+  bool evicted = false;
+
+  {
+    ScopedLock lock(_lock);
+
+    time_ms_t now = System::currentTimeMillis();
+    PoolState::IdleMap::iterator iter = _state->idle.find(key);
+
+    if(iter != _state->idle.end())
+    {
+      PoolState::IdleList& list = iter->second;
+
+      // take the most recently released connection first
+
+      while(! list.empty())
+      {
+        Connection* c = list.back();
+        list.pop_back();
+
+        PoolState::Entry& entry = _state->entries[c];
+
+        if(_isHealthy(c) && ((_maxIdleTime <= 0)
+                             || ((now - entry.idleSince) <= _maxIdleTime)))
+        {
+          // pin the connection, so that the selector can't delete it
+          // before the handler has been called
+
+          entry.state = PoolState::InUse;
+          ++entry.pins;
+          conn = c;
+          break;
+        }
+
+        _evict(c);
+        evicted = true;
+      }
+    }
+  }
+
+  if(evicted)
+    wakeup();
+
+  if(conn)
+  {
+    (*handler)(conn);
+
+    bool closed = false;
+
+    {
+      ScopedLock lock(_lock);
+
+      PoolState::Entry& entry = _state->entries[conn];
+      closed = ((--entry.pins == 0) && entry.closed);
+    }
+
+    // the selector closed the connection while it was pinned
+
+    if(closed)
+      _closed(conn);
+
+    return(true);
+  }
+
+  // no idle connection; begin a new one
+
+  conn = createConnection(endpoint);
+
+  {
+    ScopedLock lock(_lock);
+
+    PoolState::Entry& entry = _state->entries[conn];
+    entry.key = key;
+    entry.handler = handler;
+  }
+
+  if(! connect(endpoint, conn, _connectTimeout))
+  {
+    {
+      ScopedLock lock(_lock);
+      _state->entries.erase(conn);
+    }
+
+    delete conn;
+    return(false);
+  }
+
+  return(true);
+}
+
+/*
+ */
+
+void ConnectionPool::release(Connection* connection)
+{
+  bool evicted = false;
+
+  {
+    ScopedLock lock(_lock);
+
+    PoolState::EntryMap::iterator iter = _state->entries.find(connection);
+    if(iter == _state->entries.end())
+      return;
+
+    PoolState::Entry& entry = iter->second;
+    if(entry.state != PoolState::InUse)
+      return;
+
+    if(entry.closed)
+    {
+      // already closed by the selector while pinned; acquire() deletes it
+
+      entry.state = PoolState::Evicted;
+      return;
+    }
+
+    PoolState::IdleList& list = _state->idle[entry.key];
+
+    if(_isHealthy(connection) && (list.size() < _maxIdle))
+    {
+      entry.state = PoolState::Idle;
+      entry.idleSince = System::currentTimeMillis();
+      list.push_back(connection);
+    }
+    else
+    {
+      _evict(connection);
+      evicted = true;
+    }
+  }
+
+  if(evicted)
+    wakeup();
+}
+
+/*
+ */
+
+uint_t ConnectionPool::getIdleCount() const
+{
+  ScopedLock lock(_lock);
+
+  uint_t count = 0;
+
+  for(PoolState::IdleMap::const_iterator iter = _state->idle.begin();
+      iter != _state->idle.end();
+      ++iter)
+  {
+    count += static_cast<uint_t>(iter->second.size());
+  }
+
+  return(count);
+}
+
+/*
+ */
+
+uint_t ConnectionPool::getIdleCount(const SocketAddress& endpoint) const
+{
+  ScopedLock lock(_lock);
+
+  PoolState::IdleMap::const_iterator iter
+    = _state->idle.find(endpoint.toString());
+
+  if(iter == _state->idle.end())
+    return(0);
+
+  return(static_cast<uint_t>(iter->second.size()));
+}
+
+/*
+ */
+
+void ConnectionPool::connectionLost(Connection* connection)
+{
+  // no-op
+}
+
+/*
+ */
+
+Connection* ConnectionPool::connectionReady(const SocketAddress& address)
+{
+  return(NULL);
+}
+
+/*
+ */
+
+void ConnectionPool::dataReceived(Connection* connection)
+{
+  bool inUse = false;
+  bool evicted = false;
+
+  {
+    ScopedLock lock(_lock);
+
+    PoolState::EntryMap::iterator iter = _state->entries.find(connection);
+    if(iter == _state->entries.end())
+      return;
+
+    PoolState::Entry& entry = iter->second;
+
+    if(entry.state == PoolState::InUse)
+      inUse = true;
+    else if(entry.state == PoolState::Idle)
+    {
+      // the connection is out of sync with the peer
+
+      _state->idle[entry.key].remove(connection);
+      _evict(connection);
+      evicted = true;
+    }
+  }
+
+  if(evicted)
+    wakeup();
+
+  if(inUse)
+    connectionDataReceived(connection);
+}
+
+/*
+ */
+
+void ConnectionPool::connectionEstablished(Connection* connection)
+{
+  EventHandler<Connection*>* handler = NULL;
+
+  {
+    ScopedLock lock(_lock);
+
+    PoolState::EntryMap::iterator iter = _state->entries.find(connection);
+    if(iter == _state->entries.end())
+      return;
+
+    handler = iter->second.handler;
+    iter->second.handler = NULL;
+    iter->second.state = PoolState::InUse;
+  }
+
+  if(handler)
+    (*handler)(connection);
+}
+
+/*
+ */
+
+void ConnectionPool::connectionFailed(Connection* connection)
+{
+  _closed(connection);
+}
+
+/*
+ */
+
+void ConnectionPool::connectionClosed(Connection* connection)
+{
+  _closed(connection);
+}
+
+/*
+ */
+
+void ConnectionPool::connectionTimedOut(Connection* connection)
+{
+  _closed(connection);
+}
+
+/*
+ */
+
+void ConnectionPool::_closed(Connection* connection)
+{
+  PoolState::Entry entry;
+
+  {
+    ScopedLock lock(_lock);
+
+    PoolState::EntryMap::iterator iter = _state->entries.find(connection);
+    if(iter != _state->entries.end())
+    {
+      if(iter->second.pins > 0)
+      {
+        // acquire() finishes the close once the handler returns
+
+        iter->second.closed = true;
+        return;
+      }
+
+      entry = iter->second;
+
+      if(entry.state == PoolState::Idle)
+        _state->idle[entry.key].remove(connection);
+
+      _state->entries.erase(iter);
+    }
+  }
+
+  if(entry.state == PoolState::Connecting)
+  {
+    if(entry.handler)
+      (*entry.handler)(NULL);
+  }
+  else if(entry.state == PoolState::InUse)
+    connectionLost(connection);
+
+  delete connection;
+}
+
+/*
+ */
+
+void ConnectionPool::_evict(Connection* connection)
+{
+  // called with _lock held; the selector finishes the close, and the
+  // connection is deleted in connectionClosed()
+
+  _state->entries[connection].state = PoolState::Evicted;
+  connection->close();
+}
+
+/*
+ */
+
+bool ConnectionPool::_isHealthy(Connection* connection) const
+{
+  StreamSocket* sock = connection->getSocket();
+
+  // unexpected data on an idle connection means it is out of sync with
+  // the peer, so it is not reusable
+
+  return((sock != NULL) && sock->isConnected()
+         && ! connection->isClosePending()
+         && (connection->getBytesAvailableToRead() == 0));
+}
+
+/*
+ */
+
+void ConnectionPool::_sweep(bool ok)
+{
+  if(! ok)
+  {
+    // selector is shutting down; let a later init() restart the sweeper
+
+    ScopedLock lock(_lock);
+    _state->sweeping = false;
+    return;
+  }
+
+  bool evicted = false;
+
+  {
+    ScopedLock lock(_lock);
+
+    time_ms_t now = System::currentTimeMillis();
+
+    for(PoolState::IdleMap::iterator iter = _state->idle.begin();
+        iter != _state->idle.end();
+        ++iter)
+    {
+      PoolState::IdleList& list = iter->second;
+
+      for(PoolState::IdleList::iterator it = list.begin(); it != list.end(); )
+      {
+        Connection* conn = *it;
+
+        if(((now - _state->entries[conn].idleSince) > _maxIdleTime)
+           || ! _isHealthy(conn))
+        {
+          _evict(conn);
+          evicted = true;
+          it = list.erase(it);
+        }
+        else
+          ++it;
+      }
+    }
+  }
+
+  if(evicted)
+    wakeup();
+
+  schedule(std::max(_maxIdleTime / 2, 100), &_sweeper);
+}
+
+} // namespace ccxx
@@ -26,17 +26,85 @@
 
 #include "commonc++/ConsoleLogger.h++"
 #include "commonc++/Char.h++"
+#include "commonc++/ScopedLock.h++"
+#include "commonc++/System.h++"
 
 #include <cstdio>
+#include <cstring>
+
+#ifdef CCXX_OS_POSIX
+#include <unistd.h>
+#endif
 
 namespace ccxx {
 
+const size_t ConsoleLogger::DEFAULT_BUFFER_SIZE = 65536;
+
+const timespan_ms_t ConsoleLogger::DEFAULT_FLUSH_INTERVAL = 1000;
+
+/*
+ */
+
+static void __claim(AtomicCounter& flag)
+{
+  // the flag is only contended by flushOnCrash(), which never waits for it
+
+  while(flag.testAndSet(1, 0) != 0)
+    Thread::sleep(1);
+}
+
+/*
+ * Holds the buffer lock, and marks the buffer as in use while it is held,
+ * so that flushOnCrash() can test the mark rather than take the lock.
+ */
+
+class ConsoleLogger::BufferGuard
+{
+ public:
+
+  BufferGuard(ConsoleLogger& logger)
+    : _logger(logger)
+  {
+    _logger._bufferLock.lock();
+    __claim(_logger._bufferBusy);
+  }
+
+  ~BufferGuard()
+  {
+    _logger._bufferBusy.set(0);
+    _logger._bufferLock.unlock();
+  }
+
+ private:
+
+  ConsoleLogger& _logger;
+};
+
 /*
  */
 
 ConsoleLogger::ConsoleLogger(const String &format /* = "[%d %t] %@%m%." */)
-  : Logger(format)
+  : Logger(format),
+    _terminal(true),
+    _pending(NULL),
+    _flushInterval(DEFAULT_FLUSH_INTERVAL),
+    _pendingSince(0),
+    _flushRunner(this, &ConsoleLogger::_runFlusher),
+    _flusher(NULL),
+    _stopping(false)
 {
+#ifdef CCXX_OS_WINDOWS
+  _terminal = (::GetFileType(::GetStdHandle(STD_ERROR_HANDLE))
+               == FILE_TYPE_CHAR);
+#else
+  _terminal = (::isatty(STDERR_FILENO) != 0);
+#endif
+
+  if(! _terminal)
+  {
+    getLogFormat().setStylesEnabled(false);
+    _pending = new CharBuffer(static_cast<uint_t>(DEFAULT_BUFFER_SIZE));
+  }
 }
 
 /*
@@ -44,6 +112,148 @@ ConsoleLogger::ConsoleLogger(const String &format /* = "[%d %t] %@%m%." */)
 
 ConsoleLogger::~ConsoleLogger()
 {
+  if(_flusher)
+  {
+    synchronized(_bufferLock)
+    {
+      _stopping = true;
+      _flushCond.notify();
+    }
+
+    _flusher->join();
+    delete _flusher;
+  }
+
+  _flush();
+  delete _pending;
+}
+
+/*
+ */
+
+void ConsoleLogger::setBufferSize(size_t bufferSize)
+{
+  BufferGuard guard(*this);
+
+  _flush();
+
+  delete _pending;
+  _pending = NULL;
+
+  if(! _terminal && (bufferSize > 0))
+    _pending = new CharBuffer(static_cast<uint_t>(bufferSize));
+}
+
+/*
+ */
+
+void ConsoleLogger::setFlushInterval(timespan_ms_t flushInterval)
+{
+  synchronized(_bufferLock)
+  {
+    _flushInterval = (flushInterval < 0) ? 0 : flushInterval;
+    _flushCond.notify();
+  }
+}
+
+/*
+ */
+
+void ConsoleLogger::vlog(LogLevel level, const char* file, int line,
+                         const char* message, va_list args)
+{
+  Logger::vlog(level, file, line, message, args);
+
+  // don't hold back anything that may precede a crash
+
+  if(level & (LogWarning | LogError))
+    flush();
+}
+
+/*
+ */
+
+void ConsoleLogger::flush()
+{
+  BufferGuard guard(*this);
+
+  _flush();
+}
+
+/*
+ */
+
+#ifdef CCXX_OS_POSIX
+
+static bool __writeOnCrash(const char* buf, size_t buflen)
+{
+  // stdio is not async-signal-safe
+
+  while(buflen > 0)
+  {
+    ssize_t r = ::write(STDERR_FILENO, buf, buflen);
+    if(r <= 0)
+      return(false);
+
+    buf += r;
+    buflen -= static_cast<size_t>(r);
+  }
+
+  return(true);
+}
+
+#endif
+
+/*
+ */
+
+void ConsoleLogger::flushOnCrash()
+{
+#ifdef CCXX_OS_POSIX
+
+  if(_bufferBusy.testAndSet(1, 0) != 0)
+    return;
+
+  if(_pending && (_pending->getPosition() > 0))
+  {
+    _pending->flip();
+    __writeOnCrash(_pending->getPointer(), _pending->getRemaining());
+    _pending->clear();
+  }
+
+  _bufferBusy.set(0);
+
+#endif
+}
+
+/*
+ */
+
+bool ConsoleLogger::writeOnCrash(CharBuffer& buffer)
+{
+  bool ok = false;
+
+#ifdef CCXX_OS_POSIX
+
+  if(_bufferBusy.testAndSet(1, 0) != 0)
+    return(false);
+
+  if(_pending && (_pending->getPosition() > 0))
+  {
+    _pending->flip();
+    __writeOnCrash(_pending->getPointer(), _pending->getRemaining());
+    _pending->clear();
+  }
+
+  ok = __writeOnCrash(buffer.getPointer(), buffer.getRemaining());
+  if(ok)
+    buffer.bump(buffer.getRemaining());
+
+  _bufferBusy.set(0);
+
+#endif
+
+  return(ok);
 }
 
 /*
@@ -51,16 +261,109 @@ ConsoleLogger::~ConsoleLogger()
 
 bool ConsoleLogger::write(CharBuffer &buffer)
 {
+  BufferGuard guard(*this);
+
+  size_t sz = buffer.getRemaining();
+
+  if(! _pending || (sz >= _pending->getSize()))
+  {
+    // unbuffered, or too large to be worth copying
+
+    _flush();
+
 #ifdef CCXX_OS_WINDOWS
-  writeANSIString(buffer.getPointer(), buffer.getRemaining());
-#else
-  std::fwrite(buffer.getPointer(), 1, buffer.getRemaining(), stderr);
-  std::fflush(stderr);
+    if(_terminal)
+    {
+      writeANSIString(buffer.getPointer(), sz);
+      return(true);
+    }
 #endif
 
+    _write(buffer.getPointer(), sz);
+    return(true);
+  }
+
+  if(sz > _pending->getRemaining())
+    _flush();
+
+  if(_pending->getPosition() == 0)
+  {
+    _pendingSince = System::currentTimeMillis();
+
+    if(! _flusher)
+    {
+      _flusher = new Thread(&_flushRunner);
+      _flusher->start();
+    }
+
+    _flushCond.notify();
+  }
+
+  std::memcpy(_pending->getPointer(), buffer.getPointer(), sz);
+  _pending->bump(static_cast<uint_t>(sz));
+  buffer.bump(static_cast<uint_t>(sz));
+
+  if(! _pending->hasRemaining()
+     || (System::currentTimeMillis() - _pendingSince >= _flushInterval))
+    _flush();
+
   return(true);
 }
 
+/*
+ */
+
+void ConsoleLogger::_flush()
+{
+  if(! _pending || (_pending->getPosition() == 0))
+    return;
+
+  _pending->flip();
+  _write(_pending->getPointer(), _pending->getRemaining());
+  _pending->clear();
+}
+
+/*
+ */
+
+void ConsoleLogger::_runFlusher()
+{
+  synchronized(_bufferLock)
+  {
+    while(! _stopping)
+    {
+      if(_pending && (_pending->getPosition() > 0))
+      {
+        time_ms_t age = System::currentTimeMillis() - _pendingSince;
+
+        if((age >= 0) && (age < _flushInterval))
+        {
+          _flushCond.wait(_bufferLock,
+                          static_cast<uint_t>(_flushInterval - age));
+          continue;
+        }
+
+        __claim(_bufferBusy);
+        _flush();
+        _bufferBusy.set(0);
+      }
+
+      // nothing is buffered; wait until something is
+
+      _flushCond.wait(_bufferLock);
+    }
+  }
+}
+
+/*
+ */
+
+void ConsoleLogger::_write(const char *buf, size_t buflen)
+{
+  std::fwrite(buf, 1, buflen, stderr);
+  std::fflush(stderr);
+}
+
 /*
  */
 
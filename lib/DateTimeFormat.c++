@@ -202,6 +202,19 @@ size_t DateTimeFormat::format(const DateTime& value, char* buf, size_t bufsz)
   return(_format(_dateTimeFormat, value, builder));
 }
 
+/*
+ */
+
+size_t DateTimeFormat::format(const DateTime& value, char* buf, size_t bufsz,
+                              size_t* offsets, char* pads, uint_t maxFields,
+                              uint_t& numFields) const
+{
+  CStringBuilder builder(buf, bufsz);
+  numFields = 0;
+  return(_format(_dateTimeFormat, value, builder, offsets, pads, maxFields,
+                 &numFields));
+}
+
 /*
  */
 
@@ -502,6 +515,11 @@ void DateTimeFormat::_parseFormat(const String& format, TokenList* tokens)
   size_t textLen = 0;
   TokenFormat tokFmt = FMT_INVALID;
 
+  // discard any previously parsed format
+
+  std::for_each(tokens->begin(), tokens->end(), DeleteFunctor());
+  tokens->clear();
+
   CString cstr_format = format.toUTF8();
   const char *fmt = cstr_format.data();
   for(const char *p = fmt; *p; ++p)
@@ -675,7 +693,11 @@ void DateTimeFormat::_formatNumeric(String& s, uint_t val, uint_t width,
  */
 
 size_t DateTimeFormat::_format(const TokenList* tokens, const DateTime& value,
-                               CStringBuilder& builder) const
+                               CStringBuilder& builder,
+                               size_t* offsets /* = NULL */,
+                               char* pads /* = NULL */,
+                               uint_t maxFields /* = 0 */,
+                               uint_t* numFields /* = NULL */) const
 {
   #ifndef CCXX_OS_ANDROID
   uint_t val = 0;
@@ -714,6 +736,19 @@ size_t DateTimeFormat::_format(const TokenList* tokens, const DateTime& value,
         break;
 
       case TOK_MSEC:
+        if(numFields)
+        {
+          // only report fields that will be written in full
+
+          if((*numFields < maxFields) && (builder.getRemaining() >= 3))
+          {
+            offsets[*numFields] = builder.getLength();
+            pads[*numFields] = (fmt == FMT_NUMERIC_0 ? '0' : ' ');
+          }
+
+          ++(*numFields);
+        }
+
         builder.append(value.getMillisecond(), 3,
                        (fmt == FMT_NUMERIC_0 ? '0' : NUL));
         break;
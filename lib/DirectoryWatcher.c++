@@ -32,6 +32,7 @@
 #include <sys/event.h>
 #include <sys/fcntl.h>
 #else
+#include <fcntl.h>
 #include <limits.h>
 #ifdef HAVE_SYS_INOTIFY_H
 #include <sys/inotify.h>
@@ -96,6 +97,9 @@ void DirectoryWatcher::init()
   if(_handle == -1)
     throw SystemException(System::getErrorString("inotify_init"));
 
+  // nonblocking, so that processEvents() never blocks the caller
+  ::fcntl(_handle, F_SETFL, ::fcntl(_handle, F_GETFL, 0) | O_NONBLOCK);
+
   CString cstr_directory = _directory.toUTF8();
   _watch = ::inotify_add_watch(_handle, cstr_directory.data(),
                                (IN_CREATE | IN_DELETE | IN_MODIFY | IN_MOVE));
@@ -152,8 +156,6 @@ void DirectoryWatcher::run()
   if(!_initialized)
     return;
 
-  String oldPath;
-
 #if defined(CCXX_OS_WINDOWS)
 
   char buf[4096];
@@ -203,12 +205,12 @@ void DirectoryWatcher::run()
           break;
 
         case FILE_ACTION_RENAMED_OLD_NAME:
-          oldPath = path;
+          _oldPath = path;
           break;
 
         case FILE_ACTION_RENAMED_NEW_NAME:
-          fileRenamed(oldPath, path);
-          oldPath.clear();
+          fileRenamed(_oldPath, path);
+          _oldPath.clear();
           break;
 
         default:
@@ -247,7 +249,6 @@ void DirectoryWatcher::run()
 
 #elif defined(HAVE_INOTIFY_INIT)
 
-  char buf[sizeof(struct inotify_event) + PATH_MAX];
   fd_set fds;
 
   while(! testCancel())
@@ -266,38 +267,63 @@ void DirectoryWatcher::run()
         break;
     }
     else if(r > 0)
-    {
-      char *p = buf;
-      r = ::read(_handle, buf, sizeof(buf));
+      processEvents();
+  }
 
-      while(r > 0)
-      {
-        struct inotify_event *event = (struct inotify_event *)p;
-        String path = event->name;
+#endif
+}
 
-        if(event->mask & IN_CREATE)
-          fileCreated(path);
-        else if(event->mask & IN_DELETE)
-          fileDeleted(path);
-        else if(event->mask & IN_MODIFY)
-          fileModified(path);
-        else if(event->mask & IN_MOVED_FROM)
-          oldPath = path;
-        else if(event->mask & IN_MOVED_TO)
-        {
-          fileRenamed(oldPath, path);
-          oldPath.clear();
-        }
-
-        size_t len = sizeof(struct inotify_event) + event->len;
-        p += len;
-        r -= len;
-      }
+/*
+ */
+
+FileHandle DirectoryWatcher::getEventHandle() const
+{
+#if defined(HAVE_INOTIFY_INIT)
+  return(_handle);
+#else
+  return(CCXX_INVALID_FILE_HANDLE);
+#endif
+}
+
+/*
+ */
+
+void DirectoryWatcher::processEvents()
+{
+#if defined(HAVE_INOTIFY_INIT)
+
+  if(! _initialized)
+    return;
+
+  char buf[sizeof(struct inotify_event) + PATH_MAX];
+  char *p = buf;
+  ssize_t r = ::read(_handle, buf, sizeof(buf));
+
+  while(r > 0)
+  {
+    struct inotify_event *event = (struct inotify_event *)p;
+    String path = event->name;
+
+    if(event->mask & IN_CREATE)
+      fileCreated(path);
+    else if(event->mask & IN_DELETE)
+      fileDeleted(path);
+    else if(event->mask & IN_MODIFY)
+      fileModified(path);
+    else if(event->mask & IN_MOVED_FROM)
+      _oldPath = path;
+    else if(event->mask & IN_MOVED_TO)
+    {
+      fileRenamed(_oldPath, path);
+      _oldPath.clear();
     }
+
+    ssize_t len = sizeof(struct inotify_event) + event->len;
+    p += len;
+    r -= len;
   }
 
 #endif
 }
 
-
 } // namespace ccxx
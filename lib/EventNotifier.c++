@@ -0,0 +1,157 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/EventNotifier.h++"
+#include "commonc++/System.h++"
+
+#ifdef CCXX_OS_POSIX
+#include <fcntl.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+#include <unistd.h>
+#endif
+
+namespace ccxx {
+
+/*
+ */
+
+EventNotifier::EventNotifier()
+  : _initialized(false)
+{
+  _handle[0] = _handle[1] = CCXX_INVALID_FILE_HANDLE;
+}
+
+/*
+ */
+
+EventNotifier::~EventNotifier()
+{
+#ifdef CCXX_OS_POSIX
+
+  if(_handle[0] != CCXX_INVALID_FILE_HANDLE)
+    ::close(_handle[0]);
+
+  if(_handle[1] != _handle[0])
+    ::close(_handle[1]);
+
+#endif
+}
+
+/*
+ */
+
+void EventNotifier::init()
+{
+  if(_initialized)
+    return;
+
+#if defined(HAVE_SYS_EVENTFD_H)
+
+  int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if(fd < 0)
+    throw SystemException(System::getErrorString("eventfd"));
+
+  _handle[0] = _handle[1] = fd;
+
+#elif defined(CCXX_OS_POSIX)
+
+  if(::pipe(_handle) != 0)
+    throw SystemException(System::getErrorString("pipe"));
+
+  ::fcntl(_handle[0], F_SETFL, O_NONBLOCK);
+  ::fcntl(_handle[1], F_SETFL, O_NONBLOCK);
+
+#else
+
+  throw SystemException("Not implemented");
+
+#endif
+
+  _initialized = true;
+}
+
+/*
+ */
+
+void EventNotifier::notify()
+{
+  if(! _initialized)
+    return;
+
+#if defined(HAVE_SYS_EVENTFD_H)
+
+  uint64_t one = 1;
+  if(::write(_handle[1], &one, sizeof(one)) != sizeof(one)) { /* ignore */ }
+
+#elif defined(CCXX_OS_POSIX)
+
+  // if the pipe is full, a notification is already pending
+  static const char data[1] = { '!' };
+  if(::write(_handle[1], data, sizeof(data)) != 1) { /* ignore */ }
+
+#endif
+}
+
+/*
+ */
+
+FileHandle EventNotifier::getEventHandle() const
+{
+  return(_handle[0]);
+}
+
+/*
+ */
+
+void EventNotifier::processEvents()
+{
+  if(! _initialized)
+    return;
+
+  uint64_t count = 0;
+
+#if defined(HAVE_SYS_EVENTFD_H)
+
+  if(::read(_handle[0], &count, sizeof(count)) != sizeof(count))
+    return;
+
+#elif defined(CCXX_OS_POSIX)
+
+  char buf[256];
+  ssize_t r;
+
+  while((r = ::read(_handle[0], buf, sizeof(buf))) > 0)
+    count += r;
+
+#endif
+
+  if(count > 0)
+    notified(count);
+}
+
+} // namespace ccxx
@@ -25,9 +25,11 @@
 #endif
 
 #include "commonc++/File.h++"
+#include "commonc++/EncodingException.h++"
 #include "commonc++/FilePtr.h++"
 #include "commonc++/FileTraverser.h++"
-#include "commonc++/UTF8Decoder.h++"
+#include "commonc++/MemoryMappedFile.h++"
+#include "commonc++/UnsupportedOperationException.h++"
 
 #ifdef CCXX_OS_WINDOWS
 #include "commonc++/Windows.h++"
@@ -47,6 +49,15 @@
 #include <fcntl.h>
 #include <utime.h>
 #include <unistd.h>
+#include <sys/ioctl.h>
+
+#ifdef HAVE_LINUX_FS_H
+#include <linux/fs.h>
+#endif
+
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 #endif
 
 #include "commonc++/System.h++"
@@ -66,8 +77,11 @@
 #include <sys/mount.h>
 #endif
 
+#include <algorithm>
+#include <climits>
 #include <cstdio>
 #include <cerrno>
+#include <vector>
 
 namespace ccxx {
 
@@ -126,7 +140,8 @@ class FileTreeDeleter : public FileTraverser
  */
 
 File::File(const String& path)
-  : _name(path)
+  : _name(path),
+    _directIO(false)
 {
 }
 
@@ -180,6 +195,10 @@ void File::open(IOMode mode /* = IOReadWrite */,
     case FileTruncateElseCreate:
       disp = CREATE_ALWAYS;
       break;
+
+    case FileAppendElseCreate:
+      disp = OPEN_ALWAYS;
+      break;
   }
 
   switch(mode)
@@ -201,10 +220,20 @@ void File::open(IOMode mode /* = IOReadWrite */,
       break;
   }
 
+  // a handle with append access but without write access always writes at
+  // the end of the file
+
+  if((openMode == FileAppendElseCreate) && canWrite)
+    f = (f & ~FILE_WRITE_DATA) | FILE_APPEND_DATA;
+
   share = (FILE_SHARE_READ | FILE_SHARE_WRITE);
 
-  FileHandle r = ::CreateFileW(_name.data(), f, share, &sa, disp,
-                              FILE_FLAG_OVERLAPPED, NULL);
+  DWORD flags = FILE_FLAG_OVERLAPPED;
+  if(_directIO)
+    flags |= (FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH);
+
+  FileHandle r = ::CreateFileW(_name.data(), f, share, &sa, disp, flags,
+                               NULL);
 
   if(r == CCXX_INVALID_FILE_HANDLE)
   {
@@ -243,6 +272,10 @@ void File::open(IOMode mode /* = IOReadWrite */,
     case FileTruncateElseCreate:
       flags |= (O_CREAT | O_TRUNC);
       break;
+
+    case FileAppendElseCreate:
+      flags |= (O_CREAT | O_APPEND);
+      break;
   }
 
   switch(mode)
@@ -264,6 +297,11 @@ void File::open(IOMode mode /* = IOReadWrite */,
       break;
   }
 
+#ifdef O_DIRECT
+  if(_directIO)
+    flags |= O_DIRECT;
+#endif
+
   CString cstr_name = _name.toUTF8();
   FileHandle r = ::open(cstr_name.data(), flags, perm_);
   if(r < 0)
@@ -274,6 +312,15 @@ void File::open(IOMode mode /* = IOReadWrite */,
       throw IOException(System::getErrorString("open"));
   }
 
+#if ! defined(O_DIRECT) && defined(F_NOCACHE)
+  if(_directIO && (::fcntl(r, F_NOCACHE, 1) != 0))
+  {
+    String err = System::getErrorString("fcntl");
+    ::close(r);
+    throw IOException(err);
+  }
+#endif
+
 #endif
 
   Stream::_init(r, true, canRead, canWrite);
@@ -825,57 +872,74 @@ bool File::touch()
 
 String File::readToString(const String& path)
 {
-  String result;
-
-  char inputBuf[32768];
-  char16_t outputBuf[32768];
-  UTF8Decoder decoder;
-  char *input = inputBuf;
-  char16_t *output = outputBuf;
-  int inputLength = CCXX_LENGTHOF(inputBuf);
-  int outputLength = CCXX_LENGTHOF(outputBuf);
-  int inputCountLeft = 0;
-  int outputCountLeft = outputLength;
+  // Map regular files directly and decode them in a single pass; the
+  // decoder sizes the result exactly before decoding, so no intermediate
+  // copies or reallocations are needed.
 
-  FilePtr fp(path, "r");
-  if(!fp.isValid())
-    return(String::null);
+  int64_t size = isFile(path) ? getSize(path) : 0;
 
-  bool refill = true;
+  if(size > static_cast<int64_t>(INT_MAX))
+    return(String::null);
 
-  for(;;)
+  if(size > 0)
   {
-    if(refill)
+    try
     {
-      input = inputBuf;
-      inputCountLeft = ::fread(input, 1, inputLength, fp);
-      if(inputCountLeft <= 0)
-        break;
+      MemoryMappedFile mmf(path);
+      mmf.open(0, true);
+      mmf.advise(MemoryMappedFile::AdviseSequential);
 
-      refill = false;
+      return(String(reinterpret_cast<const char *>(mmf.getBase()), 0,
+                    static_cast<uint_t>(mmf.getSize())));
     }
-
-    int status = decoder.decode((const char **)&input, &inputCountLeft,
-                                &output, &outputCountLeft);
-
-    if(status == UTF8Decoder::STATUS_OUTPUT_BUFFER_FULL)
+    catch(const EncodingException&)
     {
-      result.append(output, outputLength - outputCountLeft);
-      output = outputBuf;
-      outputCountLeft = outputLength;
+      return(String::null);
     }
-    else if(status == UTF8Decoder::STATUS_NEED_MORE_INPUT)
-      refill = true;
-    else if(status == UTF8Decoder::STATUS_OK)
+    catch(const IOException&)
     {
-      result.append(output, outputLength - outputCountLeft);
-      break;
+      // fall through to the read() path
     }
-    else
+  }
+
+  // Special files (pipes, procfs entries, etc.) may report no size; read
+  // them fully into one buffer and decode that.
+
+  FilePtr fp(path, "r");
+  if(!fp.isValid())
+    return(String::null);
+
+  std::vector<char> buf;
+  size_t len = 0;
+
+  for(;;)
+  {
+    if(buf.size() - len < 32768)
+      buf.resize(std::max(buf.size() * 2, static_cast<size_t>(65536)));
+
+    size_t n = ::fread(&buf[len], 1, buf.size() - len, fp);
+    if(n == 0)
+      break;
+
+    len += n;
+    if(len > static_cast<size_t>(INT_MAX))
       return(String::null);
   }
 
-  return result;
+  if(::ferror(fp))
+    return(String::null);
+
+  if(len == 0)
+    return(String::empty);
+
+  try
+  {
+    return(String(&buf[0], 0, static_cast<uint_t>(len)));
+  }
+  catch(const EncodingException&)
+  {
+    return(String::null);
+  }
 }
 
 /*
@@ -1068,6 +1132,178 @@ void File::truncate(uint64_t size /* = 0 */)
   seek(0, SeekEnd);
 }
 
+/*
+ */
+
+void File::allocate(uint64_t offset, uint64_t length,
+                    FileAllocateMode mode /* = FileAllocateDefault */)
+{
+#ifdef CCXX_OS_WINDOWS
+
+  if(mode == FileAllocatePunchHole)
+    throw UnsupportedOperationException("hole punching not supported");
+
+  LARGE_INTEGER size;
+  if(::GetFileSizeEx(_handle, &size) == FALSE)
+    throw IOException(System::getErrorString("GetFileSizeEx"));
+
+  uint64_t end = offset + length;
+
+  FILE_ALLOCATION_INFO allocInfo;
+  allocInfo.AllocationSize.QuadPart = static_cast<LONGLONG>(end);
+
+  if(::SetFileInformationByHandle(_handle, FileAllocationInfo, &allocInfo,
+                                  sizeof(allocInfo)) == FALSE)
+    throw IOException(System::getErrorString("SetFileInformationByHandle"));
+
+  if((mode == FileAllocateDefault)
+     && (end > static_cast<uint64_t>(size.QuadPart)))
+  {
+    FILE_END_OF_FILE_INFO eofInfo;
+    eofInfo.EndOfFile.QuadPart = static_cast<LONGLONG>(end);
+
+    if(::SetFileInformationByHandle(_handle, FileEndOfFileInfo, &eofInfo,
+                                    sizeof(eofInfo)) == FALSE)
+      throw IOException(System::getErrorString("SetFileInformationByHandle"));
+  }
+
+#elif defined(HAVE_FALLOCATE)
+
+  int flags = 0;
+
+  switch(mode)
+  {
+    case FileAllocateKeepSize:
+      flags = FALLOC_FL_KEEP_SIZE;
+      break;
+
+    case FileAllocatePunchHole:
+#ifdef FALLOC_FL_PUNCH_HOLE
+      flags = (FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE);
+      break;
+#else
+      throw UnsupportedOperationException("hole punching not supported");
+#endif
+
+    case FileAllocateDefault:
+    default:
+      break;
+  }
+
+  if(::fallocate(_handle, flags, static_cast<off_t>(offset),
+                 static_cast<off_t>(length)) != 0)
+    throw IOException(System::getErrorString("fallocate"));
+
+#else
+
+  if(mode != FileAllocateDefault)
+    throw UnsupportedOperationException("allocation mode not supported");
+
+#ifdef HAVE_POSIX_FALLOCATE
+
+  int r = ::posix_fallocate(_handle, static_cast<off_t>(offset),
+                            static_cast<off_t>(length));
+  if(r != 0)
+  {
+    errno = r;
+    throw IOException(System::getErrorString("posix_fallocate"));
+  }
+
+#else
+
+  // no preallocation; at least extend the file to cover the range
+
+  struct stat stbuf;
+
+  if(::fstat(_handle, &stbuf) != 0)
+    throw IOException(System::getErrorString("fstat"));
+
+  uint64_t end = offset + length;
+
+  if((end > static_cast<uint64_t>(stbuf.st_size))
+     && (::ftruncate(_handle, static_cast<off_t>(end)) != 0))
+    throw IOException(System::getErrorString("ftruncate"));
+
+#endif
+
+#endif
+}
+
+/*
+ */
+
+void File::advise(uint64_t offset, uint64_t length, FileAccessAdvice advice)
+{
+#ifdef HAVE_POSIX_FADVISE
+
+  int flag = POSIX_FADV_NORMAL;
+
+  switch(advice)
+  {
+    case FileAdviseSequential:
+      flag = POSIX_FADV_SEQUENTIAL;
+      break;
+
+    case FileAdviseRandom:
+      flag = POSIX_FADV_RANDOM;
+      break;
+
+    case FileAdviseWillNeed:
+      flag = POSIX_FADV_WILLNEED;
+      break;
+
+    case FileAdviseDontNeed:
+      flag = POSIX_FADV_DONTNEED;
+      break;
+
+    case FileAdviseNoReuse:
+      flag = POSIX_FADV_NOREUSE;
+      break;
+
+    case FileAdviseNormal:
+    default:
+      break;
+  }
+
+  int r = ::posix_fadvise(_handle, static_cast<off_t>(offset),
+                          static_cast<off_t>(length), flag);
+  if(r != 0)
+  {
+    errno = r;
+    throw IOException(System::getErrorString("posix_fadvise"));
+  }
+
+#endif
+}
+
+/*
+ */
+
+void File::syncRange(uint64_t offset, uint64_t length, bool wait /* = false */)
+{
+#ifdef CCXX_OS_WINDOWS
+
+  if(::FlushFileBuffers(_handle) == FALSE)
+    throw IOException(System::getErrorString("FlushFileBuffers"));
+
+#elif defined(HAVE_SYNC_FILE_RANGE)
+
+  unsigned int flags = SYNC_FILE_RANGE_WRITE;
+  if(wait)
+    flags |= (SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WAIT_AFTER);
+
+  if(::sync_file_range(_handle, static_cast<off_t>(offset),
+                       static_cast<off_t>(length), flags) != 0)
+    throw IOException(System::getErrorString("sync_file_range"));
+
+#else
+
+  if(::fsync(_handle) != 0)
+    throw IOException(System::getErrorString("fsync"));
+
+#endif
+}
+
 /*
  */
 
@@ -1127,35 +1363,75 @@ bool File::rename(const String& oldName, const String& newName)
 
 bool File::copy(const String& oldName, const String& newName)
 {
+  FileCopyMethod method;
 
-#ifdef CCXX_OS_WINDOWS
+  return(copy(oldName, newName, method));
+}
 
-  return(::CopyFileW(oldName.data(), newName.data(), FALSE) == TRUE);
+/*
+ */
 
-#else
+#ifndef CCXX_OS_WINDOWS
 
-  byte_t buf[4096];
-  size_t r, w;
-  int fdin, fdout;
-  mode_t mode = S_IRUSR | S_IWUSR;
+// the size of each in-kernel copy request, and of the user-space buffer
+static const size_t __COPY_CHUNK_SIZE = 1 << 30;
+static const size_t __COPY_BUFFER_SIZE = 1 << 20;
 
-  CString cstr_oldName = oldName.toUTF8();
-  CString cstr_newName = newName.toUTF8();
+/*
+ */
 
-  fdin = ::open(cstr_oldName.data(), O_RDONLY);
-  if(fdin < 0)
-    return(false);
+static bool __isCopyUnsupported(int err)
+{
+  return((err == ENOSYS) || (err == EINVAL) || (err == EXDEV)
+         || (err == EOPNOTSUPP) || (err == ENOTSUP) || (err == EBADF));
+}
 
-  fdout = ::open(cstr_newName.data(), O_WRONLY | O_CREAT | O_EXCL, mode);
-  if(fdout < 0)
+/*
+ */
+
+// Copies the rest of the file with copy_file_range() or sendfile(), from
+// the current offsets. Returns 1 on success, 0 if the method is not
+// supported for these files, and -1 on error.
+
+static int __copyInKernel(int fdin, int fdout, FileCopyMethod method)
+{
+  for(;;)
   {
-    ::close(fdin);
-    return(false);
+    ssize_t r = -1;
+    errno = ENOSYS;
+
+#ifdef HAVE_COPY_FILE_RANGE
+    if(method == FileCopyRange)
+      r = ::copy_file_range(fdin, NULL, fdout, NULL, __COPY_CHUNK_SIZE, 0);
+#endif
+
+#ifdef HAVE_SYS_SENDFILE_H
+    if(method == FileCopySendfile)
+      r = ::sendfile(fdout, fdin, NULL, __COPY_CHUNK_SIZE);
+#endif
+
+    if(r == 0)
+      return(1);
+    else if(r < 0)
+    {
+      if(errno == EINTR)
+        continue;
+
+      return(__isCopyUnsupported(errno) ? 0 : -1);
+    }
   }
+}
+
+/*
+ */
 
+static bool __copyBuffered(int fdin, int fdout)
+{
+  byte_t *buf = new byte_t[__COPY_BUFFER_SIZE];
+  ssize_t r, w;
   bool ok = true;
 
-  while(ok && ((r = ::read(fdin, buf, sizeof(buf))) != 0))
+  while(ok && ((r = ::read(fdin, buf, __COPY_BUFFER_SIZE)) != 0))
   {
     if(r < 0)
     {
@@ -1189,8 +1465,120 @@ bool File::copy(const String& oldName, const String& newName)
     }
   }
 
+  delete[] buf;
+
+  return(ok);
+}
+
+#endif // ! CCXX_OS_WINDOWS
+
+/*
+ */
+
+bool File::copy(const String& oldName, const String& newName,
+                FileCopyMethod& method)
+{
+  method = FileCopyNone;
+
+#ifdef CCXX_OS_WINDOWS
+
+  if(::CopyFileW(oldName.data(), newName.data(), FALSE) != TRUE)
+    return(false);
+
+  method = FileCopyNative;
+  return(true);
+
+#else
+
+  int fdin, fdout;
+  mode_t mode = S_IRUSR | S_IWUSR;
+
+  CString cstr_oldName = oldName.toUTF8();
+  CString cstr_newName = newName.toUTF8();
+
+  fdin = ::open(cstr_oldName.data(), O_RDONLY);
+  if(fdin < 0)
+    return(false);
+
+  fdout = ::open(cstr_newName.data(), O_WRONLY | O_CREAT | O_EXCL, mode);
+  if(fdout < 0)
+  {
+    ::close(fdin);
+    return(false);
+  }
+
+  bool ok = false;
+
+#if (defined HAVE_LINUX_FS_H) && (defined FICLONE)
+  if(::ioctl(fdout, FICLONE, fdin) == 0)
+  {
+    method = FileCopyReflink;
+    ok = true;
+  }
+#endif
+
+  if(! ok)
+  {
+    struct stat stbuf;
+    off_t size = 0;
+
+    if((::fstat(fdin, &stbuf) == 0) && S_ISREG(stbuf.st_mode))
+      size = stbuf.st_size;
+
+#ifdef HAVE_POSIX_FALLOCATE
+    bool preallocated = ((size > 0)
+                         && (::posix_fallocate(fdout, 0, size) == 0));
+#else
+    bool preallocated = false;
+#endif
+
+#ifdef HAVE_POSIX_FADVISE
+    ::posix_fadvise(fdin, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    // each method continues from where the previous one left off; files
+    // which report a size of 0 (such as those in /proc) may still have
+    // content, which only read() is known to return
+
+    int r = 0;
+
+    if(size > 0)
+    {
+      static const FileCopyMethod methods[] = { FileCopyRange,
+                                                FileCopySendfile };
+
+      for(size_t i = 0; (r == 0) && (i < CCXX_LENGTHOF(methods)); ++i)
+      {
+        r = __copyInKernel(fdin, fdout, methods[i]);
+        if(r > 0)
+          method = methods[i];
+      }
+    }
+
+    if((r == 0) && __copyBuffered(fdin, fdout))
+    {
+      method = FileCopyBuffered;
+      r = 1;
+    }
+
+    ok = (r > 0);
+
+    // in case the source file shrank while it was being copied
+    if(ok && preallocated)
+    {
+      off_t pos = ::lseek(fdout, 0, SEEK_CUR);
+      if((pos >= 0) && (pos < size))
+        ok = (::ftruncate(fdout, pos) == 0);
+    }
+  }
+
   ::close(fdin);
-  ::close(fdout);
+
+  if(::close(fdout) != 0)
+    ok = false;
+
+  if(! ok)
+    method = FileCopyNone;
 
   return(ok);
 
@@ -1302,6 +1690,17 @@ size_t File::getDiskBlockSize(const String& path)
 #endif
 }
 
+/*
+ */
+
+size_t File::getDirectIOAlignment(const String& path)
+{
+  // direct I/O must be aligned to the logical block size of the device;
+  // the file system block size is always a multiple of that
+
+  return(std::max(getDiskBlockSize(path), static_cast<size_t>(512)));
+}
+
 /*
  */
 
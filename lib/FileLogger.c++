@@ -25,6 +25,10 @@
 #endif
 
 #include "commonc++/FileLogger.h++"
+#include "commonc++/ScopedLock.h++"
+#include "commonc++/System.h++"
+
+#include <cstring>
 
 namespace ccxx {
 
@@ -33,6 +37,50 @@ namespace ccxx {
 
 const uint_t FileLogger::MAX_ROTATE_COUNT = 9;
 
+const size_t FileLogger::DEFAULT_BUFFER_SIZE = 8192;
+
+const timespan_ms_t FileLogger::DEFAULT_FLUSH_INTERVAL = 1000;
+
+/*
+ */
+
+static void __claim(AtomicCounter& flag)
+{
+  // the flag is only contended by flushOnCrash(), which never waits for it
+
+  while(flag.testAndSet(1, 0) != 0)
+    Thread::sleep(1);
+}
+
+/*
+ * Holds the buffer lock, and marks the buffer as in use for as long as it
+ * is held. The lock is not recursive, and a signal handler must not take
+ * it, so flushOnCrash() tests the mark instead; that fails for every
+ * thread, including one that was interrupted while holding the lock.
+ */
+
+class FileLogger::BufferGuard
+{
+ public:
+
+  BufferGuard(FileLogger& logger)
+    : _logger(logger)
+  {
+    _logger._bufferLock.lock();
+    __claim(_logger._bufferBusy);
+  }
+
+  ~BufferGuard()
+  {
+    _logger._bufferBusy.set(0);
+    _logger._bufferLock.unlock();
+  }
+
+ private:
+
+  FileLogger& _logger;
+};
+
 /*
  */
 
@@ -44,7 +92,14 @@ FileLogger::FileLogger(const String &format /* = "[%d %t] %m" */,
     _maxLogSize(maxLogSize < 1 ? 1 : maxLogSize),
     _curLogSize(0),
     _rotateCount(rotateCount <= MAX_ROTATE_COUNT ? rotateCount : 0),
-    _file(NULL)
+    _file(NULL),
+    _pending(new CharBuffer(static_cast<uint_t>(DEFAULT_BUFFER_SIZE))),
+    _flushInterval(DEFAULT_FLUSH_INTERVAL),
+    _pendingSince(0),
+    _flushRunner(this, &FileLogger::_runFlusher),
+    _flusher(NULL),
+    _stopping(false),
+    _rotatePending(0)
 {
 }
 
@@ -53,7 +108,25 @@ FileLogger::FileLogger(const String &format /* = "[%d %t] %m" */,
 
 FileLogger::~FileLogger()
 {
+  if(_flusher)
+  {
+    synchronized(_bufferLock)
+    {
+      _stopping = true;
+      _flushCond.notify();
+    }
+
+    _flusher->join();
+    delete _flusher;
+  }
+
+  if(_file)
+    _flush();
+
+  completeDeferredWork();
+
   delete _file;
+  delete _pending;
 }
 
 /*
@@ -61,24 +134,21 @@ FileLogger::~FileLogger()
 
 bool FileLogger::setFile(const String& dir, const String& name)
 {
+  BufferGuard guard(*this);
+
   if(_file)
   {
+    _flush();
     _file->close();
     delete _file;
   }
 
+  completeDeferredWork();
+
   _dir = File::removeTrailingSeparators(dir);
   _name = name;
 
-  String path;
-  path << _dir;
-
-  if(! _dir.endsWith(File::separator))
-    path << File::separator;
-
-  path << _name << ".log";
-
-  _file = new File(path);
+  _file = new File(_getPath(-1));
 
   try
   {
@@ -112,12 +182,93 @@ void FileLogger::setRotateCount(uint_t rotateCount)
     _rotateCount = rotateCount;
 }
 
+/*
+ */
+
+void FileLogger::setBufferSize(size_t bufferSize)
+{
+  BufferGuard guard(*this);
+
+  if(_file)
+    _flush();
+
+  delete _pending;
+  _pending = NULL;
+
+  if(bufferSize > 0)
+    _pending = new CharBuffer(static_cast<uint_t>(bufferSize));
+}
+
+/*
+ */
+
+void FileLogger::setFlushInterval(timespan_ms_t flushInterval)
+{
+  synchronized(_bufferLock)
+  {
+    _flushInterval = (flushInterval < 0) ? 0 : flushInterval;
+    _flushCond.notify();
+  }
+}
+
+/*
+ */
+
+void FileLogger::flush()
+{
+  BufferGuard guard(*this);
+
+  if(_file)
+    _flush();
+}
+
+/*
+ */
+
+void FileLogger::flushOnCrash()
+{
+  if(_bufferBusy.testAndSet(1, 0) != 0)
+    return;
+
+  if(_file)
+    _flush();
+
+  _bufferBusy.set(0);
+}
+
+/*
+ */
+
+bool FileLogger::hasDeferredWork() const
+{
+  return(_rotatePending.get() != 0);
+}
+
+/*
+ */
+
+void FileLogger::completeDeferredWork()
+{
+  if(_rotatePending.get() == 0)
+    return;
+
+  synchronized(_rotateLock)
+  {
+    if(_rotatePending.get() != 0)
+    {
+      _shiftBacklog();
+      _rotatePending.set(0);
+    }
+  }
+}
+
 /*
  */
 
 void FileLogger::openFile()
 {
-  _file->open(IOWrite);
+  _file->open(IOWrite, FileAppendElseCreate);
+  _curLogSize = _file->getSize();
 }
 
 /*
@@ -125,6 +276,8 @@ void FileLogger::openFile()
 
 bool FileLogger::write(CharBuffer& buffer)
 {
+  BufferGuard guard(*this);
+
   if(! _file)
     return(false);
 
@@ -132,10 +285,15 @@ bool FileLogger::write(CharBuffer& buffer)
 
   try
   {
-    int64_t offset = _file->seek(0, SeekEnd);
+    // _curLogSize only counts what has actually been written
 
-    if(offset + static_cast<int64_t>(sz) > _maxFileSize)
+    int64_t size = _curLogSize + (_pending ? _pending->getPosition() : 0);
+
+    if((size > 0) && (size + static_cast<int64_t>(sz) > _maxFileSize))
     {
+      if(! _flush())
+        return(false);
+
       _file->close();
 
       if(! _rotate())
@@ -144,7 +302,48 @@ bool FileLogger::write(CharBuffer& buffer)
       openFile();
     }
 
-    _file->write(buffer);
+    if(! _pending || (sz >= _pending->getSize()))
+    {
+      // unbuffered, or too large to be worth copying
+
+      if(! _flush())
+        return(false);
+
+      while(buffer.hasRemaining())
+      {
+        size_t n = _file->write(buffer);
+        if(n == 0)
+          return(false);
+
+        _curLogSize += n;
+      }
+
+      return(true);
+    }
+
+    if((sz > _pending->getRemaining()) && ! _flush())
+      return(false);
+
+    if(_pending->getPosition() == 0)
+    {
+      _pendingSince = System::currentTimeMillis();
+
+      if(! _flusher)
+      {
+        _flusher = new Thread(&_flushRunner);
+        _flusher->start();
+      }
+
+      _flushCond.notify();
+    }
+
+    std::memcpy(_pending->getPointer(), buffer.getPointer(), sz);
+    _pending->bump(static_cast<uint_t>(sz));
+    buffer.bump(static_cast<uint_t>(sz));
+
+    if(! _pending->hasRemaining()
+       || (System::currentTimeMillis() - _pendingSince >= _flushInterval))
+      return(_flush());
 
     return(true);
   }
@@ -158,32 +357,146 @@ bool FileLogger::write(CharBuffer& buffer)
   }
 }
 
+/*
+ */
+
+bool FileLogger::writeOnCrash(CharBuffer& buffer)
+{
+  if(_bufferBusy.testAndSet(1, 0) != 0)
+    return(false);
+
+  bool ok = false;
+
+  if(_file && _flush())
+  {
+    try
+    {
+      ok = true;
+
+      while(ok && buffer.hasRemaining())
+      {
+        size_t n = _file->write(buffer);
+
+        _curLogSize += n;
+        ok = (n > 0);
+      }
+    }
+    catch(IOException &ex)
+    {
+      ok = false;
+    }
+  }
+
+  _bufferBusy.set(0);
+
+  return(ok);
+}
+
+/*
+ */
+
+bool FileLogger::_flush()
+{
+  if(! _pending || (_pending->getPosition() == 0))
+    return(true);
+
+  bool ok = true;
+  _pending->flip();
+
+  try
+  {
+    while(ok && _pending->hasRemaining())
+    {
+      size_t n = _file->write(*_pending);
+
+      _curLogSize += n;
+      ok = (n > 0);
+    }
+  }
+  catch(IOException &ex)
+  {
+    ok = false;
+  }
+
+  _pending->clear();
+
+  return(ok);
+}
+
+/*
+ */
+
+void FileLogger::_runFlusher()
+{
+  synchronized(_bufferLock)
+  {
+    while(! _stopping)
+    {
+      if(_file && _pending && (_pending->getPosition() > 0))
+      {
+        time_ms_t age = System::currentTimeMillis() - _pendingSince;
+
+        if((age >= 0) && (age < _flushInterval))
+        {
+          _flushCond.wait(_bufferLock,
+                          static_cast<uint_t>(_flushInterval - age));
+          continue;
+        }
+
+        __claim(_bufferBusy);
+        _flush();
+        _bufferBusy.set(0);
+      }
+
+      // nothing is buffered; wait until something is
+
+      _flushCond.wait(_bufferLock);
+    }
+  }
+}
+
 /*
  */
 
 bool FileLogger::_rotate()
 {
+  String path = _getPath(-1);
+
   if(_rotateCount == 0)
+    return(File::remove(path) || ! File::exists(path));
+
+  // Only move the current file out of the way here; the remaining renames
+  // are done by completeDeferredWork(), which is called without the
+  // logging lock held. If the previous rotation has not been completed,
+  // complete it now.
+
+  synchronized(_rotateLock)
   {
-    String path;
-    path << _dir << File::separator << _name;
+    String staging = _getPath(0);
+
+    if(File::exists(staging) && ! _shiftBacklog())
+      return(false);
 
-    return(File::remove(path));
+    if(File::exists(path) && ! File::rename(path, staging))
+      return(false);
+
+    _rotatePending.set(1);
   }
 
+  return(true);
+}
+
+/*
+ */
+
+bool FileLogger::_shiftBacklog()
+{
   for(int i = MAX_ROTATE_COUNT - 1; i >= 0; --i)
   {
     // delete file.i+1
     // rename file.i to file.i+1
 
-    String oldPath, newPath;
-
-    newPath << _dir;
-
-    if(! _dir.endsWith(File::separator))
-      newPath << File::separator;
-
-    newPath << _name << '.' << (i + 1) << ".log";
+    String newPath = _getPath(i + 1);
 
     if(File::exists(newPath))
     {
@@ -192,21 +505,43 @@ bool FileLogger::_rotate()
     }
 
     if(static_cast<uint_t>(i) < _rotateCount)
-
-    oldPath << _dir << File::separator << _name;
-    if(i > 0)
-      oldPath << '.' << i;
-    oldPath << ".log";
-
-    if(File::exists(oldPath))
     {
-      if(! File::rename(oldPath, newPath))
-        return(false);
+      String oldPath = _getPath(i);
+
+      if(File::exists(oldPath))
+      {
+        if(! File::rename(oldPath, newPath))
+          return(false);
+      }
     }
   }
 
   return(true);
 }
 
+/*
+ */
+
+String FileLogger::_getPath(int index) const
+{
+  // index -1 is the current log file; index 0 is the most recently rotated
+  // file, before it is renamed into the backlog
+
+  String path;
+  path << _dir;
+
+  if(! _dir.endsWith(File::separator))
+    path << File::separator;
+
+  path << _name;
+
+  if(index >= 0)
+    path << '.' << index;
+
+  path << ".log";
+
+  return(path);
+}
+
 
 } // namespace ccxx
@@ -25,11 +25,405 @@
 #endif
 
 #include "commonc++/FileTraverser.h++"
+#include "commonc++/AtomicCounter.h++"
+#include "commonc++/ConditionVar.h++"
 #include "commonc++/Dir.h++"
 #include "commonc++/File.h++"
+#include "commonc++/Mutex.h++"
+#include "commonc++/ScopedLock.h++"
+#include "commonc++/System.h++"
+#include "commonc++/Thread.h++"
+
+#ifdef CCXX_OS_POSIX
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#include <cstring>
+#include <deque>
 
 namespace ccxx {
 
+#ifdef CCXX_OS_POSIX
+
+/*
+ */
+
+class FileTraverser::Parallel
+{
+ public:
+
+  Parallel(FileTraverser& traverser, uint_t numThreads);
+  ~Parallel();
+
+  bool run(const String& baseDir);
+
+ private:
+
+  // an open directory, shared by the tasks for its subdirectories
+  struct DirRef
+  {
+    DirRef(DIR* dir)
+      : dir(dir), refs(1)
+    { }
+
+    DIR* dir;
+    AtomicCounter refs;
+  };
+
+  struct Task
+  {
+    DirRef* parent;
+    String name;
+    String path;
+    uint_t depth;
+  };
+
+  class Worker : public Thread
+  {
+   public:
+
+    Worker(Parallel& owner, uint_t index)
+      : _owner(owner), _index(index)
+    { }
+
+   protected:
+
+    void run()
+    { _owner._work(_index); }
+
+   private:
+
+    Parallel& _owner;
+    uint_t _index;
+  };
+
+  struct Queue
+  {
+    Mutex lock;
+    std::deque<Task> tasks;
+  };
+
+  void _work(uint_t index);
+  bool _take(uint_t index, Task& task);
+  void _push(uint_t index, const Task& task);
+  void _scan(uint_t index, Task& task);
+  void _release(DirRef* ref);
+  void _stop();
+
+  FileTraverser& _traverser;
+  uint_t _numThreads;
+  Queue* _queues;
+  AtomicCounter _pending;
+  volatile bool _stopped;
+  Mutex _idleLock;
+  ConditionVar _idleCond;
+
+  CCXX_COPY_DECLS(Parallel);
+};
+
+/*
+ */
+
+FileTraverser::Parallel::Parallel(FileTraverser& traverser,
+                                  uint_t numThreads)
+  : _traverser(traverser),
+    _numThreads(numThreads),
+    _queues(new Queue[numThreads]),
+    _stopped(false)
+{
+}
+
+/*
+ */
+
+FileTraverser::Parallel::~Parallel()
+{
+  delete[] _queues;
+}
+
+/*
+ */
+
+bool FileTraverser::Parallel::run(const String& baseDir)
+{
+  Task root;
+  root.parent = NULL;
+  root.path = baseDir;
+  root.depth = 1;
+
+  _push(0, root);
+
+  Worker **workers = new Worker*[_numThreads];
+
+  for(uint_t i = 0; i < _numThreads; ++i)
+  {
+    workers[i] = new Worker(*this, i);
+    workers[i]->start();
+  }
+
+  for(uint_t i = 0; i < _numThreads; ++i)
+  {
+    workers[i]->join();
+    delete workers[i];
+  }
+
+  delete[] workers;
+
+  // release any tasks that were abandoned when the traversal was stopped
+
+  for(uint_t i = 0; i < _numThreads; ++i)
+  {
+    std::deque<Task>& tasks = _queues[i].tasks;
+
+    for(std::deque<Task>::iterator iter = tasks.begin(); iter != tasks.end();
+        ++iter)
+      _release(iter->parent);
+
+    tasks.clear();
+  }
+
+  return(! _stopped);
+}
+
+/*
+ */
+
+void FileTraverser::Parallel::_work(uint_t index)
+{
+  bool done = false;
+
+  while(! done)
+  {
+    Task task;
+
+    if(_take(index, task))
+    {
+      if(_stopped)
+        _release(task.parent);
+      else
+        _scan(index, task);
+
+      if(--_pending == 0)
+      {
+        synchronized(_idleLock)
+        {
+          _idleCond.notifyAll();
+        }
+      }
+
+      continue;
+    }
+
+    // nothing to do; wait for more work, or for the traversal to finish
+
+    synchronized(_idleLock)
+    {
+      done = (_pending.get() == 0);
+
+      if(! done)
+        _idleCond.wait(_idleLock, 10);
+    }
+  }
+}
+
+/*
+ */
+
+bool FileTraverser::Parallel::_take(uint_t index, Task& task)
+{
+  // take the most recently queued task from our own queue, which keeps
+  // the scan close to the directories that are already open...
+
+  Queue& own = _queues[index];
+  Mutex& ownLock = own.lock;
+
+  synchronized(ownLock)
+  {
+    if(! own.tasks.empty())
+    {
+      task = own.tasks.back();
+      own.tasks.pop_back();
+      return(true);
+    }
+  }
+
+  // ...or steal the oldest task from another thread, which is likely to
+  // be the root of a large subtree
+
+  for(uint_t i = 1; i < _numThreads; ++i)
+  {
+    Queue& victim = _queues[(index + i) % _numThreads];
+    Mutex& victimLock = victim.lock;
+
+    synchronized(victimLock)
+    {
+      if(! victim.tasks.empty())
+      {
+        task = victim.tasks.front();
+        victim.tasks.pop_front();
+        return(true);
+      }
+    }
+  }
+
+  return(false);
+}
+
+/*
+ */
+
+void FileTraverser::Parallel::_push(uint_t index, const Task& task)
+{
+  Queue& own = _queues[index];
+  Mutex& ownLock = own.lock;
+
+  ++_pending;
+
+  synchronized(ownLock)
+  {
+    own.tasks.push_back(task);
+  }
+
+  synchronized(_idleLock)
+  {
+    _idleCond.notify();
+  }
+}
+
+/*
+ */
+
+void FileTraverser::Parallel::_scan(uint_t index, Task& task)
+{
+  int fd;
+
+  if(task.parent)
+  {
+    CString name = task.name.toUTF8();
+    fd = ::openat(::dirfd(task.parent->dir), name.data(),
+                  O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  }
+  else
+  {
+    CString path = task.path.toUTF8();
+    fd = ::open(path.data(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  }
+
+  DIR *dir = NULL;
+  if(fd >= 0)
+  {
+    dir = ::fdopendir(fd);
+    if(! dir)
+      ::close(fd);
+  }
+
+  _release(task.parent);
+
+  String dirPath = task.path;
+  dirPath += File::separator;
+
+  if(! dir)
+  {
+    IOException ex(System::getErrorString("opendir"));
+    FileName filename(dirPath);
+
+    if(! _traverser.handleError(filename, ex))
+      _stop();
+
+    return;
+  }
+
+  DirRef *self = new DirRef(dir);
+  int dfd = ::dirfd(dir);
+  struct dirent *de;
+
+  while(! _stopped && ((de = ::readdir(dir)) != NULL))
+  {
+    if(! std::strcmp(de->d_name, ".") || ! std::strcmp(de->d_name, ".."))
+      continue;
+
+    String name = de->d_name;
+
+    if(! _traverser._prunePattern.isNull()
+       && _traverser._prunePattern.match(name))
+      continue; // prune
+
+    bool isDir = false;
+    bool isLink = false;
+
+#ifdef _DIRENT_HAVE_D_TYPE
+    if((de->d_type != DT_UNKNOWN) && (de->d_type != DT_LNK))
+      isDir = (de->d_type == DT_DIR);
+    else
+#endif
+    {
+      // the entry's type is unknown, or it is a symbolic link, whose
+      // target's type is reported, as in traverse()
+
+      struct stat stbuf;
+      if(::fstatat(dfd, de->d_name, &stbuf, AT_SYMLINK_NOFOLLOW) != 0)
+        continue; // can't stat the file, so continue to next one
+
+      isLink = S_ISLNK(stbuf.st_mode);
+      if(isLink && (::fstatat(dfd, de->d_name, &stbuf, 0) != 0))
+        continue;
+
+      isDir = S_ISDIR(stbuf.st_mode);
+    }
+
+    FileName filename(dirPath, name);
+
+    if(! _traverser.processFile(filename, isDir, task.depth))
+    {
+      _stop();
+      break;
+    }
+
+    // links to directories are not descended into, so that a link cycle
+    // can't cause an endless traversal
+
+    if(isDir && ! isLink)
+    {
+      Task sub;
+      sub.parent = self;
+      sub.name = name;
+      sub.path = dirPath;
+      sub.path += name;
+      sub.depth = task.depth + 1;
+
+      ++(self->refs);
+      _push(index, sub);
+    }
+  }
+
+  _release(self);
+}
+
+/*
+ */
+
+void FileTraverser::Parallel::_release(DirRef* ref)
+{
+  if(ref && (--(ref->refs) == 0))
+  {
+    ::closedir(ref->dir);
+    delete ref;
+  }
+}
+
+/*
+ */
+
+void FileTraverser::Parallel::_stop()
+{
+  _stopped = true;
+}
+
+#endif // CCXX_OS_POSIX
+
 /*
  */
 
@@ -156,6 +550,42 @@ bool FileTraverser::traverse()
   return(true);
 }
 
+/*
+ */
+
+bool FileTraverser::traverseParallel(uint_t numThreads /* = 0 */)
+{
+#ifdef CCXX_OS_POSIX
+
+  if(numThreads == 0)
+  {
+    long n = ::sysconf(_SC_NPROCESSORS_ONLN);
+    numThreads = (n > 0) ? static_cast<uint_t>(n) : 1;
+  }
+
+  _baseDir.trimEnd(File::validSeparators);
+
+  bool dir = File::isDirectory(_baseDir);
+
+  FileName filename(_baseDir);
+
+  if(! processFile(filename, dir, 0))
+    return(false);
+
+  if(! dir)
+    return(true);
+
+  Parallel parallel(*this, numThreads);
+
+  return(parallel.run(_baseDir));
+
+#else
+
+  return(traverse());
+
+#endif
+}
+
 /*
  */
 
@@ -0,0 +1,170 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/Histogram.h++"
+
+#include <cstring>
+
+namespace ccxx {
+
+/*
+ */
+
+const uint_t Histogram::NUM_BUCKETS;
+
+/*
+ */
+
+Histogram::Histogram()
+{
+  reset();
+}
+
+/*
+ */
+
+Histogram::~Histogram()
+{
+}
+
+/*
+ */
+
+void Histogram::record(uint64_t value)
+{
+  uint_t bucket = 0;
+
+  for(uint64_t v = value; (v != 0) && (bucket < (NUM_BUCKETS - 1)); v >>= 1)
+    ++bucket;
+
+  ++_buckets[bucket];
+  ++_count;
+  _sum += value;
+
+  if(value < _min)
+    _min = value;
+
+  if(value > _max)
+    _max = value;
+}
+
+/*
+ */
+
+void Histogram::reset()
+{
+  std::memset(_buckets, 0, sizeof(_buckets));
+  _count = 0;
+  _sum = 0;
+  _min = UINT64_CONST(0xFFFFFFFFFFFFFFFF);
+  _max = 0;
+}
+
+/*
+ */
+
+double Histogram::getMean() const
+{
+  if(_count == 0)
+    return(0.0);
+
+  return(static_cast<double>(_sum) / static_cast<double>(_count));
+}
+
+/*
+ */
+
+uint64_t Histogram::getBucketCount(uint_t bucket) const
+{
+  if(bucket >= NUM_BUCKETS)
+    return(0);
+
+  return(_buckets[bucket]);
+}
+
+/*
+ */
+
+uint64_t Histogram::getBucketLimit(uint_t bucket)
+{
+  if(bucket >= (NUM_BUCKETS - 1))
+    return(UINT64_CONST(0xFFFFFFFFFFFFFFFF));
+
+  return(UINT64_CONST(1) << bucket);
+}
+
+/*
+ */
+
+uint64_t Histogram::getPercentile(double percentile) const
+{
+  if(_count == 0)
+    return(0);
+
+  if(percentile <= 0.0)
+    return(getMin());
+
+  uint64_t rank = static_cast<uint64_t>((percentile / 100.0) * _count);
+  if(rank >= _count)
+    return(_max);
+
+  uint64_t seen = 0;
+
+  for(uint_t i = 0; i < NUM_BUCKETS; ++i)
+  {
+    seen += _buckets[i];
+    if(seen > rank)
+    {
+      uint64_t limit = getBucketLimit(i);
+      return((limit > _max) ? _max : limit);
+    }
+  }
+
+  return(_max);
+}
+
+/*
+ */
+
+void Histogram::merge(const Histogram& other)
+{
+  for(uint_t i = 0; i < NUM_BUCKETS; ++i)
+    _buckets[i] += other._buckets[i];
+
+  _count += other._count;
+  _sum += other._sum;
+
+  if(other._count > 0)
+  {
+    if(other._min < _min)
+      _min = other._min;
+
+    if(other._max > _max)
+      _max = other._max;
+  }
+}
+
+} // namespace ccxx
@@ -0,0 +1,408 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/JSONLogger.h++"
+#include "commonc++/ScopedLock.h++"
+#include "commonc++/System.h++"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace ccxx {
+
+const size_t JSONLogger::DEFAULT_BUFFER_SIZE = 4096;
+
+// space held back while fields are rendered, for a closing quote and the
+// closing members
+static const uint_t __JSON_TAIL_RESERVE = 20;
+
+static const char __JSON_HEX_DIGITS[] = "0123456789abcdef";
+
+/*
+ */
+
+static const char *__levelName(LogLevel level)
+{
+  switch(level)
+  {
+    case LogDebug:
+      return("debug");
+
+    case LogInfo:
+      return("info");
+
+    case LogWarning:
+      return("warning");
+
+    case LogError:
+    default:
+      return("error");
+  }
+}
+
+/*
+ */
+
+JSONLogger::JSONLogger(Logger *target,
+                       size_t bufferSize /* = DEFAULT_BUFFER_SIZE */)
+  : Logger("%m"),
+    _target(target),
+    _record(std::max(bufferSize, static_cast<size_t>(128))),
+    _message(LOG_BUFFER_SIZE)
+{
+}
+
+/*
+ */
+
+JSONLogger::~JSONLogger()
+{
+}
+
+/*
+ */
+
+void JSONLogger::logFields(LogLevel level, const char *file, int line,
+                           const char *message, const LogField *fields,
+                           size_t numFields)
+{
+  if(! isLogLevelEnabled(level))
+    return;
+
+  synchronized(_lock)
+  {
+    bool truncated = ! _beginRecord(level, file, line, message,
+                                    message ? std::strlen(message) : 0);
+
+    for(size_t i = 0; (i < numFields) && ! truncated; ++i)
+      truncated = ! _putField(fields[i]);
+
+    _endRecord(truncated);
+    write(_record);
+  }
+
+  _target->completeDeferredWork();
+}
+
+/*
+ */
+
+void JSONLogger::vlog(LogLevel level, const char *file, int line,
+                      const char *message, va_list args)
+{
+  if(! isLogLevelEnabled(level))
+    return;
+
+  synchronized(_lock)
+  {
+    char *buf = _message.getBase();
+    size_t bufsz = _message.getSize();
+    int n = ::vsnprintf(buf, bufsz, message, args);
+
+    // on truncation, some platforms return a negative value and others
+    // the length that the full message would have had
+    size_t len = ((n < 0) || (static_cast<size_t>(n) >= bufsz))
+      ? std::strlen(buf) : static_cast<size_t>(n);
+
+    _endRecord(! _beginRecord(level, file, line, buf, len));
+    write(_record);
+  }
+
+  _target->completeDeferredWork();
+}
+
+/*
+ */
+
+void JSONLogger::flush()
+{
+  synchronized(_lock)
+  {
+    _target->flush();
+  }
+}
+
+/*
+ */
+
+bool JSONLogger::write(CharBuffer &buffer)
+{
+  return(_target->write(buffer));
+}
+
+/*
+ */
+
+bool JSONLogger::_beginRecord(LogLevel level, const char *file, int line,
+                              const char *message, size_t messageLength)
+{
+  _record.clear();
+  _record.setLimit(_record.getSize() - __JSON_TAIL_RESERVE);
+
+  const char *name = __levelName(level);
+
+  // the fixed members ahead of the file name always fit; a string that
+  // does not fit is clipped and left open, and is closed in the reserved
+  // space
+
+  _putRaw("{\"ts\":", 6);
+  _putInt(System::currentTimeMillis());
+  _putRaw(",\"level\":\"", 10);
+  _putRaw(name, std::strlen(name));
+  _putRaw("\",\"line\":", 9);
+  _putInt(line);
+  _putRaw(",\"file\":", 8);
+
+  bool ok = _putString(file ? file : "", file ? std::strlen(file) : 0, true);
+
+  // require room for the message's opening quote as well
+  if(ok && ((_record.getRemaining() < 8) || ! _putRaw(",\"msg\":", 7)))
+    return(false);
+
+  if(ok)
+    ok = _putString(message ? message : "", messageLength, true);
+
+  if(! ok)
+  {
+    _record.setLimit(_record.getSize());
+    _record.put('"');
+  }
+
+  return(ok);
+}
+
+/*
+ */
+
+bool JSONLogger::_putField(const LogField &field)
+{
+  uint_t mark = _record.getPosition();
+
+  bool ok = _putRaw(",", 1)
+    && _putString(field._name, field._name ? std::strlen(field._name) : 0)
+    && _putRaw(":", 1);
+
+  if(ok)
+  {
+    switch(field._type)
+    {
+      case LogField::TypeInt:
+      case LogField::TypeDuration:
+        ok = _putInt(field._value.i);
+        break;
+
+      case LogField::TypeUInt:
+        ok = _putUInt(field._value.u);
+        break;
+
+      case LogField::TypeDouble:
+        ok = _putDouble(field._value.d);
+        break;
+
+      case LogField::TypeBool:
+        ok = field._value.b ? _putRaw("true", 4) : _putRaw("false", 5);
+        break;
+
+      case LogField::TypeString:
+        ok = _putString(field._value.s.str, field._value.s.len);
+        break;
+    }
+  }
+
+  // drop a partially rendered field altogether
+  if(! ok)
+    _record.setPosition(mark);
+
+  return(ok);
+}
+
+/*
+ */
+
+void JSONLogger::_endRecord(bool truncated)
+{
+  _record.setLimit(_record.getSize());
+
+  if(truncated)
+    _putRaw(",\"truncated\":true", 17);
+
+  _putRaw("}\n", 2);
+  _record.flip();
+}
+
+/*
+ */
+
+bool JSONLogger::_putRaw(const char *s, size_t len)
+{
+  return(_record.put(s, static_cast<uint_t>(len)));
+}
+
+/*
+ */
+
+bool JSONLogger::_putString(const char *s, size_t len,
+                            bool clip /* = false */)
+{
+  if(! s)
+    return(_putRaw("null", 4));
+
+  if(! _record.put('"'))
+    return(false);
+
+  // copy runs of characters that need no escaping in one go
+
+  const char *run = s;
+  const char *end = s + len;
+
+  for(const char *p = s; p <= end; ++p)
+  {
+    unsigned char c = (p < end) ? static_cast<unsigned char>(*p) : 0;
+    if((p < end) && (c >= 0x20) && (c != '"') && (c != '\\'))
+      continue;
+
+    size_t runlen = p - run;
+    if(! _putRaw(run, runlen))
+    {
+      if(clip)
+      {
+        // write what fits, without splitting a UTF-8 sequence
+        const char *cut = run + _record.getRemaining();
+        while((cut > run) && ((*cut & 0xC0) == 0x80))
+          --cut;
+
+        _putRaw(run, cut - run);
+      }
+
+      return(false);
+    }
+
+    if(p == end)
+      break;
+
+    char esc[6] = { '\\', 0, 0, 0, 0, 0 };
+    size_t esclen = 2;
+
+    switch(c)
+    {
+      case '"':
+      case '\\':
+        esc[1] = static_cast<char>(c);
+        break;
+
+      case '\n':
+        esc[1] = 'n';
+        break;
+
+      case '\r':
+        esc[1] = 'r';
+        break;
+
+      case '\t':
+        esc[1] = 't';
+        break;
+
+      case '\b':
+        esc[1] = 'b';
+        break;
+
+      case '\f':
+        esc[1] = 'f';
+        break;
+
+      default:
+        esc[1] = 'u';
+        esc[2] = '0';
+        esc[3] = '0';
+        esc[4] = __JSON_HEX_DIGITS[c >> 4];
+        esc[5] = __JSON_HEX_DIGITS[c & 0x0F];
+        esclen = 6;
+        break;
+    }
+
+    if(! _putRaw(esc, esclen))
+      return(false);
+
+    run = p + 1;
+  }
+
+  return(_record.put('"'));
+}
+
+/*
+ */
+
+bool JSONLogger::_putInt(int64_t value)
+{
+  if(value < 0)
+  {
+    if(! _record.put('-'))
+      return(false);
+
+    // negate in unsigned arithmetic so that INT64_MIN is handled
+    return(_putUInt(UINT64_CONST(0) - static_cast<uint64_t>(value)));
+  }
+
+  return(_putUInt(static_cast<uint64_t>(value)));
+}
+
+/*
+ */
+
+bool JSONLogger::_putUInt(uint64_t value)
+{
+  char buf[20];
+  char *p = buf + sizeof(buf);
+
+  do
+  {
+    *--p = static_cast<char>('0' + (value % 10));
+    value /= 10;
+  }
+  while(value != 0);
+
+  return(_putRaw(p, (buf + sizeof(buf)) - p));
+}
+
+/*
+ */
+
+bool JSONLogger::_putDouble(double value)
+{
+  // JSON has no representation for NaN or the infinities
+  if((value != value) || ((value - value) != 0.0))
+    return(_putRaw("null", 4));
+
+  char buf[32];
+  int n = ::snprintf(buf, sizeof(buf), "%.17g", value);
+  if((n < 0) || (n >= static_cast<int>(sizeof(buf))))
+    return(false);
+
+  return(_putRaw(buf, n));
+}
+
+
+} // namespace ccxx
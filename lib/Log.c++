@@ -26,9 +26,165 @@
 
 #include "commonc++/Log.h++"
 #include "commonc++/ScopedLock.h++"
+#include "commonc++/Thread.h++"
+#include "commonc++/ThreadLocal.h++"
+
+#include <csignal>
+#include <cstring>
+#include <list>
+
+#ifndef va_copy
+#define va_copy(D, S) ((D) = (S))
+#endif
+
+#ifdef _MSC_VER
+#define CCXX_LOG_THREAD_LOCAL __declspec(thread)
+#else
+#define CCXX_LOG_THREAD_LOCAL __thread
+#endif
 
 namespace ccxx {
 
+/*
+ * The per-thread logging state. A thread's active count is nonzero while
+ * the thread is inside Log, where it may use the loggers without holding
+ * _lock. A logger that has been replaced is only deleted once every other
+ * thread has been seen outside of Log, so the logging path never has to
+ * take a shared lock to keep the loggers alive. The states are kept in a
+ * list so that they can be scanned; each is removed from the list when its
+ * thread exits.
+ */
+
+class LogThreadState
+{
+ public:
+
+  LogThreadState();
+  ~LogThreadState();
+
+  AtomicCounter active;
+};
+
+/*
+ */
+
+class LogThreadSlot : public ThreadLocal<LogThreadState>
+{
+ protected:
+
+  LogThreadState* initialValue()
+  { return(new LogThreadState()); }
+};
+
+/*
+ */
+
+static Mutex *__stateLock = new Mutex();
+
+static std::list<LogThreadState *> *__states
+  = new std::list<LogThreadState *>();
+
+static LogThreadSlot *__stateSlot = new LogThreadSlot();
+
+// the calling thread's state; unlike the ThreadLocal, it can be read from
+// a signal handler
+
+static CCXX_LOG_THREAD_LOCAL LogThreadState *__threadState = NULL;
+
+// set by the crash handler while it is using the loggers
+
+static AtomicCounter __crashing;
+
+/*
+ */
+
+LogThreadState::LogThreadState()
+{
+  {
+    ScopedLock guard(*__stateLock);
+    __states->push_back(this);
+  }
+
+  __threadState = this;
+}
+
+/*
+ */
+
+LogThreadState::~LogThreadState()
+{
+  {
+    ScopedLock guard(*__stateLock);
+    __states->remove(this);
+  }
+
+  if(__threadState == this)
+    __threadState = NULL;
+}
+
+/*
+ * Marks the calling thread as active for the lifetime of the object.
+ */
+
+class LogActivity
+{
+ public:
+
+  LogActivity()
+    : _state(__threadState)
+  {
+    if(! _state && __stateSlot)
+      _state = __stateSlot->getValue();
+
+    // a full barrier, so the loggers are read after the thread is marked
+    if(_state)
+      ++(_state->active);
+  }
+
+  ~LogActivity()
+  {
+    if(_state)
+      --(_state->active);
+  }
+
+ private:
+
+  LogThreadState* _state;
+};
+
+/*
+ */
+
+static void __waitForLoggers()
+{
+  // The caller has unpublished the logger that is being replaced. The
+  // atomic reads are full barriers, so any thread that is seen outside of
+  // Log from here on can no longer obtain that logger.
+
+  {
+    ScopedLock guard(*__stateLock);
+
+    for(std::list<LogThreadState *>::iterator iter = __states->begin();
+        iter != __states->end();
+        ++iter)
+    {
+      LogThreadState *state = *iter;
+
+      if(state == __threadState)
+        continue;
+
+      while(state->active.get() != 0)
+        Thread::sleep(1);
+    }
+  }
+
+  // the crash handler may be running on a thread that has never logged;
+  // it sets the flag before reading the loggers
+
+  while(__crashing.get() != 0)
+    Thread::sleep(1);
+}
+
 /*
  */
 
@@ -36,11 +192,15 @@ ConsoleLogger *Log::_consoleLog = new ConsoleLogger();
 
 FileLogger *Log::_fileLog = new FileLogger();
 
+AsyncLogger *Log::_asyncFileLog = NULL;
+
 CriticalSection Log::_lock;
 
-bool Log::_useConsoleLog = true;
+volatile bool Log::_useConsoleLog = true;
+
+volatile bool Log::_useFileLog = false;
 
-bool Log::_useFileLog = false;
+AtomicCounter Log::_levelMask(LogDebug | LogInfo | LogWarning | LogError);
 
 /* temporary hackery */
 
@@ -61,6 +221,8 @@ static void __cleanup_logger_singletons(void)
     Log::setFileLogger(NULL);
     Log::setConsoleLogger(NULL);
   }
+  else
+    Log::flush();
 }
 
 /*
@@ -71,6 +233,42 @@ CCXX_STATIC_INITIALIZER
   ::atexit(__cleanup_logger_singletons);
 }
 
+/*
+ */
+
+void Log::enableLogLevel(LogLevel level)
+{
+  synchronized(_lock)
+  {
+    _levelMask = (_levelMask.get() | level);
+  }
+}
+
+/*
+ */
+
+void Log::disableLogLevel(LogLevel level)
+{
+  synchronized(_lock)
+  {
+    _levelMask = (_levelMask.get() & ~level);
+  }
+}
+
+/*
+ */
+
+void Log::setMinLogLevel(LogLevel level)
+{
+  // the levels are single bits in increasing order of severity
+
+  synchronized(_lock)
+  {
+    _levelMask = (LogDebug | LogInfo | LogWarning | LogError)
+      & ~(static_cast<uint_t>(level) - 1);
+  }
+}
+
 /*
  */
 
@@ -136,27 +334,196 @@ void Log::setConsoleLogFormat(const String &format)
 
 void Log::setFileLogger(FileLogger *logger)
 {
+  // the async writer takes the lock to write, so it must be stopped (and
+  // drained into the old logger) without holding the lock
+
+  AsyncLogger *async = NULL;
+  FileLogger *old = NULL;
+
   synchronized(_lock)
   {
-    if(_fileLog)
-      delete _fileLog;
+    async = _asyncFileLog;
+    _asyncFileLog = NULL;
+  }
+
+  if(async)
+  {
+    __waitForLoggers();
+    async->stop();
+  }
 
+  synchronized(_lock)
+  {
+    old = _fileLog;
     _fileLog = logger;
   }
+
+  // the old logger may still be completing a rotation outside of _lock
+
+  __waitForLoggers();
+  delete old;
+
+  if(async)
+  {
+    if(logger)
+    {
+      async->setTarget(logger);
+      async->start();
+
+      synchronized(_lock)
+      {
+        _asyncFileLog = async;
+      }
+    }
+    else
+      delete async;
+  }
 }
 
 /*
  */
 
-void Log::setConsoleLogger(ConsoleLogger *logger)
+void Log::setAsyncFileLog(bool flag,
+                          size_t bufferSize
+                          /* = AsyncLogger::DEFAULT_BUFFER_SIZE */,
+                          LogOverflowPolicy policy /* = LogOverflowBlock */)
 {
+  AsyncLogger *async = NULL;
+
   synchronized(_lock)
   {
+    async = _asyncFileLog;
+    _asyncFileLog = NULL;
+  }
+
+  if(async)
+  {
+    __waitForLoggers();
+    async->stop();
+    delete async;
+  }
+
+  if(flag)
+  {
+    synchronized(_lock)
+    {
+      if(_fileLog)
+      {
+        async = new AsyncLogger(_fileLog, bufferSize, policy, &_lock);
+        async->start();
+        _asyncFileLog = async;
+      }
+    }
+  }
+}
+
+/*
+ */
+
+void Log::flush()
+{
+  LogActivity activity;
+  AsyncLogger *async = _asyncFileLog;
+
+  if(async)
+    async->flush();
+
+  synchronized(_lock)
+  {
+    if(_fileLog && ! async)
+      _fileLog->flush();
+
+    if(_consoleLog)
+      _consoleLog->flush();
+  }
+}
+
+/*
+ */
+
+#ifdef CCXX_OS_POSIX
+
+static const int __fatalSignals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL,
+                                      SIGABRT };
+
+#endif
+
+/*
+ */
+
+void Log::_flushOnCrash(int sig)
+{
+#ifdef CCXX_OS_POSIX
+
+  // Only async-signal-safe operations may be used here. If the crashing
+  // thread was inside Log, the loggers may be in an inconsistent state, so
+  // nothing is flushed; otherwise each logger skips the flush if another
+  // thread is using it. The crashing flag keeps the loggers from being
+  // deleted in the meantime.
+
+  LogThreadState *state = __threadState;
+
+  if(! (state && (state->active.get() != 0))
+     && (__crashing.testAndSet(1, 0) == 0))
+  {
+    AsyncLogger *async = _asyncFileLog;
+
+    if(async)
+      async->flushOnCrash();
+
+    if(_fileLog)
+      _fileLog->flushOnCrash();
+
     if(_consoleLog)
-      delete _consoleLog;
+      _consoleLog->flushOnCrash();
+  }
+
+  // SA_RESETHAND has restored the default disposition
+  ::raise(sig);
+
+#endif
+}
+
+/*
+ */
+
+void Log::setFlushOnCrash(bool flag)
+{
+#ifdef CCXX_OS_POSIX
+
+  struct sigaction act;
+  std::memset(&act, 0, sizeof(act));
+  ::sigemptyset(&act.sa_mask);
+
+  if(flag)
+  {
+    act.sa_handler = &Log::_flushOnCrash;
+    act.sa_flags = SA_RESETHAND;
+  }
+  else
+    act.sa_handler = SIG_DFL;
+
+  for(size_t i = 0; i < CCXX_LENGTHOF(__fatalSignals); ++i)
+    ::sigaction(__fatalSignals[i], &act, NULL);
+
+#endif
+}
+
+/*
+ */
+
+void Log::setConsoleLogger(ConsoleLogger *logger)
+{
+  ConsoleLogger *old = NULL;
 
+  synchronized(_lock)
+  {
+    old = _consoleLog;
     _consoleLog = logger;
   }
+
+  __waitForLoggers();
+  delete old;
 }
 
 /*
@@ -165,25 +532,68 @@ void Log::setConsoleLogger(ConsoleLogger *logger)
 void Log::log(LogLevel level, const char *file, int line, const char *message,
               ...)
 {
-  synchronized(_lock)
+  if(! isLogLevelEnabled(level))
+    return;
+
+  va_list vp;
+
+  va_start(vp, message);
+  _vlog(level, file, line, message, vp);
+  va_end(vp);
+}
+
+/*
+ */
+
+void Log::_vlog(LogLevel level, const char *file, int line,
+                const char *message, va_list args)
+{
+  LogActivity activity;
+  AsyncLogger *async = _asyncFileLog;
+  Logger *deferred = NULL;
+
+  // asynchronous file logging doesn't need the lock at all
+
+  if(_useConsoleLog || (_useFileLog && ! async))
   {
-    if(_useConsoleLog && _consoleLog)
+    synchronized(_lock)
     {
-      va_list vp;
-
-      va_start(vp, message);
-      _consoleLog->vlog(level, file, line, message, vp);
-      va_end(vp);
+      if(_useConsoleLog && _consoleLog)
+      {
+        va_list vp;
+
+        va_copy(vp, args);
+        _consoleLog->vlog(level, file, line, message, vp);
+        va_end(vp);
+      }
+
+      if(_useFileLog && _fileLog && ! async)
+      {
+        va_list vp;
+
+        va_copy(vp, args);
+        _fileLog->vlog(level, file, line, message, vp);
+        va_end(vp);
+
+        if(_fileLog->hasDeferredWork())
+          deferred = _fileLog;
+      }
     }
+  }
 
-    if(_useFileLog && _fileLog)
-    {
-      va_list vp;
+  // a log rotation is completed after the lock has been released; the
+  // activity keeps the logger alive until then
 
-      va_start(vp, message);
-      _fileLog->vlog(level, file, line, message, vp);
-      va_end(vp);
-    }
+  if(deferred)
+    deferred->completeDeferredWork();
+
+  if(_useFileLog && async)
+  {
+    va_list vp;
+
+    va_copy(vp, args);
+    async->vlog(level, file, line, message, vp);
+    va_end(vp);
   }
 }
 
@@ -193,11 +603,33 @@ void Log::log(LogLevel level, const char *file, int line, const char *message,
 void Log::vlogFile(LogLevel level, const char *file, int line,
                    const char *message, va_list args)
 {
+  if(! (_useFileLog && (_levelMask.load() & level)))
+    return;
+
+  LogActivity activity;
+  AsyncLogger *async = _asyncFileLog;
+
+  if(_useFileLog && async)
+  {
+    async->vlog(level, file, line, message, args);
+    return;
+  }
+
+  Logger *deferred = NULL;
+
   synchronized(_lock)
   {
     if(_useFileLog && _fileLog)
+    {
       _fileLog->vlog(level, file, line, message, args);
+
+      if(_fileLog->hasDeferredWork())
+        deferred = _fileLog;
+    }
   }
+
+  if(deferred)
+    deferred->completeDeferredWork();
 }
 
 /*
@@ -206,6 +638,11 @@ void Log::vlogFile(LogLevel level, const char *file, int line,
 void Log::vlogConsole(LogLevel level, const char *file, int line,
                       const char *message, va_list args)
 {
+  if(! (_useConsoleLog && (_levelMask.load() & level)))
+    return;
+
+  LogActivity activity;
+
   synchronized(_lock)
   {
     if(_useConsoleLog && _consoleLog)
@@ -219,6 +656,7 @@ void Log::vlogConsole(LogLevel level, const char *file, int line,
 bool Log::assert_(const char *file, int line, const char *expr)
 {
   log(LogError, file, line, "Assertion failed: %s", expr);
+  flush();
   ::abort();
 
   return(true);
@@ -228,12 +666,12 @@ bool Log::assert_(const char *file, int line, const char *expr)
  */
 
 LogFunctor::LogFunctor(const char *file, int line,
-                       LogLevel level /* = Log_debug */,
-                       bool nodebug /* = false */)
+                       LogLevel level /* = LogDebug */,
+                       bool disabled /* = false */)
   : _file(file),
     _line(line),
     _level(level),
-    _nodebug(nodebug)
+    _disabled(disabled)
 {
 }
 
@@ -249,28 +687,14 @@ LogFunctor::~LogFunctor()
 
 void LogFunctor::operator()(const char *fmt, ...)
 {
-  if((_level == LogDebug) && _nodebug)
+  if(_disabled || ! Log::isLogLevelEnabled(_level))
     return;
 
-  ScopedLock guard(Log::_lock);
-
-  if(Log::_useConsoleLog && Log::_consoleLog)
-  {
-    va_list vp;
-
-    va_start(vp, fmt);
-    Log::_consoleLog->vlog(_level, _file, _line, fmt, vp);
-    va_end(vp);
-  }
+  va_list vp;
 
-  if(Log::_useFileLog && Log::_fileLog)
-  {
-    va_list vp;
-
-    va_start(vp, fmt);
-    Log::_fileLog->vlog(_level, _file, _line, fmt, vp);
-    va_end(vp);
-  }
+  va_start(vp, fmt);
+  Log::_vlog(_level, _file, _line, fmt, vp);
+  va_end(vp);
 }
 
 /*
@@ -278,28 +702,14 @@ void LogFunctor::operator()(const char *fmt, ...)
 
 void LogFunctor::operator()(LogLevel level, const char *fmt, ...)
 {
-  if((level == LogDebug) && _nodebug)
+  if(_disabled || ! Log::isLogLevelEnabled(level))
     return;
 
-  ScopedLock guard(Log::_lock);
+  va_list vp;
 
-  if(Log::_useConsoleLog && Log::_consoleLog)
-  {
-    va_list vp;
-
-    va_start(vp, fmt);
-    Log::_consoleLog->vlog(_level, _file, _line, fmt, vp);
-    va_end(vp);
-  }
-
-  if(Log::_useFileLog && Log::_fileLog)
-  {
-    va_list vp;
-
-    va_start(vp, fmt);
-    Log::_fileLog->vlog(_level, _file, _line, fmt, vp);
-    va_end(vp);
-  }
+  va_start(vp, fmt);
+  Log::_vlog(level, _file, _line, fmt, vp);
+  va_end(vp);
 }
 
 
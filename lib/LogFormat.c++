@@ -25,6 +25,7 @@
 #endif
 
 #include "commonc++/Common.h++"
+#include "commonc++/AtomicCounter.h++"
 #include "commonc++/DeleteFunctor.h++"
 #include "commonc++/File.h++"
 #include "commonc++/LogFormat.h++"
@@ -33,6 +34,7 @@
 #include "commonc++/System.h++"
 #include "commonc++/TerminalAttr.h++"
 #include "commonc++/Thread.h++"
+#include "commonc++/ThreadLocal.h++"
 
 #include <algorithm>
 #include <cstring>
@@ -54,6 +56,164 @@ static const char _levelTokens[] = { NUL, 'D', 'I', NUL, 'W', NUL, NUL, NUL,
 
 size_t LogFormat::_eolLen = std::strlen(File::eol);
 
+static AtomicCounter __formatIDs;
+
+/*
+ * Per-thread cache of formatted dates and times. Within a given second
+ * the formatted text differs only in its millisecond fields, so it is
+ * rendered once per second and then copied, with the current
+ * milliseconds patched in. Entries are keyed by the identifier of the
+ * LogFormat that produced them; a new identifier is assigned whenever
+ * the date or time formats change.
+ */
+
+struct TimestampText
+{
+  static const uint_t MAX_FIELDS = 4;
+  static const size_t MAX_LENGTH = 64;
+
+  bool valid;
+  size_t len;
+  uint_t numFields;
+  size_t offsets[MAX_FIELDS];
+  char pads[MAX_FIELDS];
+  char text[MAX_LENGTH];
+};
+
+struct TimestampEntry
+{
+  int32_t id;
+  time_ms_t second;
+  TimestampText texts[4]; // indexed by (token - TOK_TIME_LONG)
+};
+
+struct TimestampCache
+{
+  static const uint_t NUM_ENTRIES = 4;
+
+  TimestampCache()
+    : next(0)
+  {
+    for(uint_t i = 0; i < NUM_ENTRIES; ++i)
+      entries[i].id = -1;
+  }
+
+  TimestampEntry entries[NUM_ENTRIES];
+  uint_t next;
+};
+
+/*
+ */
+
+static TimestampCache* __getTimestampCache()
+{
+  // never deleted, as it may still be needed by other static destructors
+  static ThreadLocal<TimestampCache>* __slot
+    = new ThreadLocal<TimestampCache>();
+
+  TimestampCache* cache = __slot->getValue();
+  if(! cache)
+  {
+    cache = new TimestampCache();
+    __slot->setValue(cache);
+  }
+
+  return(cache);
+}
+
+/*
+ */
+
+static size_t __formatTimestamp(const DateTimeFormat& format, int32_t id,
+                                int which, time_ms_t time, char* buf,
+                                size_t bufsz)
+{
+  if(bufsz == 0)
+    return(0);
+
+  TimestampCache* cache = __getTimestampCache();
+  time_ms_t second = time / 1000;
+  int ms = static_cast<int>(time % 1000);
+  if(ms < 0)
+  {
+    ms += 1000;
+    --second;
+  }
+
+  TimestampEntry* entry = NULL;
+  for(uint_t i = 0; i < TimestampCache::NUM_ENTRIES; ++i)
+  {
+    if(cache->entries[i].id == id)
+    {
+      entry = &(cache->entries[i]);
+      break;
+    }
+  }
+
+  if(! entry)
+  {
+    entry = &(cache->entries[cache->next]);
+    cache->next = (cache->next + 1) % TimestampCache::NUM_ENTRIES;
+    entry->id = id;
+    entry->second = second - 1; // force invalidation below
+  }
+
+  if(entry->second != second)
+  {
+    entry->second = second;
+    for(int i = 0; i < 4; ++i)
+      entry->texts[i].valid = false;
+  }
+
+  TimestampText& text = entry->texts[which];
+  if(! text.valid)
+  {
+    DateTime dt(time);
+    text.len = format.format(dt, text.text, sizeof(text.text), text.offsets,
+                             text.pads, TimestampText::MAX_FIELDS,
+                             text.numFields);
+    text.valid = true;
+  }
+
+  if((text.numFields > TimestampText::MAX_FIELDS)
+     || (text.len + 1 >= sizeof(text.text)))
+  {
+    // not cacheable; format directly
+
+    DateTime dt(time);
+    return(format.format(dt, buf, bufsz));
+  }
+
+  size_t n = std::min(text.len, bufsz - 1);
+  std::memcpy(buf, text.text, n);
+  buf[n] = NUL;
+
+  char digits[3] = { static_cast<char>('0' + (ms / 100)),
+                     static_cast<char>('0' + ((ms / 10) % 10)),
+                     static_cast<char>('0' + (ms % 10)) };
+
+  for(uint_t i = 0; i < text.numFields; ++i)
+  {
+    size_t off = text.offsets[i];
+    if(off + 3 > n)
+      break;
+
+    char* p = buf + off;
+    p[0] = digits[0];
+    p[1] = digits[1];
+    p[2] = digits[2];
+
+    if(ms < 100)
+    {
+      p[0] = text.pads[i];
+      if(ms < 10)
+        p[1] = text.pads[i];
+    }
+  }
+
+  return(n);
+}
+
 /*
  * bounded string output functions
  */
@@ -125,7 +285,9 @@ LogFormat::LogFormat(String format /* = "[%D %T] %F:%L %m" */)
     _shortDateFormat("%0y/%0m/%0d"),
     _longDateFormat("%0d-%$m-%0Y"),
     _shortTimeFormat("%_H:%0M:%0S"),
-    _longTimeFormat("%_H:%0M:%0S.%0s")
+    _longTimeFormat("%_H:%0M:%0S.%0s"),
+    _cacheID(++__formatIDs),
+    _stylesEnabled(true)
 {
   setFormat(format);
 }
@@ -202,10 +364,20 @@ void LogFormat::setFormat(const String& format)
 
 void LogFormat::format(CharBuffer& buffer, LogLevel level, const char* file,
                        int line, const char* message, va_list args)
+{
+  format(buffer, level, System::currentTimeMillis(), file, line, message,
+         args);
+}
+
+/*
+ */
+
+void LogFormat::format(CharBuffer& buffer, LogLevel level, time_ms_t time,
+                       const char* file, int line, const char* message,
+                       va_list args)
 {
   const char* p;
   size_t len;
-  DateTime now;
 
   size_t lim = buffer.getLimit();
   if(lim < _eolLen)
@@ -219,6 +391,10 @@ void LogFormat::format(CharBuffer& buffer, LogLevel level, const char* file,
   {
     Token *tok = *iter;
 
+    if(! _stylesEnabled && (tok->_token >= TOK_BOLD)
+       && (tok->_token <= TOK_AUTOCOLOR))
+      continue;
+
     switch(tok->_token)
     {
       case TOK_LITERAL:
@@ -228,26 +404,30 @@ void LogFormat::format(CharBuffer& buffer, LogLevel level, const char* file,
         break;
 
       case TOK_TIME_LONG:
-        len = _longTimeFormat.format(now, buffer.getPointer(),
-                                     buffer.getRemaining());
+        len = __formatTimestamp(_longTimeFormat, _cacheID,
+                                (tok->_token - TOK_TIME_LONG), time,
+                                buffer.getPointer(), buffer.getRemaining());
         buffer.bump(len);
         break;
 
       case TOK_TIME_SHORT:
-        len = _shortTimeFormat.format(now, buffer.getPointer(),
-                                      buffer.getRemaining());
+        len = __formatTimestamp(_shortTimeFormat, _cacheID,
+                                (tok->_token - TOK_TIME_LONG), time,
+                                buffer.getPointer(), buffer.getRemaining());
         buffer.bump(len);
         break;
 
       case TOK_DATE_LONG:
-        len = _longDateFormat.format(now, buffer.getPointer(),
-                                     buffer.getRemaining());
+        len = __formatTimestamp(_longDateFormat, _cacheID,
+                                (tok->_token - TOK_TIME_LONG), time,
+                                buffer.getPointer(), buffer.getRemaining());
         buffer.bump(len);
         break;
 
       case TOK_DATE_SHORT:
-        len = _shortDateFormat.format(now, buffer.getPointer(),
-                                      buffer.getRemaining());
+        len = __formatTimestamp(_shortDateFormat, _cacheID,
+                                (tok->_token - TOK_TIME_LONG), time,
+                                buffer.getPointer(), buffer.getRemaining());
         buffer.bump(len);
         break;
 
@@ -511,6 +691,7 @@ void LogFormat::clearTokens()
 void LogFormat::setShortDateFormat(const String &format)
 {
   _shortDateFormat.setFormat(format);
+  _cacheID = ++__formatIDs;
 }
 
 /*
@@ -519,6 +700,7 @@ void LogFormat::setShortDateFormat(const String &format)
 void LogFormat::setLongDateFormat(const String &format)
 {
   _longDateFormat.setFormat(format);
+  _cacheID = ++__formatIDs;
 }
 
 
@@ -528,6 +710,7 @@ void LogFormat::setLongDateFormat(const String &format)
 void LogFormat::setShortTimeFormat(const String &format)
 {
   _shortTimeFormat.setFormat(format);
+  _cacheID = ++__formatIDs;
 }
 
 /*
@@ -536,6 +719,15 @@ void LogFormat::setShortTimeFormat(const String &format)
 void LogFormat::setLongTimeFormat(const String &format)
 {
   _longTimeFormat.setFormat(format);
+  _cacheID = ++__formatIDs;
+}
+
+/*
+ */
+
+void LogFormat::setStylesEnabled(bool enabled)
+{
+  _stylesEnabled = enabled;
 }
 
 /*
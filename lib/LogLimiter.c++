@@ -0,0 +1,106 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/LogLimiter.h++"
+#include "commonc++/Log.h++"
+#include "commonc++/System.h++"
+
+namespace ccxx {
+
+/*
+ */
+
+LogLimiter::LogLimiter(uint_t maxPerSecond, uint_t sampleRate /* = 1 */)
+  : _maxPerSecond(static_cast<int32_t>(maxPerSecond)),
+    _sampleRate(static_cast<int32_t>(sampleRate)),
+    _window(0),
+    _count(0),
+    _calls(0),
+    _suppressed(0)
+{
+}
+
+/*
+ */
+
+LogLimiter::~LogLimiter()
+{
+}
+
+/*
+ */
+
+bool LogLimiter::allow()
+{
+  if(_sampleRate > 1)
+  {
+    uint32_t n = static_cast<uint32_t>(++_calls - 1);
+
+    if((n % static_cast<uint32_t>(_sampleRate)) != 0)
+    {
+      ++_suppressed;
+      return(false);
+    }
+  }
+
+  if(_maxPerSecond > 0)
+  {
+    int32_t now = static_cast<int32_t>(System::currentTimeMillis() / 1000);
+    int32_t window = _window.get();
+
+    // only one thread gets to start a new window; the count is
+    // approximate across the boundary, which is fine for this purpose
+
+    if((window != now) && (_window.testAndSet(now, window) == window))
+      _count.set(0);
+
+    if(++_count > _maxPerSecond)
+    {
+      ++_suppressed;
+      return(false);
+    }
+  }
+
+  return(true);
+}
+
+/*
+ */
+
+void LogLimiter::reportSuppressed(LogLevel level, const char* file, int line)
+{
+  if(_suppressed.get() == 0)
+    return;
+
+  int32_t count = _suppressed.swap(0);
+
+  if(count > 0)
+    Log::log(level, file, line, "*** %d similar log message(s) suppressed ***",
+             count);
+}
+
+
+} // namespace ccxx
@@ -0,0 +1,134 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/LogSite.h++"
+#include "commonc++/BinaryLogCodec.h++"
+#include "commonc++/Mutex.h++"
+#include "commonc++/ScopedLock.h++"
+
+#include <vector>
+
+namespace ccxx {
+
+/*
+ */
+
+const uint_t LogSite::MAX_ARGS;
+
+/*
+ * The site registry. It is deliberately never destroyed, so that sites can
+ * unregister themselves while static objects are being torn down. IDs are
+ * not reused.
+ */
+
+class LogSiteRegistry : public std::vector<const LogSite *>
+{
+ public:
+
+  Mutex lock;
+};
+
+static LogSiteRegistry& __registry()
+{
+  static LogSiteRegistry* registry = new LogSiteRegistry();
+
+  return(*registry);
+}
+
+/*
+ */
+
+LogSite::LogSite(const char* format, const char* file, int line)
+  : _format(format),
+    _file(file),
+    _line(line),
+    _id(0)
+{
+  _binary = BinaryLogCodec::parseSignature(format, _signature,
+                                           sizeof(_signature));
+  if(! _binary)
+    _signature[0] = NUL;
+
+  LogSiteRegistry& registry = __registry();
+  Mutex& lock = registry.lock;
+
+  synchronized(lock)
+  {
+    registry.push_back(this);
+    _id = static_cast<uint32_t>(registry.size());
+  }
+}
+
+/*
+ */
+
+LogSite::~LogSite()
+{
+  LogSiteRegistry& registry = __registry();
+  Mutex& lock = registry.lock;
+
+  synchronized(lock)
+  {
+    registry[_id - 1] = NULL;
+  }
+}
+
+/*
+ */
+
+const LogSite* LogSite::lookup(uint32_t id)
+{
+  LogSiteRegistry& registry = __registry();
+  Mutex& lock = registry.lock;
+  const LogSite* site = NULL;
+
+  synchronized(lock)
+  {
+    if((id > 0) && (id <= registry.size()))
+      site = registry[id - 1];
+  }
+
+  return(site);
+}
+
+/*
+ */
+
+uint32_t LogSite::getCount()
+{
+  LogSiteRegistry& registry = __registry();
+  Mutex& lock = registry.lock;
+  uint32_t count = 0;
+
+  synchronized(lock)
+  {
+    count = static_cast<uint32_t>(registry.size());
+  }
+
+  return(count);
+}
+
+} // namespace ccxx
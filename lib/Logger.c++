@@ -111,5 +111,50 @@ bool Logger::isLogLevelEnabled(LogLevel level) const
   return((_levelMask & level) != 0);
 }
 
+/*
+ */
+
+bool Logger::isBinary() const
+{
+  return(false);
+}
+
+/*
+ */
+
+void Logger::flush()
+{
+}
+
+/*
+ */
+
+void Logger::flushOnCrash()
+{
+}
+
+/*
+ */
+
+bool Logger::writeOnCrash(CharBuffer& /* buffer */)
+{
+  return(false);
+}
+
+/*
+ */
+
+bool Logger::hasDeferredWork() const
+{
+  return(false);
+}
+
+/*
+ */
+
+void Logger::completeDeferredWork()
+{
+}
+
 
 } // namespace ccxx
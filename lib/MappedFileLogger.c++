@@ -0,0 +1,584 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/MappedFileLogger.h++"
+#include "commonc++/File.h++"
+#include "commonc++/MemoryMappedFile.h++"
+#include "commonc++/ScopedLock.h++"
+#include "commonc++/System.h++"
+#include "commonc++/Thread.h++"
+#include "commonc++/ThreadLocal.h++"
+
+#include <cstdio>
+#include <cstring>
+
+namespace ccxx {
+
+/*
+ */
+
+const size_t MappedFileLogger::MIN_SEGMENT_SIZE = 64;
+
+const size_t MappedFileLogger::MAX_SEGMENT_SIZE = 1024 * 1024;
+
+const timespan_ms_t MappedFileLogger::RETRY_INTERVAL = 1000;
+
+/*
+ */
+
+class MappedFileLogger::Segment
+{
+ public:
+
+  // A segment is in use by the loggers while it is Current. Once it is
+  // Retired, the roller thread closes it as soon as the last writer has
+  // left, and then creates the next segment in its place; the segment is
+  // Ready once that has been attempted.
+
+  enum State { Current, Retired, Closed, Ready };
+
+  Segment()
+    : file(NULL),
+      base(NULL),
+      size(0),
+      used(0),
+      state(Closed)
+  { }
+
+  MemoryMappedFile* file;
+  String path;
+  byte_t* base;
+  int32_t size;
+
+  // the number of bytes reserved so far; this may exceed the size of the
+  // segment once it fills up
+  AtomicCounter reserved;
+
+  // the number of threads currently writing to the segment
+  AtomicCounter writers;
+
+  // the end of the data, as recorded by the thread whose reservation
+  // crossed the end of the segment
+  volatile int32_t used;
+
+  // changed only with the roll lock held
+  volatile State state;
+};
+
+/*
+ */
+
+class MappedFileLogger::BufferSlot : public ThreadLocal<CharBuffer>
+{
+ protected:
+
+  CharBuffer* initialValue()
+  { return(new CharBuffer(static_cast<uint_t>(Logger::LOG_BUFFER_SIZE))); }
+};
+
+/*
+ */
+
+MappedFileLogger::MappedFileLogger(const String& format
+                                   /* = "[%d %t] %m" */,
+                                   size_t segmentSize /* = 16384 */,
+                                   timespan_ms_t syncInterval /* = 1000 */)
+  : Logger(format),
+    _syncInterval(syncInterval < 0 ? 0 : syncInterval),
+    _lastSync(System::currentTimeMillis()),
+    _retryTime(0),
+    _generation(0),
+    _rollRunner(this, &MappedFileLogger::_runRoller),
+    _roller(NULL),
+    _rolling(false),
+    _stopping(false),
+    _slot(new BufferSlot()),
+    _sequence(0)
+{
+  if(segmentSize < MIN_SEGMENT_SIZE)
+    segmentSize = MIN_SEGMENT_SIZE;
+  else if(segmentSize > MAX_SEGMENT_SIZE)
+    segmentSize = MAX_SEGMENT_SIZE;
+
+  _segmentSize = static_cast<int32_t>(segmentSize * 1024);
+
+  _segments[0] = new Segment();
+  _segments[0]->state = Segment::Current;
+  _segments[1] = new Segment();
+}
+
+/*
+ */
+
+MappedFileLogger::~MappedFileLogger()
+{
+  if(_roller)
+  {
+    synchronized(_rollLock)
+    {
+      _stopping = true;
+      _rollCond.notifyAll();
+    }
+
+    _roller->join();
+    delete _roller;
+  }
+
+  // a segment that was created in advance and never used is removed
+
+  _closeSegment(_segments[0]);
+  _closeSegment(_segments[1]);
+
+  delete _segments[0];
+  delete _segments[1];
+  delete _slot;
+}
+
+/*
+ */
+
+bool MappedFileLogger::setFile(const String& dir, const String& name)
+{
+  synchronized(_rollLock)
+  {
+    // wait until the roller is done with the other segment, since it may
+    // be creating a file with the old name
+
+    int32_t gen = _generation.get();
+    Segment *next = _segments[(gen + 1) & 1];
+
+    while(_rolling || (next->state == Segment::Retired))
+      _rollCond.wait(_rollLock);
+
+    _dir = File::removeTrailingSeparators(dir);
+    _name = name;
+    _sequence = 0;
+
+    if(next->state == Segment::Ready)
+      _closeSegment(next);
+
+    _openSegment(next);
+    _publish(gen);
+
+    if(! _roller)
+    {
+      _roller = new Thread(&_rollRunner);
+      _roller->start();
+    }
+  }
+
+  return(! getCurrentPath().isEmpty());
+}
+
+/*
+ */
+
+String MappedFileLogger::getCurrentPath()
+{
+  String path;
+
+  synchronized(_rollLock)
+  {
+    Segment *segment = _segments[_generation.get() & 1];
+    if(segment->base)
+      path = segment->path;
+  }
+
+  return(path);
+}
+
+/*
+ */
+
+void MappedFileLogger::vlog(LogLevel level, const char* file, int line,
+                            const char* message, va_list args)
+{
+  if(! isLogLevelEnabled(level))
+    return;
+
+  // Logger's own buffer can't be shared between threads
+
+  CharBuffer *buf = _slot->getValue();
+  if(! buf)
+    return;
+
+  buf->clear();
+  getLogFormat().format(*buf, level, file, line, message, args);
+  buf->flip();
+
+  _append(buf->getPointer(), buf->getRemaining());
+}
+
+/*
+ */
+
+void MappedFileLogger::flush()
+{
+  synchronized(_rollLock)
+  {
+    Segment *segment = _segments[_generation.get() & 1];
+    if(segment->file)
+    {
+      try
+      {
+        segment->file->sync(false);
+      }
+      catch(IOException &ex) { }
+    }
+  }
+}
+
+/*
+ */
+
+bool MappedFileLogger::write(CharBuffer& buffer)
+{
+  size_t len = buffer.getRemaining();
+
+  if(! _append(buffer.getPointer(), len))
+    return(false);
+
+  buffer.bump(static_cast<uint_t>(len));
+  return(true);
+}
+
+/*
+ */
+
+bool MappedFileLogger::_append(const char* data, size_t len)
+{
+  if(len == 0)
+    return(true);
+
+  if(len > static_cast<size_t>(_segmentSize))
+    return(false);
+
+  int32_t delta = static_cast<int32_t>(len);
+
+  for(;;)
+  {
+    int32_t gen = _generation.get();
+    Segment *segment = _segments[gen & 1];
+
+    // register as a writer, so that the segment won't be closed while the
+    // data is being copied; if a rollover intervened, try again
+
+    ++(segment->writers);
+
+    if(_generation.get() != gen)
+    {
+      _leave(segment);
+      continue;
+    }
+
+    if(! segment->base)
+    {
+      _leave(segment);
+
+      // the segment could not be created; try again, but not too often
+
+      if(! _retry(gen))
+        return(false);
+
+      continue;
+    }
+
+    int32_t end = (segment->reserved += delta);
+    int32_t start = end - delta;
+
+    if(end <= segment->size)
+    {
+      std::memcpy(segment->base + start, data, len);
+
+      if(_syncInterval > 0)
+        _sync(segment);
+
+      _leave(segment);
+      return(true);
+    }
+
+    if(start <= segment->size)
+    {
+      // this reservation crossed the end of the segment, so this thread
+      // is responsible for rolling over to the next one
+
+      segment->used = start;
+      _leave(segment);
+
+      _rollover(gen);
+    }
+    else
+    {
+      _leave(segment);
+
+      // wait for the thread whose reservation crossed the end
+
+      synchronized(_rollLock)
+      {
+        while(_generation.get() == gen)
+          _rollCond.wait(_rollLock);
+      }
+    }
+  }
+}
+
+/*
+ */
+
+void MappedFileLogger::_leave(Segment* segment)
+{
+  // the last writer to leave a retired segment hands it off to the roller
+
+  if(((--(segment->writers)) == 0) && (segment->state == Segment::Retired))
+  {
+    synchronized(_rollLock)
+    {
+      _rollCond.notifyAll();
+    }
+  }
+}
+
+/*
+ */
+
+void MappedFileLogger::_rollover(int32_t gen)
+{
+  synchronized(_rollLock)
+  {
+    // the next segment has normally been created in advance; if not, let
+    // the roller know that it is needed now, and wait for it
+
+    while(_generation.get() == gen) // otherwise another thread got here first
+    {
+      if(_segments[(gen + 1) & 1]->state == Segment::Ready)
+      {
+        _publish(gen);
+        break;
+      }
+
+      _rollCond.notifyAll();
+      _rollCond.wait(_rollLock);
+    }
+  }
+}
+
+/*
+ */
+
+bool MappedFileLogger::_retry(int32_t gen)
+{
+  if(System::currentTimeMillis() < _retryTime)
+    return(false);
+
+  synchronized(_rollLock)
+  {
+    if(_name.isEmpty() || (System::currentTimeMillis() < _retryTime))
+      return(false);
+  }
+
+  _rollover(gen);
+
+  return(true);
+}
+
+/*
+ */
+
+void MappedFileLogger::_publish(int32_t gen)
+{
+  // called with _rollLock held; once the new generation is published, no
+  // more writers can register with the current segment
+
+  Segment *current = _segments[gen & 1];
+  Segment *next = _segments[(gen + 1) & 1];
+
+  next->state = Segment::Current;
+  current->state = Segment::Retired;
+  _generation.set(gen + 1);
+
+  _rollCond.notifyAll();
+}
+
+/*
+ */
+
+void MappedFileLogger::_runRoller()
+{
+  synchronized(_rollLock)
+  {
+    while(! _stopping)
+    {
+      int32_t gen = _generation.get();
+      Segment *segment = _segments[(gen + 1) & 1];
+
+      // if the current segment could not be created either, the writers
+      // decide when to try again
+
+      bool retry = (_segments[gen & 1]->base
+                    || (System::currentTimeMillis() >= _retryTime));
+
+      if((segment->state == Segment::Retired)
+         && (segment->writers.get() == 0))
+      {
+        // no other thread touches the segment until it is Ready, so the
+        // file can be closed and created without holding the lock
+
+        _rolling = true;
+        _rollLock.unlock();
+
+        _closeSegment(segment);
+
+        _rollLock.lock();
+        _rolling = false;
+        segment->state = Segment::Closed;
+        _rollCond.notifyAll();
+      }
+      else if((segment->state == Segment::Closed) && ! _name.isEmpty()
+              && retry)
+      {
+        _rolling = true;
+        _rollLock.unlock();
+
+        _openSegment(segment);
+
+        _rollLock.lock();
+        _rolling = false;
+        segment->state = Segment::Ready;
+        _rollCond.notifyAll();
+      }
+      else
+        _rollCond.wait(_rollLock);
+    }
+  }
+}
+
+/*
+ */
+
+void MappedFileLogger::_openSegment(Segment* segment)
+{
+  segment->reserved.set(0);
+  segment->used = 0;
+
+  if(_name.isEmpty())
+    return;
+
+  for(;;)
+  {
+    char num[16];
+    std::snprintf(num, sizeof(num), "%06u", ++_sequence);
+
+    segment->path.clear();
+    segment->path << _dir;
+
+    if(! _dir.endsWith(File::separator))
+      segment->path << File::separator;
+
+    segment->path << _name << '-' << num << ".log";
+
+    if(! File::exists(segment->path))
+      break;
+  }
+
+  segment->file = new MemoryMappedFile(segment->path);
+
+  try
+  {
+    segment->file->create(static_cast<uint64_t>(_segmentSize));
+    segment->base = segment->file->getBase();
+    segment->size = _segmentSize;
+  }
+  catch(IOException &ex)
+  {
+    delete segment->file;
+    segment->file = NULL;
+
+    _retryTime = System::currentTimeMillis() + RETRY_INTERVAL;
+  }
+}
+
+/*
+ */
+
+void MappedFileLogger::_closeSegment(Segment* segment)
+{
+  // the caller ensures that no threads are writing to the segment
+
+  if(! segment->file)
+    return;
+
+  int32_t reserved = segment->reserved.get();
+  int32_t length = (reserved <= segment->size) ? reserved : segment->used;
+
+  segment->file->close();
+  delete segment->file;
+  segment->file = NULL;
+  segment->base = NULL;
+  segment->size = 0;
+
+  if(segment->state == Segment::Ready)
+  {
+    // created in advance, but never used
+
+    File::remove(segment->path);
+    return;
+  }
+
+  // discard the unused, preallocated space
+
+  try
+  {
+    File file(segment->path);
+    file.open(IOWrite, FileOpen);
+    file.truncate(static_cast<uint64_t>(length));
+    file.close();
+  }
+  catch(IOException &ex) { }
+}
+
+/*
+ */
+
+void MappedFileLogger::_sync(Segment* segment)
+{
+  time_ms_t now = System::currentTimeMillis();
+
+  if((now - _lastSync < _syncInterval) || (_syncing.testAndSet(1, 0) != 0))
+    return;
+
+  _lastSync = now;
+
+  try
+  {
+    segment->file->sync(true);
+  }
+  catch(IOException &ex) { }
+
+  _syncing.set(0);
+}
+
+
+} // namespace ccxx
@@ -52,7 +52,9 @@ namespace ccxx {
 
 MemoryMappedFile::MemoryMappedFile(const String& path)
   : _path(path),
-    _open(false)
+    _open(false),
+    _prefault(false),
+    _hugePages(false)
 {
 }
 
@@ -103,31 +105,6 @@ void MemoryMappedFile::open(uint64_t size /* = 0 */,
       throw IOException(System::getErrorString("CreateFile"));
   }
 
-  DWORD rangeLo = static_cast<DWORD>(size & 0xFFFFFFFF);
-  DWORD rangeHi = static_cast<DWORD>((size >> 32) & 0xFFFFFFFF);
-
-  _memHandle = ::CreateFileMapping(_handle, &sa,
-                                   (readOnly ? PAGE_READONLY : PAGE_READWRITE),
-                                   rangeHi, rangeLo, NULL);
-  if(_memHandle == NULL)
-  {
-    String err = System::getErrorString("CreateFileMapping");
-    ::CloseHandle(_handle);
-    throw IOException(err);
-  }
-
-  _base = reinterpret_cast<byte_t *>
-    (::MapViewOfFile(_memHandle,
-                     (readOnly ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS),
-                     0, 0, 0));
-
-  if(_base == NULL)
-  {
-    String err = System::getErrorString("MapViewOfFile");
-    ::CloseHandle(_handle);
-    throw IOException(err);
-  }
-
 #else
 
   CString cstr_path = _path.toUTF8();
@@ -157,21 +134,96 @@ void MemoryMappedFile::open(uint64_t size /* = 0 */,
     }
   }
 
-  _base = static_cast<byte_t *>(
-    ::mmap(NULL, size, (readOnly ? PROT_READ : (PROT_READ | PROT_WRITE)),
-           MAP_SHARED, _handle, 0));
+#endif
 
-  if(_base == MAP_FAILED)
+  _map(size, readOnly);
+}
+
+/*
+ */
+
+void MemoryMappedFile::create(uint64_t size,
+                              const Permissions& perm
+                              /* = Permissions::USER_READ_WRITE */)
+{
+  if(_open)
+    throw IOException("already open");
+
+  if(size == 0)
+    throw IOException("cannot map zero-length file");
+
+#ifdef CCXX_OS_WINDOWS
+
+  SECURITY_ATTRIBUTES sa;
+  WinPerms wperm;
+
+  Windows::encodePermissions(perm, wperm);
+
+  sa.nLength = sizeof(SECURITY_ATTRIBUTES);
+  sa.lpSecurityDescriptor = wperm.pdesc;
+  sa.bInheritHandle = FALSE;
+
+  _handle = ::CreateFileW(_path.data(), GENERIC_READ | GENERIC_WRITE,
+                          (FILE_SHARE_READ | FILE_SHARE_WRITE),
+                          &sa, CREATE_ALWAYS,
+                          (FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS),
+                          NULL);
+
+  if(_handle == INVALID_HANDLE_VALUE)
   {
-    String err = System::getErrorString("mmap");
+    int err = ::GetLastError();
+    if(err == ERROR_PATH_NOT_FOUND)
+      throw PathNotFoundException(_path);
+    else
+      throw IOException(System::getErrorString("CreateFile"));
+  }
+
+  // the file is extended to the mapping size when the mapping is created
+
+#else
+
+  mode_t perm_;
+  POSIX::encodePermissions(perm, perm_);
+
+  CString cstr_path = _path.toUTF8();
+  if((_handle = ::open(cstr_path.data(), (O_RDWR | O_CREAT | O_TRUNC),
+                       perm_)) < 0)
+  {
+    if(errno == ENOENT)
+      throw PathNotFoundException(_path);
+    else
+      throw IOException(System::getErrorString("open"));
+  }
+
+  // allocate the storage up front where possible, so that stores into the
+  // mapping cannot fail for lack of disk space
+
+  int r = -1;
+
+#ifdef HAVE_POSIX_FALLOCATE
+  r = ::posix_fallocate(_handle, 0, static_cast<off_t>(size));
+
+  // fall back to a sparse file only if the filesystem can't preallocate
+
+  if((r != 0) && (r != EINVAL) && (r != EOPNOTSUPP))
+  {
+    errno = r;
+    String err = System::getErrorString("posix_fallocate");
+    ::close(_handle);
+    throw IOException(err);
+  }
+#endif
+
+  if((r != 0) && (::ftruncate(_handle, static_cast<off_t>(size)) != 0))
+  {
+    String err = System::getErrorString("ftruncate");
     ::close(_handle);
     throw IOException(err);
   }
 
 #endif
 
-  _size = size;
-  _open = true;
+  _map(size, false);
 }
 
 /*
@@ -223,5 +275,213 @@ void MemoryMappedFile::sync(bool async /* = false */)
 #endif
 }
 
+/*
+ */
+
+void MemoryMappedFile::advise(AccessAdvice advice)
+{
+  advise(0, 0, advice);
+}
+
+/*
+ */
+
+void MemoryMappedFile::advise(uint64_t offset, uint64_t length,
+                              AccessAdvice advice)
+{
+  byte_t *base;
+  size_t size;
+
+  _range(offset, length, base, size);
+
+#ifdef CCXX_OS_POSIX
+
+  int flag = MADV_NORMAL;
+
+  switch(advice)
+  {
+    case AdviseSequential:
+      flag = MADV_SEQUENTIAL;
+      break;
+
+    case AdviseRandom:
+      flag = MADV_RANDOM;
+      break;
+
+    case AdviseWillNeed:
+      flag = MADV_WILLNEED;
+      break;
+
+    case AdviseDontNeed:
+      flag = MADV_DONTNEED;
+      break;
+
+    case AdviseNormal:
+    default:
+      break;
+  }
+
+  if(::madvise(base, size, flag) != 0)
+    throw IOException(System::getErrorString("madvise"));
+
+#endif
+}
+
+/*
+ */
+
+void MemoryMappedFile::lock(uint64_t offset /* = 0 */,
+                            uint64_t length /* = 0 */)
+{
+  byte_t *base;
+  size_t size;
+
+  _range(offset, length, base, size);
+
+#ifdef CCXX_OS_WINDOWS
+
+  if(::VirtualLock(base, size) == FALSE)
+    throw IOException(System::getErrorString("VirtualLock"));
+
+#else
+
+  if(::mlock(base, size) != 0)
+    throw IOException(System::getErrorString("mlock"));
+
+#endif
+}
+
+/*
+ */
+
+void MemoryMappedFile::unlock(uint64_t offset /* = 0 */,
+                              uint64_t length /* = 0 */)
+{
+  byte_t *base;
+  size_t size;
+
+  _range(offset, length, base, size);
+
+#ifdef CCXX_OS_WINDOWS
+
+  if(::VirtualUnlock(base, size) == FALSE)
+    throw IOException(System::getErrorString("VirtualUnlock"));
+
+#else
+
+  if(::munlock(base, size) != 0)
+    throw IOException(System::getErrorString("munlock"));
+
+#endif
+}
+
+/*
+ */
+
+void MemoryMappedFile::_range(uint64_t offset, uint64_t length,
+                              byte_t*& base, size_t& size) const
+{
+  if(! _open)
+    throw IOException("not mapped");
+
+  if(offset > _size)
+    throw OutOfBoundsException();
+
+  if(length == 0)
+    length = _size - offset;
+  else if(length > _size - offset)
+    throw OutOfBoundsException();
+
+  // widen the range to page boundaries
+
+  uint64_t pageSize = System::getPageSize();
+  uint64_t start = offset - (offset % pageSize);
+
+  base = _base + start;
+  size = static_cast<size_t>(length + (offset - start));
+}
+
+/*
+ */
+
+void MemoryMappedFile::_map(uint64_t size, bool readOnly)
+{
+#ifdef CCXX_OS_WINDOWS
+
+  DWORD rangeLo = static_cast<DWORD>(size & 0xFFFFFFFF);
+  DWORD rangeHi = static_cast<DWORD>((size >> 32) & 0xFFFFFFFF);
+
+  _memHandle = ::CreateFileMapping(_handle, NULL,
+                                   (readOnly ? PAGE_READONLY : PAGE_READWRITE),
+                                   rangeHi, rangeLo, NULL);
+  if(_memHandle == NULL)
+  {
+    String err = System::getErrorString("CreateFileMapping");
+    ::CloseHandle(_handle);
+    throw IOException(err);
+  }
+
+  _base = reinterpret_cast<byte_t *>
+    (::MapViewOfFile(_memHandle,
+                     (readOnly ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS),
+                     0, 0, 0));
+
+  if(_base == NULL)
+  {
+    String err = System::getErrorString("MapViewOfFile");
+    ::CloseHandle(_memHandle);
+    ::CloseHandle(_handle);
+    throw IOException(err);
+  }
+
+  if(_prefault)
+  {
+    // touch each page to fault it in
+
+    size_t pageSize = System::getPageSize();
+    volatile byte_t sum = 0;
+
+    for(uint64_t i = 0; i < size; i += pageSize)
+      sum += _base[i];
+  }
+
+#else
+
+  int flags = MAP_SHARED;
+
+#ifdef MAP_POPULATE
+  if(_prefault)
+    flags |= MAP_POPULATE;
+#endif
+
+  _base = static_cast<byte_t *>(
+    ::mmap(NULL, size, (readOnly ? PROT_READ : (PROT_READ | PROT_WRITE)),
+           flags, _handle, 0));
+
+  if(_base == MAP_FAILED)
+  {
+    String err = System::getErrorString("mmap");
+    ::close(_handle);
+    throw IOException(err);
+  }
+
+  // the remaining hints are advisory; failures are ignored
+
+#ifdef MADV_HUGEPAGE
+  if(_hugePages)
+    ::madvise(_base, size, MADV_HUGEPAGE);
+#endif
+
+#ifndef MAP_POPULATE
+  if(_prefault)
+    ::madvise(_base, size, MADV_WILLNEED);
+#endif
+
+#endif
+
+  _size = size;
+  _open = true;
+}
+
 
 } // namespace ccxx
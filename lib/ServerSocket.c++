@@ -68,6 +68,13 @@ ServerSocket::~ServerSocket()
 void ServerSocket::init()
 {
   Socket::init();
+
+  // if the port was 0, the system has assigned one
+
+  socklen_t sz = (socklen_t)sizeof(sockaddr_in);
+  if(::getsockname(_socket, (sockaddr *)_laddr, &sz) != 0)
+    throw SocketException(System::getErrorString("getsockname"));
+
   setTimeout(-1);
 }
 
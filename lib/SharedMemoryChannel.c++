@@ -0,0 +1,431 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/SharedMemoryChannel.h++"
+#include "commonc++/System.h++"
+#include "commonc++/Thread.h++"
+
+#include "atomic.h"
+
+#include <climits>
+#include <cstring>
+
+#ifdef HAVE_LINUX_FUTEX_H
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+#endif
+
+namespace ccxx {
+
+/*
+ */
+
+static const int32_t CHANNEL_MAGIC = 0x53484d43; // 'SHMC'
+static const int32_t CHANNEL_INITIALIZING = 1;
+static const uint_t CHANNEL_SPIN_COUNT = 200;
+static const size_t CACHE_LINE_SIZE = 64;
+
+/*
+ */
+
+struct SharedMemoryChannel::Header
+{
+  int32_t magic;
+  int32_t capacity;
+  int32_t slotSize;
+  byte_t pad0[CACHE_LINE_SIZE - (3 * sizeof(int32_t))];
+
+  int32_t enqueuePos;
+  byte_t pad1[CACHE_LINE_SIZE - sizeof(int32_t)];
+
+  int32_t dequeuePos;
+  byte_t pad2[CACHE_LINE_SIZE - sizeof(int32_t)];
+
+  int32_t waiters;
+  int32_t notify;
+  byte_t pad3[CACHE_LINE_SIZE - (2 * sizeof(int32_t))];
+};
+
+/*
+ */
+
+struct SharedMemoryChannel::Slot
+{
+  int32_t seq;
+  int32_t length;
+  byte_t data[8];
+};
+
+/*
+ */
+
+static uint_t _roundCapacity(uint_t capacity)
+{
+  uint_t n = 1;
+
+  while((n < capacity) && (n < (1U << 30)))
+    n <<= 1;
+
+  return(n);
+}
+
+/*
+ */
+
+static size_t _roundSlotSize(size_t maxMessageSize)
+{
+  size_t sz = (2 * sizeof(int32_t)) + maxMessageSize;
+
+  return((sz + 7) & ~static_cast<size_t>(7));
+}
+
+/*
+ */
+
+static inline int32_t _load(int32_t* ptr)
+{
+  return(atomic_add(ptr, 0));
+}
+
+/*
+ */
+
+#ifdef HAVE_LINUX_FUTEX_H
+
+static void _futexWait(int32_t* addr, int32_t value, timespan_ms_t timeout)
+{
+  struct timespec ts, *pts = NULL;
+
+  if(timeout >= 0)
+  {
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = (timeout % 1000) * 1000000;
+    pts = &ts;
+  }
+
+  // Not FUTEX_PRIVATE_FLAG: the futex word is shared between processes.
+  ::syscall(SYS_futex, addr, FUTEX_WAIT, value, pts, NULL, 0);
+}
+
+/*
+ */
+
+static void _futexWake(int32_t* addr)
+{
+  ::syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+#endif // HAVE_LINUX_FUTEX_H
+
+/*
+ */
+
+SharedMemoryChannel::SharedMemoryChannel(const String& name, uint_t capacity,
+                                         size_t maxMessageSize,
+                                         const Permissions& perm
+                                         /* = Permissions::USER_READ_WRITE */)
+  : _name(name),
+    _capacity(_roundCapacity(capacity)),
+    _maxMessageSize(maxMessageSize),
+    _slotSize(_roundSlotSize(maxMessageSize)),
+    _block(name, sizeof(Header) + (_capacity * _slotSize), perm),
+    _header(NULL),
+    _slots(NULL)
+{
+}
+
+/*
+ */
+
+SharedMemoryChannel::~SharedMemoryChannel()
+{
+  _block.detach();
+}
+
+/*
+ */
+
+void SharedMemoryChannel::init()
+{
+  if(_header != NULL)
+    return;
+
+  _block.attach();
+
+  Header* hdr = reinterpret_cast<Header *>(_block.getBase());
+
+  // The segment is zero-filled when it is first created; whichever process
+  // claims it first formats the slots, and everyone else waits for the
+  // magic number to appear.
+
+  if(atomic_cas(&hdr->magic, CHANNEL_INITIALIZING, 0) == 0)
+  {
+    hdr->capacity = static_cast<int32_t>(_capacity);
+    hdr->slotSize = static_cast<int32_t>(_slotSize);
+    hdr->enqueuePos = 0;
+    hdr->dequeuePos = 0;
+    hdr->waiters = 0;
+    hdr->notify = 0;
+
+    byte_t* slots = _block.getBase() + sizeof(Header);
+    for(uint_t i = 0; i < _capacity; ++i)
+    {
+      Slot* slot = reinterpret_cast<Slot *>(slots + (i * _slotSize));
+      atomic_set(&slot->seq, static_cast<int32_t>(i));
+    }
+
+    atomic_set(&hdr->magic, CHANNEL_MAGIC);
+  }
+  else
+  {
+    while(_load(&hdr->magic) != CHANNEL_MAGIC)
+      Thread::sleep(1);
+
+    if((hdr->capacity != static_cast<int32_t>(_capacity))
+       || (hdr->slotSize != static_cast<int32_t>(_slotSize)))
+    {
+      _block.detach();
+      throw SystemException("Channel geometry mismatch");
+    }
+  }
+
+  _header = hdr;
+  _slots = _block.getBase() + sizeof(Header);
+}
+
+/*
+ */
+
+SharedMemoryChannel::Slot* SharedMemoryChannel::_slotAt(uint32_t pos) const
+{
+  return(reinterpret_cast<Slot *>(_slots + ((pos & (_capacity - 1))
+                                            * _slotSize)));
+}
+
+/*
+ */
+
+bool SharedMemoryChannel::send(const byte_t* buf, size_t count)
+{
+  if((_header == NULL) || (count > _maxMessageSize))
+    return(false);
+
+  Slot* slot;
+  uint32_t pos = static_cast<uint32_t>(_load(&_header->enqueuePos));
+
+  for(;;)
+  {
+    slot = _slotAt(pos);
+    int32_t dif = static_cast<int32_t>(
+      static_cast<uint32_t>(_load(&slot->seq)) - pos);
+
+    if(dif == 0)
+    {
+      uint32_t cur = static_cast<uint32_t>(
+        atomic_cas(&_header->enqueuePos, static_cast<int32_t>(pos + 1),
+                   static_cast<int32_t>(pos)));
+      if(cur == pos)
+        break;
+
+      pos = cur;
+    }
+    else if(dif < 0)
+      return(false); // full
+    else
+      pos = static_cast<uint32_t>(_load(&_header->enqueuePos));
+  }
+
+  slot->length = static_cast<int32_t>(count);
+  std::memcpy(slot->data, buf, count);
+  atomic_set(&slot->seq, static_cast<int32_t>(pos + 1));
+
+  _notify();
+
+  return(true);
+}
+
+/*
+ */
+
+bool SharedMemoryChannel::_dequeue(byte_t* buf, size_t& count)
+{
+  Slot* slot;
+  uint32_t pos = static_cast<uint32_t>(_load(&_header->dequeuePos));
+
+  for(;;)
+  {
+    slot = _slotAt(pos);
+    int32_t dif = static_cast<int32_t>(
+      static_cast<uint32_t>(_load(&slot->seq)) - (pos + 1));
+
+    if(dif == 0)
+    {
+      uint32_t cur = static_cast<uint32_t>(
+        atomic_cas(&_header->dequeuePos, static_cast<int32_t>(pos + 1),
+                   static_cast<int32_t>(pos)));
+      if(cur == pos)
+        break;
+
+      pos = cur;
+    }
+    else if(dif < 0)
+      return(false); // empty
+    else
+      pos = static_cast<uint32_t>(_load(&_header->dequeuePos));
+  }
+
+  size_t len = static_cast<size_t>(slot->length);
+  if(len < count)
+    count = len;
+
+  std::memcpy(buf, slot->data, count);
+  atomic_set(&slot->seq, static_cast<int32_t>(pos + _capacity));
+
+  return(true);
+}
+
+/*
+ */
+
+bool SharedMemoryChannel::_isReady() const
+{
+  uint32_t pos = static_cast<uint32_t>(_load(&_header->dequeuePos));
+
+  return(static_cast<uint32_t>(_load(&_slotAt(pos)->seq)) == (pos + 1));
+}
+
+/*
+ */
+
+size_t SharedMemoryChannel::receive(byte_t* buf, size_t count)
+{
+  if(_header == NULL)
+    throw SystemException("Channel not initialized");
+
+  for(;;)
+  {
+    size_t n = count;
+    if(_dequeue(buf, n))
+      return(n);
+
+    _wait(-1);
+  }
+}
+
+/*
+ */
+
+size_t SharedMemoryChannel::tryReceive(byte_t* buf, size_t count,
+                                       timespan_ms_t timeout /* = 0 */)
+{
+  if(_header == NULL)
+    throw SystemException("Channel not initialized");
+
+  time_ms_t deadline = System::currentTimeMillis() + timeout;
+
+  for(;;)
+  {
+    size_t n = count;
+    if(_dequeue(buf, n))
+      return(n);
+
+    time_ms_t remaining = deadline - System::currentTimeMillis();
+    if(remaining <= 0)
+      throw TimeoutException();
+
+    _wait(static_cast<timespan_ms_t>(remaining));
+  }
+}
+
+/*
+ */
+
+uint_t SharedMemoryChannel::getSize() const
+{
+  if(_header == NULL)
+    return(0);
+
+  uint32_t head = static_cast<uint32_t>(_load(&_header->enqueuePos));
+  uint32_t tail = static_cast<uint32_t>(_load(&_header->dequeuePos));
+  uint32_t n = head - tail;
+
+  return((n > _capacity) ? 0 : static_cast<uint_t>(n));
+}
+
+/*
+ */
+
+void SharedMemoryChannel::_wait(timespan_ms_t timeout)
+{
+  // Spin briefly first; a sender in another process is likely to be
+  // mid-write, and parking costs two system calls.
+
+  for(uint_t i = 0; i < CHANNEL_SPIN_COUNT; ++i)
+  {
+    if(_isReady())
+      return;
+  }
+
+#ifdef HAVE_LINUX_FUTEX_H
+
+  // Registering as a waiter before sampling the notify word and
+  // re-checking the ring guarantees that a concurrent send() either is
+  // seen here, or sees the waiter and bumps the notify word.
+
+  atomic_increment(&_header->waiters);
+  int32_t seq = _load(&_header->notify);
+
+  if(! _isReady())
+    _futexWait(&_header->notify, seq, timeout);
+
+  atomic_decrement(&_header->waiters);
+
+#else
+
+  Thread::sleep(1);
+
+#endif
+}
+
+/*
+ */
+
+void SharedMemoryChannel::_notify()
+{
+#ifdef HAVE_LINUX_FUTEX_H
+
+  if(_load(&_header->waiters) > 0)
+  {
+    atomic_increment(&_header->notify);
+    _futexWake(&_header->notify);
+  }
+
+#endif
+}
+
+} // namespace ccxx
@@ -0,0 +1,173 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/SignalNotifier.h++"
+#include "commonc++/System.h++"
+
+#ifdef HAVE_SYS_SIGNALFD_H
+#include <pthread.h>
+#include <signal.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+#endif
+
+namespace ccxx {
+
+/*
+ */
+
+SignalNotifier::SignalNotifier()
+  : _signals(UINT64_CONST(0))
+  , _unblock(UINT64_CONST(0))
+  , _handle(CCXX_INVALID_FILE_HANDLE)
+{
+}
+
+/*
+ */
+
+SignalNotifier::~SignalNotifier()
+{
+#ifdef HAVE_SYS_SIGNALFD_H
+
+  if(_handle == CCXX_INVALID_FILE_HANDLE)
+    return;
+
+  // discard any signals that are still queued, so that unblocking them
+  // does not deliver them asynchronously
+
+  struct signalfd_siginfo info[8];
+  while(::read(_handle, info, sizeof(info)) > 0)
+    ;
+
+  ::close(_handle);
+
+  // unblock only the signals that were not already blocked by the caller
+
+  if(_unblock != UINT64_CONST(0))
+  {
+    sigset_t mask;
+    ::sigemptyset(&mask);
+
+    for(int sig = 1; sig < 64; ++sig)
+    {
+      if(_unblock & (UINT64_CONST(1) << sig))
+        ::sigaddset(&mask, sig);
+    }
+
+    ::pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+  }
+
+#endif
+}
+
+/*
+ */
+
+void SignalNotifier::addSignal(int signal)
+{
+  if((signal > 0) && (signal < 64))
+    _signals |= (UINT64_CONST(1) << signal);
+}
+
+/*
+ */
+
+void SignalNotifier::init()
+{
+  if(_handle != CCXX_INVALID_FILE_HANDLE)
+    return;
+
+#ifdef HAVE_SYS_SIGNALFD_H
+
+  sigset_t mask;
+  ::sigemptyset(&mask);
+
+  for(int sig = 1; sig < 64; ++sig)
+  {
+    if(_signals & (UINT64_CONST(1) << sig))
+      ::sigaddset(&mask, sig);
+  }
+
+  sigset_t oldMask;
+
+  if(::pthread_sigmask(SIG_BLOCK, &mask, &oldMask) != 0)
+    throw SystemException("pthread_sigmask() failed");
+
+  _handle = ::signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  if(_handle < 0)
+  {
+    String error = System::getErrorString("signalfd");
+    _handle = CCXX_INVALID_FILE_HANDLE;
+    ::pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+    throw SystemException(error);
+  }
+
+  _unblock = UINT64_CONST(0);
+  for(int sig = 1; sig < 64; ++sig)
+  {
+    if((_signals & (UINT64_CONST(1) << sig))
+       && ! ::sigismember(&oldMask, sig))
+      _unblock |= (UINT64_CONST(1) << sig);
+  }
+
+#else
+
+  throw SystemException("Not implemented");
+
+#endif
+}
+
+/*
+ */
+
+FileHandle SignalNotifier::getEventHandle() const
+{
+  return(_handle);
+}
+
+/*
+ */
+
+void SignalNotifier::processEvents()
+{
+#ifdef HAVE_SYS_SIGNALFD_H
+
+  struct signalfd_siginfo info[8];
+  ssize_t r;
+
+  while((r = ::read(_handle, info, sizeof(info))) > 0)
+  {
+    size_t n = static_cast<size_t>(r) / sizeof(struct signalfd_siginfo);
+
+    for(size_t i = 0; i < n; ++i)
+      signalReceived(static_cast<int>(info[i].ssi_signo));
+  }
+
+#endif
+}
+
+} // namespace ccxx
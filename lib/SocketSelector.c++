@@ -32,12 +32,17 @@
 
 #ifdef CCXX_OS_POSIX
 #include <fcntl.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
 #include <sys/time.h>
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <cerrno>
 #include <list>
+#include <map>
 
 namespace ccxx {
 
@@ -48,6 +53,21 @@ class SocketSelector::ConnectionList : public std::list<Connection *>
 {
 };
 
+/*
+ */
+
+class SocketSelector::TimerQueue
+  : public std::multimap<time_ms_t, EventHandler<bool> *>
+{
+};
+
+/*
+ */
+
+class SocketSelector::SourceList : public std::list<Selectable *>
+{
+};
+
 /*
  */
 
@@ -57,7 +77,16 @@ SocketSelector::SocketSelector(uint_t maxConnections /* = 64 */,
     _mutex(true),
     _pool(maxConnections == 0 ? 1 : maxConnections),
     _idleLimit(defaultIdleLimit),
-    _ssock(NULL)
+    _ssock(NULL),
+    _initialized(false),
+    _connectDeadline(INT64_CONST(0)),
+    _throttleDeadline(INT64_CONST(0)),
+    _readQuantum(0),
+    _idleHead(NULL),
+    _idleTail(NULL),
+    _timers(new TimerQueue()),
+    _sources(new SourceList()),
+    _statsEnabled(false)
 {
 }
 
@@ -66,6 +95,8 @@ SocketSelector::SocketSelector(uint_t maxConnections /* = 64 */,
 
 SocketSelector::~SocketSelector()
 {
+  delete _sources;
+  delete _timers;
   delete _connections;
 }
 
@@ -80,13 +111,37 @@ bool SocketSelector::init(ServerSocket* socket)
   if((socket == NULL) || !socket->isListening())
     return(false);
 
+  if(! SocketSelector::init())
+    return(false);
+
   _ssock = socket;
 
+  return(true);
+}
+
+/*
+ */
+
+bool SocketSelector::init()
+{
+  if(_initialized)
+    return(true);
 
 #ifdef CCXX_OS_WINDOWS
 
   // TODO: implement wakeup() mechanism for Windows
 
+#elif defined(HAVE_SYS_EVENTFD_H)
+
+  // an eventfd is a single descriptor whose counter absorbs any number
+  // of wakeups, so it can never fill up the way a pipe can
+
+  int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if(fd < 0)
+    return(false);
+
+  _wakePipe[0] = _wakePipe[1] = fd;
+
 #else
 
   if(::pipe(_wakePipe) != 0)
@@ -97,6 +152,57 @@ bool SocketSelector::init(ServerSocket* socket)
 
 #endif
 
+  _initialized = true;
+
+  return(true);
+}
+
+/*
+ */
+
+bool SocketSelector::connect(const SocketAddress& address,
+                             Connection* connection,
+                             timespan_ms_t timeout /* = 0 */)
+{
+  ScopedLock lock(_mutex);
+
+  StreamSocket *sock = NULL;
+
+  try
+  {
+    sock = _pool.reserve();
+  }
+  catch(const ObjectPoolException &)
+  {
+    // too many connections
+    return(false);
+  }
+
+  try
+  {
+    sock->init();
+    sock->beginConnect(address);
+  }
+  catch(const IOException &)
+  {
+    sock->close();
+    _pool.release(sock);
+    return(false);
+  }
+
+  // even if the connect completed immediately, it is finished (and
+  // reported) by the selector thread
+
+  time_ms_t now = System::currentTimeMillis();
+
+  connection->attach(this, sock);
+  connection->_connecting = true;
+  connection->_connectDeadline = (timeout > 0) ? (now + timeout) : 0;
+  connection->setTimestamp(now);
+  _connections->push_back(connection);
+
+  wakeup();
+
   return(true);
 }
 
@@ -116,6 +222,14 @@ void SocketSelector::cleanup()
   }
 
   _connections->clear();
+  _idleHead = _idleTail = NULL;
+
+  while(! _timers->empty())
+  {
+    EventHandler<bool> *handler = _timers->begin()->second;
+    _timers->erase(_timers->begin());
+    (*handler)(false);
+  }
 
 #ifdef CCXX_OS_WINDOWS
 
@@ -124,7 +238,8 @@ void SocketSelector::cleanup()
 #else
 
   ::close(_wakePipe[0]);
-  ::close(_wakePipe[1]);
+  if(_wakePipe[1] != _wakePipe[0])
+    ::close(_wakePipe[1]);
 
 #endif
 }
@@ -138,6 +253,14 @@ void SocketSelector::wakeup()
 
   // TODO: implement wakeup() mechanism for Windows
 
+#elif defined(HAVE_SYS_EVENTFD_H)
+
+  static const uint64_t data = 1;
+
+  if(_wakeFlag.testAndSet(1, 0) == 0)
+    if(::write(_wakePipe[1], &data, sizeof(data)) != sizeof(data))
+    { /* ignore */ }
+
 #else
 
   static const char data[1] = { '!' };
@@ -156,6 +279,324 @@ size_t SocketSelector::getConnectionCount() const
   return(_connections->size());
 }
 
+/*
+ */
+
+void SocketSelector::resetStats()
+{
+  _callbackTimes.reset();
+  _dispatchDelays.reset();
+  _writeQueueTimes.reset();
+}
+
+/*
+ */
+
+void SocketSelector::setReadRateLimit(uint_t bytesPerSecond,
+                                      uint_t burst /* = 0 */)
+{
+  ScopedLock lock(_mutex);
+
+  _readBucket.setRate(bytesPerSecond, burst);
+}
+
+/*
+ */
+
+bool SocketSelector::_isReadAllowed(Connection* conn, time_ms_t now)
+{
+  // A congested flow control is polled, since nothing tells the selector
+  // when it drains; a used-up allowance has a known refill time.
+
+  static const timespan_ms_t FLOW_CONTROL_POLL_INTERVAL = 10;
+
+  time_ms_t until = 0;
+
+  if(conn->_flowControl && conn->_flowControl->isCongested())
+    until = now + FLOW_CONTROL_POLL_INTERVAL;
+  else if(conn->_readBucket.isLimited()
+          && (conn->_readBucket.getAvailable(now) == 0))
+    until = now + std::max(conn->_readBucket.getDelay(now), 1);
+  else if(_readBucket.isLimited() && (_readBucket.getAvailable(now) == 0))
+    until = now + std::max(_readBucket.getDelay(now), 1);
+
+  if(until == 0)
+    return(true);
+
+  if((_throttleDeadline == 0) || (until < _throttleDeadline))
+    _throttleDeadline = until;
+
+  return(false);
+}
+
+/*
+ */
+
+bool SocketSelector::_getReadBudget(Connection* conn, time_ms_t now,
+                                    size_t& budget)
+{
+  // The budget is the smallest of the read quantum and the connection's
+  // and the selector's allowances; 0 means no limit. Returns false if
+  // there is no allowance left, for example because connections serviced
+  // earlier in this pass used up the selector's.
+
+  budget = _readQuantum;
+
+  if(conn->_readBucket.isLimited())
+  {
+    size_t n = conn->_readBucket.getAvailable(now);
+    if(n == 0)
+      return(false);
+
+    budget = (budget == 0) ? n : std::min(budget, n);
+  }
+
+  if(_readBucket.isLimited())
+  {
+    size_t n = _readBucket.getAvailable(now);
+    if(n == 0)
+      return(false);
+
+    budget = (budget == 0) ? n : std::min(budget, n);
+  }
+
+  return(true);
+}
+
+/*
+ */
+
+void SocketSelector::_recordCallback(Connection* connection, int64_t start)
+{
+  uint64_t elapsed = static_cast<uint64_t>(System::nanoTime() - start) / 1000;
+
+  connection->_statsLock.enter();
+  connection->_stats.callbackTime += elapsed;
+  connection->_statsLock.leave();
+
+  _callbackTimes.record(elapsed);
+}
+
+/*
+ */
+
+void SocketSelector::_idleLink(Connection* connection)
+{
+  // Connections are kept in order of last receive time, oldest first.
+  // Since all connections share the same idle limit, this is also the
+  // order in which they will time out.
+
+  connection->_idlePrev = _idleTail;
+  connection->_idleNext = NULL;
+
+  if(_idleTail)
+    _idleTail->_idleNext = connection;
+  else
+    _idleHead = connection;
+
+  _idleTail = connection;
+}
+
+/*
+ */
+
+void SocketSelector::_idleUnlink(Connection* connection)
+{
+  if((connection->_idlePrev == NULL) && (_idleHead != connection))
+    return; // not linked
+
+  if(connection->_idlePrev)
+    connection->_idlePrev->_idleNext = connection->_idleNext;
+  else
+    _idleHead = connection->_idleNext;
+
+  if(connection->_idleNext)
+    connection->_idleNext->_idlePrev = connection->_idlePrev;
+  else
+    _idleTail = connection->_idlePrev;
+
+  connection->_idlePrev = connection->_idleNext = NULL;
+}
+
+/*
+ */
+
+void SocketSelector::_expireIdle(time_ms_t now)
+{
+  // Flag the connections that have exceeded the idle limit; the work done
+  // here is proportional to the number of connections that are expiring.
+
+  if(_idleLimit <= 0)
+    return;
+
+  while(_idleHead && ((now - _idleHead->getTimestamp())
+                      > static_cast<int64_t>(_idleLimit)))
+  {
+    Connection *conn = _idleHead;
+
+    _idleUnlink(conn);
+    conn->_idleExpired = true;
+  }
+}
+
+/*
+ */
+
+timespan_ms_t SocketSelector::_nextWait(time_ms_t now) const
+{
+  // Compute the select() timeout from the earliest of the next idle
+  // deadline, the next connect deadline, the time at which a throttled
+  // connection may read again, and the next timer. The wait is capped so
+  // that the selector remains responsive to cancellation.
+
+  static const timespan_ms_t MAX_WAIT = 1000;
+
+  time_ms_t wait = MAX_WAIT;
+
+  if((_idleLimit > 0) && _idleHead)
+    wait = std::min(wait, _idleHead->getTimestamp() + _idleLimit + 1 - now);
+
+  if(_connectDeadline != 0)
+    wait = std::min(wait, _connectDeadline - now);
+
+  if(_throttleDeadline != 0)
+    wait = std::min(wait, _throttleDeadline - now);
+
+  if(! _timers->empty())
+    wait = std::min(wait, _timers->begin()->first - now);
+
+  return(static_cast<timespan_ms_t>(std::max(INT64_CONST(0), wait)));
+}
+
+/*
+ */
+
+void SocketSelector::schedule(timespan_ms_t delay,
+                              EventHandler<bool>* handler)
+{
+  ScopedLock lock(_mutex);
+
+  _timers->insert(std::make_pair(System::currentTimeMillis()
+                                 + std::max(delay, 0), handler));
+  wakeup();
+}
+
+/*
+ */
+
+bool SocketSelector::addEventSource(Selectable* source)
+{
+#ifdef CCXX_OS_WINDOWS
+
+  return(false);
+
+#else
+
+  if(! source)
+    return(false);
+
+  FileHandle fd = source->getEventHandle();
+  if((fd == CCXX_INVALID_FILE_HANDLE) || (fd >= FD_SETSIZE))
+    return(false);
+
+  ScopedLock lock(_mutex);
+
+  if(std::find(_sources->begin(), _sources->end(), source)
+     != _sources->end())
+    return(false);
+
+  _sources->push_back(source);
+  wakeup();
+
+  return(true);
+
+#endif
+}
+
+/*
+ */
+
+bool SocketSelector::removeEventSource(Selectable* source)
+{
+  ScopedLock lock(_mutex);
+
+  SourceList::iterator iter = std::find(_sources->begin(), _sources->end(),
+                                        source);
+  if(iter == _sources->end())
+    return(false);
+
+  _sources->erase(iter);
+  wakeup();
+
+  return(true);
+}
+
+/*
+ */
+
+void SocketSelector::_runTimers(time_ms_t now)
+{
+  // handlers may schedule new timers, so remove each one before invoking it
+
+  while(! _timers->empty() && (_timers->begin()->first <= now))
+  {
+    EventHandler<bool> *handler = _timers->begin()->second;
+    _timers->erase(_timers->begin());
+    (*handler)(true);
+  }
+}
+
+/*
+ */
+
+void SocketSelector::_dispatchHandlers(Connection* conn)
+{
+  // a handler may destroy itself or register a new one, so unregister
+  // each one before invoking it
+
+  if(conn->_readHandler
+     && (conn->getBytesAvailableToRead() >= conn->_readWant))
+  {
+    EventHandler<bool> *handler = conn->_readHandler;
+    conn->_readHandler = NULL;
+    (*handler)(true);
+  }
+
+  if(conn->_writeHandler && conn->getSocket()->isConnected())
+  {
+    conn->_writeLock.enter();
+    bool ready = (conn->writeBuffer.getFree() >= conn->_writeWant);
+    conn->_writeLock.leave();
+
+    if(ready)
+    {
+      EventHandler<bool> *handler = conn->_writeHandler;
+      conn->_writeHandler = NULL;
+      (*handler)(true);
+    }
+  }
+}
+
+/*
+ */
+
+void SocketSelector::_cancelHandlers(Connection* conn)
+{
+  if(conn->_readHandler)
+  {
+    EventHandler<bool> *handler = conn->_readHandler;
+    conn->_readHandler = NULL;
+    (*handler)(false);
+  }
+
+  if(conn->_writeHandler)
+  {
+    EventHandler<bool> *handler = conn->_writeHandler;
+    conn->_writeHandler = NULL;
+    (*handler)(false);
+  }
+}
+
 /*
  */
 
@@ -169,13 +610,14 @@ void SocketSelector::dataReceivedOOB(Connection* connection)
 
 void SocketSelector::run()
 {
-  if(! _ssock)
+  if(! _initialized)
   {
     // Not properly initialized; return immediately.
     return;
   }
 
-  SocketHandle ms = _ssock->getSocketHandle();
+  SocketHandle ms = _ssock ? _ssock->getSocketHandle()
+    : INVALID_SOCKET_HANDLE;
   fd_set readfd, writefd, exceptfd;
   struct timeval tv;
 
@@ -188,7 +630,8 @@ void SocketSelector::run()
     FD_ZERO(&exceptfd);
 
     // server-socket specific:
-    FD_SET(ms, &readfd);
+    if(_ssock)
+      FD_SET(ms, &readfd);
 
     // wakeup()-specific:
 
@@ -202,28 +645,61 @@ void SocketSelector::run()
 
 #endif
 
-    for(ConnectionList::const_iterator iter = _connections->begin();
-        iter != _connections->end();
-        ++iter)
+    timespan_ms_t wait;
+
     {
-      Connection *conn = *iter;
-      SocketHandle fd = conn->getSocket()->getSocketHandle();
+      ScopedLock fdlock(_mutex);
+
+      time_ms_t pollTime = System::currentTimeMillis();
+      _connectDeadline = _throttleDeadline = 0;
 
-      if(! conn->isReadHigh())
-        FD_SET(fd, &readfd);
+      for(ConnectionList::const_iterator iter = _connections->begin();
+          iter != _connections->end();
+          ++iter)
+      {
+        Connection *conn = *iter;
+        SocketHandle fd = conn->getSocket()->getSocketHandle();
+
+        if(conn->_connecting)
+        {
+          // connect completion is signalled by writability
+          FD_SET(fd, &writefd);
+
+          if((conn->_connectDeadline != 0)
+             && ((_connectDeadline == 0)
+                 || (conn->_connectDeadline < _connectDeadline)))
+            _connectDeadline = conn->_connectDeadline;
+
+          continue;
+        }
+
+        if(! conn->isReadHigh() && _isReadAllowed(conn, pollTime))
+          FD_SET(fd, &readfd);
+
+        if(! conn->isWriteLow())
+          FD_SET(fd, &writefd);
+
+        if(! conn->getOOBFlag())
+          FD_SET(fd, &exceptfd);
+      }
+
+#ifndef CCXX_OS_WINDOWS
 
-      if(! conn->isWriteLow())
-        FD_SET(fd, &writefd);
+      for(SourceList::const_iterator iter = _sources->begin();
+          iter != _sources->end();
+          ++iter)
+        FD_SET((*iter)->getEventHandle(), &readfd);
 
-      if(! conn->getOOBFlag())
-        FD_SET(fd, &exceptfd);
+#endif
+
+      wait = _nextWait(pollTime);
     }
 
     // select on fd sets
 
   SELECT:
-    tv.tv_sec = 1;
-    tv.tv_usec = 0;
+    tv.tv_sec = wait / 1000;
+    tv.tv_usec = (wait % 1000) * 1000;
     int r = ::select(FD_SETSIZE, &readfd, &writefd, &exceptfd, &tv);
 
     if(r < 0)
@@ -238,13 +714,15 @@ void SocketSelector::run()
     // now we may have descriptors ready
 
     time_ms_t now = System::currentTimeMillis();
+    int64_t readyTime = _statsEnabled ? System::nanoTime() : 0;
 
     // server-socket specific:
     // check if master socket is ready for read
 
-    if((r > 0) && FD_ISSET(ms, &readfd))
+    if((r > 0) && _ssock && FD_ISSET(ms, &readfd))
     {
       // a new connection is pending
+      ScopedLock lock(_mutex);
       StreamSocket *sock = NULL;
 
       try
@@ -262,6 +740,7 @@ void SocketSelector::run()
         {
           conn->attach(this, sock);
           conn->setTimestamp(now);
+          _idleLink(conn);
           _connections->push_back(conn);
         }
       }
@@ -283,17 +762,33 @@ void SocketSelector::run()
 
     if((r > 0) && FD_ISSET(_wakePipe[0], &readfd))
     {
+#ifdef HAVE_SYS_EVENTFD_H
+      uint64_t buf;
+#else
       char buf;
-      if(::read(_wakePipe[0], &buf, 1) != 1) { /* ignore */ }
+#endif
+      if(::read(_wakePipe[0], &buf, sizeof(buf)) != sizeof(buf))
+      { /* ignore */ }
       _wakeFlag.set(0);
     }
 
 #endif
 
-    // now check all active connections
+    // now check all active connections; finding the idle ones that have
+    // expired is proportional to their number, but every connection is
+    // still visited here, as it was when the fd sets were built
 
     ScopedLock lock(_mutex);
 
+    _expireIdle(now);
+
+    // rotate the service order, so that no connection is always first in
+    // line for the selector-wide read allowance
+
+    if(_connections->size() > 1)
+      _connections->splice(_connections->end(), *_connections,
+                           _connections->begin());
+
     for(ConnectionList::iterator iter = _connections->begin();
         iter != _connections->end();
       )
@@ -301,13 +796,43 @@ void SocketSelector::run()
       Connection *conn = *iter;
       StreamSocket *sock = conn->getSocket();
       SocketHandle fd = sock->getSocketHandle();
+      size_t budget = 0;
 
       if(conn->isClosePending())
       {
         // had a pending close; so perform it now
         _connectionClosed(conn);
+        conn = NULL;
+      }
+      else if(conn->_connecting)
+      {
+        if((r > 0) && FD_ISSET(fd, &writefd))
+        {
+          try
+          {
+            sock->finishConnect();
+
+            conn->_connecting = false;
+            conn->setTimestamp(now);
+            _idleLink(conn);
+
+            connectionEstablished(conn);
+          }
+          catch(const IOException &)
+          {
+            _connectionFailed(conn);
+            conn = NULL;
+          }
+        }
+        else if((conn->_connectDeadline != 0)
+                && (now >= conn->_connectDeadline))
+        {
+          _connectionFailed(conn);
+          conn = NULL;
+        }
       }
-      else if((r > 0) && FD_ISSET(fd, &readfd))
+      else if((r > 0) && FD_ISSET(fd, &readfd)
+              && _getReadBudget(conn, now, budget))
       {
         try
         {
@@ -316,22 +841,55 @@ void SocketSelector::run()
           conn->_readLock.enter();
 
           // read as much data as possible
-          conn->read();
+          size_t n = conn->read(budget);
+          conn->_readBucket.consume(static_cast<uint_t>(n));
+          _readBucket.consume(static_cast<uint_t>(n));
           conn->setTimestamp(now);
+          _idleUnlink(conn);
+          _idleLink(conn);
+          conn->_idleExpired = false;
 
           if(! conn->isReadLow())
             rcvd = true;
 
           conn->setOOBFlag(false);
 
+          if(_statsEnabled)
+          {
+            ScopedLock statsGuard(conn->_statsLock);
+
+            conn->_stats.bytesReceived += n;
+            if(conn->isReadHigh())
+              ++conn->_stats.readHighWaterHits;
+          }
+
           conn->_readLock.leave();
 
-          if(rcvd)
-            dataReceived(conn);
+          if(rcvd && ! conn->_readHandler)
+          {
+            if(_statsEnabled)
+            {
+              int64_t start = System::nanoTime();
+              uint64_t delay = static_cast<uint64_t>(start - readyTime) / 1000;
+
+              conn->_statsLock.enter();
+              conn->_stats.dispatchDelay += delay;
+              ++conn->_stats.messagesReceived;
+              conn->_statsLock.leave();
+
+              _dispatchDelays.record(delay);
+
+              dataReceived(conn);
+              _recordCallback(conn, start);
+            }
+            else
+              dataReceived(conn);
+          }
         }
         catch(const EOFException &)
         {
           _connectionClosed(conn);
+          conn = NULL;
         }
         catch(const IOException& ex)
         {
@@ -347,17 +905,46 @@ void SocketSelector::run()
           conn->_writeLock.enter();
 
           // write as much data as possible
-          conn->write();
+          size_t n = conn->write();
           low = conn->isWriteLow();
 
+          if(_statsEnabled)
+          {
+            ScopedLock statsGuard(conn->_statsLock);
+
+            conn->_stats.bytesSent += n;
+
+            if(conn->writeBuffer.isEmpty() && (conn->_writeQueuedAt != 0))
+            {
+              uint64_t elapsed = static_cast<uint64_t>(
+                System::nanoTime() - conn->_writeQueuedAt) / 1000;
+
+              conn->_stats.writeQueueTime += elapsed;
+              _writeQueueTimes.record(elapsed);
+            }
+          }
+
+          if(conn->writeBuffer.isEmpty())
+            conn->_writeQueuedAt = 0;
+
           conn->_writeLock.leave();
 
           if(low)
-            dataSent(conn);
+          {
+            if(_statsEnabled)
+            {
+              int64_t start = System::nanoTime();
+              dataSent(conn);
+              _recordCallback(conn, start);
+            }
+            else
+              dataSent(conn);
+          }
         }
         catch(const EOFException &)
         {
           _connectionClosed(conn);
+          conn = NULL;
         }
         catch(const IOException& ex)
         {
@@ -372,7 +959,15 @@ void SocketSelector::run()
 
           conn->readOOB();
           conn->setOOBFlag(true);
-          dataReceivedOOB(conn);
+
+          if(_statsEnabled)
+          {
+            int64_t start = System::nanoTime();
+            dataReceivedOOB(conn);
+            _recordCallback(conn, start);
+          }
+          else
+            dataReceivedOOB(conn);
 
           conn->_readLock.leave();
         }
@@ -381,22 +976,62 @@ void SocketSelector::run()
           exceptionOccurred(conn, ex);
         }
       }
-      else
+      else if(conn->_idleExpired)
       {
-        // descriptor NOT set...check if connection timed out
-        if((_idleLimit > 0) && ((now - conn->getTimestamp())
-                                > static_cast<int64_t>(_idleLimit)))
-        {
-          _connectionTimedOut(conn);
-        }
+        // descriptor NOT set, and connection has timed out
+        _connectionTimedOut(conn);
+        conn = NULL;
       }
 
-      // if socket is no longer connected, remove connection from list
-      if(! sock->isConnected())
+      if(conn && (conn->_readHandler || conn->_writeHandler))
+        _dispatchHandlers(conn);
+
+      // if socket is no longer connected, remove connection from list;
+      // conn is NULL if it has already been released (and deleted);
+      // otherwise it was closed without a callback, for example by
+      // exceptionOccurred(), so release it now
+      if(! sock->isConnected() && !(conn && conn->_connecting))
+      {
+        if(conn)
+          _connectionClosed(conn);
+
         iter = _connections->erase(iter);
+      }
       else
         ++iter;
     }
+
+#ifndef CCXX_OS_WINDOWS
+
+    // event sources; a source may unregister itself or another source
+    // from processEvents(), so work from a snapshot and skip any source
+    // that is no longer registered
+
+    if((r > 0) && ! _sources->empty())
+    {
+      SourceList ready;
+
+      for(SourceList::const_iterator iter = _sources->begin();
+          iter != _sources->end();
+          ++iter)
+      {
+        if(FD_ISSET((*iter)->getEventHandle(), &readfd))
+          ready.push_back(*iter);
+      }
+
+      for(SourceList::const_iterator iter = ready.begin();
+          iter != ready.end();
+          ++iter)
+      {
+        if(std::find(_sources->begin(), _sources->end(), *iter)
+           != _sources->end())
+          (*iter)->processEvents();
+      }
+    }
+
+#endif
+
+    _runTimers(System::currentTimeMillis());
   }
 }
 
@@ -407,12 +1042,29 @@ void SocketSelector::_connectionClosed(Connection* conn)
 {
   StreamSocket* sock = conn->getSocket();
 
+  _idleUnlink(conn);
+
   conn->close(true);
   _pool.release(sock);
 
+  _cancelHandlers(conn);
   connectionClosed(conn);
 }
 
+/*
+ */
+
+void SocketSelector::_connectionFailed(Connection* conn)
+{
+  StreamSocket* sock = conn->getSocket();
+
+  conn->close(true);
+  _pool.release(sock);
+
+  _cancelHandlers(conn);
+  connectionFailed(conn);
+}
+
 /*
  */
 
@@ -420,12 +1072,31 @@ void SocketSelector::_connectionTimedOut(Connection* conn)
 {
   StreamSocket* sock = conn->getSocket();
 
+  _idleUnlink(conn);
+
   conn->close(true);
   _pool.release(sock);
 
+  _cancelHandlers(conn);
   connectionTimedOut(conn);
 }
 
+/*
+ */
+
+void SocketSelector::connectionEstablished(Connection* connection)
+{
+  // no-op
+}
+
+/*
+ */
+
+void SocketSelector::connectionFailed(Connection* connection)
+{
+  connectionClosed(connection);
+}
+
 /*
  */
 
@@ -465,6 +1136,17 @@ uint_t SocketSelector::writeAll(const byte_t* buf, size_t count)
   return(n);
 }
 
+/*
+ */
+
+void ConnectionStats::reset()
+{
+  bytesReceived = bytesSent = UINT64_CONST(0);
+  messagesReceived = messagesSent = UINT64_CONST(0);
+  callbackTime = dispatchDelay = writeQueueTime = UINT64_CONST(0);
+  readHighWaterHits = writeHighWaterHits = 0;
+}
+
 /*
  */
 
@@ -480,6 +1162,7 @@ Connection::Connection(size_t bufferSize /* = DEFAULT_BUFFER_SIZE */)
   : _socket(NULL)
   , readBuffer(bufferSize)
   , writeBuffer(bufferSize)
+  , _selector(NULL)
   , _readLoMark(1)
   , _readHiMark(bufferSize)
   , _writeLoMark(1)
@@ -488,6 +1171,17 @@ Connection::Connection(size_t bufferSize /* = DEFAULT_BUFFER_SIZE */)
   , _closePending(false)
   , _oobData(0)
   , _lastRecv(INT64_CONST(0))
+  , _writeQueuedAt(INT64_CONST(0))
+  , _idlePrev(NULL)
+  , _idleNext(NULL)
+  , _idleExpired(false)
+  , _readHandler(NULL)
+  , _readWant(0)
+  , _writeHandler(NULL)
+  , _writeWant(0)
+  , _connecting(false)
+  , _connectDeadline(INT64_CONST(0))
+  , _flowControl(NULL)
 {
 }
 
@@ -506,9 +1200,13 @@ bool Connection::writeData(ByteBuffer& buffer)
   ScopedLock guard(_writeLock);
 
   if(writeBuffer.getFree() < buffer.getRemaining())
+  {
+    _wrote(false);
     return(false);
+  }
 
   writeBuffer.write(buffer);
+  _wrote(true);
 
   _selector->wakeup();
 
@@ -523,9 +1221,13 @@ bool Connection::writeData(const byte_t* buf, size_t count)
   ScopedLock lock(_writeLock);
 
   if(writeBuffer.getFree() < count)
+  {
+    _wrote(false);
     return(false);
+  }
 
   writeBuffer.write(buf, count);
+  _wrote(true);
 
   _selector->wakeup();
 
@@ -542,10 +1244,14 @@ bool Connection::writeLine(const String& text)
   CString cstr_text = text.toUTF8();
 
   if(writeBuffer.getFree() < (cstr_text.length() + 2))
+  {
+    _wrote(false);
     return(false);
+  }
 
   writeBuffer.write((const byte_t *)(cstr_text.data()), cstr_text.length());
   writeBuffer.write((const byte_t *)"\r\n", 2);
+  _wrote(true);
 
   _selector->wakeup();
 
@@ -565,6 +1271,9 @@ void Connection::beginWrite()
 
 void Connection::endWrite()
 {
+  if(! writeBuffer.isEmpty())
+    _wrote(true);
+
   _writeLock.unlock();
 
   _selector->wakeup();
@@ -694,6 +1403,23 @@ void Connection::setReadHighWaterMark(size_t count)
     _readHiMark = count;
 }
 
+/*
+ */
+
+void Connection::setReadRateLimit(uint_t bytesPerSecond, uint_t burst /* = 0 */)
+{
+  // the selector consumes from the bucket with its lock held
+
+  SocketSelector *selector = _selector;
+  if(selector)
+    selector->_mutex.lock();
+
+  _readBucket.setRate(bytesPerSecond, burst);
+
+  if(selector)
+    selector->_mutex.unlock();
+}
+
 /*
  */
 
@@ -720,6 +1446,108 @@ void Connection::attach(SocketSelector* selector, StreamSocket* socket)
   _socket = socket;
   _selector = selector;
   _closePending = false;
+  _idleExpired = false;
+}
+
+/*
+ */
+
+bool Connection::awaitRead(size_t count, EventHandler<bool>* handler)
+{
+  // the selector reads the handler with its lock held; the lock is
+  // recursive, so it may also be taken from within a selector callback
+
+  SocketSelector *selector = _selector;
+  if(selector)
+    selector->_mutex.lock();
+
+  bool ok = (! _readHandler && (count <= _readHiMark));
+
+  if(ok)
+  {
+    _readHandler = handler;
+    _readWant = count;
+
+    // if the data is already here, make sure the selector comes around
+    if(selector && (getBytesAvailableToRead() >= count))
+      selector->wakeup();
+  }
+
+  if(selector)
+    selector->_mutex.unlock();
+
+  return(ok);
+}
+
+/*
+ */
+
+bool Connection::awaitWrite(size_t count, EventHandler<bool>* handler)
+{
+  SocketSelector *selector = _selector;
+  if(selector)
+    selector->_mutex.lock();
+
+  bool ok = (! _writeHandler && (count <= writeBuffer.getSize()));
+
+  if(ok)
+  {
+    _writeHandler = handler;
+    _writeWant = count;
+
+    if(selector)
+      selector->wakeup();
+  }
+
+  if(selector)
+    selector->_mutex.unlock();
+
+  return(ok);
+}
+
+/*
+ */
+
+ConnectionStats Connection::getStats() const
+{
+  ScopedLock guard(_statsLock);
+
+  return(_stats);
+}
+
+/*
+ */
+
+bool Connection::_isStatsEnabled() const
+{
+  return((_selector != NULL) && _selector->isStatsEnabled());
+}
+
+/*
+ */
+
+void Connection::_wrote(bool accepted)
+{
+  // called with _writeLock held
+
+  if(! _isStatsEnabled())
+    return;
+
+  ScopedLock statsGuard(_statsLock);
+
+  if(! accepted)
+  {
+    ++_stats.writeHighWaterHits;
+    return;
+  }
+
+  ++_stats.messagesSent;
+
+  if(_writeQueuedAt == 0)
+    _writeQueuedAt = System::nanoTime();
+
+  if(writeBuffer.getRemaining() >= _writeHiMark)
+    ++_stats.writeHighWaterHits;
 }
 
 /*
@@ -733,17 +1561,17 @@ bool Connection::isClosePending() const
 /*
  */
 
-void Connection::read()
+size_t Connection::read(size_t limit)
 {
-  readBuffer.write(*_socket);
+  return(readBuffer.write(*_socket, static_cast<uint_t>(limit)));
 }
 
 /*
  */
 
-void Connection::write()
+size_t Connection::write()
 {
-  writeBuffer.read(*_socket);
+  return(writeBuffer.read(*_socket));
 }
 
 /*
@@ -75,7 +75,8 @@ Stream::Stream(FileHandle handle, bool seekable /* = true */,
   : _handle(handle),
     _seekable(seekable),
     _canRead(readable),
-    _canWrite(writable)
+    _canWrite(writable),
+    _timeout(-1)
 {
 }
 
@@ -132,6 +132,77 @@ void StreamSocket::connect(const SocketAddress& addr)
   Stream::_init((FileHandle)(_socket), false, true, true);
 }
 
+/*
+ */
+
+bool StreamSocket::beginConnect(const SocketAddress& addr)
+{
+  if(_connected)
+    throw SocketException("already connected");
+
+  if(! isInitialized())
+    throw SocketException("socket not initialized");
+
+  _raddr = addr;
+
+  try
+  {
+    if(! SocketUtil::startConnect(_socket, (sockaddr *)_raddr,
+                                  (socklen_t)sizeof(sockaddr_in)))
+      return(false);
+  }
+  catch(const IOException& ioex)
+  {
+    close();
+    throw;
+  }
+
+  _completeConnect();
+
+  return(true);
+}
+
+/*
+ */
+
+void StreamSocket::finishConnect()
+{
+  if(_connected)
+    return;
+
+  if(! isInitialized())
+    throw SocketException("socket not initialized");
+
+  try
+  {
+    SocketUtil::finishConnect(_socket);
+  }
+  catch(const IOException& ioex)
+  {
+    // the handle has already been closed
+    _socket = INVALID_SOCKET_HANDLE;
+    Socket::shutdown();
+    throw;
+  }
+
+  _completeConnect();
+}
+
+/*
+ */
+
+void StreamSocket::_completeConnect()
+{
+  socklen_t sz = (socklen_t)sizeof(sockaddr_in);
+
+  if(::getsockname(_socket, (sockaddr *)_laddr, &sz) != 0)
+    throw SocketException(System::getErrorString("getsockname"));
+
+  _connected = true;
+
+  Stream::_init((FileHandle)(_socket), false, true, true);
+}
+
 /*
  */
 
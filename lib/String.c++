@@ -1535,7 +1535,7 @@ void String::_fromUTF8(const char *str, uint_t offset, uint_t count)
   reserve(length);
 
   UTF8Decoder decoder;
-  const char* input = str;
+  const char* input = str + offset;
   char16_t *output = _buf->_data;
   int outlen = length;
   int inputLen = count;
@@ -50,6 +50,10 @@
 #include <sys/ioctl.h>
 #endif // CCXX_OS_POSIX
 
+#ifdef CCXX_OS_MACOSX
+#include <mach/mach_time.h>
+#endif
+
 #include "stacktrace.h"
 
 namespace ccxx {
@@ -101,6 +105,51 @@ ccxx::time_ms_t System::currentTimeMillis()
 #endif
 }
 
+/*
+ */
+
+int64_t System::nanoTime()
+{
+#if defined(CCXX_OS_WINDOWS)
+
+  static LARGE_INTEGER freq = { 0 };
+  LARGE_INTEGER count;
+
+  if(freq.QuadPart == 0)
+    ::QueryPerformanceFrequency(&freq);
+
+  ::QueryPerformanceCounter(&count);
+
+  return(static_cast<int64_t>((count.QuadPart / freq.QuadPart) * 1000000000)
+         + static_cast<int64_t>(((count.QuadPart % freq.QuadPart)
+                                 * 1000000000) / freq.QuadPart));
+
+#elif defined(CCXX_OS_MACOSX)
+
+  // mach_absolute_time() is monotonic, unlike gettimeofday()
+
+  static mach_timebase_info_data_t timebase = { 0, 0 };
+
+  if(timebase.denom == 0)
+    ::mach_timebase_info(&timebase);
+
+  uint64_t t = ::mach_absolute_time();
+
+  return(static_cast<int64_t>((t / timebase.denom) * timebase.numer)
+         + static_cast<int64_t>(((t % timebase.denom) * timebase.numer)
+                                / timebase.denom));
+
+#else
+
+  struct timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return((static_cast<int64_t>(ts.tv_sec) * 1000000000)
+         + static_cast<int64_t>(ts.tv_nsec));
+
+#endif
+}
+
 /*
  */
 
@@ -487,6 +536,27 @@ void System::_getSystemInfo()
   }
 }
 
+#ifdef CCXX_OS_POSIX
+
+/*
+ */
+
+// strerror_r() returns a status code on XSI-compliant systems, but a pointer
+// to the message (which may not be in the supplied buffer) with glibc
+
+static inline const char *__strerror(int result, const char* buf)
+{
+  return((result == 0) ? buf : NULL);
+}
+
+static inline const char *__strerror(const char* result,
+                                     const char* /* buf */)
+{
+  return(result);
+}
+
+#endif
+
 /*
  */
 
@@ -516,13 +586,14 @@ String System::getErrorString(const String& text /* = String::null */)
 
 #else
 
-  // strerror_r is broken on Linux, so we don't use it
-
+  int err = errno;
   char buf[128];
-  if(::strerror_r(errno, buf, sizeof(buf) == 0))
-    s << buf;
+  const char *msg = __strerror(::strerror_r(err, buf, sizeof(buf)), buf);
+
+  if(msg != NULL)
+    s << msg;
   else
-    s << "Error " << errno;
+    s << "Error " << err;
 
 #endif
 
@@ -28,13 +28,19 @@
 #include "commonc++/DynamicArray.h++"
 #include "commonc++/File.h++"
 #include "commonc++/System.h++"
+#include "commonc++/UnsupportedOperationException.h++"
 
 #include <cstdlib>
 #include <iostream>
 #include <cstring>
+#include <cerrno>
 
 #ifdef CCXX_OS_POSIX
+#include <cstdio>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 
 #ifdef CCXX_OS_WINDOWS
@@ -43,12 +49,47 @@
 
 namespace ccxx {
 
+#ifdef CCXX_OS_POSIX
+
 /*
  */
 
-TempFile::TempFile(const String& path /* = String::null */)
+// gives a name to an open file, which may not have one
+
+static bool __linkHandle(int fd, const char* path)
+{
+#ifdef __linux__
+
+  // linking through procfs does not require privileges, unlike
+  // AT_EMPTY_PATH
+
+  char procPath[64];
+  std::snprintf(procPath, sizeof(procPath), "/proc/self/fd/%d", fd);
+
+  if(::linkat(AT_FDCWD, procPath, AT_FDCWD, path, AT_SYMLINK_FOLLOW) == 0)
+    return(true);
+
+#ifdef AT_EMPTY_PATH
+  if(errno == ENOENT)
+    return(::linkat(fd, "", AT_FDCWD, path, AT_EMPTY_PATH) == 0);
+#endif
+
+#endif
+
+  return(false);
+}
+
+#endif
+
+/*
+ */
+
+TempFile::TempFile(const String& path /* = String::null */,
+                   TempFileMode mode /* = TempFileNamed */)
   : Stream(),
-    _path(path)
+    _path(path),
+    _mode(mode),
+    _actualMode(mode)
 {
 }
 
@@ -67,16 +108,37 @@ void TempFile::open()
   if(isOpen())
     return;
 
-  String path;
+  if((_mode == TempFileMemory) && ! _path.isNull())
+    throw UnsupportedOperationException(
+      "memory-backed files cannot shadow another file");
+
+  String dir;
 
   if(_path.isNull())
-    path = System::getTempDir();
+    dir = System::getTempDir();
   else
   {
     FileName fn(_path);
-    path = fn.getDirectory();
+    dir = fn.getDirectory();
   }
 
+  // fall back to the next best kind of storage if one is not supported
+
+  if((_mode == TempFileMemory) && _openMemory())
+    return;
+
+  if((_mode != TempFileNamed) && _openAnonymous(dir))
+    return;
+
+  _openNamed(dir);
+}
+
+/*
+ */
+
+void TempFile::_openNamed(const String& dir)
+{
+  String path = dir;
   path << File::separator << "ccxxtmp-XXXXXX";
 
 #ifdef CCXX_OS_WINDOWS
@@ -108,8 +170,128 @@ void TempFile::open()
 #endif
 
   _tempPath = buf.data();
+  _actualMode = TempFileNamed;
+
+  Stream::_init(handle, true, true, true);
+}
+
+/*
+ */
+
+bool TempFile::_openAnonymous(const String& dir)
+{
+#ifdef O_TMPFILE
+
+  CString cstr_dir = dir.toUTF8();
+  int handle = ::open(cstr_dir.data(), (O_TMPFILE | O_RDWR | O_CLOEXEC),
+                      (S_IRUSR | S_IWUSR));
+
+  if(handle < 0)
+  {
+    // fall back if the kernel or file system does not support O_TMPFILE
+
+    if((errno == EOPNOTSUPP) || (errno == EISDIR) || (errno == EINVAL))
+      return(false);
+
+    throw IOException(System::getErrorString("open"));
+  }
+
+  _tempPath = String::null;
+  _actualMode = TempFileAnonymous;
+
+  Stream::_init(handle, true, true, true);
+
+  return(true);
+
+#else
+
+  return(false);
+
+#endif
+}
+
+/*
+ */
+
+bool TempFile::_openMemory()
+{
+#if defined(HAVE_MEMFD_CREATE) && defined(MFD_ALLOW_SEALING)
+
+  int handle = ::memfd_create("ccxxtmp", (MFD_CLOEXEC | MFD_ALLOW_SEALING));
+
+  if(handle < 0)
+  {
+    if(errno == ENOSYS)
+      return(false);
+
+    throw IOException(System::getErrorString("memfd_create"));
+  }
+
+  _tempPath = String::null;
+  _actualMode = TempFileMemory;
 
   Stream::_init(handle, true, true, true);
+
+  return(true);
+
+#else
+
+  return(false);
+
+#endif
+}
+
+/*
+ */
+
+void TempFile::link(const String& path)
+{
+  if(! isOpen())
+    throw IOException("not open");
+
+  if(_actualMode == TempFileMemory)
+    throw UnsupportedOperationException(
+      "memory-backed files cannot be linked");
+
+#ifdef CCXX_OS_POSIX
+
+  CString cstr_path = path.toUTF8();
+  bool ok;
+
+  if(_actualMode == TempFileAnonymous)
+    ok = __linkHandle(_handle, cstr_path.data());
+  else
+    ok = (::link(_tempPath.toUTF8().data(), cstr_path.data()) == 0);
+
+  if(! ok)
+    throw IOException(System::getErrorString("link"));
+
+#else
+
+  throw UnsupportedOperationException("hard links not supported");
+
+#endif
+}
+
+/*
+ */
+
+void TempFile::seal()
+{
+  if(_actualMode != TempFileMemory)
+    throw UnsupportedOperationException("only memory-backed files can be "
+                                        "sealed");
+
+  if(! isOpen())
+    throw IOException("not open");
+
+#ifdef F_ADD_SEALS
+
+  if(::fcntl(_handle, F_ADD_SEALS, (F_SEAL_SHRINK | F_SEAL_GROW
+                                    | F_SEAL_WRITE | F_SEAL_SEAL)) != 0)
+    throw IOException(System::getErrorString("fcntl"));
+
+#endif
 }
 
 /*
@@ -117,10 +299,57 @@ void TempFile::open()
 
 void TempFile::close()
 {
-  if(isOpen())
+  if(! isOpen())
+    return;
+
+#ifdef CCXX_OS_POSIX
+
+  if((_actualMode == TempFileAnonymous) && ! _path.isNull())
   {
+    // Give the file a unique name alongside the shadowed file, and then
+    // move it onto the shadowed file; the shadowed file is thus replaced
+    // atomically by the completely written file.
+
+    FileName fn(_path);
+    String tempPath;
+
+    for(uint_t i = 0; ; ++i)
+    {
+      tempPath = fn.getDirectory();
+      tempPath << File::separator << "ccxxtmp-"
+               << static_cast<int>(::getpid()) << '-' << i;
+
+      if(__linkHandle(_handle, tempPath.toUTF8().data()))
+        break;
+
+      if((errno != EEXIST) || (i > 100))
+      {
+        String err = System::getErrorString("linkat");
+        Stream::close();
+        throw IOException(err);
+      }
+    }
+
     Stream::close();
 
+    if(! File::rename(tempPath, _path))
+    {
+      // capture the error before remove() can clobber errno
+
+      String err = System::getErrorString("rename");
+      File::remove(tempPath);
+      throw IOException(err);
+    }
+
+    return;
+  }
+
+#endif
+
+  Stream::close();
+
+  if(_actualMode == TempFileNamed)
+  {
     if(! _path.isNull())
       // Move the temp file onto the shadowed file.
       File::rename(_tempPath, _path);
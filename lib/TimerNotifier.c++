@@ -0,0 +1,160 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/TimerNotifier.h++"
+#include "commonc++/System.h++"
+
+#ifdef HAVE_SYS_TIMERFD_H
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+namespace ccxx {
+
+/*
+ */
+
+TimerNotifier::TimerNotifier()
+  : _handle(CCXX_INVALID_FILE_HANDLE)
+{
+}
+
+/*
+ */
+
+TimerNotifier::~TimerNotifier()
+{
+#ifdef HAVE_SYS_TIMERFD_H
+
+  if(_handle != CCXX_INVALID_FILE_HANDLE)
+    ::close(_handle);
+
+#endif
+}
+
+/*
+ */
+
+void TimerNotifier::init()
+{
+  if(_handle != CCXX_INVALID_FILE_HANDLE)
+    return;
+
+#ifdef HAVE_SYS_TIMERFD_H
+
+  _handle = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if(_handle < 0)
+  {
+    _handle = CCXX_INVALID_FILE_HANDLE;
+    throw SystemException(System::getErrorString("timerfd_create"));
+  }
+
+#else
+
+  throw SystemException("Not implemented");
+
+#endif
+}
+
+/*
+ */
+
+void TimerNotifier::start(timespan_ms_t delay,
+                          timespan_ms_t interval /* = 0 */)
+{
+#ifdef HAVE_SYS_TIMERFD_H
+
+  if(_handle == CCXX_INVALID_FILE_HANDLE)
+    throw SystemException("Timer not initialized");
+
+  // a zero it_value would disarm the timer
+  if(delay <= 0)
+    delay = 1;
+
+  struct itimerspec spec;
+  spec.it_value.tv_sec = delay / 1000;
+  spec.it_value.tv_nsec = (delay % 1000) * 1000000;
+  spec.it_interval.tv_sec = std::max(interval, 0) / 1000;
+  spec.it_interval.tv_nsec = (std::max(interval, 0) % 1000) * 1000000;
+
+  if(::timerfd_settime(_handle, 0, &spec, NULL) != 0)
+    throw SystemException(System::getErrorString("timerfd_settime"));
+
+#else
+
+  throw SystemException("Not implemented");
+
+#endif
+}
+
+/*
+ */
+
+void TimerNotifier::stop()
+{
+#ifdef HAVE_SYS_TIMERFD_H
+
+  if(_handle == CCXX_INVALID_FILE_HANDLE)
+    return;
+
+  struct itimerspec spec = { { 0, 0 }, { 0, 0 } };
+
+  if(::timerfd_settime(_handle, 0, &spec, NULL) != 0)
+    throw SystemException(System::getErrorString("timerfd_settime"));
+
+#endif
+}
+
+/*
+ */
+
+FileHandle TimerNotifier::getEventHandle() const
+{
+  return(_handle);
+}
+
+/*
+ */
+
+void TimerNotifier::processEvents()
+{
+#ifdef HAVE_SYS_TIMERFD_H
+
+  uint64_t count = 0;
+
+  if(::read(_handle, &count, sizeof(count)) != sizeof(count))
+    return;
+
+  if(count > 0)
+    timerExpired(count);
+
+#endif
+}
+
+} // namespace ccxx
@@ -0,0 +1,137 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/TokenBucket.h++"
+
+#include <algorithm>
+#include <climits>
+
+namespace ccxx {
+
+/*
+ */
+
+TokenBucket::TokenBucket(uint_t rate /* = 0 */, uint_t burst /* = 0 */)
+{
+  setRate(rate, burst);
+}
+
+/*
+ */
+
+TokenBucket::~TokenBucket()
+{
+}
+
+/*
+ */
+
+void TokenBucket::setRate(uint_t rate, uint_t burst /* = 0 */)
+{
+  _rate = rate;
+  _burst = (burst == 0) ? rate : burst;
+  _tokens = static_cast<uint64_t>(_burst) * 1000;
+  _last = INT64_CONST(0);
+}
+
+/*
+ */
+
+void TokenBucket::_refill(time_ms_t now)
+{
+  // Tokens are counted in thousandths so that a refill after any whole
+  // number of milliseconds adds an exact amount.
+
+  if(_last == 0)
+  {
+    _last = now;
+    return;
+  }
+
+  if(now <= _last)
+    return;
+
+  uint64_t max = static_cast<uint64_t>(_burst) * 1000;
+  uint64_t elapsed = static_cast<uint64_t>(now - _last);
+
+  _last = now;
+
+  if(_tokens >= max)
+    return;
+
+  // elapsed is bounded to avoid overflow after a long idle period
+  if(elapsed > 1000 * static_cast<uint64_t>(_burst / _rate + 1))
+    _tokens = max;
+  else
+    _tokens = std::min(max, _tokens + (elapsed * _rate));
+}
+
+/*
+ */
+
+uint_t TokenBucket::getAvailable(time_ms_t now)
+{
+  if(_rate == 0)
+    return(UINT_MAX);
+
+  _refill(now);
+
+  return(static_cast<uint_t>(_tokens / 1000));
+}
+
+/*
+ */
+
+void TokenBucket::consume(uint_t count)
+{
+  if(_rate == 0)
+    return;
+
+  uint64_t n = static_cast<uint64_t>(count) * 1000;
+
+  _tokens = (n > _tokens) ? 0 : (_tokens - n);
+}
+
+/*
+ */
+
+timespan_ms_t TokenBucket::getDelay(time_ms_t now, uint_t count /* = 1 */)
+{
+  if(_rate == 0)
+    return(0);
+
+  _refill(now);
+
+  uint64_t n = static_cast<uint64_t>(std::min(count, _burst)) * 1000;
+
+  if(_tokens >= n)
+    return(0);
+
+  // round up to the next whole millisecond
+  return(static_cast<timespan_ms_t>((n - _tokens + _rate - 1) / _rate));
+}
+
+} // namespace ccxx
@@ -26,10 +26,23 @@
 
 #include "commonc++/UTF8Decoder.h++"
 
+#include <algorithm>
 #include <cstring>
 
 namespace ccxx {
 
+/*
+ */
+
+// tests if the next 8 bytes are all 7-bit ASCII characters
+static inline bool __isASCII8(const char *p)
+{
+  uint64_t word;
+  std::memcpy(&word, p, sizeof(word));
+
+  return((word & UINT64_CONST(0x8080808080808080)) == 0);
+}
+
 /*
  */
 
@@ -70,6 +83,38 @@ int UTF8Decoder::decode(const char** input, int* inputCountLeft,
 
   while(*inputCountLeft > 0)
   {
+    // fast path for runs of ASCII characters, which are widened 8 at a
+    // time where possible
+
+    if((_bytesExpected == 0) && ! _stopDecodingAtNulChar)
+    {
+      const char *in = *input;
+      char16_t *out = *output;
+      const char *end = in + std::min(*inputCountLeft, *outputCountLeft);
+
+      while((end - in >= 8) && __isASCII8(in))
+      {
+        for(int i = 0; i < 8; ++i)
+          out[i] = static_cast<char16_t>(in[i]);
+
+        in += 8;
+        out += 8;
+      }
+
+      while((in < end) && ((*in & 0x80) == 0))
+        *(out++) = static_cast<char16_t>(*(in++));
+
+      int n = static_cast<int>(in - *input);
+      if(n > 0)
+      {
+        *input = in;
+        *output = out;
+        *inputCountLeft -= n;
+        *outputCountLeft -= n;
+        continue;
+      }
+    }
+
     char c = **input;
     ++*input;
     --*inputCountLeft;
@@ -159,41 +204,58 @@ int UTF8Decoder::decodedLength(const char* input, int length,
 
   int count = 0;
   int bytesExpected = 0;
+  int sequenceLength = 0;
+  const char *p = input;
 
-  for(const char *p = input; length > 0; ++p, --length)
+  while(length > 0)
   {
+    if((bytesExpected == 0) && (length >= 8) && __isASCII8(p)
+       && ((maxLength == 0) || (count + 8 <= maxLength)))
+    {
+      count += 8;
+      p += 8;
+      length -= 8;
+      continue;
+    }
+
+    char c = *(p++);
+    --length;
+
     if(bytesExpected > 0)
     {
-      if((*p & 0xC0) != 0x80)
+      if((c & 0xC0) != 0x80)
         return(STATUS_INVALID_INPUT);
 
       if(--bytesExpected == 0)
       {
-        if((maxLength > 0) && (count == maxLength))
+        // a four-byte sequence decodes to a UTF-16 surrogate pair
+        int n = (sequenceLength == 4) ? 2 : 1;
+
+        if((maxLength > 0) && (count + n > maxLength))
           break;
 
-        ++count;
+        count += n;
       }
     }
     else
     {
-      if((*p & 0x80) == 0)
+      if((c & 0x80) == 0)
       {
         if((maxLength > 0) && (count == maxLength))
           break;
 
         ++count;
       }
-      else if((*p & 0xE0) == 0xC0)
+      else if((c & 0xE0) == 0xC0)
         bytesExpected = 1;
-      else if((*p & 0xF0) == 0xE0)
+      else if((c & 0xF0) == 0xE0)
         bytesExpected = 2;
-      else if((*p & 0xF8) == 0xF0)
+      else if((c & 0xF8) == 0xF0)
         bytesExpected = 3;
-      else if((*p & 0xFC) == 0xF8)
-        bytesExpected = 4;
       else
         return(STATUS_INVALID_INPUT);
+
+      sequenceLength = bytesExpected + 1;
     }
   }
 
@@ -0,0 +1,600 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "cpp_config.h"
+#endif
+
+#include "commonc++/WindowedMappedFile.h++"
+#include "commonc++/ScopedLock.h++"
+#include "commonc++/System.h++"
+
+#ifdef CCXX_OS_WINDOWS
+#include "commonc++/Windows.h++"
+#endif
+
+#ifdef CCXX_OS_POSIX
+
+#include "commonc++/POSIX.h++"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace ccxx {
+
+/*
+ */
+
+struct WindowedMappedFile::Window
+{
+  Window(uint64_t start, byte_t* base, size_t length)
+    : start(start),
+      base(base),
+      length(length),
+      refs(0),
+      prev(NULL),
+      next(NULL)
+  { }
+
+  uint64_t start;
+  byte_t* base;
+  size_t length;
+  uint_t refs;
+  Window* prev;
+  Window* next;
+};
+
+/*
+ */
+
+const size_t WindowedMappedFile::DEFAULT_WINDOW_SIZE = 4 * 1024 * 1024;
+
+const uint_t WindowedMappedFile::DEFAULT_MAX_WINDOWS = 8;
+
+/*
+ */
+
+WindowedMappedFile::View::View(WindowedMappedFile& file, uint64_t offset,
+                               size_t length)
+  : _file(file),
+    _window(NULL),
+    _data(NULL),
+    _offset(offset),
+    _length(length)
+{
+  if((length > file._windowSize) || (offset >= file._size)
+     || (length > file._size - offset))
+    throw OutOfBoundsException();
+
+  _window = file._acquire(offset);
+  _data = _window->base + (offset - _window->start);
+}
+
+/*
+ */
+
+WindowedMappedFile::View::~View()
+{
+  _file._release(_window);
+}
+
+/*
+ */
+
+WindowedMappedFile::WindowedMappedFile(const String& path,
+                                       size_t windowSize
+                                       /* = DEFAULT_WINDOW_SIZE */,
+                                       uint_t maxWindows
+                                       /* = DEFAULT_MAX_WINDOWS */)
+  : _path(path),
+    _windowSize(windowSize),
+    _maxWindows(std::max(maxWindows, 1U)),
+    _size(0),
+    _open(false),
+    _readOnly(false),
+    _head(NULL),
+    _tail(NULL)
+{
+  // windows must start on a multiple of the mapping granularity
+
+#ifdef CCXX_OS_WINDOWS
+  SYSTEM_INFO info;
+  ::GetSystemInfo(&info);
+  size_t granularity = static_cast<size_t>(info.dwAllocationGranularity);
+#else
+  size_t granularity = System::getPageSize();
+#endif
+
+  if(_windowSize < granularity)
+    _windowSize = granularity;
+  else if(_windowSize % granularity)
+    _windowSize += (granularity - (_windowSize % granularity));
+}
+
+/*
+ */
+
+WindowedMappedFile::~WindowedMappedFile()
+{
+  close();
+}
+
+/*
+ */
+
+void WindowedMappedFile::open(bool readOnly /* = false */)
+{
+  if(_open)
+    throw IOException("already open");
+
+#ifdef CCXX_OS_WINDOWS
+
+  SECURITY_ATTRIBUTES sa;
+
+  sa.nLength = sizeof(SECURITY_ATTRIBUTES);
+  sa.lpSecurityDescriptor = NULL;
+  sa.bInheritHandle = FALSE;
+
+  _handle = ::CreateFileW(_path.data(), (readOnly ? GENERIC_READ
+                                         : GENERIC_READ | GENERIC_WRITE),
+                          (FILE_SHARE_READ | FILE_SHARE_WRITE),
+                          &sa, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+  if(_handle == INVALID_HANDLE_VALUE)
+  {
+    int err = ::GetLastError();
+    if((err == ERROR_FILE_NOT_FOUND) || (err == ERROR_PATH_NOT_FOUND))
+      throw PathNotFoundException(_path);
+    else
+      throw IOException(System::getErrorString("CreateFile"));
+  }
+
+  LARGE_INTEGER size;
+  if(! ::GetFileSizeEx(_handle, &size))
+  {
+    String err = System::getErrorString("GetFileSizeEx");
+    ::CloseHandle(_handle);
+    throw IOException(err);
+  }
+
+  _size = static_cast<uint64_t>(size.QuadPart);
+
+#else
+
+  CString cstr_path = _path.toUTF8();
+  if((_handle = ::open(cstr_path.data(), (readOnly ? O_RDONLY : O_RDWR))) < 0)
+  {
+    if(errno == ENOENT)
+      throw PathNotFoundException(_path);
+    else
+      throw IOException(System::getErrorString("open"));
+  }
+
+  struct stat stbuf;
+
+  if(::fstat(_handle, &stbuf) != 0)
+  {
+    String err = System::getErrorString("fstat");
+    ::close(_handle);
+    throw IOException(err);
+  }
+
+  _size = static_cast<uint64_t>(stbuf.st_size);
+
+#endif
+
+  if(_size == 0)
+  {
+#ifdef CCXX_OS_WINDOWS
+    ::CloseHandle(_handle);
+#else
+    ::close(_handle);
+#endif
+    throw IOException("cannot map zero-length file");
+  }
+
+#ifdef CCXX_OS_WINDOWS
+
+  _memHandle = ::CreateFileMapping(_handle, NULL,
+                                   (readOnly ? PAGE_READONLY : PAGE_READWRITE),
+                                   0, 0, NULL);
+  if(_memHandle == NULL)
+  {
+    String err = System::getErrorString("CreateFileMapping");
+    ::CloseHandle(_handle);
+    throw IOException(err);
+  }
+
+#endif
+
+  _readOnly = readOnly;
+  _open = true;
+}
+
+/*
+ */
+
+void WindowedMappedFile::create(uint64_t size,
+                                const Permissions& perm
+                                /* = Permissions::USER_READ_WRITE */)
+{
+  if(_open)
+    throw IOException("already open");
+
+  if(size == 0)
+    throw IOException("cannot map zero-length file");
+
+#ifdef CCXX_OS_WINDOWS
+
+  SECURITY_ATTRIBUTES sa;
+  WinPerms wperm;
+
+  Windows::encodePermissions(perm, wperm);
+
+  sa.nLength = sizeof(SECURITY_ATTRIBUTES);
+  sa.lpSecurityDescriptor = wperm.pdesc;
+  sa.bInheritHandle = FALSE;
+
+  _handle = ::CreateFileW(_path.data(), GENERIC_READ | GENERIC_WRITE,
+                          (FILE_SHARE_READ | FILE_SHARE_WRITE),
+                          &sa, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+  if(_handle == INVALID_HANDLE_VALUE)
+  {
+    int err = ::GetLastError();
+    if(err == ERROR_PATH_NOT_FOUND)
+      throw PathNotFoundException(_path);
+    else
+      throw IOException(System::getErrorString("CreateFile"));
+  }
+
+  // the file is extended to the given size when the mapping is created
+
+  DWORD rangeLo = static_cast<DWORD>(size & 0xFFFFFFFF);
+  DWORD rangeHi = static_cast<DWORD>((size >> 32) & 0xFFFFFFFF);
+
+  _memHandle = ::CreateFileMapping(_handle, NULL, PAGE_READWRITE, rangeHi,
+                                   rangeLo, NULL);
+  if(_memHandle == NULL)
+  {
+    String err = System::getErrorString("CreateFileMapping");
+    ::CloseHandle(_handle);
+    throw IOException(err);
+  }
+
+#else
+
+  mode_t perm_;
+  POSIX::encodePermissions(perm, perm_);
+
+  CString cstr_path = _path.toUTF8();
+  if((_handle = ::open(cstr_path.data(), (O_RDWR | O_CREAT | O_TRUNC),
+                       perm_)) < 0)
+  {
+    if(errno == ENOENT)
+      throw PathNotFoundException(_path);
+    else
+      throw IOException(System::getErrorString("open"));
+  }
+
+  int r = -1;
+
+#ifdef HAVE_POSIX_FALLOCATE
+  r = ::posix_fallocate(_handle, 0, static_cast<off_t>(size));
+
+  // fall back to a sparse file only if the filesystem can't preallocate
+
+  if((r != 0) && (r != EINVAL) && (r != EOPNOTSUPP))
+  {
+    errno = r;
+    String err = System::getErrorString("posix_fallocate");
+    ::close(_handle);
+    throw IOException(err);
+  }
+#endif
+
+  if((r != 0) && (::ftruncate(_handle, static_cast<off_t>(size)) != 0))
+  {
+    String err = System::getErrorString("ftruncate");
+    ::close(_handle);
+    throw IOException(err);
+  }
+
+#endif
+
+  _size = size;
+  _readOnly = false;
+  _open = true;
+}
+
+/*
+ */
+
+void WindowedMappedFile::close()
+{
+  ScopedLock guard(_lock);
+
+  if(! _open)
+    return;
+
+  while(_head != NULL)
+    _unmap(_head);
+
+#ifdef CCXX_OS_WINDOWS
+
+  ::CloseHandle(_memHandle);
+  ::CloseHandle(_handle);
+
+#else
+
+  ::close(_handle);
+
+#endif
+
+  _open = false;
+}
+
+/*
+ */
+
+void WindowedMappedFile::sync(bool async /* = false */)
+{
+  ScopedLock guard(_lock);
+
+  for(Window *window = _head; window != NULL; window = window->next)
+  {
+#ifdef CCXX_OS_WINDOWS
+
+    if(::FlushViewOfFile(window->base, 0) == FALSE)
+      throw IOException(System::getErrorString("FlushViewOfFile"));
+
+#else
+
+    if(::msync(window->base, window->length,
+               (async ? MS_ASYNC : MS_SYNC)) != 0)
+      throw IOException(System::getErrorString("msync"));
+
+#endif
+  }
+}
+
+/*
+ */
+
+size_t WindowedMappedFile::read(uint64_t offset, byte_t* buf, size_t count)
+{
+  if(offset >= _size)
+    return(0);
+
+  count = static_cast<size_t>(std::min(static_cast<uint64_t>(count),
+                                       _size - offset));
+  size_t total = 0;
+
+  while(total < count)
+  {
+    size_t n = std::min(count - total, _windowSize);
+    View view(*this, offset, n);
+
+    std::memcpy(buf + total, view.getData(), n);
+    offset += n;
+    total += n;
+  }
+
+  return(total);
+}
+
+/*
+ */
+
+size_t WindowedMappedFile::write(uint64_t offset, const byte_t* buf,
+                                 size_t count)
+{
+  if(_readOnly)
+    throw IOException("file is read-only");
+
+  if(offset >= _size)
+    return(0);
+
+  count = static_cast<size_t>(std::min(static_cast<uint64_t>(count),
+                                       _size - offset));
+  size_t total = 0;
+
+  while(total < count)
+  {
+    size_t n = std::min(count - total, _windowSize);
+    View view(*this, offset, n);
+
+    std::memcpy(view.getData(), buf + total, n);
+    offset += n;
+    total += n;
+  }
+
+  return(total);
+}
+
+/*
+ */
+
+uint_t WindowedMappedFile::getWindowCount() const
+{
+  ScopedLock guard(_lock);
+
+  return(static_cast<uint_t>(_windows.size()));
+}
+
+/*
+ */
+
+WindowedMappedFile::Window* WindowedMappedFile::_acquire(uint64_t offset)
+{
+  ScopedLock guard(_lock);
+
+  if(! _open)
+    throw IOException("not open");
+
+  uint64_t start = offset - (offset % _windowSize);
+
+  WindowMap::iterator iter = _windows.find(start);
+  if(iter != _windows.end())
+  {
+    Window *window = iter->second;
+    ++window->refs;
+
+    if(window != _head)
+    {
+      _unlink(window);
+      _link(window);
+    }
+
+    return(window);
+  }
+
+  // map twice the window size, so that any range of up to one window size
+  // that starts in this window is covered
+
+  size_t length = static_cast<size_t>(
+    std::min(static_cast<uint64_t>(_windowSize) * 2, _size - start));
+
+#ifdef CCXX_OS_WINDOWS
+
+  byte_t *base = reinterpret_cast<byte_t *>(
+    ::MapViewOfFile(_memHandle,
+                    (_readOnly ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS),
+                    static_cast<DWORD>((start >> 32) & 0xFFFFFFFF),
+                    static_cast<DWORD>(start & 0xFFFFFFFF), length));
+
+  if(base == NULL)
+    throw IOException(System::getErrorString("MapViewOfFile"));
+
+#else
+
+  void *addr = ::mmap(NULL, length,
+                      (_readOnly ? PROT_READ : (PROT_READ | PROT_WRITE)),
+                      MAP_SHARED, _handle, static_cast<off_t>(start));
+
+  if(addr == MAP_FAILED)
+    throw IOException(System::getErrorString("mmap"));
+
+  byte_t *base = static_cast<byte_t *>(addr);
+
+#endif
+
+  Window *window = new Window(start, base, length);
+  window->refs = 1;
+
+  _windows[start] = window;
+  _link(window);
+  _trim();
+
+  return(window);
+}
+
+/*
+ */
+
+void WindowedMappedFile::_release(Window* window)
+{
+  ScopedLock guard(_lock);
+
+  if(--window->refs == 0)
+    _trim();
+}
+
+/*
+ */
+
+void WindowedMappedFile::_unmap(Window* window)
+{
+#ifdef CCXX_OS_WINDOWS
+  ::UnmapViewOfFile(window->base);
+#else
+  ::munmap(window->base, window->length);
+#endif
+
+  _unlink(window);
+  _windows.erase(window->start);
+  delete window;
+}
+
+/*
+ */
+
+void WindowedMappedFile::_trim()
+{
+  // unmap the least recently used windows that are not in use
+
+  Window *window = _tail;
+
+  while((window != NULL) && (_windows.size() > _maxWindows))
+  {
+    Window *prev = window->prev;
+
+    if(window->refs == 0)
+      _unmap(window);
+
+    window = prev;
+  }
+}
+
+/*
+ */
+
+void WindowedMappedFile::_unlink(Window* window)
+{
+  if(window->prev)
+    window->prev->next = window->next;
+  else
+    _head = window->next;
+
+  if(window->next)
+    window->next->prev = window->prev;
+  else
+    _tail = window->prev;
+
+  window->prev = window->next = NULL;
+}
+
+/*
+ */
+
+void WindowedMappedFile::_link(Window* window)
+{
+  window->prev = NULL;
+  window->next = _head;
+
+  if(_head)
+    _head->prev = window;
+  else
+    _tail = window;
+
+  _head = window;
+}
+
+
+} // namespace ccxx
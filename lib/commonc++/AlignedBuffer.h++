@@ -0,0 +1,102 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_AlignedBuffer_hxx
+#define __ccxx_AlignedBuffer_hxx
+
+#include <commonc++/Common.h++>
+
+namespace ccxx {
+
+/**
+ * A fixed-size block of memory whose address is a multiple of a given
+ * alignment. Such buffers are needed for direct (unbuffered) file I/O; see
+ * File::setDirectIO().
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API AlignedBuffer
+{
+ public:
+
+  /**
+   * Construct a new AlignedBuffer.
+   *
+   * @param size The size of the buffer, in bytes. It will be rounded up
+   * to a multiple of the alignment.
+   * @param alignment The alignment, in bytes, which must be a power of
+   * two. If 0, the system's page size is used.
+   * @throw std::bad_alloc If the memory could not be allocated.
+   */
+  AlignedBuffer(size_t size, size_t alignment = 0);
+
+  /** Destructor. Frees the memory. */
+  ~AlignedBuffer();
+
+  /** Get a pointer to the start of the buffer. */
+  inline byte_t* getData()
+  { return(_data); }
+
+  /** Get a pointer to the start of the buffer. */
+  inline const byte_t* getData() const
+  { return(_data); }
+
+  /** Get the size of the buffer, in bytes. */
+  inline size_t getSize() const
+  { return(_size); }
+
+  /** Get the alignment of the buffer, in bytes. */
+  inline size_t getAlignment() const
+  { return(_alignment); }
+
+  /**
+   * Round a size or offset up to the next multiple of an alignment.
+   *
+   * @param value The value to round.
+   * @param alignment The alignment, which must be a power of two.
+   * @return The rounded value.
+   */
+  inline static uint64_t alignUp(uint64_t value, size_t alignment)
+  { return((value + alignment - 1) & ~static_cast<uint64_t>(alignment - 1)); }
+
+  /**
+   * Round a size or offset down to the previous multiple of an alignment.
+   *
+   * @param value The value to round.
+   * @param alignment The alignment, which must be a power of two.
+   * @return The rounded value.
+   */
+  inline static uint64_t alignDown(uint64_t value, size_t alignment)
+  { return(value & ~static_cast<uint64_t>(alignment - 1)); }
+
+ private:
+
+  byte_t* _data;
+  size_t _size;
+  size_t _alignment;
+
+  CCXX_COPY_DECLS(AlignedBuffer);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_AlignedBuffer_hxx
@@ -0,0 +1,267 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_AsyncLogger_hxx
+#define __ccxx_AsyncLogger_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/AtomicCounter.h++>
+#include <commonc++/ConditionVar.h++>
+#include <commonc++/CriticalSection.h++>
+#include <commonc++/Logger.h++>
+#include <commonc++/LogSite.h++>
+#include <commonc++/Mutex.h++>
+#include <commonc++/Runnable.h++>
+#include <commonc++/Thread.h++>
+
+namespace ccxx {
+
+/** Policies for handling a full asynchronous log buffer. */
+enum LogOverflowPolicy {
+  /** Block the logging thread until the writer makes room. */
+  LogOverflowBlock,
+  /** Silently discard the record. */
+  LogOverflowDrop,
+  /**
+   * Discard the record, and have the writer log the number of records
+   * that were discarded.
+   */
+  LogOverflowDropAndReport
+};
+
+/**
+ * A logger that decouples the formatting of log records from the writing
+ * of them. Records are formatted on the calling thread, into a ring buffer
+ * owned by that thread, without taking any lock; a background writer
+ * thread drains the ring buffers of all threads and passes the records to
+ * a target logger in large batches.
+ * <p>
+ * The target logger's format and level mask are used to format and filter
+ * records, so they should be configured before the AsyncLogger is
+ * started, and should not be changed while other threads are logging.
+ * Each ring buffer is released once its thread has exited and the writer
+ * has drained it.
+ * <p>
+ * Messages may also be logged as <i>binary records</i>, via logBinary() or
+ * the CCXX_LOG_BINARY() macro. A binary record holds only the ID of its
+ * LogSite, a timestamp, and the raw bytes of the message arguments, so
+ * logging one involves no formatting at all. If the target logger is
+ * binary (see Logger::isBinary()), the records are passed through to it
+ * as-is and can be rendered later by a decoder such as BinaryLogReader;
+ * otherwise they are rendered by the writer thread. In the latter case,
+ * the thread-related format directives reflect the writer thread rather
+ * than the logging thread.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API AsyncLogger : public Logger
+{
+ public:
+
+  /**
+   * Construct a new AsyncLogger.
+   *
+   * @param target The logger to write records to. The AsyncLogger does
+   * not take ownership of this object.
+   * @param bufferSize The size of each thread's ring buffer, in bytes. It
+   * is rounded up to a power of 2.
+   * @param policy The policy to apply when a thread's ring buffer is full.
+   * @param targetLock An optional lock to hold while writing to the
+   * target logger, if the target is shared with synchronous callers.
+   */
+  AsyncLogger(Logger* target, size_t bufferSize = DEFAULT_BUFFER_SIZE,
+              LogOverflowPolicy policy = LogOverflowBlock,
+              CriticalSection* targetLock = NULL);
+
+  /** Destructor. Stops the writer thread, if it is running. */
+  virtual ~AsyncLogger();
+
+  /**
+   * Start the writer thread. Records logged before the writer is started
+   * are buffered, subject to the overflow policy.
+   */
+  void start();
+
+  /**
+   * Stop the writer thread, after it has written all buffered records.
+   */
+  void stop();
+
+  /** Test if the writer thread is running. */
+  bool isRunning() const;
+
+  /**
+   * Write all buffered records to the target logger from the calling
+   * thread, without waiting for the writer thread, and then flush the
+   * target logger.
+   */
+  void flush();
+
+  /**
+   * Write any buffered records to the target logger on a best-effort
+   * basis. Intended to be called from a fatal signal handler or a
+   * terminate handler. It never blocks, takes a lock, allocates or frees
+   * memory; if any thread is draining the buffers, nothing is written.
+   * The records are written with the target's Logger::writeOnCrash().
+   * Binary records are only written if the target logger is itself
+   * binary, since rendering them is not async-signal-safe.
+   */
+  void flushOnCrash();
+
+  void vlog(LogLevel level, const char* file, int line, const char* message,
+            va_list args);
+
+  /**
+   * %Log a message as a binary record. If the site is not binary-capable,
+   * the message is formatted immediately, as by vlog().
+   *
+   * @param level The log level (severity).
+   * @param site The site of the log statement.
+   * @param ... The message arguments.
+   */
+  void logBinary(LogLevel level, const LogSite* site, ...);
+
+  /**
+   * %Log a message as a binary record.
+   *
+   * @param level The log level (severity).
+   * @param site The site of the log statement.
+   * @param args The message arguments.
+   */
+  void vlogBinary(LogLevel level, const LogSite* site, va_list args);
+
+  /**
+   * Set the target logger. This method may only be called while the
+   * writer thread is stopped.
+   */
+  void setTarget(Logger* target);
+
+  /** Get the target logger. */
+  inline Logger* getTarget()
+  { return(_target); }
+
+  /** Get the ring buffer size. */
+  inline size_t getBufferSize() const
+  { return(_bufferSize); }
+
+  /** Get the overflow policy. */
+  inline LogOverflowPolicy getOverflowPolicy() const
+  { return(_policy); }
+
+  /** Get the number of records discarded due to overflow. */
+  inline uint32_t getDropCount() const
+  { return(static_cast<uint32_t>(_dropCount.get())); }
+
+  /** The default ring buffer size. */
+  static const size_t DEFAULT_BUFFER_SIZE;
+
+  /** The maximum interval between writer passes, in milliseconds. */
+  static const timespan_ms_t FLUSH_INTERVAL;
+
+ protected:
+
+  /** Enqueue a preformatted record from the calling thread. */
+  bool write(CharBuffer& buffer);
+
+ private:
+
+  class Ring; // fwd decl
+  class RingList; // fwd decl
+  class RingHandle; // fwd decl
+  class RingSlot; // fwd decl
+
+  Ring* _getRing();
+  bool _enqueue(Ring* ring, const char* data, uint32_t len, bool binary);
+  void _run();
+  void _drain(bool crashing);
+  bool _append(Ring* ring, uint32_t pos, uint32_t len, bool binary);
+  bool _appendText(const char* text, uint32_t len);
+  void _writeBatch(bool crashing);
+  void _flushTarget(bool crashing);
+  void _wake();
+
+  Logger* _target;
+  size_t _bufferSize;
+  LogOverflowPolicy _policy;
+  CriticalSection* _targetLock;
+  RingList* _rings;
+  RingSlot* _slot;
+  CharBuffer _batch;
+  CharBuffer _line;
+  char* _record;
+  char* _message;
+  Mutex _ringLock;
+  AtomicCounter _ringsBusy;
+  Mutex _drainLock;
+  AtomicCounter _drainBusy;
+  Mutex _waitLock;
+  ConditionVar _waitCond;
+  bool _pending;
+  AtomicCounter _running;
+  AtomicCounter _dropCount;
+  AtomicCounter _dropReported;
+  RunnableDelegate<AsyncLogger> _runner;
+  Thread* _writer;
+
+  CCXX_COPY_DECLS(AsyncLogger);
+};
+
+#if (defined CCXX_OS_WINDOWS) && (defined _MSC_VER) && (_MSC_VER < 1400)
+
+// no variadic macros; CCXX_LOG_BINARY() is not available
+
+#elif (defined __GNUC__)
+
+/**
+ * Log a message as a binary record to an AsyncLogger. A static LogSite is
+ * created for each occurrence of this macro, and the arguments are
+ * checked against the format string at compile time.
+ *
+ * @param LOGGER The AsyncLogger.
+ * @param L The log level.
+ * @param M The message format, which must be a string literal.
+ */
+#define CCXX_LOG_BINARY(LOGGER, L, M, args...)                          \
+  do                                                                    \
+  {                                                                     \
+    static const ccxx::LogSite ccxx_log_site_(M, __FILE__, __LINE__);   \
+    if(false)                                                           \
+      ccxx::LogSite::checkFormat(M, ## args);                           \
+    (LOGGER).logBinary(L, &ccxx_log_site_, ## args);                    \
+  } while(0)
+
+#else // assume ANSI compiler with support for C99 variadic macros
+
+#define CCXX_LOG_BINARY(LOGGER, L, M, ...)                              \
+  do                                                                    \
+  {                                                                     \
+    static const ccxx::LogSite ccxx_log_site_(M, __FILE__, __LINE__);   \
+    if(false)                                                           \
+      ccxx::LogSite::checkFormat(M, __VA_ARGS__);                       \
+    (LOGGER).logBinary(L, &ccxx_log_site_, __VA_ARGS__);                \
+  } while(0)
+
+#endif // variadic checks
+
+} // namespace ccxx
+
+#endif // __ccxx_AsyncLogger_hxx
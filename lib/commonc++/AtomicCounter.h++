@@ -99,6 +99,23 @@ class COMMONCPP_API AtomicCounter
   /** Get the current value of the counter. */
   int32_t get() const;
 
+  /**
+   * Get the current value of the counter without a memory barrier. This
+   * is much cheaper than get(), and is suitable for values, such as
+   * flags, that are read far more often than they are written, when the
+   * reader does not depend on the ordering of other memory accesses.
+   */
+  inline int32_t load() const
+  {
+#if (defined __clang__) || ((defined __GNUC__) \
+     && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7))))
+    return(__atomic_load_n(&_atomic, __ATOMIC_RELAXED));
+#else
+    // aligned 32-bit loads are atomic on all supported platforms
+    return(*const_cast<const volatile int32_t *>(&_atomic));
+#endif
+  }
+
   /** Cast operator. */
   inline operator int32_t() const
   { return(get()); }
@@ -24,6 +24,8 @@
 #define __ccxx_BasicBufferedStream_hxx
 
 #include <commonc++/Common.h++>
+#include <commonc++/AlignedBuffer.h++>
+#include <commonc++/BlockReader.h++>
 #include <commonc++/CircularBuffer.h++>
 #include <commonc++/IOException.h++>
 #include <commonc++/Stream.h++>
@@ -34,6 +36,19 @@
 
 namespace ccxx {
 
+/** Buffering modes for BasicBufferedStream. */
+enum BufferedStreamMode {
+  /** Buffer data in a circular buffer; reads and writes are issued for
+   * whatever space or data the buffer holds. */
+  BufferedStreamNormal,
+  /** Read and write in whole, page-aligned blocks, with one system call
+   * per block. Suitable for bulk copies. */
+  BufferedStreamBlock,
+  /** As BufferedStreamBlock, but while one block is being consumed, the
+   * next is read on a background thread. Readahead is used only if the
+   * stream is open for reading only. */
+  BufferedStreamReadahead };
+
 /**
  * A buffered stream. This class is a subclass of
  * <b>std::basic_iostream</b> and serves as the "glue" between
@@ -54,9 +69,24 @@ template <typename C> class BasicBufferedStream : public std::basic_iostream<C>
   BasicBufferedStream(Stream& stream,
                       size_t bufferSize = DEFAULT_BUFFER_SIZE);
 
+  /** Construct a new BasicBufferedStream for the given stream, buffering
+   * mode, and buffer size.
+   *
+   * @param stream The stream.
+   * @param mode The buffering mode.
+   * @param bufferSize The buffer size. In the block modes, this is the
+   * block size, and is rounded up to a multiple of the page size. If 0,
+   * a default appropriate for the mode is used.
+   */
+  BasicBufferedStream(Stream& stream, BufferedStreamMode mode,
+                      size_t bufferSize = 0);
+
   /** The default buffer size. */
   static const size_t DEFAULT_BUFFER_SIZE;
 
+  /** The default block size for the block modes. */
+  static const size_t DEFAULT_BLOCK_SIZE;
+
   /** Destructor. */
   virtual ~BasicBufferedStream();
 
@@ -86,11 +116,15 @@ template <typename C> class BasicBufferedStream : public std::basic_iostream<C>
 
    public:
 
-    StreamBuf(size_t bufferSize, Stream& stream);
+    StreamBuf(size_t bufferSize, Stream& stream,
+              BufferedStreamMode mode = BufferedStreamNormal);
     ~StreamBuf();
 
     int sync();
 
+    /** Discard buffered input, and stop any readahead in progress. */
+    void discard();
+
    protected:
 
     int_type overflow(int_type c);
@@ -105,10 +139,15 @@ template <typename C> class BasicBufferedStream : public std::basic_iostream<C>
 
     inline void _resetp();
     inline void _resetg();
+    int64_t _seek(int64_t offset, SeekMode seekMode,
+                  std::ios::openmode mode);
+    void _flushBlock();
 
     Stream& _stream;
     CircularBuffer<C> *_inbuf;
     CircularBuffer<C> *_outbuf;
+    BlockReader *_inblock;
+    AlignedBuffer *_outblock;
     int64_t _readPos;
     int64_t _writePos;
     StreamOp _lastOp;
@@ -32,6 +32,11 @@
 template<typename C>
   const size_t BasicBufferedStream<C>::DEFAULT_BUFFER_SIZE = 4096;
 
+/*
+ */
+template<typename C>
+  const size_t BasicBufferedStream<C>::DEFAULT_BLOCK_SIZE = 1024 * 1024;
+
 /*
  */
 
@@ -42,6 +47,19 @@ template<typename C> BasicBufferedStream<C>::BasicBufferedStream(
 {
 }
 
+/*
+ */
+
+template<typename C> BasicBufferedStream<C>::BasicBufferedStream(
+  Stream& stream, BufferedStreamMode mode, size_t bufferSize /* = 0 */)
+  : std::iostream(_buf = new StreamBuf(
+                    (bufferSize != 0 ? bufferSize
+                     : (mode == BufferedStreamNormal ? DEFAULT_BUFFER_SIZE
+                        : DEFAULT_BLOCK_SIZE)), stream, mode)),
+    _stream(stream)
+{
+}
+
 /*
  */
 
@@ -59,8 +77,14 @@ template<typename C>
   void BasicBufferedStream<C>::close(IOMode mode /* = IOReadWrite */)
 {
   if(_buf)
+  {
     _buf->sync();
 
+    // make sure no readahead is in progress when the stream is closed
+    if(mode != IOWrite)
+      _buf->discard();
+  }
+
   _stream.close(mode);
 }
 
@@ -68,24 +92,44 @@ template<typename C>
  */
 
 template<typename C>
-  BasicBufferedStream<C>::StreamBuf::StreamBuf(size_t bufferSize,
-                                               Stream& stream)
+  BasicBufferedStream<C>::StreamBuf::StreamBuf(
+    size_t bufferSize, Stream& stream,
+    BufferedStreamMode mode /* = BufferedStreamNormal */)
     : _stream(stream),
       _inbuf(NULL),
       _outbuf(NULL),
+      _inblock(NULL),
+      _outblock(NULL),
       _readPos(0LL),
       _writePos(0LL),
       _lastOp(OpNone)
 {
+  if(stream.isSeekable())
+    _readPos = _writePos = stream.tell();
+
   if(stream.isReadable())
   {
-    _inbuf = new CircularBuffer<C>(bufferSize);
+    if(mode == BufferedStreamNormal)
+      _inbuf = new CircularBuffer<C>(bufferSize);
+    else
+    {
+      // reading ahead would race with writes, which move the same file
+      // pointer
+      _inblock = new BlockReader(stream, bufferSize,
+                                 (mode == BufferedStreamReadahead)
+                                 && ! stream.isWritable());
+    }
+
     _resetg();
   }
 
   if(stream.isWritable())
   {
-    _outbuf = new CircularBuffer<C>(bufferSize);
+    if(mode == BufferedStreamNormal)
+      _outbuf = new CircularBuffer<C>(bufferSize);
+    else
+      _outblock = new AlignedBuffer(bufferSize);
+
     _resetp();
   }
 }
@@ -98,11 +142,10 @@ template<typename C>
 {
   sync();
 
-  if(_inbuf)
-    delete _inbuf;
-
-  if(_outbuf)
-    delete _outbuf;
+  delete _inbuf;
+  delete _outbuf;
+  delete _inblock;
+  delete _outblock;
 }
 
 /*
@@ -115,6 +158,19 @@ template<typename C>
   if(! _stream.isWritable())
     return(std::char_traits<C>::eof());
 
+  if(_outblock)
+  {
+    _flushBlock();
+
+    if(! std::char_traits<C>::eq_int_type(c, std::char_traits<C>::eof()))
+    {
+      *(this->pptr()) = c;
+      this->pbump(1);
+    }
+
+    return(std::char_traits<C>::not_eof(c));
+  }
+
   size_t nw = this->pptr() - _outbuf->getWritePos();
 
   _outbuf->advanceWritePos(nw);
@@ -124,7 +180,8 @@ template<typename C>
   {
     // if last operation wasn't a write seek or write, we need to
     // reposition the seek pointer to the write position
-    if((_lastOp != OpWriteSeek) && (_lastOp != OpWrite) && (_lastOp != OpSeek))
+    if((_lastOp != OpWriteSeek) && (_lastOp != OpWrite) && (_lastOp != OpSeek)
+       && _stream.isSeekable())
       _stream.seek(_writePos);
 
     size_t w = _outbuf->read(_stream);
@@ -158,15 +215,43 @@ template<typename C>
   if(! _stream.isReadable())
     return(std::char_traits<C>::eof());
 
+  if(this->gptr() < this->egptr())
+    return(std::char_traits<C>::to_int_type(*(this->gptr())));
+
+  // if last operation wasn't a read seek or read, we need to reposition
+  // the seek pointer to the read position; the reader thread, if any, owns
+  // the seek pointer
+  bool reposition = ((_lastOp != OpReadSeek) && (_lastOp != OpRead)
+                     && (_lastOp != OpSeek) && _stream.isSeekable());
+
+  if(_inblock)
+  {
+    if(reposition && ! _inblock->isReadahead())
+      _stream.seek(_readPos);
+
+    byte_t *data = NULL;
+    size_t r = _inblock->next(data);
+
+    _readPos += r;
+    _lastOp = OpRead;
+
+    size_t x = r / sizeof(C);
+    if(x < 1)
+      return(std::char_traits<C>::eof());
+
+    C *pos = reinterpret_cast<C *>(data);
+    this->setg(pos, pos, pos + x);
+
+    return(std::char_traits<C>::to_int_type(*(this->gptr())));
+  }
+
   size_t nr = this->gptr() - _inbuf->getReadPos();
   _inbuf->advanceReadPos(nr);
 
   size_t x = _inbuf->getReadExtent();
   if(x < 1)
   {
-    // if last operation wasn't a read seek or read, we need to
-    // reposition the seek pointer to the read position
-    if((_lastOp != OpReadSeek) && (_lastOp != OpRead) && (_lastOp != OpSeek))
+    if(reposition)
       _stream.seek(_readPos);
 
     size_t r = _inbuf->write(_stream);
@@ -182,10 +267,7 @@ template<typename C>
 
   this->setg(pos, pos, pos + x);
 
-  int_type c = std::char_traits<C>::to_int_type(*(this->gptr()));
-  this->gbump(1);
-
-  return(c);
+  return(std::char_traits<C>::to_int_type(*(this->gptr())));
 }
 
 /*
@@ -196,30 +278,7 @@ template<typename C>
   BasicBufferedStream<C>::StreamBuf::seekpos(pos_type streampos,
                                              std::ios::openmode mode)
 {
-  if(! _stream.isSeekable())
-    return(static_cast<pos_type>(-1));
-
-  if(sync() != 0)
-    return(static_cast<pos_type>(-1));
-
-  if(_inbuf)
-    _inbuf->clear();
-
-  int64_t pos = _stream.seek(streampos);
-
-  if(mode & std::ios_base::in)
-  {
-    _readPos = pos;
-    _lastOp = OpReadSeek;
-  }
-
-  if(mode & std::ios_base::out)
-  {
-    _writePos = pos;
-    _lastOp = (mode & std::ios_base::in) ? OpSeek : OpWriteSeek;
-  }
-
-  return(static_cast<pos_type>(pos));
+  return(seekoff(static_cast<off_type>(streampos), std::ios_base::beg, mode));
 }
 
 /*
@@ -257,10 +316,61 @@ template<typename C>
       break;
   }
 
-  if(_inbuf)
-    _inbuf->clear();
+  return(static_cast<pos_type>(_seek(static_cast<int64_t>(offset), seekMode,
+                                     mode)));
+}
+
+/*
+ */
+
+template<typename C>
+  int64_t BasicBufferedStream<C>::StreamBuf::_seek(int64_t offset,
+                                                   SeekMode seekMode,
+                                                   std::ios::openmode mode)
+{
+  if((mode & std::ios_base::in) && (_lastOp == OpRead))
+  {
+    // The stream position is ahead of the read position by the amount of
+    // data that is buffered (or has been read ahead), so positions are
+    // computed relative to the next character to be read.
+
+    int64_t buffered = this->egptr() - this->gptr();
+    if(_inbuf)
+      buffered = _inbuf->getRemaining() - (this->gptr() - _inbuf->getReadPos());
 
-  int64_t pos = _stream.seek(static_cast<int64_t>(offset), seekMode);
+    int64_t cur = _readPos - (buffered * static_cast<int64_t>(sizeof(C)));
+
+    if(seekMode == SeekRelative)
+    {
+      offset += cur;
+      seekMode = SeekAbsolute;
+    }
+
+    if(! (mode & std::ios_base::out) && (seekMode == SeekAbsolute))
+    {
+      // a target within the get area (such as the current position, as
+      // requested by tellg()) needs no I/O
+
+      int64_t start = cur - ((this->gptr() - this->eback())
+                             * static_cast<int64_t>(sizeof(C)));
+      int64_t end = cur + ((this->egptr() - this->gptr())
+                           * static_cast<int64_t>(sizeof(C)));
+
+      if((offset >= start) && (offset <= end)
+         && (((offset - start) % sizeof(C)) == 0))
+      {
+        this->setg(this->eback(),
+                   this->eback() + ((offset - start) / sizeof(C)),
+                   this->egptr());
+
+        return(offset);
+      }
+    }
+  }
+
+  discard();
+
+  int64_t pos = _stream.seek(offset, seekMode);
 
   if(mode & std::ios_base::in)
   {
@@ -274,7 +384,7 @@ template<typename C>
     _lastOp = (mode & std::ios_base::in) ? OpSeek : OpWriteSeek;
   }
 
-  return(static_cast<pos_type>(pos));
+  return(pos);
 }
 
 /*
@@ -283,6 +393,9 @@ template<typename C>
 template<typename C>
   int BasicBufferedStream<C>::StreamBuf::sync()
 {
+  if(_outblock)
+    _flushBlock();
+
   if(_outbuf)
   {
     size_t nw = this->pptr() - _outbuf->getWritePos();
@@ -300,6 +413,22 @@ template<typename C>
   return(0);
 }
 
+/*
+ */
+
+template<typename C>
+  void BasicBufferedStream<C>::StreamBuf::discard()
+{
+  if(_inbuf)
+    _inbuf->clear();
+
+  if(_inblock)
+    _inblock->discard();
+
+  if(_inbuf || _inblock)
+    _resetg();
+}
+
 /*
  */
 
@@ -312,16 +441,40 @@ template<typename C>
   return(static_cast<int>(_inbuf->getRemaining()));
 }
 
+/*
+ */
+
+template<typename C>
+  void BasicBufferedStream<C>::StreamBuf::_flushBlock()
+{
+  size_t n = (this->pptr() - this->pbase()) * sizeof(C);
+
+  if(n > 0)
+  {
+    if((_lastOp != OpWriteSeek) && (_lastOp != OpWrite) && (_lastOp != OpSeek)
+       && _stream.isSeekable())
+      _stream.seek(_writePos);
+
+    _stream.writeFully(reinterpret_cast<const byte_t *>(this->pbase()), n);
+
+    _writePos += n;
+    _lastOp = OpWrite;
+  }
+
+  _resetp();
+}
+
 /*
  */
 
 template<typename C>
   void BasicBufferedStream<C>::StreamBuf::_resetg()
 {
-  this->setg(reinterpret_cast<char *>(_inbuf->getBase()),
-             reinterpret_cast<char *>(_inbuf->getBase()),
-             reinterpret_cast<char *>(_inbuf->getBase()
-                                      + _inbuf->getSize()));
+  // the get area starts out empty, so that the first read calls underflow()
+
+  C *base = _inbuf ? _inbuf->getBase() : NULL;
+
+  this->setg(base, base, base);
 }
 
 /*
@@ -330,9 +483,16 @@ template<typename C>
 template<typename C>
   void BasicBufferedStream<C>::StreamBuf::_resetp()
 {
-  this->setp(reinterpret_cast<char *>(_outbuf->getBase()),
-             reinterpret_cast<char *>(_outbuf->getBase()
-                                      + _outbuf->getSize()));
+  if(_outblock)
+  {
+    C *base = reinterpret_cast<C *>(_outblock->getData());
+
+    this->setp(base, base + (_outblock->getSize() / sizeof(C)));
+  }
+  else
+    this->setp(reinterpret_cast<char *>(_outbuf->getBase()),
+               reinterpret_cast<char *>(_outbuf->getBase()
+                                        + _outbuf->getSize()));
 }
 
 #endif // __ccxx_BasicBufferedStreamImpl_hxx
@@ -0,0 +1,100 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_BinaryFileLogger_hxx
+#define __ccxx_BinaryFileLogger_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/FileLogger.h++>
+
+namespace ccxx {
+
+/**
+ * A logger that writes binary log frames to a file, for use as the target
+ * of an AsyncLogger. Binary log records are written unrendered, together
+ * with the definitions of the LogSite objects they refer to; messages
+ * that were formatted before they were logged are written as text frames.
+ * The resulting files are typically much smaller than the equivalent text
+ * logs, and can be rendered with BinaryLogReader or the <b>logtool</b>
+ * utility. Log rotation is performed as for FileLogger; each log file
+ * is self-contained.
+ * <p>
+ * The log message format of this logger is not used; the format is chosen
+ * when the file is rendered.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API BinaryFileLogger : public FileLogger
+{
+ public:
+
+  /**
+   * Construct a new BinaryFileLogger.
+   *
+   * @param maxLogSize The maximum log file size, in kilobytes.
+   * @param rotateCount The maximum number of backlog files to create. The
+   * value must range from 0 to 9, with 0 indicating that log rotation is
+   * disabled.
+   */
+  BinaryFileLogger(size_t maxLogSize = 2048, uint_t rotateCount = 1);
+
+  /** Destructor. */
+  virtual ~BinaryFileLogger();
+
+  bool isBinary() const;
+
+ protected:
+
+  /**
+   * Open the log file, and write the file header and the definitions of
+   * all sites that have been registered so far.
+   *
+   * @throw IOException If an I/O error occurs.
+   */
+  void openFile();
+
+  /**
+   * Write a sequence of frames to the file, preceding each record frame
+   * with the definition of its site, if it has not yet been written.
+   */
+  bool write(CharBuffer& buffer);
+
+  /**
+   * Write a sequence of frames to the file from a fatal signal handler.
+   * Record frames whose sites have not yet been defined in the file are
+   * discarded, since defining them is not async-signal-safe.
+   */
+  bool writeOnCrash(CharBuffer& buffer);
+
+ private:
+
+  bool _flushFrames();
+
+  CharBuffer _frames;
+  uint32_t _definedSites;
+
+  CCXX_COPY_DECLS(BinaryFileLogger);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_BinaryFileLogger_hxx
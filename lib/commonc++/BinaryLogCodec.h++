@@ -0,0 +1,227 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_BinaryLogCodec_hxx
+#define __ccxx_BinaryLogCodec_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/Buffer.h++>
+#include <commonc++/LogFormat.h++>
+#include <commonc++/LogSite.h++>
+
+#include <cstdarg>
+
+namespace ccxx {
+
+/**
+ * Routines for encoding and decoding binary log records. A binary log
+ * record consists of a LogSite ID, a log level, a timestamp, and the raw
+ * bytes of the message arguments; the message text is only produced when
+ * the record is rendered, using the format string of its site.
+ * <p>
+ * A binary log file begins with a header (FILE_MAGIC followed by a byte
+ * order mark) and consists of a sequence of <i>frames</i>. Each frame has
+ * a one-byte type and a four-byte payload length, followed by the
+ * payload. A site frame defines a LogSite ID in terms of its source
+ * location and format string; it precedes the first record frame that
+ * refers to that ID. A text frame contains a message that was formatted
+ * before it was logged. All integers are stored in host byte order.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API BinaryLogCodec
+{
+ public:
+
+  /**
+   * Parse a printf-style format string into an argument signature. See
+   * LogSite for a list of the supported conversions.
+   *
+   * @param format The format string.
+   * @param signature The output array for the signature, which will be
+   * NUL-terminated.
+   * @param size The size of the output array.
+   * @return <b>true</b> if the format string is supported and its
+   * signature fit in the output array, <b>false</b> otherwise.
+   */
+  static bool parseSignature(const char* format, char* signature,
+                             size_t size);
+
+  /**
+   * Encode a log record.
+   *
+   * @param buf The output array.
+   * @param size The size of the output array. String arguments are
+   * truncated as necessary to make the record fit.
+   * @param site The site of the log statement.
+   * @param level The log level.
+   * @param time The time at which the message was logged.
+   * @param args The message arguments.
+   * @return The length of the encoded record, or 0 if the output array is
+   * too small to hold even a truncated record.
+   */
+  static size_t encodeRecord(char* buf, size_t size, const LogSite& site,
+                             LogLevel level, time_ms_t time, va_list args);
+
+  /**
+   * Decode the header of a log record.
+   *
+   * @param data The encoded record.
+   * @param len The length of the encoded record.
+   * @param siteID The site ID.
+   * @param level The log level.
+   * @param time The time at which the message was logged.
+   * @param args Returns a pointer to the encoded message arguments.
+   * @param argsLen Returns the length of the encoded message arguments.
+   * @return <b>true</b> on success, <b>false</b> if the record is
+   * malformed.
+   */
+  static bool decodeRecord(const char* data, size_t len, uint32_t& siteID,
+                           LogLevel& level, time_ms_t& time,
+                           const char*& args, size_t& argsLen);
+
+  /**
+   * Render the message of a log record.
+   *
+   * @param format The format string of the record's site.
+   * @param args The encoded message arguments.
+   * @param argsLen The length of the encoded message arguments.
+   * @param output The output array. The message is NUL-terminated, and is
+   * truncated if the array is too small.
+   * @param outputLen The size of the output array.
+   * @return The length of the rendered message.
+   */
+  static size_t renderMessage(const char* format, const char* args,
+                              size_t argsLen, char* output,
+                              size_t outputLen);
+
+  /**
+   * Format a rendered message as a log line, using a LogFormat. The
+   * buffer is cleared beforehand, and flipped afterwards so that it is
+   * ready to be written.
+   *
+   * @param logFormat The log format.
+   * @param buffer The output buffer.
+   * @param level The log level.
+   * @param time The time at which the message was logged.
+   * @param file The source file of the log statement.
+   * @param line The source line of the log statement.
+   * @param message The rendered message.
+   */
+  static void formatLine(LogFormat& logFormat, CharBuffer& buffer,
+                         LogLevel level, time_ms_t time, const char* file,
+                         int line, const char* message);
+
+  /**
+   * Encode a site frame.
+   *
+   * @param buf The output array.
+   * @param size The size of the output array.
+   * @param site The site.
+   * @return The length of the frame, including the frame header, or 0 if
+   * the output array is too small.
+   */
+  static size_t encodeSiteFrame(char* buf, size_t size, const LogSite& site);
+
+  /**
+   * Decode the payload of a site frame.
+   *
+   * @param data The frame payload.
+   * @param len The length of the frame payload.
+   * @param siteID The site ID.
+   * @param line The source line.
+   * @param file Returns a pointer to the NUL-terminated source file.
+   * @param format Returns a pointer to the NUL-terminated format string.
+   * @return <b>true</b> on success, <b>false</b> if the frame is
+   * malformed.
+   */
+  static bool decodeSiteFrame(const char* data, size_t len, uint32_t& siteID,
+                              int& line, const char*& file,
+                              const char*& format);
+
+  /**
+   * Write a frame header.
+   *
+   * @param buf The output array, which must have room for at least
+   * FRAME_HEADER_SIZE bytes.
+   * @param type The frame type.
+   * @param len The length of the frame payload.
+   */
+  static void encodeFrameHeader(char* buf, char type, uint32_t len);
+
+  /**
+   * Read a frame header.
+   *
+   * @param buf The frame header, which must be FRAME_HEADER_SIZE bytes
+   * long.
+   * @param type Returns the frame type.
+   * @param len Returns the length of the frame payload.
+   */
+  static void decodeFrameHeader(const char* buf, char& type, uint32_t& len);
+
+  /**
+   * Write a binary log file header.
+   *
+   * @param buf The output array, which must have room for at least
+   * FILE_HEADER_SIZE bytes.
+   */
+  static void encodeFileHeader(char* buf);
+
+  /**
+   * Validate a binary log file header.
+   *
+   * @param buf The header, which must be FILE_HEADER_SIZE bytes long.
+   * @return <b>true</b> if the header is valid and was written on a host
+   * with the same byte order, <b>false</b> otherwise.
+   */
+  static bool checkFileHeader(const char* buf);
+
+  /** The site frame type. */
+  static const char FRAME_SITE = 'S';
+
+  /** The record frame type. */
+  static const char FRAME_RECORD = 'R';
+
+  /** The text frame type. */
+  static const char FRAME_TEXT = 'T';
+
+  /** The size of a frame header. */
+  static const size_t FRAME_HEADER_SIZE = 5;
+
+  /** The size of a record header. */
+  static const size_t RECORD_HEADER_SIZE = 13;
+
+  /** The size of the binary log file header. */
+  static const size_t FILE_HEADER_SIZE = 12;
+
+  /** The magic string at the beginning of a binary log file. */
+  static const char* FILE_MAGIC;
+
+ private:
+
+  BinaryLogCodec(); // not supported
+  CCXX_COPY_DECLS(BinaryLogCodec);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_BinaryLogCodec_hxx
@@ -0,0 +1,116 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_BinaryLogReader_hxx
+#define __ccxx_BinaryLogReader_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/Buffer.h++>
+#include <commonc++/DataFormatException.h++>
+#include <commonc++/File.h++>
+#include <commonc++/IOException.h++>
+#include <commonc++/LogFormat.h++>
+#include <commonc++/String.h++>
+
+namespace ccxx {
+
+/**
+ * A reader that renders binary log files, as written by BinaryFileLogger,
+ * as formatted text. Record frames are rendered with a LogFormat, using
+ * the timestamp and site that were recorded when the message was logged;
+ * text frames are passed through as-is.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API BinaryLogReader
+{
+ public:
+
+  /**
+   * Construct a new BinaryLogReader.
+   *
+   * @param path The path of the binary log file.
+   * @param format The log message format to render records with.
+   */
+  BinaryLogReader(const String& path,
+                  const String& format = "[%D %T] %F:%L %m");
+
+  /** Destructor. Closes the file, if it is open. */
+  ~BinaryLogReader();
+
+  /**
+   * Open the log file and validate its header.
+   *
+   * @throw IOException If an I/O error occurs.
+   * @throw DataFormatException If the file is not a binary log file, or
+   * was written on a host with a different byte order.
+   */
+  void open();
+
+  /** Close the log file. */
+  void close();
+
+  /**
+   * Read and render the next log message. On return, the buffer is flipped
+   * and ready to be written.
+   *
+   * @param buffer The buffer to render the message into.
+   * @return <b>true</b> if a message was read, <b>false</b> if the end of
+   * the file has been reached.
+   * @throw IOException If an I/O error occurs.
+   * @throw DataFormatException If the file is malformed.
+   */
+  bool read(CharBuffer& buffer);
+
+  /** Get the LogFormat used to render records. */
+  inline LogFormat& getLogFormat()
+  { return(_format); }
+
+  /**
+   * Get the number of records that referred to sites that were not
+   * defined in the file; such records are skipped.
+   */
+  inline uint_t getUnknownSiteCount() const
+  { return(_unknownSites); }
+
+ private:
+
+  class SiteMap; // fwd decl
+
+  bool _fill(size_t count);
+
+  File _file;
+  LogFormat _format;
+  SiteMap* _sites;
+  char* _data;
+  size_t _dataSize;
+  size_t _dataPos;
+  size_t _dataLen;
+  char* _message;
+  uint_t _unknownSites;
+
+  CCXX_COPY_DECLS(BinaryLogReader);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_BinaryLogReader_hxx
@@ -0,0 +1,145 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_BlockReader_hxx
+#define __ccxx_BlockReader_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/AlignedBuffer.h++>
+#include <commonc++/ConditionVar.h++>
+#include <commonc++/IOException.h++>
+#include <commonc++/Mutex.h++>
+#include <commonc++/Runnable.h++>
+#include <commonc++/Stream.h++>
+#include <commonc++/String.h++>
+#include <commonc++/Thread.h++>
+
+namespace ccxx {
+
+/**
+ * A reader that consumes a Stream sequentially in large, aligned
+ * blocks. Each block is read with a single system call into a buffer
+ * whose address and size are multiples of the alignment, so the reader
+ * can be used with files opened for direct I/O (see File::setDirectIO()),
+ * provided that the stream is positioned at an aligned offset.
+ *
+ * In <i>readahead</i> mode, the reader double-buffers: while the caller
+ * consumes one block, the next one is read from the stream on a background
+ * thread, so that the caller's processing overlaps with I/O latency. The
+ * stream must not be accessed by any other means while readahead is
+ * active; call discard() before repositioning it.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API BlockReader
+{
+ public:
+
+  /**
+   * Construct a new BlockReader.
+   *
+   * @param stream The stream to read from.
+   * @param blockSize The block size, in bytes. It will be rounded up to
+   * a multiple of the alignment.
+   * @param readahead Whether to read ahead on a background thread.
+   * @param alignment The buffer alignment, which must be a power of two.
+   * If 0, the system's page size is used.
+   */
+  BlockReader(Stream& stream, size_t blockSize = DEFAULT_BLOCK_SIZE,
+              bool readahead = false, size_t alignment = 0);
+
+  /**
+   * Destructor. Stops the background thread. A read from a pipe or socket
+   * that is waiting for data is interrupted; a read from a file is allowed
+   * to complete.
+   */
+  ~BlockReader();
+
+  /**
+   * Get the next block of data from the stream. The block returned by
+   * the previous call is released, and its data may be overwritten.
+   *
+   * @param data A pointer to the data is returned in this parameter.
+   * @return The number of bytes in the block, which may be less than the
+   * block size, or 0 if the end of the stream was reached.
+   * @throw IOException If an I/O error occurred.
+   */
+  size_t next(byte_t*& data);
+
+  /**
+   * Discard any data that has been read ahead, and suspend readahead
+   * until the next call to next(). This method must be called before
+   * the stream is repositioned. A read from a pipe or socket that is
+   * waiting for data is interrupted.
+   */
+  void discard();
+
+  /** Get the block size, in bytes. */
+  inline size_t getBlockSize() const
+  { return(_blocks[0].buffer->getSize()); }
+
+  /** Test if the reader is in readahead mode. */
+  inline bool isReadahead() const
+  { return(_thread != NULL); }
+
+  /** The default block size (1 MB). */
+  static const size_t DEFAULT_BLOCK_SIZE;
+
+ private:
+
+  /** @cond INTERNAL */
+  enum BlockState { BlockFree, BlockFilled, BlockInUse };
+
+  struct Block
+  {
+    AlignedBuffer* buffer;
+    size_t length;
+    BlockState state;
+  };
+  /** @endcond */
+
+  void _run();
+  bool _waitForData();
+  void _interrupt();
+
+  Stream& _stream;
+  Block _blocks[2];
+  uint_t _fillIndex;
+  uint_t _useIndex;
+  bool _busy;
+  bool _paused;
+  bool _stopping;
+  bool _eof;
+  bool _failed;
+  String _error;
+  Mutex _lock;
+  ConditionVar _cond;
+  RunnableDelegate<BlockReader> _runner;
+  Thread* _thread;
+  FileHandle _wakeHandle[2];
+
+  CCXX_COPY_DECLS(BlockReader);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_BlockReader_hxx
@@ -25,6 +25,7 @@
 
 #include <commonc++/Common.h++>
 #include <commonc++/ConditionVar.h++>
+#include <commonc++/FlowControl.h++>
 #include <commonc++/InterruptedException.h++>
 #include <commonc++/Mutex.h++>
 #include <commonc++/ScopedLock.h++>
@@ -38,10 +39,12 @@ namespace ccxx {
 /**
  * A bounded, threadsafe FIFO processing queue. Items are enqueued
  * by one or more producers and consumed by one or more consumers.
+ * The queue reports itself as congested once it holds at least its
+ * high-water mark of items, which by default is its capacity.
  *
  * @author Mark Lindner
  */
-template <typename T> class BoundedQueue
+template <typename T> class BoundedQueue : public FlowControl
 {
  public:
 
@@ -136,6 +139,25 @@ template <typename T> class BoundedQueue
    */
   void setCapacity(uint_t capacity);
 
+  /**
+   * Set the high-water mark for the queue.
+   *
+   * @param mark The number of items at or above which the queue is
+   * considered to be congested, or 0 to use the capacity of the queue.
+   */
+  inline void setHighWaterMark(uint_t mark)
+  { _highWaterMark = mark; }
+
+  /** Get the high-water mark for the queue. */
+  inline uint_t getHighWaterMark() const
+  { return(_highWaterMark == 0 ? _capacity : _highWaterMark); }
+
+  /**
+   * Test if the number of items in the queue has reached the high-water
+   * mark.
+   */
+  bool isCongested() const;
+
   /**
    * Interrupt the queue. Unblocks any pending operations, causing the
    * corresponding methods to throw an InterruptedException.
@@ -155,6 +177,7 @@ template <typename T> class BoundedQueue
  private:
 
   uint_t _capacity;
+  uint_t _highWaterMark;
   std::deque<T> _queue;
   mutable Mutex _mutex;
   ConditionVar _condP;
@@ -32,6 +32,7 @@
 
 template<typename T> BoundedQueue<T>::BoundedQueue(uint_t capacity)
   : _capacity(capacity),
+    _highWaterMark(0),
     _terminated(false)
 {
 }
@@ -202,6 +203,16 @@ template<typename T> uint_t BoundedQueue<T>::getSize() const
   return(_queue.size());
 }
 
+/*
+ */
+
+template<typename T> bool BoundedQueue<T>::isCongested() const
+{
+  ScopedLock lock(_mutex);
+
+  return(_queue.size() >= getHighWaterMark());
+}
+
 /*
  */
 
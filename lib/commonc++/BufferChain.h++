@@ -0,0 +1,187 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_BufferChain_hxx
+#define __ccxx_BufferChain_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/Buffer.h++>
+#include <commonc++/IOException.h++>
+#include <commonc++/MemoryBlock.h++>
+#include <commonc++/OutOfBoundsException.h++>
+#include <commonc++/Stream.h++>
+
+#include <vector>
+
+namespace ccxx {
+
+/**
+ * A sequence of byte segments that together form one logical block of
+ * data. Data appended to the chain is copied into fixed-size ByteBuffers
+ * owned by the chain, which are allocated as needed; alternatively, a
+ * view of memory owned by the caller can be appended without copying it.
+ * The whole chain can then be written to a Stream with gather writes
+ * (<code>writev()</code>), one system call for every
+ * Stream::MAX_IOBLOCK_COUNT segments, without first being copied into a
+ * contiguous buffer.
+ *
+ * Buffers are retained for reuse when the chain is cleared.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API BufferChain
+{
+ public:
+
+  /**
+   * Construct a new, empty BufferChain.
+   *
+   * @param blockSize The size of each buffer allocated by the chain. If 0,
+   * the default block size is used.
+   */
+  BufferChain(size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+  /** Destructor. */
+  ~BufferChain();
+
+  /**
+   * Append data to the chain, copying it into the chain's buffers.
+   *
+   * @param data The data to append.
+   * @param count The number of bytes to append.
+   */
+  void append(const byte_t* data, size_t count);
+
+  /**
+   * Append bytes of the given value to the chain.
+   *
+   * @param value The byte value.
+   * @param count The number of bytes to append.
+   */
+  void fill(byte_t value, size_t count);
+
+  /**
+   * Append a view of memory owned by the caller to the chain. The memory
+   * is not copied; it must remain valid, and unmodified, until the chain
+   * has been written or cleared.
+   *
+   * @param data The data to append.
+   * @param count The number of bytes to append.
+   */
+  void appendView(const byte_t* data, size_t count);
+
+  /**
+   * Overwrite data that has already been appended to the chain, for
+   * example to fill in a length field once the length is known.
+   *
+   * @param offset The offset within the chain.
+   * @param data The data to write.
+   * @param count The number of bytes to write.
+   * @throw OutOfBoundsException If the range extends past the end of the
+   * data in the chain.
+   * @throw IOException If the range overlaps a view.
+   */
+  void overwrite(size_t offset, const byte_t* data, size_t count);
+
+  /**
+   * Discard the data past the given length.
+   *
+   * @param length The new length of the data in the chain. If greater than
+   * the current length, the chain is not modified.
+   */
+  void truncate(size_t length);
+
+  /** Discard all data in the chain. */
+  inline void clear()
+  { truncate(0); }
+
+  /**
+   * Write the entire contents of the chain to a stream, using as few
+   * gather writes as possible, and then clear the chain.
+   *
+   * @param stream The stream to write to.
+   * @return The number of bytes written.
+   * @throw IOException If an I/O error occurs. The chain is left intact,
+   * though some of its contents may have been written.
+   */
+  size_t write(Stream& stream);
+
+  /**
+   * Get the segments in the chain, as memory blocks suitable for a gather
+   * write.
+   *
+   * @param vec The array to store the segments in.
+   * @param count The number of elements in the array.
+   * @param index The index of the first segment to get.
+   * @return The number of segments stored.
+   */
+  uint_t getSegments(MemoryBlock* vec, uint_t count, uint_t index = 0) const;
+
+  /** Get the number of segments in the chain. */
+  inline uint_t getSegmentCount() const
+  { return(static_cast<uint_t>(_segments.size())); }
+
+  /** Get the total length of the data in the chain, in bytes. */
+  inline size_t getLength() const
+  { return(_length); }
+
+  /** Test if the chain is empty. */
+  inline bool isEmpty() const
+  { return(_length == 0); }
+
+  /** Get the size of the buffers allocated by the chain. */
+  inline size_t getBlockSize() const
+  { return(_blockSize); }
+
+  /** The default block size. */
+  static const size_t DEFAULT_BLOCK_SIZE;
+
+ private:
+
+  /** @cond INTERNAL */
+  struct Segment
+  {
+    Segment(byte_t* data, size_t length, ByteBuffer* buffer)
+      : data(data),
+        length(length),
+        buffer(buffer)
+    { }
+
+    byte_t* data;
+    size_t length;
+    ByteBuffer* buffer; // NULL for a view
+  };
+  /** @endcond */
+
+  byte_t* _reserve(size_t& count);
+
+  std::vector<Segment> _segments;
+  std::vector<ByteBuffer*> _spare;
+  size_t _blockSize;
+  size_t _length;
+
+  CCXX_COPY_DECLS(BufferChain);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_BufferChain_hxx
@@ -0,0 +1,88 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_ChainDataWriter_hxx
+#define __ccxx_ChainDataWriter_hxx
+
+#include <commonc++/DataWriter.h++>
+#include <commonc++/BufferChain.h++>
+#include <commonc++/IOException.h++>
+#include <commonc++/Stream.h++>
+
+namespace ccxx {
+
+/**
+ * A DataWriter which writes data to a BufferChain. Encoded data is
+ * accumulated in the chain's buffers, rather than in a single contiguous
+ * buffer, and can be written to a Stream in gather writes when the
+ * writer is flushed. Seeking backward (for example, to fill in a length
+ * field) overwrites data already in the chain.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API ChainDataWriter : public DataWriter
+{
+ public:
+
+  /**
+   * Construct a new ChainDataWriter for the given BufferChain. Data is
+   * appended after any data already in the chain.
+   *
+   * @param chain The chain to write data to.
+   * @param stream An optional Stream to which the chain will be written
+   * when the writer is flushed. Once flushed, data can no longer be
+   * overwritten by seeking backward.
+   */
+  ChainDataWriter(BufferChain& chain, Stream* stream = NULL);
+
+  /** Destructor. */
+  ~ChainDataWriter();
+
+  void skip(size_t count);
+
+  void skip(size_t count, byte_t fillByte);
+
+  void flush();
+
+  void reset();
+
+  void setOffset(int64_t offset);
+
+ protected:
+
+  size_t write(const byte_t* buf, size_t count);
+
+ private:
+
+  size_t _overwrite(const byte_t* buf, size_t count, byte_t fillByte);
+
+  BufferChain& _chain;
+  Stream* _stream;
+  size_t _start;
+  int64_t _base;
+
+  CCXX_COPY_DECLS(ChainDataWriter);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_ChainDataWriter_hxx
@@ -178,7 +178,7 @@ template <typename T>
   {
     size_t n = static_cast<size_t>(bufEnd - dataStart);
     len1 = std::min(n, countBytes);
-    countBytes -= n;
+    countBytes -= len1;
     if(countBytes > 0)
     {
       buf2 = bufStart;
@@ -321,7 +321,7 @@ template <typename T>
   {
     size_t n = static_cast<size_t>(bufEnd - dataStart);
     len1 = std::min(n, countBytes);
-    countBytes -= n;
+    countBytes -= len1;
     if(countBytes > 0)
     {
       buf2 = bufStart;
@@ -0,0 +1,182 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_ConnectionPool_hxx
+#define __ccxx_ConnectionPool_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/EventHandler.h++>
+#include <commonc++/Mutex.h++>
+#include <commonc++/SocketAddress.h++>
+#include <commonc++/SocketSelector.h++>
+
+namespace ccxx {
+
+/**
+ * A SocketSelector that manages pools of outbound connections to remote
+ * endpoints. Connections are established with non-blocking connects that
+ * are driven by the selector thread, and connections that are released
+ * back to the pool are kept open, so that later requests to the same
+ * endpoint can reuse them rather than paying for a new handshake and
+ * ephemeral port.
+ *
+ * Pooled (idle) connections are evicted if they are closed by the peer,
+ * if they have been idle for longer than the maximum idle time, or if
+ * unexpected data arrives on them. The pool is initialized with
+ * <b>init()</b> and must then be started like any other selector.
+ *
+ * Subclasses implement <b>createConnection()</b> to construct connection
+ * objects, and <b>connectionDataReceived()</b> to handle incoming data on
+ * connections that are in use. Data that arrives on an idle connection is
+ * never passed to the subclass.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API ConnectionPool : public SocketSelector
+{
+ public:
+
+  /**
+   * Construct a new ConnectionPool.
+   *
+   * @param maxConnections The maximum number of connections, pooled or in
+   * use, across all endpoints.
+   * @param maxIdlePerEndpoint The maximum number of idle connections to
+   * keep for each endpoint.
+   * @param connectTimeout The connect timeout, in milliseconds, or 0 for
+   * no timeout.
+   * @param maxIdleTime The maximum time, in milliseconds, that a
+   * connection may remain idle in the pool before it is closed.
+   */
+  ConnectionPool(uint_t maxConnections = 64, uint_t maxIdlePerEndpoint = 4,
+                 timespan_ms_t connectTimeout = 5000,
+                 timespan_ms_t maxIdleTime = 60000);
+
+  /** Destructor. */
+  virtual ~ConnectionPool();
+
+  bool init();
+
+  /**
+   * Acquire a connection to an endpoint. If a healthy idle connection to
+   * the endpoint is available, it is passed to the handler before this
+   * method returns; the connection is not deleted while the handler is
+   * running, even if it is closed by the peer. Otherwise a new connection is begun, and the handler
+   * is invoked from the selector thread once it has been established,
+   * or with <b>NULL</b> if the connect failed or timed out.
+   *
+   * @param endpoint The address of the endpoint.
+   * @param handler The handler to receive the connection.
+   * @return <b>true</b> if the handler has been or will be invoked,
+   * <b>false</b> if a new connection could not be started.
+   */
+  bool acquire(const SocketAddress& endpoint,
+               EventHandler<Connection*>* handler);
+
+  /**
+   * Release a connection back to the pool. The connection is kept open
+   * for reuse if it is healthy and the pool for its endpoint is not full;
+   * otherwise it is closed. The connection must not be used by the
+   * caller after it is released.
+   *
+   * @param connection The connection.
+   */
+  void release(Connection* connection);
+
+  /** Get the number of idle connections in the pool, for all endpoints. */
+  uint_t getIdleCount() const;
+
+  /**
+   * Get the number of idle connections in the pool for an endpoint.
+   *
+   * @param endpoint The address of the endpoint.
+   */
+  uint_t getIdleCount(const SocketAddress& endpoint) const;
+
+ protected:
+
+  /**
+   * This method is called to construct a new Connection object for a
+   * connection to an endpoint.
+   *
+   * @param endpoint The address of the endpoint.
+   * @return The new connection object.
+   */
+  virtual Connection* createConnection(const SocketAddress& endpoint) = 0;
+
+  /**
+   * This method is called when data has been received on a connection
+   * that is in use.
+   *
+   * @param connection The connection.
+   */
+  virtual void connectionDataReceived(Connection* connection) = 0;
+
+  /**
+   * This method is called when a connection that is in use (that is, has
+   * been acquired and not yet released) is closed by the peer or times
+   * out. The connection object is deleted after this method returns. The
+   * method is called from the selector thread, or from <b>acquire()</b>
+   * if the connection was closed while it was being passed to the
+   * handler. The default implementation does nothing.
+   *
+   * @param connection The connection.
+   */
+  virtual void connectionLost(Connection* connection);
+
+  /** Returns <b>NULL</b>; the pool does not accept inbound connections. */
+  Connection* connectionReady(const SocketAddress& address);
+
+  /**
+   * Evicts the connection if it is idle, and otherwise calls
+   * <b>connectionDataReceived()</b>. Subclasses should not override this
+   * method.
+   */
+  void dataReceived(Connection* connection);
+
+  void connectionEstablished(Connection* connection);
+  void connectionFailed(Connection* connection);
+  void connectionClosed(Connection* connection);
+  void connectionTimedOut(Connection* connection);
+
+ private:
+
+  void _evict(Connection* connection);
+  bool _isHealthy(Connection* connection) const;
+  void _sweep(bool ok);
+  void _closed(Connection* connection);
+
+  class PoolState; // fwd decl
+
+  PoolState* _state;
+  mutable Mutex _lock;
+  uint_t _maxIdle;
+  timespan_ms_t _connectTimeout;
+  timespan_ms_t _maxIdleTime;
+  EventHandlerDelegate<ConnectionPool, bool> _sweeper;
+
+  CCXX_COPY_DECLS(ConnectionPool);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_ConnectionPool_hxx
@@ -24,14 +24,29 @@
 #define __ccxx_ConsoleLogger_hxx
 
 #include <commonc++/Common.h++>
+#include <commonc++/AtomicCounter.h++>
+#include <commonc++/ConditionVar.h++>
 #include <commonc++/Console.h++>
 #include <commonc++/Logger.h++>
+#include <commonc++/Mutex.h++>
+#include <commonc++/Runnable.h++>
+#include <commonc++/Thread.h++>
 
 namespace ccxx {
 
 /**
  * A logger that writes to the console (the standard error stream).
  *
+ * Whether the standard error stream is a terminal is determined once, when
+ * the logger is constructed. If it is not (as is typically the case for a
+ * service whose output is collected by a process supervisor or a container
+ * runtime), the text style and color directives in the log format are
+ * disabled, and messages are collected in a buffer and written out in
+ * batches rather than one at a time. The buffer is written out when it
+ * fills up, when the oldest message in it has been buffered for longer
+ * than the flush interval (which is enforced by a background thread), and
+ * immediately after any message of level LogWarning or higher.
+ *
  * @author Mark Lindner
  */
 class COMMONCPP_API ConsoleLogger : public Logger
@@ -45,22 +60,87 @@ class COMMONCPP_API ConsoleLogger : public Logger
    */
   ConsoleLogger(const String& format = "[%d %t] %@%m%.");
 
-  /** Destructor. */
+  /** Destructor. Writes out any buffered messages. */
   ~ConsoleLogger();
 
+  /** Test if the console output is a terminal. */
+  inline bool isTerminal() const
+  { return(_terminal); }
+
+  /**
+   * Set the size of the message buffer. Messages are only buffered if the
+   * console output is not a terminal.
+   *
+   * @param bufferSize The buffer size, in bytes. A size of 0 disables
+   * buffering, so that each message is written immediately.
+   */
+  void setBufferSize(size_t bufferSize);
+
+  /**
+   * Set the flush interval.
+   *
+   * @param flushInterval The maximum amount of time, in milliseconds,
+   * that a message may be buffered before it is written out. An interval
+   * of 0 causes each message to be written immediately.
+   */
+  void setFlushInterval(timespan_ms_t flushInterval);
+
+  void vlog(LogLevel level, const char* file, int line, const char* message,
+            va_list args);
+
+  /** Write out any buffered messages. */
+  void flush();
+
+  /**
+   * Write out any buffered messages from a fatal signal handler. Nothing
+   * is written if another call, on any thread, is using the buffer.
+   */
+  void flushOnCrash();
+
+  /** The default buffer size, in bytes. */
+  static const size_t DEFAULT_BUFFER_SIZE;
+
+  /** The default flush interval, in milliseconds. */
+  static const timespan_ms_t DEFAULT_FLUSH_INTERVAL;
+
  protected:
 
   /** Write a preformatted log message to the console. */
   virtual bool write(CharBuffer& buffer);
 
+  /**
+   * Write a preformatted log message to the console from a fatal signal
+   * handler, after any buffered messages.
+   */
+  bool writeOnCrash(CharBuffer& buffer);
+
  private:
 
+  class BufferGuard; // fwd decl
+
+  void _flush();
+  void _write(const char* buf, size_t buflen);
+  void _runFlusher();
+
+  bool _terminal;
+  CharBuffer* _pending;
+  timespan_ms_t _flushInterval;
+  time_ms_t _pendingSince;
+  Mutex _bufferLock;
+  AtomicCounter _bufferBusy;
+  ConditionVar _flushCond;
+  RunnableDelegate<ConsoleLogger> _flushRunner;
+  Thread* _flusher;
+  bool _stopping;
+
 #ifdef CCXX_OS_WINDOWS
   void writeANSIString(const char* buf, size_t buflen);
   void processANSI(char cmd, uint_t argc, uint_t* argv);
 
   Console _console;
 #endif
+
+  CCXX_COPY_DECLS(ConsoleLogger);
 };
 
 } // namespace ccxx
@@ -0,0 +1,318 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_Coroutine_hxx
+#define __ccxx_Coroutine_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/EventHandler.h++>
+#include <commonc++/IOException.h++>
+#include <commonc++/InterruptedException.h++>
+#include <commonc++/Log.h++>
+#include <commonc++/SocketSelector.h++>
+
+// The awaitables below require a C++20 compiler; the library itself does
+// not, so this header is empty otherwise. They are built entirely on the
+// handler interfaces of Connection and SocketSelector, which may be used
+// directly from C++11 code.
+
+#if (__cplusplus >= 202002L) && defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+
+namespace ccxx {
+
+/**
+ * The return type for a detached coroutine that runs on a SocketSelector
+ * thread. The coroutine begins executing immediately when called, runs
+ * until its first suspension, and thereafter is resumed by the selector
+ * as the I/O or timer it awaits completes. Its frame is destroyed when it
+ * finishes. If an exception escapes the coroutine, the connection that it
+ * last awaited is closed, and the exception is logged with Log, unless
+ * it is an EOFException.
+ *
+ * A typical coroutine is started from
+ * <b>SocketSelector::connectionReady()</b> or
+ * <b>SocketSelector::dataReceived()</b>, and may use the connection
+ * until an awaitable throws an EOFException, which indicates that the
+ * connection has been closed.
+ *
+ * @author Mark Lindner
+ */
+class AsyncTask
+{
+ public:
+
+  /** The coroutine promise type. */
+  struct promise_type
+  {
+    promise_type()
+      : connection(NULL)
+    { }
+
+    AsyncTask get_return_object()
+    { return(AsyncTask()); }
+
+    std::suspend_never initial_suspend() noexcept
+    { return(std::suspend_never()); }
+
+    std::suspend_never final_suspend() noexcept
+    { return(std::suspend_never()); }
+
+    void return_void()
+    { }
+
+    void unhandled_exception()
+    {
+      // the coroutine is detached, so there is nobody to rethrow to
+
+      try
+      {
+        throw;
+      }
+      catch(const EOFException &)
+      {
+        // the connection was closed; this is how a coroutine normally ends
+      }
+      catch(const std::exception& ex)
+      {
+        Log_error("Unhandled exception in coroutine: %s", ex.what());
+      }
+      catch(...)
+      {
+        Log_error("Unhandled exception in coroutine");
+      }
+
+      if(connection)
+        connection->close();
+    }
+
+    /** The connection that the coroutine last awaited, if any. */
+    Connection* connection;
+  };
+};
+
+/**
+ * A base class for awaitables that are resumed by a SocketSelector. The
+ * awaitable itself is the handler that the selector invokes, so a
+ * suspended coroutine costs nothing beyond its frame.
+ *
+ * @author Mark Lindner
+ */
+class AsyncAwaitable : public EventHandler<bool>
+{
+ protected:
+
+  AsyncAwaitable()
+    : _ok(true)
+  { }
+
+  template<typename P>
+    static void track(std::coroutine_handle<P> handle, Connection& connection)
+  {
+    if constexpr (std::is_same<P, AsyncTask::promise_type>::value)
+      handle.promise().connection = &connection;
+  }
+
+  void invoke(bool ok)
+  {
+    _ok = ok;
+    _handle.resume();
+  }
+
+  std::coroutine_handle<> _handle;
+  bool _ok;
+};
+
+/**
+ * An awaitable that reads a fixed number of bytes from a Connection.
+ * Produced by <b>asyncRead()</b>.
+ *
+ * @author Mark Lindner
+ */
+class AsyncRead : public AsyncAwaitable
+{
+ public:
+
+  AsyncRead(Connection& connection, byte_t* buf, size_t count)
+    : _connection(connection), _buf(buf), _count(count)
+  { }
+
+  bool await_ready()
+  { return(_connection.getBytesAvailableToRead() >= _count); }
+
+  template<typename P>
+    bool await_suspend(std::coroutine_handle<P> handle)
+  {
+    _handle = handle;
+    track(handle, _connection);
+
+    if(! _connection.awaitRead(_count, this))
+      throw IOException("Read request cannot be satisfied");
+
+    return(true);
+  }
+
+  size_t await_resume()
+  {
+    if(! _ok)
+      throw EOFException();
+
+    return(_connection.readData(_buf, _count));
+  }
+
+ private:
+
+  Connection& _connection;
+  byte_t* _buf;
+  size_t _count;
+};
+
+/**
+ * An awaitable that enqueues a block of data for writing on a
+ * Connection, waiting for room in the write buffer if necessary.
+ * Produced by <b>asyncWrite()</b>.
+ *
+ * @author Mark Lindner
+ */
+class AsyncWrite : public AsyncAwaitable
+{
+ public:
+
+  AsyncWrite(Connection& connection, const byte_t* buf, size_t count)
+    : _connection(connection), _buf(buf), _count(count)
+  { }
+
+  bool await_ready()
+  { return(_connection.writeData(_buf, _count)); }
+
+  template<typename P>
+    bool await_suspend(std::coroutine_handle<P> handle)
+  {
+    _handle = handle;
+    track(handle, _connection);
+
+    if(! _connection.awaitWrite(_count, this))
+      throw IOException("Write request cannot be satisfied");
+
+    return(true);
+  }
+
+  void await_resume()
+  {
+    if(! _ok)
+      throw EOFException();
+
+    // if the coroutine was never suspended, the data is already enqueued
+    if(_handle && ! _connection.writeData(_buf, _count))
+      throw IOException("Write buffer full");
+  }
+
+ private:
+
+  Connection& _connection;
+  const byte_t* _buf;
+  size_t _count;
+};
+
+/**
+ * An awaitable that suspends the coroutine for a period of time.
+ * Produced by <b>asyncSleep()</b>.
+ *
+ * @author Mark Lindner
+ */
+class AsyncSleep : public AsyncAwaitable
+{
+ public:
+
+  AsyncSleep(SocketSelector& selector, timespan_ms_t delay)
+    : _selector(selector), _delay(delay)
+  { }
+
+  bool await_ready()
+  { return(_delay <= 0); }
+
+  void await_suspend(std::coroutine_handle<> handle)
+  {
+    _handle = handle;
+    _selector.schedule(_delay, this);
+  }
+
+  void await_resume()
+  {
+    if(! _ok)
+      throw InterruptedException();
+  }
+
+ private:
+
+  SocketSelector& _selector;
+  timespan_ms_t _delay;
+};
+
+/**
+ * Read exactly <i>count</i> bytes from a connection, suspending the
+ * calling coroutine until they are available. The co_await expression
+ * yields the number of bytes read.
+ *
+ * @param connection The connection.
+ * @param buf The buffer to read into.
+ * @param count The number of bytes to read; may not exceed the read
+ * high-water mark of the connection.
+ * @throw EOFException If the connection is closed while waiting.
+ * @throw IOException If the request cannot be satisfied.
+ */
+inline AsyncRead asyncRead(Connection& connection, byte_t* buf, size_t count)
+{ return(AsyncRead(connection, buf, count)); }
+
+/**
+ * Enqueue <i>count</i> bytes for writing on a connection, suspending the
+ * calling coroutine until there is room in the write buffer.
+ *
+ * @param connection The connection.
+ * @param buf The data to write.
+ * @param count The number of bytes to write; may not exceed the size
+ * of the write buffer.
+ * @throw EOFException If the connection is closed while waiting.
+ * @throw IOException If the request cannot be satisfied.
+ */
+inline AsyncWrite asyncWrite(Connection& connection, const byte_t* buf,
+                             size_t count)
+{ return(AsyncWrite(connection, buf, count)); }
+
+/**
+ * Suspend the calling coroutine for a period of time.
+ *
+ * @param selector The selector on whose thread the coroutine runs.
+ * @param delay The delay, in milliseconds.
+ * @throw InterruptedException If the selector shuts down while waiting.
+ */
+inline AsyncSleep asyncSleep(SocketSelector& selector, timespan_ms_t delay)
+{ return(AsyncSleep(selector, delay)); }
+
+} // namespace ccxx
+
+#endif // __cplusplus >= 202002L
+
+#endif // __ccxx_Coroutine_hxx
@@ -177,6 +177,31 @@ class COMMONCPP_API DateTimeFormat
    */
   size_t format(const DateTime& value, char* buf, size_t bufsz) const;
 
+  /**
+   * Format a DateTime, and report where the millisecond fields occur in
+   * the result. Each millisecond field is exactly three characters wide,
+   * so a caller that formats many values within the same second, such as
+   * LogFormat, can cache the result and patch in just the milliseconds
+   * for each value.
+   *
+   * @param value The DateTime to format.
+   * @param buf A raw character buffer to write the formatted value to.
+   * @param bufsz The size of the character buffer.
+   * @param offsets An array that receives the buffer offset of each
+   * millisecond field that was written in full.
+   * @param pads An array that receives the padding character ('0' or ' ')
+   * of each such field.
+   * @param maxFields The size of the <i>offsets</i> and <i>pads</i>
+   * arrays.
+   * @param numFields Returns the number of millisecond fields in the
+   * format, which may exceed <i>maxFields</i>. Offsets are not reported
+   * for fields that were truncated because the buffer was too small.
+   * @return The number of characters written to the buffer.
+   */
+  size_t format(const DateTime& value, char* buf, size_t bufsz,
+                size_t* offsets, char* pads, uint_t maxFields,
+                uint_t& numFields) const;
+
   /**
    * Parse a Date from a string.
    *
@@ -271,7 +296,9 @@ class COMMONCPP_API DateTimeFormat
   void _parseFormat(const String& format, TokenList* tokens);
   String _format(const TokenList* tokens, const DateTime& value) const;
   size_t _format(const TokenList* tokens, const DateTime& value,
-                 CStringBuilder& builder) const;
+                 CStringBuilder& builder, size_t* offsets = NULL,
+                 char* pads = NULL, uint_t maxFields = 0,
+                 uint_t* numFields = NULL) const;
   void _parse(const TokenList* tokens, DateTime& value, const char* buf) const;
 
   int _parseInt(const char*& p, uint_t& pos, int min, int max) const;
@@ -23,6 +23,7 @@
 #ifndef __ccxx_DirectoryWatcher_hxx
 #define __ccxx_DirectoryWatcher_hxx
 
+#include <commonc++/Selectable.h++>
 #include <commonc++/String.h++>
 #include <commonc++/SystemException.h++>
 #include <commonc++/Thread.h++>
@@ -34,13 +35,15 @@ namespace ccxx {
  * within the watched directory is created, deleted, modified, or
  * renamed, the corresponding handler method is called. This is an
  * abstract class which must be subclassed to implement the handler
- * methods. A watcher must run in its own thread.
+ * methods. A watcher may run in its own thread, or, on Linux, it may
+ * instead be registered as an event source with a SocketSelector, in
+ * which case its handler methods are called from the selector's thread.
  * <p>
  * <b>NOTE</b>: This class is currently not implemented on Mac OS X.
  *
  * @author Mark Lindner
  */
-class COMMONCPP_API DirectoryWatcher : public Thread
+class COMMONCPP_API DirectoryWatcher : public Thread, public Selectable
 {
  public:
 
@@ -54,6 +57,19 @@ class COMMONCPP_API DirectoryWatcher : public Thread
    */
   void init();
 
+  /**
+   * Get the inotify handle for the watcher. On platforms other than
+   * Linux, returns <b>CCXX_INVALID_FILE_HANDLE</b>, since the watcher
+   * can only be run in its own thread.
+   */
+  FileHandle getEventHandle() const;
+
+  /**
+   * Read and dispatch any pending change notifications. This method
+   * does not block.
+   */
+  void processEvents();
+
  protected:
 
   /**
@@ -102,6 +118,7 @@ class COMMONCPP_API DirectoryWatcher : public Thread
  private:
 
   String _directory;
+  String _oldPath;
   bool _initialized;
 
 #if defined(CCXX_OS_WINDOWS)
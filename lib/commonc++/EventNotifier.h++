@@ -0,0 +1,93 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_EventNotifier_hxx
+#define __ccxx_EventNotifier_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/Selectable.h++>
+#include <commonc++/SystemException.h++>
+
+namespace ccxx {
+
+/**
+ * A cross-thread event notifier. Any thread may call <b>notify()</b>;
+ * the notifications are delivered to <b>notified()</b> from the thread
+ * that services the notifier, typically a SocketSelector with which the
+ * notifier has been registered as an event source. Notifications that
+ * arrive before the notifier is serviced are coalesced into a single
+ * call. On Linux the notifier is backed by an <i>eventfd</i>; on other
+ * POSIX systems it falls back to a pipe.
+ * <p>
+ * <b>NOTE</b>: This class is currently not implemented on Windows.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API EventNotifier : public Selectable
+{
+ public:
+
+  /** Destructor. */
+  virtual ~EventNotifier();
+
+  /**
+   * Initialize the notifier.
+   *
+   * @throw SystemException If an error occurs.
+   */
+  void init();
+
+  /**
+   * Post a notification. This method may be called from any thread, and
+   * never blocks.
+   */
+  void notify();
+
+  FileHandle getEventHandle() const;
+
+  void processEvents();
+
+ protected:
+
+  /** Construct a new EventNotifier. */
+  EventNotifier();
+
+  /**
+   * Called when notifications have been received.
+   *
+   * @param count The number of notifications that were coalesced into
+   * this call. With the pipe-based implementation, this count may be
+   * lower than the number of calls to <b>notify()</b>.
+   */
+  virtual void notified(uint64_t count) = 0;
+
+ private:
+
+  bool _initialized;
+  FileHandle _handle[2];
+
+  CCXX_COPY_DECLS(EventNotifier);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_EventNotifier_hxx
@@ -60,7 +60,13 @@ enum FileOpenMode {
   /** Open and truncate the file if it exists, otherwise fail. */
   FileTruncate,
   /** Open and truncate the file if it exists, otherwise create the file. */
-  FileTruncateElseCreate
+  FileTruncateElseCreate,
+  /**
+   * Open the file for appending if it exists, otherwise create the file.
+   * Every write is made at the end of the file, regardless of the current
+   * file position.
+   */
+  FileAppendElseCreate
 };
 
 /**
@@ -101,6 +107,60 @@ struct COMMONCPP_API FileAttributes
   { return(type == TypeFile); }
 };
 
+/** Methods by which a file can be copied. See File::copy(). */
+enum FileCopyMethod {
+  /** The file was not copied. */
+  FileCopyNone,
+  /**
+   * The copy shares the data blocks of the original file (a reflink or
+   * clone); no data was copied.
+   */
+  FileCopyReflink,
+  /** The data was copied within the kernel, by copy_file_range(). */
+  FileCopyRange,
+  /** The data was copied within the kernel, by sendfile(). */
+  FileCopySendfile,
+  /** The data was read into and written from a user-space buffer. */
+  FileCopyBuffered,
+  /** The file was copied by the operating system's own copy function. */
+  FileCopyNative
+};
+
+/** Modes for File::allocate(). */
+enum FileAllocateMode {
+  /**
+   * Allocate storage for the range, extending the file if the range ends
+   * past the end of the file.
+   */
+  FileAllocateDefault,
+  /**
+   * Allocate storage for the range, but do not change the file size, even
+   * if the range ends past the end of the file.
+   */
+  FileAllocateKeepSize,
+  /**
+   * Deallocate the storage for the range, leaving a hole which reads as
+   * zeroes; the file size is not changed.
+   */
+  FileAllocatePunchHole
+};
+
+/** Access pattern hints for File::advise(). */
+enum FileAccessAdvice {
+  /** No special treatment. */
+  FileAdviseNormal,
+  /** The data will be accessed in order; read ahead aggressively. */
+  FileAdviseSequential,
+  /** The data will be accessed in random order; do not read ahead. */
+  FileAdviseRandom,
+  /** The data will be needed soon; start reading it in now. */
+  FileAdviseWillNeed,
+  /** The data will not be needed soon; it may be dropped from the cache. */
+  FileAdviseDontNeed,
+  /** The data will be accessed only once. */
+  FileAdviseNoReuse
+};
+
 /** %File lock types. */
 enum LockType {
   /** %Lock for reading. */
@@ -235,6 +295,68 @@ class COMMONCPP_API File : public Stream
    */
   void truncate(uint64_t size = 0);
 
+  /**
+   * Allocate or deallocate storage for a range of the file. Allocating
+   * storage up front avoids fragmentation when a file is written
+   * incrementally, and guarantees that writes to the range will not fail
+   * for lack of disk space.
+   *
+   * @param offset The start offset of the range.
+   * @param length The length of the range.
+   * @param mode The allocation mode.
+   * @throw UnsupportedOperationException If the mode is not supported on
+   * this platform.
+   * @throw IOException If the operation fails, including because the
+   * mode is not supported by the file system.
+   */
+  void allocate(uint64_t offset, uint64_t length,
+                FileAllocateMode mode = FileAllocateDefault);
+
+  /**
+   * Advise the system of the expected access pattern for a range of the
+   * file, so that the page cache can be managed accordingly. This is a
+   * hint only, and has no effect on platforms that do not support it.
+   *
+   * @param offset The start offset of the range.
+   * @param length The length of the range. A value of 0 indicates the
+   * remainder of the file.
+   * @param advice The access advice.
+   * @throw IOException If an error occurs.
+   */
+  void advise(uint64_t offset, uint64_t length, FileAccessAdvice advice);
+
+  /**
+   * Initiate writeback of the dirty pages in a range of the file to disk.
+   * Unlike a full sync, this does not flush the file's metadata, and
+   * allows data that has been written to be written back incrementally.
+   * Where writeback of a range cannot be requested, the whole file's data
+   * is synchronized instead.
+   *
+   * @param offset The start offset of the range.
+   * @param length The length of the range. A value of 0 indicates the
+   * remainder of the file.
+   * @param wait A flag indicating whether the method should wait for the
+   * writeback to complete.
+   * @throw IOException If an error occurs.
+   */
+  void syncRange(uint64_t offset, uint64_t length, bool wait = false);
+
+  /**
+   * Specify whether the file should be opened for direct I/O, bypassing
+   * the system's page cache. Must be called before the file is opened.
+   * With direct I/O, the buffers, offsets and lengths of reads and writes
+   * must generally be multiples of the alignment returned by
+   * getDirectIOAlignment(); see AlignedBuffer.
+   *
+   * @param directIO The new value for the flag.
+   */
+  inline void setDirectIO(bool directIO)
+  { _directIO = directIO; }
+
+  /** Determine if the file is opened for direct I/O. */
+  inline bool isDirectIO() const
+  { return(_directIO); }
+
   /** Get the pathname for the file. */
   inline String getPath() const
   { return(_name); }
@@ -425,6 +547,25 @@ class COMMONCPP_API File : public Stream
    */
   static bool copy(const String& oldFile, const String& newFile);
 
+  /**
+   * Copy a file to another file, and report how the copy was made. On
+   * Linux, the target is first cloned from the source (sharing its data
+   * blocks) if the filesystem supports it; otherwise the data is copied
+   * within the kernel, by copy_file_range() or, failing that, sendfile();
+   * and only as a last resort through a user-space buffer. The target
+   * file is preallocated to the size of the source file before data is
+   * copied.
+   *
+   * @param oldFile The source file.
+   * @param newFile The target file, which must not already exist.
+   * @param method The method that completed the copy; if the copy was
+   * begun with one method and finished with another, the latter is
+   * reported.
+   * @return <b>true</b> on success, <b>false</b> otherwise.
+   */
+  static bool copy(const String& oldFile, const String& newFile,
+                   FileCopyMethod& method);
+
   /**
    * Move a file or directory to another location within the same
    * volume or filesystem.
@@ -499,6 +640,16 @@ class COMMONCPP_API File : public Stream
    */
   static size_t getDiskBlockSize(const String& path);
 
+  /**
+   * Get the alignment required for the buffers, offsets and lengths of
+   * direct I/O operations on files in the filesystem containing the given
+   * path.
+   *
+   * @param path The path.
+   * @return The alignment, in bytes.
+   */
+  static size_t getDirectIOAlignment(const String& path);
+
   /**
    * Round a file size to the next higher multiple of the given block
    * size. This method may be used to determine the actual amount of space
@@ -553,6 +704,8 @@ class COMMONCPP_API File : public Stream
 
  private:
 
+  bool _directIO;
+
   CCXX_COPY_DECLS(File);
 };
 
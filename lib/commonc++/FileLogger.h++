@@ -24,16 +24,35 @@
 #define __ccxx_FileLogger_hxx
 
 #include <commonc++/Common.h++>
+#include <commonc++/AtomicCounter.h++>
+#include <commonc++/ConditionVar.h++>
 #include <commonc++/File.h++>
 #include <commonc++/IOException.h++>
 #include <commonc++/Logger.h++>
+#include <commonc++/Mutex.h++>
+#include <commonc++/Runnable.h++>
 #include <commonc++/String.h++>
+#include <commonc++/Thread.h++>
 
 namespace ccxx {
 
 /**
  * A logger that writes to a file, and can optionally perform log
  * rotation.
+ * <p>
+ * The file is opened in append mode, and the logger keeps track of its
+ * size, so that no system calls are needed to decide when to rotate it.
+ * Messages are collected in a buffer, which is written to the file when
+ * it fills up, or when the oldest message in it has been buffered for
+ * longer than the flush interval. The interval is enforced by a
+ * background thread, which is started when the first message is
+ * buffered, so messages reach the file within the interval even if no
+ * further messages are logged.
+ * <p>
+ * When the file is rotated, it is renamed out of the way and a new file
+ * is opened; the remaining renames of the backlog files are deferred
+ * until completeDeferredWork() is called, which the Log class does once
+ * it has released the logging lock.
  *
  * @author Mark Lindner
  */
@@ -82,13 +101,52 @@ class COMMONCPP_API FileLogger : public Logger
    */
   void setRotateCount(uint_t rotateCount);
 
+  /**
+   * Set the size of the message buffer.
+   *
+   * @param bufferSize The buffer size, in bytes. A size of 0 disables
+   * buffering, so that each message is written to the file immediately.
+   */
+  void setBufferSize(size_t bufferSize);
+
+  /**
+   * Set the flush interval.
+   *
+   * @param flushInterval The maximum amount of time, in milliseconds,
+   * that a message may be buffered before it is written to the file. An
+   * interval of 0 causes each message to be written immediately.
+   */
+  void setFlushInterval(timespan_ms_t flushInterval);
+
+  /** Write any buffered messages to the file. */
+  void flush();
+
+  /**
+   * Write any buffered messages to the file from a fatal signal handler.
+   * Nothing is written if another call, on any thread, is using the
+   * buffer.
+   */
+  void flushOnCrash();
+
+  bool hasDeferredWork() const;
+
+  /** Complete a deferred log rotation, if one is pending. */
+  void completeDeferredWork();
+
   /** The maximum file rotate count. */
   static const uint_t MAX_ROTATE_COUNT;
 
+  /** The default message buffer size, in bytes. */
+  static const size_t DEFAULT_BUFFER_SIZE;
+
+  /** The default flush interval, in milliseconds. */
+  static const timespan_ms_t DEFAULT_FLUSH_INTERVAL;
+
  protected:
 
   /**
-   * Open the log file.
+   * Open the log file, and initialize the current log size from the size
+   * of the file.
    *
    * @throw IOException If an I/O error occurs.
    */
@@ -97,17 +155,41 @@ class COMMONCPP_API FileLogger : public Logger
   /** Write a preformatted log message to the file. */
   virtual bool write(CharBuffer& buffer);
 
+  /**
+   * Write a preformatted log message to the file from a fatal signal
+   * handler, after any buffered messages. The file is not rotated.
+   */
+  bool writeOnCrash(CharBuffer& buffer);
+
   /** @cond INTERNAL */
+  class BufferGuard; // fwd decl
+
+  bool _flush();
+  void _runFlusher();
   bool _rotate();
+  bool _shiftBacklog();
+  String _getPath(int index) const;
 
   int64_t _maxFileSize;
   size_t _maxLogSize;
-  size_t _curLogSize;
+  int64_t _curLogSize;
   uint_t _rotateCount;
 
   File* _file;
   String _dir;
   String _name;
+
+  CharBuffer* _pending;
+  timespan_ms_t _flushInterval;
+  time_ms_t _pendingSince;
+  Mutex _bufferLock;
+  AtomicCounter _bufferBusy;
+  ConditionVar _flushCond;
+  RunnableDelegate<FileLogger> _flushRunner;
+  Thread* _flusher;
+  bool _stopping;
+  Mutex _rotateLock;
+  AtomicCounter _rotatePending;
   /** @endcond */
 };
 
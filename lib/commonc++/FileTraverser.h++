@@ -36,6 +36,9 @@ namespace ccxx {
  * function to process each file and directory encountered during
  * the traversal.
  *
+ * Large trees can also be traversed by a pool of threads; see
+ * traverseParallel().
+ *
  * @author Mark Lindner
  */
 class COMMONCPP_API FileTraverser
@@ -72,6 +75,33 @@ class COMMONCPP_API FileTraverser
    */
   bool traverse();
 
+  /**
+   * Traverse the file tree using a pool of threads. Each thread scans
+   * one directory at a time, and subdirectories that it discovers are
+   * queued for it to scan next; idle threads take work from the queues
+   * of busy ones. On POSIX systems, directories are opened relative to
+   * their already-open parent directories, and files are only
+   * <b>stat</b>()'ed if the directory entry does not indicate their
+   * type. Symbolic links to directories are processed as directories,
+   * but are not descended into.
+   *
+   * The <b>processFile</b>() and <b>handleError</b>() methods may be
+   * called concurrently from several threads, and so must be threadsafe.
+   * Files and directories are processed in no particular order, except
+   * that a directory is always processed before any of its contents; the
+   * depth-first setting does not apply. If either method returns
+   * <b>false</b>, the traversal is stopped as soon as all threads have
+   * finished processing their current directories. On systems where
+   * parallel traversal is not supported, this method is equivalent to
+   * traverse().
+   *
+   * @param numThreads The number of threads to use, or 0 to use one
+   * thread per online processor.
+   * @return <b>true</b> if the traversal completed successfully,
+   * <b>false</b> otherwise.
+   */
+  bool traverseParallel(uint_t numThreads = 0);
+
  protected:
 
   /**
@@ -99,6 +129,9 @@ class COMMONCPP_API FileTraverser
 
  private:
 
+  class Parallel; // fwd decl
+  friend class Parallel;
+
   bool _traverse(FileName& filename, uint_t depth);
 
   String _baseDir;
@@ -0,0 +1,56 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_FlowControl_hxx
+#define __ccxx_FlowControl_hxx
+
+#include <commonc++/Common.h++>
+
+namespace ccxx {
+
+/**
+ * An interface for a consumer of work that can signal when it is
+ * overloaded, so that producers can stop generating more work for it.
+ * For example, a SocketSelector stops reading from a connection while
+ * the connection's downstream queue is congested.
+ *
+ * @author Mark Lindner
+ */
+class FlowControl
+{
+ public:
+
+  /** Destructor. */
+  virtual ~FlowControl() { }
+
+  /**
+   * Test if the consumer is congested.
+   *
+   * @return <b>true</b> if producers should hold off, <b>false</b>
+   * otherwise.
+   */
+  virtual bool isCongested() const = 0;
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_FlowControl_hxx
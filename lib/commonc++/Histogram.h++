@@ -0,0 +1,130 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_Histogram_hxx
+#define __ccxx_Histogram_hxx
+
+#include <commonc++/Common.h++>
+
+namespace ccxx {
+
+/**
+ * A histogram of non-negative integer samples, such as latencies or
+ * sizes. Samples are counted in buckets whose bounds are successive
+ * powers of 2, so recording a sample is a constant-time operation and
+ * the histogram occupies a fixed, small amount of memory regardless of
+ * the number or range of samples.
+ *
+ * The class is not threadsafe; values read while another thread is
+ * recording samples may be slightly out of date.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API Histogram
+{
+ public:
+
+  /** The number of buckets in a histogram. */
+  static const uint_t NUM_BUCKETS = 64;
+
+  /** Construct a new, empty Histogram. */
+  Histogram();
+
+  /** Destructor. */
+  ~Histogram();
+
+  /**
+   * Record a sample. Sample <i>v</i> is counted in bucket 0 if it is 0,
+   * and otherwise in bucket <i>n</i> such that
+   * 2<sup><i>n</i>-1</sup> <= <i>v</i> < 2<sup><i>n</i></sup>.
+   *
+   * @param value The value to record.
+   */
+  void record(uint64_t value);
+
+  /** Reset the histogram, discarding all samples. */
+  void reset();
+
+  /** Get the number of samples recorded. */
+  inline uint64_t getCount() const
+  { return(_count); }
+
+  /** Get the sum of all samples recorded. */
+  inline uint64_t getSum() const
+  { return(_sum); }
+
+  /** Get the smallest sample recorded, or 0 if there are no samples. */
+  inline uint64_t getMin() const
+  { return(_count == 0 ? 0 : _min); }
+
+  /** Get the largest sample recorded, or 0 if there are no samples. */
+  inline uint64_t getMax() const
+  { return(_max); }
+
+  /** Get the mean of all samples recorded, or 0 if there are no samples. */
+  double getMean() const;
+
+  /**
+   * Get the number of samples in a bucket.
+   *
+   * @param bucket The bucket index.
+   * @return The count, or 0 if the index is out of range.
+   */
+  uint64_t getBucketCount(uint_t bucket) const;
+
+  /**
+   * Get the (exclusive) upper bound of a bucket.
+   *
+   * @param bucket The bucket index.
+   * @return The upper bound.
+   */
+  static uint64_t getBucketLimit(uint_t bucket);
+
+  /**
+   * Estimate a percentile of the recorded samples. The result is the
+   * upper bound of the bucket that contains the requested percentile,
+   * clamped to the largest sample recorded.
+   *
+   * @param percentile The percentile, in the range 0.0 to 100.0.
+   * @return The estimate, or 0 if there are no samples.
+   */
+  uint64_t getPercentile(double percentile) const;
+
+  /**
+   * Add the samples of another histogram to this one.
+   *
+   * @param other The other histogram.
+   */
+  void merge(const Histogram& other);
+
+ private:
+
+  uint64_t _buckets[NUM_BUCKETS];
+  uint64_t _count;
+  uint64_t _sum;
+  uint64_t _min;
+  uint64_t _max;
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_Histogram_hxx
@@ -0,0 +1,248 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_JSONLogger_hxx
+#define __ccxx_JSONLogger_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/Buffer.h++>
+#include <commonc++/CriticalSection.h++>
+#include <commonc++/Logger.h++>
+#include <commonc++/TimeSpan.h++>
+
+#include <cstdarg>
+#include <cstring>
+
+namespace ccxx {
+
+/**
+ * A typed, named field of a structured log record. A LogField refers to,
+ * but does not copy, its name and string value; it is intended to be
+ * constructed on the stack in an array that is passed to
+ * JSONLogger::logFields(). Constructing a LogField never allocates memory.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API LogField
+{
+ public:
+
+  /** Field value types. */
+  enum Type {
+    /** A signed integer. */
+    TypeInt,
+    /** An unsigned integer. */
+    TypeUInt,
+    /** A floating point number. */
+    TypeDouble,
+    /** A boolean. */
+    TypeBool,
+    /** A UTF-8 string. */
+    TypeString,
+    /** A duration, rendered in milliseconds. */
+    TypeDuration
+  };
+
+  /** Construct a signed integer field. */
+  LogField(const char* name, int value)
+    : _name(name), _type(TypeInt)
+  { _value.i = value; }
+
+  /** Construct a signed integer field. */
+  LogField(const char* name, int64_t value)
+    : _name(name), _type(TypeInt)
+  { _value.i = value; }
+
+  /** Construct an unsigned integer field. */
+  LogField(const char* name, uint_t value)
+    : _name(name), _type(TypeUInt)
+  { _value.u = value; }
+
+  /** Construct an unsigned integer field. */
+  LogField(const char* name, uint64_t value)
+    : _name(name), _type(TypeUInt)
+  { _value.u = value; }
+
+  /** Construct a floating point field. */
+  LogField(const char* name, double value)
+    : _name(name), _type(TypeDouble)
+  { _value.d = value; }
+
+  /** Construct a boolean field. */
+  LogField(const char* name, bool value)
+    : _name(name), _type(TypeBool)
+  { _value.b = value; }
+
+  /**
+   * Construct a string field.
+   *
+   * @param name The field name.
+   * @param value The NUL-terminated UTF-8 value, which must remain valid
+   * until the record has been logged. A <b>NULL</b> value is rendered as
+   * a JSON <code>null</code>.
+   */
+  LogField(const char* name, const char* value)
+    : _name(name), _type(TypeString)
+  { _value.s.str = value; _value.s.len = value ? std::strlen(value) : 0; }
+
+  /**
+   * Construct a string field from a character array that need not be
+   * NUL-terminated.
+   *
+   * @param name The field name.
+   * @param value The UTF-8 value.
+   * @param length The length of the value, in bytes.
+   */
+  LogField(const char* name, const char* value, size_t length)
+    : _name(name), _type(TypeString)
+  { _value.s.str = value; _value.s.len = length; }
+
+  /** Construct a duration field. */
+  LogField(const char* name, const TimeSpan& value)
+    : _name(name), _type(TypeDuration)
+  { _value.i = value.getSpan(); }
+
+  /** Get the field name. */
+  inline const char* getName() const
+  { return(_name); }
+
+  /** Get the field type. */
+  inline Type getType() const
+  { return(_type); }
+
+ private:
+
+  const char* _name;
+  Type _type;
+
+  union
+  {
+    int64_t i;
+    uint64_t u;
+    double d;
+    bool b;
+    struct
+    {
+      const char* str;
+      size_t len;
+    } s;
+  } _value;
+
+  friend class JSONLogger;
+};
+
+/**
+ * A Logger that renders log records as JSON lines: one JSON object per
+ * record, terminated by a newline. Each object contains the members
+ * <code>ts</code> (the time, in milliseconds since the epoch),
+ * <code>level</code>, <code>line</code>, <code>file</code> and
+ * <code>msg</code>, followed by the caller's typed fields, in order.
+ *
+ * Records are rendered into a reusable buffer by a specialized encoder
+ * rather than by a LogFormat, and are then passed to a target logger
+ * (such as a FileLogger or MappedFileLogger) which writes them out
+ * verbatim; no memory is allocated per record. A record that does not fit
+ * in the buffer is truncated at a field boundary and marked with a
+ * <code>"truncated":true</code> member, so that every line remains
+ * well-formed JSON.
+ *
+ * Log messages that are logged through the vlog() method are formatted
+ * printf-style, as usual, and become the <code>msg</code> member of a
+ * record with no additional fields.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API JSONLogger : public Logger
+{
+ public:
+
+  /**
+   * Construct a new JSONLogger.
+   *
+   * @param target The logger to write rendered records to. The JSONLogger
+   * does not take ownership of this object, and the target should not be
+   * written to by any other party.
+   * @param bufferSize The size of the record buffer, which is the maximum
+   * length of a rendered record, in bytes.
+   */
+  JSONLogger(Logger* target, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+  /** Destructor. */
+  virtual ~JSONLogger();
+
+  /**
+   * %Log a structured record.
+   *
+   * @param level The log level (severity).
+   * @param file The source filename.
+   * @param line The source file line number.
+   * @param message The log message, which is not formatted.
+   * @param fields An array of fields.
+   * @param numFields The number of fields in the array.
+   */
+  void logFields(LogLevel level, const char* file, int line,
+                 const char* message, const LogField* fields,
+                 size_t numFields);
+
+  void vlog(LogLevel level, const char* file, int line, const char* message,
+            va_list args);
+
+  /** Flush the target logger. */
+  void flush();
+
+  /** The default record buffer size. */
+  static const size_t DEFAULT_BUFFER_SIZE;
+
+ protected:
+
+  bool write(CharBuffer& buffer);
+
+ private:
+
+  bool _beginRecord(LogLevel level, const char* file, int line,
+                    const char* message, size_t messageLength);
+  bool _putField(const LogField& field);
+  void _endRecord(bool truncated);
+  bool _putString(const char* s, size_t len, bool clip = false);
+  bool _putRaw(const char* s, size_t len);
+  bool _putInt(int64_t value);
+  bool _putUInt(uint64_t value);
+  bool _putDouble(double value);
+
+  Logger* _target;
+  CharBuffer _record;
+  CharBuffer _message;
+  CriticalSection _lock;
+
+  CCXX_COPY_DECLS(JSONLogger);
+};
+
+/**
+ * Log a structured record with a JSONLogger. <i>F</i> must be an array of
+ * LogField objects, such as one declared with an aggregate initializer.
+ */
+#define Log_fields(LOGGER, L, M, F)                                     \
+  (LOGGER).logFields(L, __FILE__, __LINE__, M, F, CCXX_LENGTHOF(F))
+
+} // namespace ccxx
+
+#endif // __ccxx_JSONLogger_hxx
@@ -24,9 +24,12 @@
 #define __ccxx_Log_hxx
 
 #include <commonc++/Common.h++>
+#include <commonc++/AsyncLogger.h++>
+#include <commonc++/AtomicCounter.h++>
 #include <commonc++/ConsoleLogger.h++>
 #include <commonc++/CriticalSection.h++>
 #include <commonc++/FileLogger.h++>
+#include <commonc++/LogLimiter.h++>
 #include <commonc++/Logger.h++>
 #include <commonc++/String.h++>
 
@@ -41,7 +44,7 @@ class COMMONCPP_API LogFunctor
  public:
 
   LogFunctor(const char *file, int line, LogLevel level = LogDebug,
-             bool nodebug = false);
+             bool disabled = false);
   ~LogFunctor();
 
   void operator()(const char *fmt, ...);
@@ -52,7 +55,7 @@ class COMMONCPP_API LogFunctor
   const char *_file;
   int _line;
   LogLevel _level;
-  bool _nodebug;
+  bool _disabled;
 };
 /** @endcond */
 
@@ -82,6 +85,40 @@ class COMMONCPP_API Log
    */
   static void setConsoleLogFormat(const String& format);
 
+  /**
+   * Enable a log level globally. All levels are enabled by default.
+   * Levels that are disabled globally are filtered out before any lock is
+   * taken or any argument is formatted; the loggers' own level masks are
+   * applied in addition to this one.
+   *
+   * @param level The level to enable.
+   */
+  static void enableLogLevel(LogLevel level);
+
+  /**
+   * Disable a log level globally.
+   *
+   * @param level The level to disable.
+   */
+  static void disableLogLevel(LogLevel level);
+
+  /**
+   * Enable the given log level and all more severe levels globally, and
+   * disable all less severe levels.
+   *
+   * @param level The minimum level to log.
+   */
+  static void setMinLogLevel(LogLevel level);
+
+  /**
+   * Test if messages at the given level would be logged anywhere. This
+   * check is lock-free, and is made by the logging macros before their
+   * arguments are evaluated.
+   */
+  inline static bool isLogLevelEnabled(LogLevel level)
+  { return(((_levelMask.load() & level) != 0)
+           && (_useConsoleLog || _useFileLog)); }
+
   /**
    * Enable or disable logging to the console.
    *
@@ -93,8 +130,9 @@ class COMMONCPP_API Log
 
   /**
    * Set the FileLogger object to use for logging to a file. Any current
-   * FileLogger object will be deleted. The passed in object must be
-   * heap allocated, and should never be freed by the caller.
+   * FileLogger object will be deleted, once no other thread can still be
+   * using it. The passed in object must be heap allocated, and should
+   * never be freed by the caller.
    */
   static void setFileLogger(FileLogger* logger);
 
@@ -147,6 +185,49 @@ class COMMONCPP_API Log
    */
   static void setLogFileRotateCount(uint_t rotateCount);
 
+  /**
+   * Enable or disable asynchronous file logging. When enabled, file log
+   * records are formatted on the calling thread without taking the global
+   * log lock, and are written to the FileLogger in batches by a background
+   * writer thread; see AsyncLogger. This method should be called while no
+   * other threads are logging.
+   *
+   * @param flag <b>true</b> if asynchronous file logging should be
+   * enabled, <b>false</b> otherwise.
+   * @param bufferSize The size of each thread's record buffer, in bytes.
+   * @param policy The policy to apply when a thread's record buffer is
+   * full.
+   */
+  static void setAsyncFileLog(bool flag,
+                              size_t bufferSize
+                              = AsyncLogger::DEFAULT_BUFFER_SIZE,
+                              LogOverflowPolicy policy = LogOverflowBlock);
+
+  /** Test if asynchronous file logging is enabled. */
+  inline static bool isAsyncFileLog()
+  { return(_asyncFileLog != NULL); }
+
+  /**
+   * Write any buffered log records, including asynchronous ones, to the
+   * log file before returning.
+   */
+  static void flush();
+
+  /**
+   * Enable or disable flushing of buffered log records when the process
+   * receives a fatal signal (such as SIGSEGV or SIGABRT). The records are
+   * flushed on a best-effort basis, using only async-signal-safe
+   * operations: nothing is flushed if the crashing thread was itself
+   * logging, and a logger that another thread is using is skipped (see
+   * Logger::flushOnCrash()). The signal is then re-raised with its
+   * default disposition. This replaces any handlers that were installed
+   * for those signals. Currently only supported on POSIX systems.
+   *
+   * @param flag <b>true</b> to install the crash handler, <b>false</b>
+   * to restore the default dispositions.
+   */
+  static void setFlushOnCrash(bool flag);
+
   /** Write a log message to the log file, if file logging is enabled. */
   static void vlogFile(LogLevel level, const char* file, int line,
                        const char* message, va_list args);
@@ -179,11 +260,17 @@ class COMMONCPP_API Log
 
  private:
 
+  static void _vlog(LogLevel level, const char* file, int line,
+                    const char* message, va_list args);
+  static void _flushOnCrash(int sig);
+
   static CriticalSection _lock;
   static ConsoleLogger* _consoleLog;
   static FileLogger* _fileLog;
-  static bool _useConsoleLog;
-  static bool _useFileLog;
+  static AsyncLogger* _asyncFileLog;
+  static volatile bool _useConsoleLog;
+  static volatile bool _useFileLog;
+  static AtomicCounter _levelMask;
 
   Log(); // not supported
   CCXX_COPY_DECLS(Log);
@@ -193,97 +280,206 @@ class COMMONCPP_API Log
 #define Log_assert(EXPR)                                                \
   (void)((EXPR)|| ccxx::Log::assert_(__FILE__, __LINE__, #EXPR))
 
-#if (defined CCXX_OS_WINDOWS) && (defined _MSC_VER) && (_MSC_VER < 1400)
-
-// no variadic macros; emulate with LogFunctor
-
-#if (defined DEBUG) || (defined DEBUG_LOG_MESSAGES)
-
 /**
- * Log a debug message. Compiled in only if DEBUG or DEBUG_LOG_MESSAGES is
- * defined.
+ * @def CCXX_LOG_MIN_LEVEL
+ * The minimum log level that is compiled in: 1 (debug), 2 (info), 4
+ * (warning), or 8 (error). Logging macros for less severe levels expand to
+ * nothing, so they cost nothing at runtime. Defaults to 1 if DEBUG or
+ * DEBUG_LOG_MESSAGES is defined, and to 2 otherwise.
  */
-#define Log_debug                                       \
-  ccxx::LogFunctor(__FILE__, __LINE__, ccxx::LogDebug)
+#ifndef CCXX_LOG_MIN_LEVEL
+#if (defined DEBUG) || (defined DEBUG_LOG_MESSAGES)
+#define CCXX_LOG_MIN_LEVEL 1
+#else
+#define CCXX_LOG_MIN_LEVEL 2
+#endif
+#endif // CCXX_LOG_MIN_LEVEL
 
-#else // ! (DEBUG || DEBUG_LOG_MESSAGES)
+#if (defined CCXX_OS_WINDOWS) && (defined _MSC_VER) && (_MSC_VER < 1400)
 
-#define Log_debug                                               \
-  ccxx::LogFunctor(__FILE__, __LINE__, ccxx::LogDebug, true)
+// no variadic macros; emulate with LogFunctor, which can't avoid evaluating
+// the arguments, but still skips formatting and locking
 
-#endif // DEBUG || DEBUG_LOG_MESSAGES
+/**
+ * Log a debug message. Compiled in only if CCXX_LOG_MIN_LEVEL is 1.
+ */
+#define Log_debug                                                       \
+  ccxx::LogFunctor(__FILE__, __LINE__, ccxx::LogDebug,                  \
+                   (CCXX_LOG_MIN_LEVEL > 1))
 
 /** Log an informational message. */
-#define Log_info                                        \
-  ccxx::LogFunctor(__FILE__, __LINE__, ccxx::LogInfo)
+#define Log_info                                                        \
+  ccxx::LogFunctor(__FILE__, __LINE__, ccxx::LogInfo,                   \
+                   (CCXX_LOG_MIN_LEVEL > 2))
 
 /** Log a warning message. */
-#define Log_warning                                             \
-  ccxx::LogFunctor(__FILE__, __LINE__, ccxx::LogWarning)
+#define Log_warning                                                     \
+  ccxx::LogFunctor(__FILE__, __LINE__, ccxx::LogWarning,                \
+                   (CCXX_LOG_MIN_LEVEL > 4))
 
 /** Log an error message. */
 #define Log_error                                       \
   ccxx::LogFunctor(__FILE__, __LINE__, ccxx::LogError)
 
+// no variadic macros; Log_limited() and Log_sampled() are not available
+
 #elif (defined __GNUC__)
 
 // gcc-style variadic macros (for compatibility with older versions of GCC)
 
-#if (defined DEBUG) || (defined DEBUG_LOG_MESSAGES)
+/** @cond INTERNAL */
+#define CCXX_LOG_(L, M, args...)                                        \
+  (ccxx::Log::isLogLevelEnabled(L)                                      \
+   ? ccxx::Log::log(L, __FILE__, __LINE__, M, ## args) : (void)0)
+/** @endcond */
+
+#if CCXX_LOG_MIN_LEVEL <= 1
 
 /**
- * Log a debug message. Compiled in only if DEBUG or DEBUG_LOG_MESSAGES is
- * defined.
+ * Log a debug message. Compiled in only if CCXX_LOG_MIN_LEVEL is 1.
  */
-#define Log_debug(M, args...)                                           \
-  ccxx::Log::log(ccxx::LogDebug, __FILE__, __LINE__, M, ## args)
+#define Log_debug(M, args...) CCXX_LOG_(ccxx::LogDebug, M, ## args)
+
+#else
 
-#else // ! (DEBUG || DEBUG_LOG_MESSAGES)
+#define Log_debug(M, args...) ((void)0)
 
-#define Log_debug(M, args...)
+#endif
 
-#endif // DEBUG || DEBUG_LOG_MESSAGES
+#if CCXX_LOG_MIN_LEVEL <= 2
 
 /** Log an informational message. */
-#define Log_info(M, args...)                                    \
-  ccxx::Log::log(ccxx::LogInfo, __FILE__, __LINE__, M, ## args)
+#define Log_info(M, args...) CCXX_LOG_(ccxx::LogInfo, M, ## args)
+
+#else
+
+#define Log_info(M, args...) ((void)0)
+
+#endif
+
+#if CCXX_LOG_MIN_LEVEL <= 4
 
 /** Log a warning message. */
-#define Log_warning(M, args...)                                         \
-  ccxx::Log::log(ccxx::LogWarning, __FILE__, __LINE__, M, ## args)
+#define Log_warning(M, args...) CCXX_LOG_(ccxx::LogWarning, M, ## args)
+
+#else
+
+#define Log_warning(M, args...) ((void)0)
+
+#endif
 
 /** Log an error message. */
-#define Log_error(M, args...)                                           \
-  ccxx::Log::log(ccxx::LogError, __FILE__, __LINE__,  M, ## args)
+#define Log_error(M, args...) CCXX_LOG_(ccxx::LogError, M, ## args)
+
+/** @cond INTERNAL */
+#define CCXX_LOG_LIMITED_(L, N, K, M, args...)                          \
+  do                                                                    \
+  {                                                                     \
+    if(ccxx::Log::isLogLevelEnabled(L))                                 \
+    {                                                                   \
+      static ccxx::LogLimiter ccxx_log_limiter_(N, K);                  \
+      if(ccxx_log_limiter_.allow())                                     \
+      {                                                                 \
+        ccxx_log_limiter_.reportSuppressed(L, __FILE__, __LINE__);      \
+        ccxx::Log::log(L, __FILE__, __LINE__, M, ## args);              \
+      }                                                                 \
+    }                                                                   \
+  } while(0)
+/** @endcond */
+
+/**
+ * Log a message at the given level, at most <i>N</i> times per second
+ * from this call site. The number of suppressed messages is logged along
+ * with the next message that is passed. See LogLimiter.
+ */
+#define Log_limited(L, N, M, args...)                   \
+  CCXX_LOG_LIMITED_(L, N, 1, M, ## args)
+
+/**
+ * Log only one in every <i>K</i> messages at the given level from this
+ * call site. The number of suppressed messages is logged along with the
+ * next message that is passed. See LogLimiter.
+ */
+#define Log_sampled(L, K, M, args...)                   \
+  CCXX_LOG_LIMITED_(L, 0, K, M, ## args)
 
 #else // assume ANSI compiler with support for C99 variadic macros
 
-#if (defined DEBUG) || defined(DEBUG_LOG_MESSAGES)
+/** @cond INTERNAL */
+#define CCXX_LOG_(L, M, ...)                                            \
+  (ccxx::Log::isLogLevelEnabled(L)                                      \
+   ? ccxx::Log::log(L, __FILE__, __LINE__, M, __VA_ARGS__) : (void)0)
+/** @endcond */
+
+#if CCXX_LOG_MIN_LEVEL <= 1
 
 /**
- * Log a debug message. Compiled in only if DEBUG or DEBUG_LOG_MESSAGES is
- * defined.
+ * Log a debug message. Compiled in only if CCXX_LOG_MIN_LEVEL is 1.
  */
-#define Log_debug(M, ...)                                               \
-  ccxx::Log::log(ccxx::LogDebug, __FILE__, __LINE__, M, __VA_ARGS__)
+#define Log_debug(M, ...) CCXX_LOG_(ccxx::LogDebug, M, __VA_ARGS__)
+
+#else
 
-#else // ! (DEBUG || DEBUG_LOG_MESSAGES)
+#define Log_debug(M, ...) ((void)0)
 
-#define Log_debug(M, ...)
+#endif
 
-#endif // DEBUG || DEBUG_LOG_MESSAGES
+#if CCXX_LOG_MIN_LEVEL <= 2
 
 /** Log an informational message. */
-#define Log_info(M, ...)                                                \
-  ccxx::Log::log(ccxx::LogInfo, __FILE__, __LINE__, M, __VA_ARGS__)
+#define Log_info(M, ...) CCXX_LOG_(ccxx::LogInfo, M, __VA_ARGS__)
+
+#else
+
+#define Log_info(M, ...) ((void)0)
+
+#endif
+
+#if CCXX_LOG_MIN_LEVEL <= 4
 
 /** Log a warning message. */
-#define Log_warning(M, ...)                                             \
-  ccxx::Log::log(ccxx::LogWarning, __FILE__, __LINE__, M, __VA_ARGS__)
+#define Log_warning(M, ...) CCXX_LOG_(ccxx::LogWarning, M, __VA_ARGS__)
+
+#else
+
+#define Log_warning(M, ...) ((void)0)
+
+#endif
 
 /** Log an error message. */
-#define Log_error(M, ...)                                               \
-  ccxx::Log::log(ccxx::LogError, __FILE__, __LINE__,  M, __VA_ARGS__)
+#define Log_error(M, ...) CCXX_LOG_(ccxx::LogError, M, __VA_ARGS__)
+
+/** @cond INTERNAL */
+#define CCXX_LOG_LIMITED_(L, N, K, M, ...)                              \
+  do                                                                    \
+  {                                                                     \
+    if(ccxx::Log::isLogLevelEnabled(L))                                 \
+    {                                                                   \
+      static ccxx::LogLimiter ccxx_log_limiter_(N, K);                  \
+      if(ccxx_log_limiter_.allow())                                     \
+      {                                                                 \
+        ccxx_log_limiter_.reportSuppressed(L, __FILE__, __LINE__);      \
+        ccxx::Log::log(L, __FILE__, __LINE__, M, __VA_ARGS__);          \
+      }                                                                 \
+    }                                                                   \
+  } while(0)
+/** @endcond */
+
+/**
+ * Log a message at the given level, at most <i>N</i> times per second
+ * from this call site. The number of suppressed messages is logged along
+ * with the next message that is passed. See LogLimiter.
+ */
+#define Log_limited(L, N, M, ...)                       \
+  CCXX_LOG_LIMITED_(L, N, 1, M, __VA_ARGS__)
+
+/**
+ * Log only one in every <i>K</i> messages at the given level from this
+ * call site. The number of suppressed messages is logged along with the
+ * next message that is passed. See LogLimiter.
+ */
+#define Log_sampled(L, K, M, ...)                       \
+  CCXX_LOG_LIMITED_(L, 0, K, M, __VA_ARGS__)
 
 #endif // variadic checks
 
@@ -226,6 +226,25 @@ class COMMONCPP_API LogFormat
   void format(CharBuffer& buffer, LogLevel level, const char* file,
               int line, const char* message, va_list args);
 
+  /**
+   * Format a log message with an explicit timestamp and write it to a
+   * buffer. This variant is used when a message is rendered some time
+   * after it was logged, as is the case for deferred-format binary log
+   * records; the time and date directives then reflect the time at which
+   * the message was originally logged.
+   *
+   * @param buffer The output buffer for the resulting message.
+   * @param level The logging (severity) level for the message.
+   * @param time The time at which the message was logged, in
+   * milliseconds since the epoch.
+   * @param file The source file of the originating log statement.
+   * @param line The source line of the originating log statement.
+   * @param message The formatted message.
+   * @param args Optional message arguments.
+   */
+  void format(CharBuffer& buffer, LogLevel level, time_ms_t time,
+              const char* file, int line, const char* message, va_list args);
+
   /** Set the short format for dates. See DateTimeFormat. */
   void setShortDateFormat(const String& format);
 
@@ -238,6 +257,18 @@ class COMMONCPP_API LogFormat
   /** Set the long format for times. See DateTimeFormat. */
   void setLongTimeFormat(const String& format);
 
+  /**
+   * Enable or disable the text style and color directives. When styles
+   * are disabled, these directives produce no output; this is useful
+   * when messages are written to something other than a terminal.
+   * Styles are enabled by default.
+   */
+  void setStylesEnabled(bool enabled);
+
+  /** Test if the text style and color directives are enabled. */
+  inline bool isStylesEnabled() const
+  { return(_stylesEnabled); }
+
  private:
 
   static size_t _eolLen;
@@ -246,6 +277,8 @@ class COMMONCPP_API LogFormat
   DateTimeFormat _longDateFormat;
   DateTimeFormat _shortTimeFormat;
   DateTimeFormat _longTimeFormat;
+  int32_t _cacheID;
+  bool _stylesEnabled;
 
   CCXX_COPY_DECLS(LogFormat);
 };
@@ -0,0 +1,97 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_LogLimiter_hxx
+#define __ccxx_LogLimiter_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/AtomicCounter.h++>
+#include <commonc++/LogFormat.h++>
+
+namespace ccxx {
+
+/**
+ * A rate limiter for a single logging call site. A static LogLimiter is
+ * created for each occurrence of the <b>Log_limited()</b> and
+ * <b>Log_sampled()</b> macros, so the state for each site lives with the
+ * site itself, and checking it involves no locks or lookups. A limiter
+ * may pass at most a given number of messages per second, or only one in
+ * every <i>K</i> messages, or both. The number of messages that were
+ * suppressed is reported, from the same call site, along with the next
+ * message that is passed.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API LogLimiter
+{
+ public:
+
+  /**
+   * Construct a new LogLimiter.
+   *
+   * @param maxPerSecond The maximum number of messages to pass per
+   * second, or 0 for no limit.
+   * @param sampleRate Pass only one in every <i>sampleRate</i> messages.
+   * A value of 0 or 1 passes every message.
+   */
+  LogLimiter(uint_t maxPerSecond, uint_t sampleRate = 1);
+
+  /** Destructor. */
+  ~LogLimiter();
+
+  /**
+   * Test if a message should be passed. Suppressed messages are counted.
+   *
+   * @return <b>true</b> if the message should be logged, <b>false</b>
+   * otherwise.
+   */
+  bool allow();
+
+  /**
+   * If any messages have been suppressed since the last report, log the
+   * number of suppressed messages, and reset the count.
+   *
+   * @param level The log level for the report.
+   * @param file The source file of the call site.
+   * @param line The source line of the call site.
+   */
+  void reportSuppressed(LogLevel level, const char* file, int line);
+
+  /** Get the number of messages suppressed since the last report. */
+  inline int32_t getSuppressedCount() const
+  { return(_suppressed.get()); }
+
+ private:
+
+  const int32_t _maxPerSecond;
+  const int32_t _sampleRate;
+  AtomicCounter _window;
+  AtomicCounter _count;
+  AtomicCounter _calls;
+  AtomicCounter _suppressed;
+
+  CCXX_COPY_DECLS(LogLimiter);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_LogLimiter_hxx
@@ -0,0 +1,141 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_LogSite_hxx
+#define __ccxx_LogSite_hxx
+
+#include <commonc++/Common.h++>
+
+namespace ccxx {
+
+/**
+ * A static description of a binary logging statement: its format string,
+ * source location, and argument signature. Each LogSite is assigned a
+ * small integer ID when it is constructed; binary log records refer to
+ * their site by this ID rather than carrying the format string, so that
+ * formatting can be deferred to a writer thread or to an offline decoder.
+ * <p>
+ * LogSite objects are normally created as function-local statics by the
+ * CCXX_LOG_BINARY() macro. A site is unregistered when it is destroyed;
+ * records that refer to it and have not yet been rendered are then
+ * discarded.
+ * <p>
+ * The argument signature is derived from the format string. The
+ * conversions <b>d i o u x X c</b> (with the <b>hh h l ll j z t</b>
+ * length modifiers), <b>e E f F g G a A</b>, <b>s</b>, and <b>p</b> are
+ * supported, as are <b>*</b> field widths and precisions. A format string
+ * that contains any other conversion, or more than MAX_ARGS arguments,
+ * yields a site that is not binary-capable; messages for such sites are
+ * formatted immediately instead.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API LogSite
+{
+ public:
+
+  /**
+   * Construct and register a new LogSite.
+   *
+   * @param format The printf-style message format. The string must remain
+   * valid for the lifetime of the process, as a string literal does.
+   * @param file The source file of the log statement.
+   * @param line The source line of the log statement.
+   */
+  LogSite(const char* format, const char* file, int line);
+
+  /** Destructor. Unregisters the site. */
+  ~LogSite();
+
+  /** Get the ID of this site. IDs are assigned sequentially from 1. */
+  inline uint32_t getID() const
+  { return(_id); }
+
+  /** Get the message format. */
+  inline const char* getFormat() const
+  { return(_format); }
+
+  /** Get the source file. */
+  inline const char* getFile() const
+  { return(_file); }
+
+  /** Get the source line. */
+  inline int getLine() const
+  { return(_line); }
+
+  /**
+   * Get the argument signature, one character per argument consumed by
+   * the format string.
+   */
+  inline const char* getSignature() const
+  { return(_signature); }
+
+  /**
+   * Test if messages for this site can be logged as binary records.
+   */
+  inline bool isBinary() const
+  { return(_binary); }
+
+  /**
+   * Look up a site by ID.
+   *
+   * @param id The site ID.
+   * @return The site, or <b>NULL</b> if there is no site with the given ID.
+   */
+  static const LogSite* lookup(uint32_t id);
+
+  /** Get the number of sites that have been registered. */
+  static uint32_t getCount();
+
+  /** @cond INTERNAL */
+
+  /**
+   * A no-op that allows the compiler to check the arguments of a binary
+   * logging statement against its format string.
+   */
+  ___PRINTF(1, 2) static inline void checkFormat(const char* /* format */,
+                                                 ...)
+  { }
+
+  /** @endcond */
+
+  /**
+   * The maximum number of arguments that the format string of a
+   * binary-capable site may consume.
+   */
+  static const uint_t MAX_ARGS = 32;
+
+ private:
+
+  const char* _format;
+  const char* _file;
+  int _line;
+  uint32_t _id;
+  bool _binary;
+  char _signature[MAX_ARGS + 1];
+
+  CCXX_COPY_DECLS(LogSite);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_LogSite_hxx
@@ -39,6 +39,9 @@ namespace ccxx {
  */
 class COMMONCPP_API Logger
 {
+  friend class AsyncLogger;
+  friend class JSONLogger;
+
  public:
 
   /**
@@ -79,8 +82,8 @@ class COMMONCPP_API Logger
    * @param message The log message.
    * @param args Optional message arguments.
    */
-  void vlog(LogLevel level, const char* file, int line, const char* message,
-            va_list args);
+  virtual void vlog(LogLevel level, const char* file, int line,
+                    const char* message, va_list args);
 
   /**
    * Enable a specific log level.
@@ -99,6 +102,42 @@ class COMMONCPP_API Logger
   /** Test if a specific log level is enabled. */
   bool isLogLevelEnabled(LogLevel level) const;
 
+  /**
+   * Test if this Logger writes binary log frames rather than formatted
+   * text. An AsyncLogger passes binary log records through to such a
+   * logger unrendered; see BinaryFileLogger.
+   */
+  virtual bool isBinary() const;
+
+  /**
+   * Write out any log messages that this Logger has buffered. The default
+   * implementation does nothing.
+   */
+  virtual void flush();
+
+  /**
+   * Write out any log messages that this Logger has buffered, from a
+   * fatal signal handler, on a best-effort basis. Implementations may use
+   * only async-signal-safe operations, and must write nothing if the
+   * logger is in use (including by the calling thread), since its buffers
+   * may then be inconsistent. The default implementation does nothing.
+   */
+  virtual void flushOnCrash();
+
+  /**
+   * Test if this Logger has deferred work, such as renaming rotated log
+   * files, that should be completed without holding the logging lock.
+   * The default implementation returns <b>false</b>.
+   */
+  virtual bool hasDeferredWork() const;
+
+  /**
+   * Complete any deferred work. This method is called after a message
+   * has been written and the logging lock has been released. The default
+   * implementation does nothing.
+   */
+  virtual void completeDeferredWork();
+
   /** Get the LogFormat used by this Logger. */
   inline LogFormat &getLogFormat()
   { return(_format); }
@@ -120,6 +159,17 @@ class COMMONCPP_API Logger
    */
   virtual bool write(CharBuffer& buffer) = 0;
 
+  /**
+   * Write a formatted log message from a fatal signal handler, subject to
+   * the same restrictions as flushOnCrash(). The default implementation
+   * writes nothing.
+   *
+   * @param buffer The buffer containing the log message.
+   * @return <b>true</b> if the message was written successfully,
+   * <b>false</b> otherwise.
+   */
+  virtual bool writeOnCrash(CharBuffer& buffer);
+
  private:
 
   CharBuffer _buffer;
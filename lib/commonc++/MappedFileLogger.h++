@@ -0,0 +1,162 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_MappedFileLogger_hxx
+#define __ccxx_MappedFileLogger_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/AtomicCounter.h++>
+#include <commonc++/ConditionVar.h++>
+#include <commonc++/Logger.h++>
+#include <commonc++/Mutex.h++>
+#include <commonc++/Runnable.h++>
+#include <commonc++/String.h++>
+#include <commonc++/Thread.h++>
+
+namespace ccxx {
+
+/**
+ * A logger that appends log messages to a sequence of preallocated,
+ * memory-mapped log files, or <i>segments</i>. Each message is written by
+ * reserving space in the current segment with an atomic add and copying
+ * the formatted message directly into the mapping, so any number of
+ * threads may log concurrently, without a lock and without a system call
+ * per message. The next segment is created in advance by a background
+ * thread, so when a segment fills up, the loggers only have to switch to
+ * the next one; the full segment is then truncated to the length of the
+ * data that was written to it and closed by the background thread.
+ * <p>
+ * Segments are named <i>name</i>-000001.log, <i>name</i>-000002.log, and so
+ * on; numbers of segments that already exist are skipped, so existing
+ * segments are never overwritten. The mapping is synchronized with the
+ * disk periodically; if the process terminates abnormally, the unused
+ * portion of the last segment remains filled with NUL bytes.
+ * <p>
+ * If a segment can't be created, for example because the disk is full,
+ * messages are discarded, and the creation of a new segment is retried
+ * at most once every RETRY_INTERVAL milliseconds.
+ * <p>
+ * Unlike the other loggers, this logger does not need to be protected by
+ * a lock, and so it is meant to be used directly, rather than through
+ * the Log class.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API MappedFileLogger : public Logger
+{
+ public:
+
+  /**
+   * Construct a new MappedFileLogger.
+   *
+   * @param format The log message format.
+   * @param segmentSize The size of each log file segment, in kilobytes.
+   * @param syncInterval The interval at which the current segment is
+   * synchronized with the disk, in milliseconds, or 0 to leave this to
+   * the operating system.
+   */
+  MappedFileLogger(const String& format = "[%d %t] %m",
+                   size_t segmentSize = 16384,
+                   timespan_ms_t syncInterval = 1000);
+
+  /** Destructor. Closes the current segment. */
+  virtual ~MappedFileLogger();
+
+  /**
+   * Set the logging directory and the base name of the log file
+   * segments, and create the first segment. Any current segment is
+   * closed.
+   *
+   * @param dir The directory in which the segments will be created.
+   * @param name The base name for the segments.
+   * @return <b>true</b> if the segment was created successfully,
+   * <b>false</b> otherwise.
+   */
+  bool setFile(const String& dir, const String& name);
+
+  /** Get the path of the current segment. */
+  String getCurrentPath();
+
+  void vlog(LogLevel level, const char* file, int line, const char* message,
+            va_list args);
+
+  /** Synchronize the current segment with the disk. */
+  void flush();
+
+  /** The minimum segment size, in kilobytes. */
+  static const size_t MIN_SEGMENT_SIZE;
+
+  /** The maximum segment size, in kilobytes. */
+  static const size_t MAX_SEGMENT_SIZE;
+
+  /**
+   * The minimum interval, in milliseconds, between attempts to create a
+   * segment after a failure.
+   */
+  static const timespan_ms_t RETRY_INTERVAL;
+
+ protected:
+
+  /** Append a preformatted log message to the current segment. */
+  bool write(CharBuffer& buffer);
+
+ private:
+
+  class Segment; // fwd decl
+  class BufferSlot; // fwd decl
+
+  bool _append(const char* data, size_t len);
+  void _leave(Segment* segment);
+  void _rollover(int32_t generation);
+  bool _retry(int32_t generation);
+  void _publish(int32_t generation);
+  void _runRoller();
+  void _openSegment(Segment* segment);
+  void _closeSegment(Segment* segment);
+  void _sync(Segment* segment);
+
+  int32_t _segmentSize;
+  timespan_ms_t _syncInterval;
+  volatile time_ms_t _lastSync;
+  AtomicCounter _syncing;
+  volatile time_ms_t _retryTime;
+
+  Segment* _segments[2];
+  AtomicCounter _generation;
+  Mutex _rollLock;
+  ConditionVar _rollCond;
+  RunnableDelegate<MappedFileLogger> _rollRunner;
+  Thread* _roller;
+  bool _rolling;
+  bool _stopping;
+  BufferSlot* _slot;
+
+  String _dir;
+  String _name;
+  uint_t _sequence;
+
+  CCXX_COPY_DECLS(MappedFileLogger);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_MappedFileLogger_hxx
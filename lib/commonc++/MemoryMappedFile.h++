@@ -25,6 +25,7 @@
 
 #include <commonc++/Common.h++>
 #include <commonc++/IOException.h++>
+#include <commonc++/OutOfBoundsException.h++>
 #include <commonc++/Permissions.h++>
 
 namespace ccxx {
@@ -38,6 +39,19 @@ class COMMONCPP_API MemoryMappedFile
 {
  public:
 
+  /** Access pattern hints for the mapped memory. */
+  enum AccessAdvice {
+    /** No special treatment. */
+    AdviseNormal,
+    /** Pages will be accessed in order; read ahead aggressively. */
+    AdviseSequential,
+    /** Pages will be accessed in random order; do not read ahead. */
+    AdviseRandom,
+    /** Pages will be needed soon; start reading them in now. */
+    AdviseWillNeed,
+    /** Pages will not be needed soon; they may be released. */
+    AdviseDontNeed };
+
   /**
    * Construct a new MemoryMappedFile for the given path.
    *
@@ -64,6 +78,20 @@ class COMMONCPP_API MemoryMappedFile
    */
   void open(uint64_t size = 0, bool readOnly = false);
 
+  /**
+   * Create the file, or truncate it if it already exists, allocate
+   * storage for it, and map it into memory. Where the platform supports
+   * it, the storage is allocated up front, so that stores into the mapping
+   * will not fail later for lack of disk space.
+   *
+   * @param size The size of the file.
+   * @param perm The permissions for the file.
+   * @throw IOException If the size is 0, or if the file could not be
+   * created or allocated, or the mapping operation failed.
+   */
+  void create(uint64_t size,
+              const Permissions& perm = Permissions::USER_READ_WRITE);
+
   /** Unmap and close the file. */
   void close();
 
@@ -76,6 +104,89 @@ class COMMONCPP_API MemoryMappedFile
    */
   void sync(bool async = false);
 
+  /**
+   * Specify whether the whole mapping should be faulted in when the file is
+   * mapped, rather than a page at a time on first access. Must be called
+   * before the file is opened or created.
+   *
+   * @param prefault The new value for the flag.
+   */
+  inline void setPrefault(bool prefault)
+  { _prefault = prefault; }
+
+  /** Determine if the mapping is prefaulted when the file is mapped. */
+  inline bool isPrefault() const
+  { return(_prefault); }
+
+  /**
+   * Specify whether the mapping should be backed by huge pages, where the
+   * platform and file system support it. This is a hint only. Must be
+   * called before the file is opened or created.
+   *
+   * @param hugePages The new value for the flag.
+   */
+  inline void setHugePages(bool hugePages)
+  { _hugePages = hugePages; }
+
+  /** Determine if the mapping is requested to be backed by huge pages. */
+  inline bool isHugePages() const
+  { return(_hugePages); }
+
+  /**
+   * Advise the system of the expected access pattern for the whole mapping.
+   * This is a hint only, and has no effect on platforms that do not support
+   * it.
+   *
+   * @param advice The access advice.
+   * @throw IOException If the file is not mapped, or if an I/O error
+   * occurs.
+   */
+  void advise(AccessAdvice advice);
+
+  /**
+   * Advise the system of the expected access pattern for a range of the
+   * mapping. The range is widened to page boundaries.
+   *
+   * @param offset The offset of the start of the range.
+   * @param length The length of the range. A value of 0 indicates the
+   * remainder of the mapping.
+   * @param advice The access advice.
+   * @throw OutOfBoundsException If the range extends past the end of the
+   * mapping.
+   * @throw IOException If the file is not mapped, or if an I/O error
+   * occurs.
+   */
+  void advise(uint64_t offset, uint64_t length, AccessAdvice advice);
+
+  /**
+   * Lock a range of the mapping into physical memory, so that accesses to
+   * it never page-fault. The range is widened to page boundaries.
+   *
+   * @param offset The offset of the start of the range.
+   * @param length The length of the range. A value of 0 indicates the
+   * remainder of the mapping.
+   * @throw OutOfBoundsException If the range extends past the end of the
+   * mapping.
+   * @throw IOException If the file is not mapped, or if the range could not
+   * be locked, for example because the process's locked memory limit would
+   * be exceeded.
+   */
+  void lock(uint64_t offset = 0, uint64_t length = 0);
+
+  /**
+   * Unlock a range of the mapping that was previously locked with
+   * lock(). The range is widened to page boundaries.
+   *
+   * @param offset The offset of the start of the range.
+   * @param length The length of the range. A value of 0 indicates the
+   * remainder of the mapping.
+   * @throw OutOfBoundsException If the range extends past the end of the
+   * mapping.
+   * @throw IOException If the file is not mapped, or if an I/O error
+   * occurs.
+   */
+  void unlock(uint64_t offset = 0, uint64_t length = 0);
+
   /** Get a pointer to the base of the mapped memory segment. */
   inline byte_t* getBase()
   { return(_base); }
@@ -90,6 +201,10 @@ class COMMONCPP_API MemoryMappedFile
 
  private:
 
+  void _map(uint64_t size, bool readOnly);
+  void _range(uint64_t offset, uint64_t length, byte_t*& base,
+              size_t& size) const;
+
   String _path;
   FileHandle _handle;
 #ifdef CCXX_OS_WINDOWS
@@ -98,6 +213,8 @@ class COMMONCPP_API MemoryMappedFile
   byte_t* _base;
   uint64_t _size;
   bool _open;
+  bool _prefault;
+  bool _hugePages;
 };
 
 } // namespace ccxx
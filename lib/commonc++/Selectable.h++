@@ -0,0 +1,61 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_Selectable_hxx
+#define __ccxx_Selectable_hxx
+
+#include <commonc++/Common.h++>
+
+namespace ccxx {
+
+/**
+ * An interface for event sources that are represented by a file
+ * descriptor, such as an EventNotifier, a TimerNotifier, a SignalNotifier
+ * or a DirectoryWatcher. Such sources can be registered with a
+ * SocketSelector, so that they are serviced by the same event loop as the
+ * selector's connections.
+ *
+ * @author Mark Lindner
+ */
+class Selectable
+{
+ public:
+
+  /** Destructor. */
+  virtual ~Selectable() { }
+
+  /**
+   * Get the handle that becomes readable when events are pending, or
+   * <b>CCXX_INVALID_FILE_HANDLE</b> if the source has not been initialized.
+   */
+  virtual FileHandle getEventHandle() const = 0;
+
+  /**
+   * Process pending events. This method is called when the event handle
+   * is readable; it must not block.
+   */
+  virtual void processEvents() = 0;
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_Selectable_hxx
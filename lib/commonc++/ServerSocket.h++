@@ -44,7 +44,9 @@ class COMMONCPP_API ServerSocket : public Socket
   /**
    * Construct a new ServerSocket that will listen on the given port.
    *
-   * @param port The port number to listen on.
+   * @param port The port number to listen on, or 0 to have the system
+   * assign one, which can be obtained from <b>getLocalAddress()</b> once
+   * the socket has been initialized.
    * @param backlog The size of the connection backlog.
    */
   ServerSocket(uint16_t port, uint_t backlog = 3);
@@ -53,7 +55,9 @@ class COMMONCPP_API ServerSocket : public Socket
    * Construct a new ServerSocket that will listen on the given port and
    * network interface.
    *
-   * @param port The port number to listen on.
+   * @param port The port number to listen on, or 0 to have the system
+   * assign one, which can be obtained from <b>getLocalAddress()</b> once
+   * the socket has been initialized.
    * @param ixface The network interface to listen on.
    * @param backlog The size of the connection backlog.
    */
@@ -0,0 +1,172 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_SharedMemoryChannel_hxx
+#define __ccxx_SharedMemoryChannel_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/IOException.h++>
+#include <commonc++/Permissions.h++>
+#include <commonc++/SharedMemoryBlock.h++>
+#include <commonc++/String.h++>
+#include <commonc++/SystemException.h++>
+
+namespace ccxx {
+
+/**
+ * A message channel between (not necessarily related) processes,
+ * implemented as a lock-free ring of fixed-size message slots in a
+ * SharedMemoryBlock. Any number of processes may send and receive
+ * messages on the channel; messages are delivered in FIFO order, each
+ * to exactly one receiver.
+ *
+ * Sending a message involves no system calls unless a receiver is
+ * blocked waiting for data, in which case it is woken up (via a futex
+ * on Linux). Processes rendezvous on the channel by name, in the same
+ * way as with Semaphore; the first process to initialize the channel
+ * creates and formats the shared memory segment.
+ *
+ * A SharedMemoryChannel must be initialized before it can be used, via
+ * a call to the init() method.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API SharedMemoryChannel
+{
+ public:
+
+  /**
+   * Construct a new SharedMemoryChannel.
+   *
+   * @param name The name of the channel. For maximal portability, the
+   * name should consist of at most 14 alphanumeric characters and should
+   * not contain slashes.
+   * @param capacity The maximum number of messages that can be queued in
+   * the channel at any given time. This value will be rounded up to the
+   * nearest power of 2.
+   * @param maxMessageSize The maximum size of a message, in bytes.
+   * @param perm The permissions with which to create the channel, if it
+   * does not exist at the time of the <b>init()</b>.
+   */
+  SharedMemoryChannel(const String& name, uint_t capacity,
+                      size_t maxMessageSize,
+                      const Permissions& perm
+                      = Permissions::USER_READ_WRITE);
+
+  /** Destructor. Detaches from the channel. */
+  ~SharedMemoryChannel();
+
+  /**
+   * Initialize the channel. If the underlying shared memory segment
+   * did not yet exist, it is created and formatted.
+   *
+   * @throw SystemException If the operation fails, or if the channel
+   * already exists with a different capacity or maximum message size.
+   */
+  void init();
+
+  /**
+   * Send a message on the channel. The method does not block.
+   *
+   * @param buf The buffer containing the message.
+   * @param count The length of the message, in bytes.
+   * @return <b>true</b> if the message was enqueued, <b>false</b> if
+   * the channel is full, if the channel has not been initialized, or if
+   * <i>count</i> exceeds the maximum message size.
+   */
+  bool send(const byte_t* buf, size_t count);
+
+  /**
+   * Receive a message from the channel. If the channel is empty, the
+   * method blocks until a message becomes available.
+   *
+   * @param buf The buffer to receive the message into.
+   * @param count The size of the buffer. If the message is longer than
+   * this, the excess bytes are discarded.
+   * @return The number of bytes copied into the buffer.
+   * @throw SystemException If the channel has not been initialized.
+   */
+  size_t receive(byte_t* buf, size_t count);
+
+  /**
+   * Receive a message from the channel. If the channel is empty, the
+   * method blocks until a message becomes available or the timeout
+   * expires, whichever occurs first.
+   *
+   * @param buf The buffer to receive the message into.
+   * @param count The size of the buffer. If the message is longer than
+   * this, the excess bytes are discarded.
+   * @param timeout The timeout, in milliseconds.
+   * @return The number of bytes copied into the buffer.
+   * @throw TimeoutException If the operation timed out.
+   * @throw SystemException If the channel has not been initialized.
+   */
+  size_t tryReceive(byte_t* buf, size_t count, timespan_ms_t timeout = 0);
+
+  /**
+   * Get the number of messages currently queued in the channel. The
+   * value is approximate if other processes are concurrently using the
+   * channel.
+   */
+  uint_t getSize() const;
+
+  /** Test if the channel is empty. */
+  inline bool isEmpty() const
+  { return(getSize() == 0); }
+
+  /** Get the capacity of the channel, in messages. */
+  inline uint_t getCapacity() const
+  { return(_capacity); }
+
+  /** Get the maximum message size, in bytes. */
+  inline size_t getMaxMessageSize() const
+  { return(_maxMessageSize); }
+
+  /** Get the name of the channel. */
+  inline String getName() const
+  { return(_name); }
+
+ private:
+
+  struct Header;
+  struct Slot;
+
+  bool _dequeue(byte_t* buf, size_t& count);
+  bool _isReady() const;
+  void _wait(timespan_ms_t timeout);
+  void _notify();
+  Slot* _slotAt(uint32_t pos) const;
+
+  String _name;
+  uint_t _capacity;
+  size_t _maxMessageSize;
+  size_t _slotSize;
+  SharedMemoryBlock _block;
+  Header* _header;
+  byte_t* _slots;
+
+  CCXX_COPY_DECLS(SharedMemoryChannel);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_SharedMemoryChannel_hxx
@@ -0,0 +1,103 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_SignalNotifier_hxx
+#define __ccxx_SignalNotifier_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/Selectable.h++>
+#include <commonc++/SystemException.h++>
+
+namespace ccxx {
+
+/**
+ * A synchronous signal receiver that is delivered as an event source.
+ * Rather than interrupting an arbitrary thread with an asynchronous
+ * signal handler, the selected signals are blocked and queued, and
+ * <b>signalReceived()</b> is called for each one from the thread that
+ * services the notifier, typically a SocketSelector with which it has
+ * been registered.
+ * <p>
+ * Signal masks are per-thread and are inherited by new threads, so
+ * <b>init()</b> should be called from the main thread before any other
+ * threads are started; otherwise a thread that does not block the
+ * signals may receive them in the usual asynchronous way. The
+ * destructor discards any signals that are still pending and restores
+ * the signal mask that was in effect before <b>init()</b>; it should
+ * therefore be called from the same thread.
+ * <p>
+ * <b>NOTE</b>: This class is currently only implemented on Linux, where it
+ * is backed by a <i>signalfd</i>.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API SignalNotifier : public Selectable
+{
+ public:
+
+  /** Destructor. */
+  virtual ~SignalNotifier();
+
+  /**
+   * Add a signal to the set of signals to be received. This method must
+   * be called before <b>init()</b>.
+   *
+   * @param signal The signal number.
+   */
+  void addSignal(int signal);
+
+  /**
+   * Initialize the notifier. Blocks the selected signals in the calling
+   * thread.
+   *
+   * @throw SystemException If an error occurs.
+   */
+  void init();
+
+  FileHandle getEventHandle() const;
+
+  void processEvents();
+
+ protected:
+
+  /** Construct a new SignalNotifier. */
+  SignalNotifier();
+
+  /**
+   * Called when a signal is received.
+   *
+   * @param signal The signal number.
+   */
+  virtual void signalReceived(int signal) = 0;
+
+ private:
+
+  uint64_t _signals;
+  uint64_t _unblock;
+  FileHandle _handle;
+
+  CCXX_COPY_DECLS(SignalNotifier);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_SignalNotifier_hxx
@@ -27,12 +27,17 @@
 #include <commonc++/AtomicCounter.h++>
 #include <commonc++/CircularBuffer.h++>
 #include <commonc++/CriticalSection.h++>
+#include <commonc++/EventHandler.h++>
+#include <commonc++/FlowControl.h++>
+#include <commonc++/Histogram.h++>
 #include <commonc++/Iterator.h++>
 #include <commonc++/StaticObjectPool.h++>
 #include <commonc++/ServerSocket.h++>
 #include <commonc++/StreamSocket.h++>
 #include <commonc++/Thread.h++>
+#include <commonc++/TokenBucket.h++>
 #include <commonc++/Mutex.h++>
+#include <commonc++/Selectable.h++>
 
 #ifdef CCXX_OS_POSIX
 #include <sys/select.h>
@@ -42,6 +47,51 @@ namespace ccxx {
 
 class SocketSelector;
 
+/**
+ * I/O statistics for a Connection. These are maintained only while
+ * statistics collection is enabled on the owning SocketSelector. All
+ * times are in microseconds.
+ *
+ * @author Mark Lindner
+ */
+struct COMMONCPP_API ConnectionStats
+{
+  /** Constructor. */
+  ConnectionStats()
+  { reset(); }
+
+  /** Reset all counters to 0. */
+  void reset();
+
+  /** The number of bytes received. */
+  uint64_t bytesReceived;
+  /** The number of bytes sent. */
+  uint64_t bytesSent;
+  /** The number of times <b>SocketSelector::dataReceived()</b> was called. */
+  uint64_t messagesReceived;
+  /** The number of writes that were enqueued on the connection. */
+  uint64_t messagesSent;
+  /** The total time spent in selector callbacks for the connection. */
+  uint64_t callbackTime;
+  /**
+   * The total time between the connection becoming readable and
+   * <b>SocketSelector::dataReceived()</b> being called for it.
+   */
+  uint64_t dispatchDelay;
+  /**
+   * The total time that data spent queued in the write buffer before the
+   * buffer was drained.
+   */
+  uint64_t writeQueueTime;
+  /** The number of times the read high-water mark was reached. */
+  uint_t readHighWaterHits;
+  /**
+   * The number of times the write high-water mark was reached, or a
+   * write was rejected because the write buffer was full.
+   */
+  uint_t writeHighWaterHits;
+};
+
 /**
  * An abstract object representing a network connection. It holds a
  * reference to a connected <b>StreamSocket</b>, and is intended to be
@@ -199,6 +249,31 @@ class COMMONCPP_API Connection
    */
   bool isReadHigh() const;
 
+  /**
+   * Limit the rate at which data is read from the connection. While the
+   * connection's allowance is used up, the SocketSelector stops reading
+   * from it. This method may be called from any thread; it holds the
+   * selector's lock while the limit is changed.
+   *
+   * @param bytesPerSecond The maximum sustained read rate, in bytes per
+   * second, or 0 for no limit.
+   * @param burst The maximum number of bytes that may be read at once
+   * after a quiet period; if 0, <i>bytesPerSecond</i> is used.
+   */
+  void setReadRateLimit(uint_t bytesPerSecond, uint_t burst = 0);
+
+  /**
+   * Set a flow control for the connection. While the flow control
+   * reports that it is congested, the SocketSelector stops reading from
+   * the connection, in the same way as when the read high-water mark is
+   * reached. This allows, for example, a full downstream BoundedQueue to
+   * push back on the peer.
+   *
+   * @param flowControl The flow control, or <b>NULL</b> for none.
+   */
+  inline void setFlowControl(const FlowControl* flowControl)
+  { _flowControl = flowControl; }
+
   /**
    * Set the write low-water mark for the connection. If the amount
    * of data queued in the output buffer drops below the high-water
@@ -292,6 +367,48 @@ class COMMONCPP_API Connection
   /** Test if a close is pending on the connection. */
   bool isClosePending() const;
 
+  /**
+   * Get a snapshot of the I/O statistics for the connection. The counters
+   * are updated by the selector thread and by writers, so a copy is
+   * returned.
+   *
+   * @see SocketSelector::setStatsEnabled()
+   */
+  ConnectionStats getStats() const;
+
+  /**
+   * Register a handler to be invoked once at least <i>count</i> bytes
+   * are available to be read on the connection. While a read handler is
+   * registered, it is invoked in place of
+   * <b>SocketSelector::dataReceived()</b> for the connection. The handler
+   * is invoked once, from the selector thread, with <b>true</b>; or with
+   * <b>false</b> if the connection is closed first. This method may be
+   * called from any thread; it holds the selector's lock while the
+   * handler is registered.
+   *
+   * @param count The number of bytes to wait for.
+   * @param handler The handler to invoke.
+   * @return <b>true</b> if the handler was registered, <b>false</b> if
+   * a read handler is already registered, or if <i>count</i> exceeds the
+   * read high-water mark.
+   */
+  bool awaitRead(size_t count, EventHandler<bool>* handler);
+
+  /**
+   * Register a handler to be invoked once there is room for at least
+   * <i>count</i> bytes in the write buffer. The handler is invoked once,
+   * from the selector thread, with <b>true</b>; or with <b>false</b> if
+   * the connection is closed first. This method may be called from any
+   * thread; it holds the selector's lock while the handler is registered.
+   *
+   * @param count The number of bytes to wait for.
+   * @param handler The handler to invoke.
+   * @return <b>true</b> if the handler was registered, <b>false</b> if
+   * a write handler is already registered, or if <i>count</i> exceeds the
+   * size of the write buffer.
+   */
+  bool awaitWrite(size_t count, EventHandler<bool>* handler);
+
  protected:
 
   /**
@@ -303,11 +420,13 @@ class COMMONCPP_API Connection
 
  private:
 
-  void read();
+  size_t read(size_t limit);
   void readOOB();
-  void write();
+  size_t write();
 
   void attach(SocketSelector* selector, StreamSocket* socket);
+  void _wrote(bool accepted);
+  bool _isStatsEnabled() const;
 
   inline void setOOBFlag(bool flag)
   {  _oobFlag = flag; }
@@ -333,8 +452,22 @@ class COMMONCPP_API Connection
   bool _closePending;
   byte_t _oobData;
   time_ms_t _lastRecv;
+  int64_t _writeQueuedAt;
+  ConnectionStats _stats;
+  Connection* _idlePrev;
+  Connection* _idleNext;
+  bool _idleExpired;
+  EventHandler<bool>* _readHandler;
+  size_t _readWant;
+  EventHandler<bool>* _writeHandler;
+  size_t _writeWant;
+  bool _connecting;
+  time_ms_t _connectDeadline;
+  TokenBucket _readBucket;
+  const FlowControl* _flowControl;
   mutable CriticalSection _readLock;
   mutable CriticalSection _writeLock;
+  mutable CriticalSection _statsLock;
   static const bool _isSameEndianness;
 
   CCXX_COPY_DECLS(Connection);
@@ -345,11 +478,21 @@ class COMMONCPP_API Connection
  * pattern; the various connection event handlers are called when
  * the corresponding I/O events occur on the sockets being managed
  * by the selector. A selector must run in its own thread.
+ * <p>
+ * Idle connections are kept in order of their idle deadlines, so
+ * finding the connections that have timed out, and computing how long
+ * to wait for I/O, costs time proportional to the number of connections
+ * that are expiring. The selector is built on <b>select()</b>, however,
+ * so each pass of the event loop still builds the descriptor sets from,
+ * and checks the readiness of, every connection; it is not intended for
+ * more connections than <b>select()</b> can handle efficiently.
  *
  * @author Mark Lindner
  */
 class COMMONCPP_API SocketSelector : public Thread
 {
+  friend class Connection;
+
  public:
 
   /**
@@ -391,6 +534,35 @@ class COMMONCPP_API SocketSelector : public Thread
    */
   virtual bool init(ServerSocket* socket);
 
+  /**
+   * Initialize the selector without a server socket. Such a selector
+   * manages only outbound connections, which are added with
+   * <b>connect()</b>.
+   *
+   * @return <b>true</b> on success, <b>false</b> otherwise.
+   */
+  virtual bool init();
+
+  /**
+   * Begin a non-blocking connect to a remote peer, and add the connection
+   * to the selector. The selector invokes <b>connectionEstablished()</b>
+   * once the connect completes, or <b>connectionFailed()</b> if it fails
+   * or does not complete within the timeout. This method may be called
+   * from any thread.
+   *
+   * @param address The address of the remote peer.
+   * @param connection The connection object for the new connection.
+   * @param timeout The connect timeout, in milliseconds, or 0 for no
+   * timeout.
+   * @return <b>true</b> if the connect is in progress, <b>false</b> if it
+   * could not be started, either because the selector is already managing
+   * its maximum number of connections, or because the connect failed
+   * immediately. In the latter case no callback is invoked, and the
+   * caller retains ownership of the connection object.
+   */
+  bool connect(const SocketAddress& address, Connection* connection,
+               timespan_ms_t timeout = 0);
+
   /**
    * Write a block of data to all active connections.
    *
@@ -401,6 +573,116 @@ class COMMONCPP_API SocketSelector : public Thread
    */
   uint_t writeAll(const byte_t* buf, size_t count);
 
+  /**
+   * Enable or disable the collection of I/O statistics. When enabled,
+   * the selector maintains a ConnectionStats for each connection, and
+   * selector-wide histograms of callback times, dispatch delays and
+   * write-queue times. Collection is disabled by default, since it
+   * costs a few clock reads per I/O event.
+   *
+   * @param enabled A flag indicating whether statistics should be
+   * collected.
+   */
+  inline void setStatsEnabled(bool enabled)
+  { _statsEnabled = enabled; }
+
+  /** Test if I/O statistics collection is enabled. */
+  inline bool isStatsEnabled() const
+  { return(_statsEnabled); }
+
+  /**
+   * Get the histogram of time spent in the selector callbacks, in
+   * microseconds, across all connections.
+   */
+  inline const Histogram& getCallbackTimeHistogram() const
+  { return(_callbackTimes); }
+
+  /**
+   * Get the histogram of time between a connection becoming readable
+   * and <b>dataReceived()</b> being called for it, in microseconds,
+   * across all connections.
+   */
+  inline const Histogram& getDispatchDelayHistogram() const
+  { return(_dispatchDelays); }
+
+  /**
+   * Get the histogram of time that data spent in connection write
+   * buffers before being drained, in microseconds, across all
+   * connections.
+   */
+  inline const Histogram& getWriteQueueTimeHistogram() const
+  { return(_writeQueueTimes); }
+
+  /** Reset the selector-wide statistics histograms. */
+  void resetStats();
+
+  /**
+   * Limit the aggregate rate at which data is read from all connections.
+   * While the allowance is used up, the selector stops reading. This
+   * method may be called from any thread.
+   *
+   * @param bytesPerSecond The maximum sustained read rate, in bytes per
+   * second, or 0 for no limit.
+   * @param burst The maximum number of bytes that may be read at once
+   * after a quiet period; if 0, <i>bytesPerSecond</i> is used.
+   */
+  void setReadRateLimit(uint_t bytesPerSecond, uint_t burst = 0);
+
+  /**
+   * Set the read quantum: the maximum number of bytes that will be read
+   * from any one connection per pass through the selector loop. The
+   * order in which connections are serviced is also rotated on each
+   * pass, so a busy connection cannot starve the others.
+   *
+   * @param quantum The quantum, in bytes, or 0 for no limit (the
+   * default).
+   */
+  inline void setReadQuantum(size_t quantum)
+  { _readQuantum = quantum; }
+
+  /** Get the read quantum. */
+  inline size_t getReadQuantum() const
+  { return(_readQuantum); }
+
+  /**
+   * Schedule a handler to be invoked by the selector thread after the
+   * given delay. The handler is invoked once, with <b>true</b>; or with
+   * <b>false</b> if the selector shuts down first. This method may be
+   * called from any thread.
+   *
+   * @param delay The delay, in milliseconds.
+   * @param handler The handler to invoke.
+   */
+  void schedule(timespan_ms_t delay, EventHandler<bool>* handler);
+
+  /**
+   * Register an event source with the selector. The selector waits on the
+   * source's event handle along with its sockets, and calls
+   * <b>processEvents()</b> on the source from the selector thread
+   * whenever the handle is readable. This allows notifiers, timers,
+   * signal receivers and directory watchers to share the selector's
+   * thread rather than each requiring one of their own. This method may
+   * be called from any thread.
+   *
+   * @param source The event source, which must already be initialized.
+   * The selector does not take ownership of the source.
+   * @return <b>true</b> if the source was registered, <b>false</b> if it
+   * is already registered, if it has no valid event handle, or if event
+   * sources are not supported on this platform.
+   */
+  bool addEventSource(Selectable* source);
+
+  /**
+   * Unregister an event source from the selector. This method may be
+   * called from any thread, including from within the source's own
+   * <b>processEvents()</b>.
+   *
+   * @param source The event source.
+   * @return <b>true</b> if the source was unregistered, <b>false</b> if
+   * it was not registered.
+   */
+  bool removeEventSource(Selectable* source);
+
  protected:
 
   /**
@@ -414,6 +696,26 @@ class COMMONCPP_API SocketSelector : public Thread
    */
   virtual Connection* connectionReady(const SocketAddress& address) = 0;
 
+  /**
+   * This method is called when an outbound connection that was begun
+   * with <b>connect()</b> has been established. The default
+   * implementation does nothing.
+   *
+   * @param connection The connection.
+   */
+  virtual void connectionEstablished(Connection* connection);
+
+  /**
+   * This method is called when an outbound connection that was begun
+   * with <b>connect()</b> could not be established, either because the
+   * connect failed or because it timed out. The method should delete the
+   * connection object before returning. The default implementation calls
+   * <b>connectionClosed()</b>.
+   *
+   * @param connection The connection.
+   */
+  virtual void connectionFailed(Connection* connection);
+
   /**
    * This method is called when data has been received on the connection.
    * It is called only when the total number of bytes available to read
@@ -462,7 +764,9 @@ class COMMONCPP_API SocketSelector : public Thread
 
   /**
    * This method is called when an exception occurs during I/O. The
-   * default implementation closes the connection.
+   * default implementation closes the connection. A connection that is
+   * closed here is removed from the selector, and
+   * <b>connectionClosed()</b> is then called for it.
    *
    * @param connection The connection.
    * @param ex The exception that occurred.
@@ -479,11 +783,38 @@ class COMMONCPP_API SocketSelector : public Thread
 
   void _connectionTimedOut(Connection* connection);
   void _connectionClosed(Connection* connection);
+  void _connectionFailed(Connection* connection);
+  void _recordCallback(Connection* connection, int64_t start);
+  void _idleLink(Connection* connection);
+  void _idleUnlink(Connection* connection);
+  void _expireIdle(time_ms_t now);
+  timespan_ms_t _nextWait(time_ms_t now) const;
+  void _runTimers(time_ms_t now);
+  void _dispatchHandlers(Connection* connection);
+  void _cancelHandlers(Connection* connection);
+  bool _isReadAllowed(Connection* connection, time_ms_t now);
+  bool _getReadBudget(Connection* connection, time_ms_t now, size_t& budget);
+
+  class TimerQueue; // fwd decl
+  class SourceList; // fwd decl
 
   Mutex _mutex;
   StaticObjectPool<StreamSocket> _pool;
   timespan_ms_t _idleLimit;
   ServerSocket* _ssock;
+  bool _initialized;
+  time_ms_t _connectDeadline;
+  time_ms_t _throttleDeadline;
+  TokenBucket _readBucket;
+  size_t _readQuantum;
+  Connection* _idleHead;
+  Connection* _idleTail;
+  TimerQueue* _timers;
+  SourceList* _sources;
+  bool _statsEnabled;
+  Histogram _callbackTimes;
+  Histogram _dispatchDelays;
+  Histogram _writeQueueTimes;
 #ifndef CCXX_OS_WINDOWS
   int _wakePipe[2];
   AtomicCounter _wakeFlag;
@@ -59,6 +59,7 @@ enum SeekMode {
  */
 class COMMONCPP_API Stream
 {
+  friend class BlockReader;
   friend class Process;
 
  public:
@@ -55,6 +55,26 @@ class COMMONCPP_API StreamSocket : public Stream, public Socket
   void connect(const String& addr, uint16_t port);
   void connect(const SocketAddress& addr);
 
+  /**
+   * Begin a non-blocking connect to the given address. The socket must
+   * be in non-blocking mode. If the connect does not complete
+   * immediately, the socket becomes writable when it does, at which
+   * point <b>finishConnect()</b> must be called.
+   *
+   * @param addr The address to connect to.
+   * @return <b>true</b> if the connect completed immediately, <b>false</b>
+   * if it is in progress.
+   * @throw IOException If the connect fails.
+   */
+  bool beginConnect(const SocketAddress& addr);
+
+  /**
+   * Complete a connect that was begun with <b>beginConnect()</b>.
+   *
+   * @throw IOException If the connect failed.
+   */
+  void finishConnect();
+
   size_t read(byte_t* buffer, size_t buflen);
   size_t write(const byte_t* buffer, size_t buflen);
 
@@ -111,6 +131,7 @@ class COMMONCPP_API StreamSocket : public Stream, public Socket
  private:
 
   void setSocketHandle(SocketHandle handle);
+  void _completeConnect();
 
   CCXX_COPY_DECLS(StreamSocket);
 };
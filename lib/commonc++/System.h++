@@ -48,6 +48,13 @@ class COMMONCPP_API System
   /** Get the system time, in milliseconds since the epoch. */
   static time_ms_t currentTimeMillis();
 
+  /**
+   * Get the current value of the system's high-resolution monotonic
+   * clock, in nanoseconds. The value has no relation to the wall-clock
+   * time, and is only meaningful for measuring elapsed time.
+   */
+  static int64_t nanoTime();
+
   /**
    * Set the system time. On most platforms, superuser or administrator
    * privileges are required to set the system time.
@@ -33,6 +33,28 @@
 
 namespace ccxx {
 
+/** Kinds of storage for a TempFile. */
+enum TempFileMode {
+  /**
+   * A file with a (randomly generated) name in the filesystem.
+   */
+  TempFileNamed,
+  /**
+   * A file on disk without any directory entry, which is not visible in
+   * the filesystem unless and until it is linked. Requires
+   * <code>O_TMPFILE</code> support from the host system and the file
+   * system; otherwise a named file is used instead.
+   */
+  TempFileAnonymous,
+  /**
+   * A file that resides purely in memory and has no presence in the
+   * filesystem. Requires <code>memfd_create()</code> support from the host
+   * system; otherwise an anonymous file, or failing that a named file, is
+   * used instead.
+   */
+  TempFileMemory
+};
+
 /**
  * A temporary file that may optionally "shadow" another file.
  * <p>
@@ -44,6 +66,11 @@ namespace ccxx {
  * If constructed without a path, the temporary file will be created
  * in the host platform's designated temporary directory; when the
  * file is closed, it will be deleted.
+ * <p>
+ * By default the temporary file is an ordinary named file. Anonymous and
+ * memory-backed files avoid the cost of creating and removing directory
+ * entries, and are never visible in the filesystem while they are being
+ * written; see TempFileMode.
  *
  * @author Mark Lindner
  */
@@ -55,8 +82,11 @@ class COMMONCPP_API TempFile : public Stream
    * Construct a new TempFile.
    *
    * @param path The path to the file being shadowed, if any.
+   * @param mode The kind of storage for the file. Memory-backed files
+   * cannot shadow another file.
    */
-  TempFile(const String& path = String::null);
+  TempFile(const String& path = String::null,
+           TempFileMode mode = TempFileNamed);
 
   /** Destructor. */
   ~TempFile();
@@ -64,10 +94,46 @@ class COMMONCPP_API TempFile : public Stream
   /**
    * Create and open the TempFile.
    *
+   * @throw UnsupportedOperationException If a memory-backed file was
+   * requested for a file that shadows another file.
    * @throw IOException If the file could not be created and/or opened.
    */
   void open();
 
+  /**
+   * Give the open temporary file a (further) name in the filesystem, by
+   * creating a hard link to it. For an anonymous file, this makes the
+   * completely written file visible at once.
+   *
+   * @param path The path of the new link, which must be in the same
+   * filesystem as the temporary file, and must not exist.
+   * @throw UnsupportedOperationException If the file is memory-backed, or
+   * if hard links are not supported on this platform.
+   * @throw IOException If the file is not open, or the link could not be
+   * created.
+   */
+  void link(const String& path);
+
+  /**
+   * Seal a memory-backed file, so that its contents and size can no
+   * longer be modified by anyone, including other processes with which
+   * the file handle is shared.
+   *
+   * @throw UnsupportedOperationException If the file is not memory-backed.
+   * @throw IOException If the file is not open, or the seals could not be
+   * applied, for example because the file is mapped writable.
+   */
+  void seal();
+
+  /**
+   * Get the kind of storage of the file. Once the file has been opened,
+   * this reflects the storage actually used, which may differ from that
+   * requested if the host system does not support it. Reopening the file
+   * tries the requested kind of storage again.
+   */
+  inline TempFileMode getMode() const
+  { return(_actualMode); }
+
   /**
    * Close (and delete) the temporary file. If the temporary file is shadowing
    * another file, its contents are copied to that file before the temporary
@@ -77,9 +143,14 @@ class COMMONCPP_API TempFile : public Stream
 
  private:
 
+  void _openNamed(const String& dir);
+  bool _openAnonymous(const String& dir);
+  bool _openMemory();
+
   String _path;
   String _tempPath;
-  FileHandle _handle;
+  TempFileMode _mode;
+  TempFileMode _actualMode;
 
   CCXX_COPY_DECLS(TempFile);
 };
@@ -0,0 +1,101 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_TimerNotifier_hxx
+#define __ccxx_TimerNotifier_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/Selectable.h++>
+#include <commonc++/SystemException.h++>
+
+namespace ccxx {
+
+/**
+ * A kernel-backed timer that is delivered as an event source. The timer
+ * is serviced by whichever thread services its event handle, typically
+ * a SocketSelector with which it has been registered, and so needs no
+ * thread of its own. Periodic expirations that occur before the timer
+ * is serviced are coalesced into a single call to <b>timerExpired()</b>.
+ * <p>
+ * <b>NOTE</b>: This class is currently only implemented on Linux, where it
+ * is backed by a <i>timerfd</i>.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API TimerNotifier : public Selectable
+{
+ public:
+
+  /** Destructor. */
+  virtual ~TimerNotifier();
+
+  /**
+   * Initialize the timer.
+   *
+   * @throw SystemException If an error occurs.
+   */
+  void init();
+
+  /**
+   * Start (or restart) the timer.
+   *
+   * @param delay The delay until the first expiration, in milliseconds.
+   * @param interval The interval between subsequent expirations, in
+   * milliseconds, or 0 for a one-shot timer.
+   * @throw SystemException If an error occurs.
+   */
+  void start(timespan_ms_t delay, timespan_ms_t interval = 0);
+
+  /**
+   * Stop the timer.
+   *
+   * @throw SystemException If an error occurs.
+   */
+  void stop();
+
+  FileHandle getEventHandle() const;
+
+  void processEvents();
+
+ protected:
+
+  /** Construct a new TimerNotifier. */
+  TimerNotifier();
+
+  /**
+   * Called when the timer expires.
+   *
+   * @param count The number of expirations since the timer was last
+   * serviced; greater than 1 only for periodic timers.
+   */
+  virtual void timerExpired(uint64_t count) = 0;
+
+ private:
+
+  FileHandle _handle;
+
+  CCXX_COPY_DECLS(TimerNotifier);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_TimerNotifier_hxx
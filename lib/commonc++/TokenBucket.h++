@@ -0,0 +1,118 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_TokenBucket_hxx
+#define __ccxx_TokenBucket_hxx
+
+#include <commonc++/Common.h++>
+
+namespace ccxx {
+
+/**
+ * A token-bucket rate limiter. Tokens accrue at a fixed rate, up to a
+ * maximum (the burst size); an operation may proceed only by consuming
+ * tokens. The bucket is refilled lazily from the supplied clock
+ * readings, so it costs nothing while it is not in use.
+ *
+ * The class is not threadsafe.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API TokenBucket
+{
+ public:
+
+  /**
+   * Construct a new TokenBucket. The bucket starts out full.
+   *
+   * @param rate The rate at which tokens accrue, per second, or 0 for
+   * no limit.
+   * @param burst The maximum number of tokens the bucket can hold. If 0,
+   * the rate is used.
+   */
+  TokenBucket(uint_t rate = 0, uint_t burst = 0);
+
+  /** Destructor. */
+  ~TokenBucket();
+
+  /**
+   * Change the rate and burst size. The bucket is refilled to the new
+   * burst size.
+   *
+   * @param rate The rate at which tokens accrue, per second, or 0 for
+   * no limit.
+   * @param burst The maximum number of tokens the bucket can hold. If 0,
+   * the rate is used.
+   */
+  void setRate(uint_t rate, uint_t burst = 0);
+
+  /** Get the rate at which tokens accrue, per second. */
+  inline uint_t getRate() const
+  { return(_rate); }
+
+  /** Get the maximum number of tokens the bucket can hold. */
+  inline uint_t getBurst() const
+  { return(_burst); }
+
+  /** Test if the bucket imposes a limit. */
+  inline bool isLimited() const
+  { return(_rate > 0); }
+
+  /**
+   * Get the number of tokens that are currently available.
+   *
+   * @param now The current time, in milliseconds.
+   * @return The number of available tokens.
+   */
+  uint_t getAvailable(time_ms_t now);
+
+  /**
+   * Consume tokens. If fewer tokens are available, the bucket is
+   * emptied.
+   *
+   * @param count The number of tokens to consume.
+   */
+  void consume(uint_t count);
+
+  /**
+   * Get the time until a given number of tokens will be available.
+   *
+   * @param now The current time, in milliseconds.
+   * @param count The number of tokens.
+   * @return The delay, in milliseconds; 0 if the tokens are available
+   * now.
+   */
+  timespan_ms_t getDelay(time_ms_t now, uint_t count = 1);
+
+ private:
+
+  void _refill(time_ms_t now);
+
+  uint_t _rate;
+  uint_t _burst;
+  uint64_t _tokens; // in thousandths of a token
+  time_ms_t _last;
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_TokenBucket_hxx
@@ -0,0 +1,259 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2014  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+*/
+
+#ifndef __ccxx_WindowedMappedFile_hxx
+#define __ccxx_WindowedMappedFile_hxx
+
+#include <commonc++/Common.h++>
+#include <commonc++/IOException.h++>
+#include <commonc++/Mutex.h++>
+#include <commonc++/OutOfBoundsException.h++>
+#include <commonc++/Permissions.h++>
+
+#include <map>
+
+namespace ccxx {
+
+/**
+ * A memory-mapped file which is mapped in fixed-size, aligned windows on
+ * demand, rather than all at once. At most a fixed number of windows are
+ * kept mapped; when a new window is needed, the least recently used window
+ * that is not in use is unmapped. This allows files much larger than the
+ * available address space to be read and written at memory-mapped speed,
+ * with bounded memory usage.
+ *
+ * Mapped memory is accessed through View objects, which keep the
+ * underlying window mapped for as long as they exist. Each window maps
+ * twice the window size (or up to the end of the file), so a view of up
+ * to one window size in length never straddles two mappings.
+ *
+ * The class is thread-safe, though data accessed through views is not
+ * synchronized.
+ *
+ * @author Mark Lindner
+ */
+class COMMONCPP_API WindowedMappedFile
+{
+ private:
+
+  struct Window; // fwd decl
+
+ public:
+
+  /**
+   * A view of a range of a WindowedMappedFile. The memory is guaranteed
+   * to remain mapped for the lifetime of the view.
+   *
+   * @author Mark Lindner
+   */
+  class COMMONCPP_API View
+  {
+   public:
+
+    /**
+     * Construct a new View of a range of the given file, mapping the
+     * window that contains it if necessary.
+     *
+     * @param file The file.
+     * @param offset The offset of the start of the range.
+     * @param length The length of the range. Must not exceed the window
+     * size of the file.
+     * @throw OutOfBoundsException If the range extends past the end of
+     * the file or is longer than the window size.
+     * @throw IOException If the file is not open, or if the mapping
+     * operation failed.
+     */
+    View(WindowedMappedFile& file, uint64_t offset, size_t length);
+
+    /** Destructor. Releases the window. */
+    ~View();
+
+    /** Get a pointer to the start of the range. */
+    inline byte_t* getData()
+    { return(_data); }
+
+    /** Get a pointer to the start of the range. */
+    inline const byte_t* getData() const
+    { return(_data); }
+
+    /** Get the offset of the range within the file. */
+    inline uint64_t getOffset() const
+    { return(_offset); }
+
+    /** Get the length of the range. */
+    inline size_t getLength() const
+    { return(_length); }
+
+   private:
+
+    WindowedMappedFile& _file;
+    Window* _window;
+    byte_t* _data;
+    uint64_t _offset;
+    size_t _length;
+
+    CCXX_COPY_DECLS(View);
+  };
+
+  /**
+   * Construct a new WindowedMappedFile for the given path.
+   *
+   * @param path The path of the file to be mapped.
+   * @param windowSize The window size, in bytes. It will be rounded up to
+   * a multiple of the system's mapping granularity.
+   * @param maxWindows The maximum number of windows to keep mapped. This
+   * limit is exceeded only while more views are in use at once than there
+   * are windows.
+   */
+  WindowedMappedFile(const String& path,
+                     size_t windowSize = DEFAULT_WINDOW_SIZE,
+                     uint_t maxWindows = DEFAULT_MAX_WINDOWS);
+
+  /** Destructor. Unmaps all windows and closes the file. */
+  ~WindowedMappedFile();
+
+  /**
+   * Open the file. Zero-length files cannot be mapped.
+   *
+   * @param readOnly A flag indicating whether the file should be mapped
+   * read-only or read-write.
+   * @throw IOException If the file has a length of 0, or if it could not
+   * be opened.
+   */
+  void open(bool readOnly = false);
+
+  /**
+   * Create the file, or truncate it if it already exists, and allocate
+   * storage for it.
+   *
+   * @param size The size of the file.
+   * @param perm The permissions for the file.
+   * @throw IOException If the size is 0, or if the file could not be
+   * created or allocated.
+   */
+  void create(uint64_t size,
+              const Permissions& perm = Permissions::USER_READ_WRITE);
+
+  /**
+   * Unmap all windows and close the file. Any views of the file must have
+   * been destroyed beforehand.
+   */
+  void close();
+
+  /**
+   * Synchronize the in-memory state of all mapped windows with the file
+   * on disk.
+   *
+   * @param async A flag indicating whether the sync operation should occur
+   * asynchronously.
+   * @throw IOException If an I/O error occurs.
+   */
+  void sync(bool async = false);
+
+  /**
+   * Read data from the file, mapping windows as needed.
+   *
+   * @param offset The offset in the file to read from.
+   * @param buf The buffer to read into.
+   * @param count The number of bytes to read.
+   * @return The number of bytes read, which is less than <i>count</i> only
+   * if the end of the file was reached.
+   * @throw IOException If the file is not open, or if the mapping
+   * operation failed.
+   */
+  size_t read(uint64_t offset, byte_t* buf, size_t count);
+
+  /**
+   * Write data to the file, mapping windows as needed. The file is not
+   * extended.
+   *
+   * @param offset The offset in the file to write to.
+   * @param buf The buffer to write from.
+   * @param count The number of bytes to write.
+   * @return The number of bytes written, which is less than <i>count</i>
+   * only if the end of the file was reached.
+   * @throw IOException If the file is not open or is read-only, or if the
+   * mapping operation failed.
+   */
+  size_t write(uint64_t offset, const byte_t* buf, size_t count);
+
+  /** Determine if the file is open. */
+  inline bool isOpen() const
+  { return(_open); }
+
+  /** Determine if the file is mapped read-only. */
+  inline bool isReadOnly() const
+  { return(_readOnly); }
+
+  /** Get the size of the file, in bytes. */
+  inline uint64_t getSize() const
+  { return(_size); }
+
+  /** Get the window size, in bytes. */
+  inline size_t getWindowSize() const
+  { return(_windowSize); }
+
+  /** Get the maximum number of windows that are kept mapped. */
+  inline uint_t getMaxWindows() const
+  { return(_maxWindows); }
+
+  /** Get the number of windows that are currently mapped. */
+  uint_t getWindowCount() const;
+
+  /** The default window size (4 MB). */
+  static const size_t DEFAULT_WINDOW_SIZE;
+
+  /** The default maximum number of mapped windows. */
+  static const uint_t DEFAULT_MAX_WINDOWS;
+
+ private:
+
+  Window* _acquire(uint64_t offset);
+  void _release(Window* window);
+  void _unmap(Window* window);
+  void _trim();
+  void _unlink(Window* window);
+  void _link(Window* window);
+
+  String _path;
+  FileHandle _handle;
+#ifdef CCXX_OS_WINDOWS
+  HANDLE _memHandle;
+#endif
+  size_t _windowSize;
+  uint_t _maxWindows;
+  uint64_t _size;
+  bool _open;
+  bool _readOnly;
+
+  typedef std::map<uint64_t, Window*> WindowMap;
+  WindowMap _windows;
+  Window* _head;
+  Window* _tail;
+  mutable Mutex _lock;
+
+  CCXX_COPY_DECLS(WindowedMappedFile);
+};
+
+} // namespace ccxx
+
+#endif // __ccxx_WindowedMappedFile_hxx
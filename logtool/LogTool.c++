@@ -0,0 +1,133 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "LogTool.h++"
+
+#include <cstdio>
+
+#include <commonc++/BinaryLogReader.h++>
+#include <commonc++/DataFormatException.h++>
+#include <commonc++/IOException.h++>
+#include <commonc++/Logger.h++>
+#include <commonc++/Process.h++>
+
+namespace ccxx {
+namespace tools {
+
+/*
+ */
+
+LogTool::LogTool(int argc, char **argv,
+                 const String &version  /* = 1.0 */,
+                 const String &compileDate /* = "" */,
+                 const String &compileTime /* = "" */)
+  : Application(argc, argv, version, compileDate, compileTime),
+    _format("[%D %T] %F:%L %m"),
+    _exitStatus(ExitStatus::SUCCESS)
+{
+  registerOption('f', "format", "format",
+                 "Render records with log format @@ (see LogFormat).");
+
+  int index;
+
+  if(! parseOptions(argc, argv, index) || (index == argc))
+  {
+    printUsage();
+    exit(EXIT_FAILURE);
+  }
+
+  for(int i = index; i < argc; ++i)
+  {
+    if(! outputLog(argv[i]))
+      _exitStatus = ExitStatus::FAILURE;
+  }
+
+  std::fflush(stdout);
+}
+
+/*
+ */
+
+LogTool::~LogTool()
+{
+}
+
+/*
+ */
+
+bool LogTool::processOption(char opt, const String &longOpt,
+                            const String& arg)
+{
+  if((opt == 'f') || (longOpt == "format"))
+    _format = arg;
+  else
+    return(Application::processOption(opt, longOpt, arg));
+
+  return(true);
+}
+
+/*
+ */
+
+void LogTool::printUsage()
+{
+  Application::printUsage();
+}
+
+/*
+ */
+
+bool LogTool::outputLog(const String& file)
+{
+  BinaryLogReader reader(file, _format);
+  CharBuffer line(static_cast<uint_t>(Logger::LOG_BUFFER_SIZE));
+
+  try
+  {
+    reader.open();
+
+    while(reader.read(line))
+      std::fwrite(line.getPointer(), 1, line.getRemaining(), stdout);
+
+    reader.close();
+  }
+  catch(const IOException &ioex)
+  {
+    CString cstr_file = file.toUTF8();
+    CString cstr_msg = ioex.getMessage().toUTF8();
+    printError("Error reading log file: %s\n", cstr_file.data());
+    printError("%s\n", cstr_msg.data());
+    return(false);
+  }
+
+  if(reader.getUnknownSiteCount() > 0)
+  {
+    CString cstr_file = file.toUTF8();
+    printError("%s: %u record(s) with undefined sites were skipped\n",
+               cstr_file.data(), reader.getUnknownSiteCount());
+  }
+
+  return(true);
+}
+
+} // namespace tools
+} // namespace ccxx
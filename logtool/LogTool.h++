@@ -0,0 +1,64 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#ifndef __ccxx_LogTool_hxx
+#define __ccxx_LogTool_hxx
+
+#include <commonc++/Application.h++>
+#include <commonc++/String.h++>
+
+using ccxx::Application;
+using ccxx::String;
+
+namespace ccxx {
+namespace tools {
+
+class LogTool : public Application
+{
+  public:
+
+  LogTool(int argc, char** argv, const String& version = "1.0",
+          const String& compileDate = __DATE__,
+          const String& compileTime = __TIME__);
+  ~LogTool();
+
+  inline int getExitStatus() const
+  { return(_exitStatus); }
+
+  protected:
+
+  bool processOption(char opt, const String& longOpt, const String& arg);
+
+  void printUsage();
+
+  bool outputLog(const String& file);
+
+  private:
+
+  String _format;
+  int _exitStatus;
+};
+
+} // namespace tools
+} // namespace ccxx
+
+#endif // __ccxx_LogTool_hxx
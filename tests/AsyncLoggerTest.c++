@@ -0,0 +1,235 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "AsyncLoggerTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+#include "commonc++/ScopedLock.h++"
+
+#include <cstring>
+
+using namespace ccxx;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AsyncLoggerTest);
+
+/*
+ */
+
+bool CaptureLogger::write(CharBuffer& buffer)
+{
+  // records are written in batches, so count them by line
+
+  const char *p = buffer.getPointer();
+  const char *end = p + buffer.getRemaining();
+
+  ++writes;
+
+  for(; p < end; ++p)
+  {
+    if(*p == '\n')
+      ++lines;
+    else if((*p == '*') && (std::strncmp(p, "*** ", 4) == 0))
+    {
+      const char *start = p;
+
+      ++reports;
+      while((p < end) && (*p != '\n'))
+        ++p;
+
+      lastReport = String(start, 0, static_cast<uint_t>(p - start));
+    }
+  }
+
+  return(true);
+}
+
+/*
+ */
+
+bool CaptureLogger::writeOnCrash(CharBuffer& buffer)
+{
+  ++crashWrites;
+
+  return(write(buffer));
+}
+
+/*
+ */
+
+void LoggingThread::run()
+{
+  for(int i = 0; i < _count; ++i)
+    _logger->log(LogInfo, __FILE__, __LINE__, "record #%d", i);
+}
+
+/*
+ */
+
+CppUnit::Test *AsyncLoggerTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(AsyncLoggerTest);
+  CCXX_TESTSUITE_TEST(AsyncLoggerTest, testAsyncLogger);
+  CCXX_TESTSUITE_TEST(AsyncLoggerTest, testFlush);
+  CCXX_TESTSUITE_TEST(AsyncLoggerTest, testOverflow);
+  CCXX_TESTSUITE_TEST(AsyncLoggerTest, testFlushOnCrash);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void AsyncLoggerTest::setUp()
+{
+}
+
+/*
+ */
+
+void AsyncLoggerTest::tearDown()
+{
+}
+
+/*
+ */
+
+void AsyncLoggerTest::testAsyncLogger()
+{
+  CaptureLogger target;
+  AsyncLogger logger(&target);
+
+  logger.start();
+  CPPUNIT_ASSERT(logger.isRunning());
+
+  LoggingThread t1(&logger, 5000), t2(&logger, 5000), t3(&logger, 5000);
+  t1.start();
+  t2.start();
+  t3.start();
+
+  t1.join();
+  t2.join();
+  t3.join();
+
+  // stopping drains whatever is still buffered
+
+  logger.stop();
+  CPPUNIT_ASSERT(! logger.isRunning());
+
+  CPPUNIT_ASSERT_EQUAL(15000, target.lines);
+  CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(logger.getDropCount()));
+
+  // records should have been written in batches
+  CPPUNIT_ASSERT(target.writes < (target.lines / 10));
+}
+
+/*
+ */
+
+void AsyncLoggerTest::testFlush()
+{
+  CaptureLogger target;
+  AsyncLogger logger(&target);
+
+  for(int i = 0; i < 100; ++i)
+    logger.log(LogWarning, __FILE__, __LINE__, "record #%d", i);
+
+  CPPUNIT_ASSERT_EQUAL(0, target.lines);
+
+  logger.flush();
+
+  CPPUNIT_ASSERT_EQUAL(100, target.lines);
+  CPPUNIT_ASSERT_EQUAL(1, target.writes);
+
+  // disabled levels are filtered before formatting
+
+  target.disableLogLevel(LogDebug);
+  logger.log(LogDebug, __FILE__, __LINE__, "not logged");
+  logger.flush();
+
+  CPPUNIT_ASSERT_EQUAL(100, target.lines);
+}
+
+/*
+ */
+
+void AsyncLoggerTest::testOverflow()
+{
+  CaptureLogger target;
+
+  // with no writer running, the smallest ring fills up quickly
+
+  AsyncLogger logger(&target, 0, LogOverflowDropAndReport);
+
+  for(int i = 0; i < 1000; ++i)
+    logger.log(LogInfo, __FILE__, __LINE__, "record #%d", i);
+
+  int dropped = static_cast<int>(logger.getDropCount());
+  CPPUNIT_ASSERT(dropped > 0);
+
+  logger.flush();
+
+  CPPUNIT_ASSERT_EQUAL(1, target.reports);
+  CPPUNIT_ASSERT_EQUAL(1000 - dropped, target.lines);
+
+  // drops are only reported once
+
+  logger.flush();
+  CPPUNIT_ASSERT_EQUAL(1, target.reports);
+}
+
+/*
+ */
+
+void AsyncLoggerTest::testFlushOnCrash()
+{
+  CaptureLogger target;
+  CriticalSection lock;
+
+  AsyncLogger logger(&target, 0, LogOverflowDropAndReport, &lock);
+
+  for(int i = 0; i < 1000; ++i)
+    logger.log(LogInfo, __FILE__, __LINE__, "record #%d", i);
+
+  int dropped = static_cast<int>(logger.getDropCount());
+  CPPUNIT_ASSERT(dropped > 0);
+
+  // the crashing thread may hold the target lock; it is not taken
+
+  synchronized(lock)
+  {
+    logger.flushOnCrash();
+  }
+
+  CPPUNIT_ASSERT_EQUAL(1000 - dropped, target.lines);
+  CPPUNIT_ASSERT_EQUAL(1, target.reports);
+  CPPUNIT_ASSERT(target.crashWrites > 0);
+  CPPUNIT_ASSERT_EQUAL(target.writes, target.crashWrites);
+
+  // the report is formatted without snprintf()
+
+  String expected = "*** ";
+  expected << dropped << " log record(s) dropped ***";
+  CPPUNIT_ASSERT_EQUAL(expected, target.lastReport);
+}
@@ -0,0 +1,270 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "BinaryLogTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+#include "commonc++/BinaryFileLogger.h++"
+#include "commonc++/BinaryLogReader.h++"
+#include "commonc++/File.h++"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace ccxx;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BinaryLogTest);
+
+/*
+ */
+
+bool TextCaptureLogger::write(CharBuffer& buffer)
+{
+  text.append(buffer.getPointer(), buffer.getRemaining());
+
+  return(true);
+}
+
+/*
+ */
+
+static size_t __encode(char* buf, size_t size, const LogSite* site, ...)
+{
+  va_list vp;
+  va_start(vp, site);
+  size_t len = BinaryLogCodec::encodeRecord(buf, size, *site, LogInfo,
+                                            INT64_CONST(1234567890123), vp);
+  va_end(vp);
+
+  return(len);
+}
+
+/*
+ */
+
+static std::string __render(const char* buf, size_t len,
+                            const LogSite& site)
+{
+  uint32_t id;
+  LogLevel level;
+  time_ms_t time;
+  const char *args;
+  size_t argsLen;
+
+  CPPUNIT_ASSERT(BinaryLogCodec::decodeRecord(buf, len, id, level, time,
+                                              args, argsLen));
+  CPPUNIT_ASSERT_EQUAL(site.getID(), id);
+  CPPUNIT_ASSERT_EQUAL(LogInfo, level);
+  CPPUNIT_ASSERT(time == INT64_CONST(1234567890123));
+
+  char out[256];
+  BinaryLogCodec::renderMessage(site.getFormat(), args, argsLen, out,
+                                sizeof(out));
+
+  return(std::string(out));
+}
+
+/*
+ */
+
+CppUnit::Test *BinaryLogTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(BinaryLogTest);
+  CCXX_TESTSUITE_TEST(BinaryLogTest, testSignature);
+  CCXX_TESTSUITE_TEST(BinaryLogTest, testRender);
+  CCXX_TESTSUITE_TEST(BinaryLogTest, testAsyncRender);
+  CCXX_TESTSUITE_TEST(BinaryLogTest, testBinaryFile);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void BinaryLogTest::setUp()
+{
+}
+
+/*
+ */
+
+void BinaryLogTest::tearDown()
+{
+}
+
+/*
+ */
+
+void BinaryLogTest::testSignature()
+{
+  char sig[LogSite::MAX_ARGS + 1];
+
+  CPPUNIT_ASSERT(BinaryLogCodec::parseSignature("no args, 100%%", sig,
+                                                sizeof(sig)));
+  CPPUNIT_ASSERT(std::strcmp(sig, "") == 0);
+
+  CPPUNIT_ASSERT(BinaryLogCodec::parseSignature(
+                   "%d %hhu %ld %lld %zu %5.2f %Lg %-*.*s %p %c %jd %tx",
+                   sig, sizeof(sig)));
+  CPPUNIT_ASSERT(std::strcmp(sig, "iilqzdDiispijt") == 0);
+
+  CPPUNIT_ASSERT(! BinaryLogCodec::parseSignature("%n", sig, sizeof(sig)));
+  CPPUNIT_ASSERT(! BinaryLogCodec::parseSignature("%ls", sig, sizeof(sig)));
+  CPPUNIT_ASSERT(! BinaryLogCodec::parseSignature("%d %d", sig, 2));
+
+  LogSite site("%d apples and %n", __FILE__, __LINE__);
+  CPPUNIT_ASSERT(! site.isBinary());
+  CPPUNIT_ASSERT(site.getID() > 0);
+  CPPUNIT_ASSERT(LogSite::lookup(site.getID()) == &site);
+  CPPUNIT_ASSERT(LogSite::lookup(LogSite::getCount() + 1) == NULL);
+}
+
+/*
+ */
+
+void BinaryLogTest::testRender()
+{
+  char buf[512];
+  char expected[256];
+
+  LogSite site1("int %d, long %ld, size %zu, hex %#08x, char '%c'",
+                __FILE__, __LINE__);
+  size_t len = __encode(buf, sizeof(buf), &site1, -42, 1234567890123L,
+                        static_cast<size_t>(77), 0xBEEF, 'q');
+  CPPUNIT_ASSERT(len > BinaryLogCodec::RECORD_HEADER_SIZE);
+  std::snprintf(expected, sizeof(expected), site1.getFormat(), -42,
+                1234567890123L, static_cast<size_t>(77), 0xBEEF, 'q');
+  CPPUNIT_ASSERT_EQUAL(std::string(expected), __render(buf, len, site1));
+
+  LogSite site2("[%-*s] [%.*f] [%s] %g%%", __FILE__, __LINE__);
+  len = __encode(buf, sizeof(buf), &site2, 8, "left", 3, 3.14159,
+                 static_cast<const char *>(NULL), 1e10);
+  CPPUNIT_ASSERT_EQUAL(std::string("[left    ] [3.142] [(null)] 1e+10%"),
+                       __render(buf, len, site2));
+
+  // strings are truncated to fit
+
+  LogSite site3("%s", __FILE__, __LINE__);
+  len = __encode(buf, BinaryLogCodec::RECORD_HEADER_SIZE + 2 + 5 + 1, &site3,
+                 "truncated");
+  CPPUNIT_ASSERT_EQUAL(std::string("trunc"), __render(buf, len, site3));
+
+  // and a record with no room for its arguments is rejected
+
+  LogSite site4("%d", __FILE__, __LINE__);
+  CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0),
+                       __encode(buf, BinaryLogCodec::RECORD_HEADER_SIZE + 2,
+                                &site4, 5));
+}
+
+/*
+ */
+
+void BinaryLogTest::testAsyncRender()
+{
+  TextCaptureLogger target;
+  AsyncLogger logger(&target);
+
+  for(int i = 0; i < 3; ++i)
+    CCXX_LOG_BINARY(logger, LogInfo, "binary %d of %s", i, "three");
+
+  // not binary-capable, so formatted up front
+  CCXX_LOG_BINARY(logger, LogInfo, "%d %ls", 1, L"wide");
+
+  logger.log(LogInfo, __FILE__, __LINE__, "text %d", 4);
+
+  target.disableLogLevel(LogDebug);
+  CCXX_LOG_BINARY(logger, LogDebug, "filtered");
+
+  logger.flush();
+
+  std::string expected;
+  expected.append("binary 0 of three").append(File::eol);
+  expected.append("binary 1 of three").append(File::eol);
+  expected.append("binary 2 of three").append(File::eol);
+  expected.append("1 wide").append(File::eol);
+  expected.append("text 4").append(File::eol);
+
+  CPPUNIT_ASSERT_EQUAL(expected, target.text);
+}
+
+/*
+ */
+
+void BinaryLogTest::testBinaryFile()
+{
+  File::remove("./binarylogtest.log");
+
+  BinaryFileLogger target(4096, 0);
+  CPPUNIT_ASSERT(target.isBinary());
+  CPPUNIT_ASSERT(target.setFile(".", "binarylogtest"));
+
+  AsyncLogger logger(&target);
+  logger.start();
+
+  for(int i = 0; i < 100; ++i)
+  {
+    CCXX_LOG_BINARY(logger, LogWarning, "record %d: %s %.1f", i, "value",
+                    i / 2.0);
+  }
+
+  logger.log(LogError, __FILE__, __LINE__, "a text record");
+
+  // a site registered after the file was opened
+  CCXX_LOG_BINARY(logger, LogError, "late site %u", 99u);
+
+  logger.stop();
+
+  BinaryLogReader reader("./binarylogtest.log", "%l %m");
+  reader.open();
+
+  CharBuffer line(1024);
+  char expected[128];
+  int count = 0;
+
+  for(int i = 0; i < 100; ++i, ++count)
+  {
+    CPPUNIT_ASSERT(reader.read(line));
+    std::snprintf(expected, sizeof(expected), "W record %d: value %.1f%s",
+                  i, i / 2.0, File::eol);
+    CPPUNIT_ASSERT_EQUAL(std::string(expected),
+                         std::string(line.getPointer(),
+                                     line.getRemaining()));
+  }
+
+  CPPUNIT_ASSERT(reader.read(line));
+  CPPUNIT_ASSERT_EQUAL(std::string("a text record") + File::eol,
+                       std::string(line.getPointer(), line.getRemaining()));
+
+  CPPUNIT_ASSERT(reader.read(line));
+  CPPUNIT_ASSERT_EQUAL(std::string("E late site 99") + File::eol,
+                       std::string(line.getPointer(), line.getRemaining()));
+
+  CPPUNIT_ASSERT(! reader.read(line));
+  CPPUNIT_ASSERT_EQUAL(0U, reader.getUnknownSiteCount());
+
+  reader.close();
+  File::remove("./binarylogtest.log");
+}
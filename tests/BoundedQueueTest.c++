@@ -46,6 +46,7 @@ CppUnit::Test *BoundedQueueTest::suite()
 {
   CCXX_TESTSUITE_BEGIN(BoundedQueueTest);
   CCXX_TESTSUITE_TEST(BoundedQueueTest, testQueue);
+  CCXX_TESTSUITE_TEST(BoundedQueueTest, testHighWaterMark);
   CCXX_TESTSUITE_END();
 }
 
@@ -89,6 +90,32 @@ void BoundedQueueTest::testQueue()
   CPPUNIT_ASSERT_EQUAL(true, _boundsOK);
 }
 
+/*
+ */
+
+void BoundedQueueTest::testHighWaterMark()
+{
+  CPPUNIT_ASSERT_EQUAL(10U, _queue->getHighWaterMark());
+
+  _queue->setHighWaterMark(3);
+  CPPUNIT_ASSERT_EQUAL(3U, _queue->getHighWaterMark());
+
+  _queue->put(1);
+  _queue->put(2);
+  CPPUNIT_ASSERT(! _queue->isCongested());
+
+  _queue->put(3);
+  CPPUNIT_ASSERT(_queue->isCongested());
+
+  _queue->take();
+  CPPUNIT_ASSERT(! _queue->isCongested());
+
+  // 0 reverts to the capacity
+
+  _queue->setHighWaterMark(0);
+  CPPUNIT_ASSERT_EQUAL(10U, _queue->getHighWaterMark());
+}
+
 /*
  */
 
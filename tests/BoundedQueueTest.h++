@@ -38,6 +38,7 @@ class BoundedQueueTest : public CppUnit::TestFixture
   void tearDown();
 
   void testQueue();
+  void testHighWaterMark();
 
  private:
 
@@ -0,0 +1,333 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "BufferChainTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+#include "commonc++/BufferChain.h++"
+#include "commonc++/File.h++"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace ccxx;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BufferChainTest);
+
+static const char *testFile = "./testdata/chain.bin";
+
+/*
+ */
+
+// A stream that accepts at most a few bytes per gather write, as a socket
+// or pipe may, and collects them in memory.
+
+class ShortWriteStream : public Stream
+{
+ public:
+
+  ShortWriteStream(size_t maxWrite)
+    : writes(0), _maxWrite(maxWrite)
+  { }
+
+  using Stream::write;
+
+  size_t write(const MemoryBlock* vec, uint_t count)
+  {
+    size_t total = 0;
+
+    for(uint_t i = 0; (i < count) && (total < _maxWrite); ++i)
+    {
+      size_t n = std::min(vec[i].getSize(), _maxWrite - total);
+      data.insert(data.end(), vec[i].getBase(), vec[i].getBase() + n);
+      total += n;
+    }
+
+    ++writes;
+    return(total);
+  }
+
+  std::vector<byte_t> data;
+  int writes;
+
+ private:
+
+  size_t _maxWrite;
+};
+
+/*
+ */
+
+CppUnit::Test *BufferChainTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(BufferChainTest);
+  CCXX_TESTSUITE_TEST(BufferChainTest, testAppend);
+  CCXX_TESTSUITE_TEST(BufferChainTest, testOverwrite);
+  CCXX_TESTSUITE_TEST(BufferChainTest, testWrite);
+  CCXX_TESTSUITE_TEST(BufferChainTest, testShortWrite);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void BufferChainTest::setUp()
+{
+  File::remove(testFile);
+}
+
+/*
+ */
+
+void BufferChainTest::tearDown()
+{
+  File::remove(testFile);
+}
+
+/*
+ */
+
+void BufferChainTest::testAppend()
+{
+  BufferChain chain(64);
+
+  CPPUNIT_ASSERT(chain.isEmpty());
+  CPPUNIT_ASSERT_EQUAL(size_t(64), chain.getBlockSize());
+
+  byte_t data[100];
+  for(size_t i = 0; i < sizeof(data); ++i)
+    data[i] = static_cast<byte_t>(i);
+
+  // appends fill the last buffer before starting a new one
+
+  chain.append(data, 10);
+  chain.append(data, 60);
+  CPPUNIT_ASSERT_EQUAL(size_t(70), chain.getLength());
+  CPPUNIT_ASSERT_EQUAL(uint_t(2), chain.getSegmentCount());
+
+  // a view is a segment of its own; data appended after it goes into a
+  // new buffer
+
+  chain.appendView(data, sizeof(data));
+  chain.fill(0xAA, 5);
+  CPPUNIT_ASSERT_EQUAL(size_t(175), chain.getLength());
+  CPPUNIT_ASSERT_EQUAL(uint_t(4), chain.getSegmentCount());
+
+  MemoryBlock vec[4];
+  CPPUNIT_ASSERT_EQUAL(uint_t(4), chain.getSegments(vec, 4));
+  CPPUNIT_ASSERT_EQUAL(size_t(64), vec[0].getSize());
+  CPPUNIT_ASSERT_EQUAL(size_t(6), vec[1].getSize());
+  CPPUNIT_ASSERT(vec[2].getBase() == data);
+  CPPUNIT_ASSERT_EQUAL(size_t(5), vec[3].getSize());
+  CPPUNIT_ASSERT_EQUAL(byte_t(0xAA), vec[3].getBase()[4]);
+
+  CPPUNIT_ASSERT_EQUAL(byte_t(9), vec[0].getBase()[9]);
+  CPPUNIT_ASSERT_EQUAL(byte_t(0), vec[0].getBase()[10]);
+  CPPUNIT_ASSERT_EQUAL(byte_t(59), vec[1].getBase()[5]);
+
+  CPPUNIT_ASSERT_EQUAL(uint_t(2), chain.getSegments(vec, 4, 2));
+  CPPUNIT_ASSERT(vec[0].getBase() == data);
+
+  // truncation, into the middle of a buffer
+
+  chain.truncate(30);
+  CPPUNIT_ASSERT_EQUAL(size_t(30), chain.getLength());
+  CPPUNIT_ASSERT_EQUAL(uint_t(1), chain.getSegmentCount());
+
+  chain.truncate(100);
+  CPPUNIT_ASSERT_EQUAL(size_t(30), chain.getLength());
+
+  chain.clear();
+  CPPUNIT_ASSERT(chain.isEmpty());
+  CPPUNIT_ASSERT_EQUAL(uint_t(0), chain.getSegmentCount());
+
+  // buffers are reused after clearing
+
+  chain.append(data, sizeof(data));
+  CPPUNIT_ASSERT_EQUAL(uint_t(2), chain.getSegmentCount());
+  CPPUNIT_ASSERT_EQUAL(size_t(100), chain.getLength());
+}
+
+/*
+ */
+
+void BufferChainTest::testOverwrite()
+{
+  BufferChain chain(64);
+
+  byte_t data[80];
+  std::memset(data, 0, sizeof(data));
+
+  byte_t view[8];
+  std::memset(view, 0x55, sizeof(view));
+
+  chain.append(data, sizeof(data));
+  chain.appendView(view, sizeof(view));
+
+  // spanning two buffers
+
+  static const byte_t patch[] = { 1, 2, 3, 4 };
+  chain.overwrite(62, patch, sizeof(patch));
+
+  MemoryBlock vec[3];
+  chain.getSegments(vec, 3);
+  CPPUNIT_ASSERT_EQUAL(byte_t(1), vec[0].getBase()[62]);
+  CPPUNIT_ASSERT_EQUAL(byte_t(2), vec[0].getBase()[63]);
+  CPPUNIT_ASSERT_EQUAL(byte_t(3), vec[1].getBase()[0]);
+  CPPUNIT_ASSERT_EQUAL(byte_t(4), vec[1].getBase()[1]);
+
+  try
+  {
+    chain.overwrite(86, patch, sizeof(patch));
+    CPPUNIT_FAIL("No OutOfBoundsException thrown");
+  }
+  catch(OutOfBoundsException &)
+  {
+  }
+
+  // an empty overwrite at the end of the chain is a no-op
+
+  chain.overwrite(chain.getLength(), patch, 0);
+
+  try
+  {
+    chain.overwrite(78, patch, sizeof(patch));
+    CPPUNIT_FAIL("No IOException thrown");
+  }
+  catch(IOException &)
+  {
+  }
+
+  CPPUNIT_ASSERT_EQUAL(byte_t(0x55), view[0]);
+}
+
+/*
+ */
+
+void BufferChainTest::testWrite()
+{
+  // more segments than can be written in a single gather write
+
+  BufferChain chain(128);
+
+  std::vector<byte_t> expected;
+
+  byte_t view[300];
+  for(size_t i = 0; i < sizeof(view); ++i)
+    view[i] = static_cast<byte_t>(i * 7);
+
+  for(int i = 0; i < 40; ++i)
+  {
+    byte_t rec[50];
+    std::memset(rec, i, sizeof(rec));
+
+    chain.append(rec, sizeof(rec));
+    expected.insert(expected.end(), rec, rec + sizeof(rec));
+
+    if(i % 5 == 0)
+    {
+      chain.appendView(view, sizeof(view));
+      expected.insert(expected.end(), view, view + sizeof(view));
+    }
+  }
+
+  CPPUNIT_ASSERT(chain.getSegmentCount() > 16);
+  CPPUNIT_ASSERT_EQUAL(expected.size(), chain.getLength());
+
+  File file(testFile);
+  file.open(IOReadWrite, FileTruncateElseCreate);
+
+  CPPUNIT_ASSERT_EQUAL(expected.size(), chain.write(file));
+  CPPUNIT_ASSERT(chain.isEmpty());
+
+  file.close();
+
+  CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(expected.size()),
+                       file.getSize());
+
+  std::vector<byte_t> actual(expected.size());
+
+  file.open(IORead, FileOpen);
+  CPPUNIT_ASSERT_EQUAL(actual.size(),
+                       file.readFully(&actual[0], actual.size()));
+  file.close();
+
+  CPPUNIT_ASSERT(actual == expected);
+}
+
+/*
+ */
+
+void BufferChainTest::testShortWrite()
+{
+  BufferChain chain(16);
+
+  std::vector<byte_t> expected;
+
+  byte_t view[10];
+  for(size_t i = 0; i < sizeof(view); ++i)
+    view[i] = static_cast<byte_t>(0x80 + i);
+
+  for(int i = 0; i < 6; ++i)
+  {
+    byte_t rec[13];
+    for(size_t j = 0; j < sizeof(rec); ++j)
+      rec[j] = static_cast<byte_t>((i * 16) + j);
+
+    chain.append(rec, sizeof(rec));
+    expected.insert(expected.end(), rec, rec + sizeof(rec));
+
+    chain.appendView(view, sizeof(view));
+    expected.insert(expected.end(), view, view + sizeof(view));
+  }
+
+  // each write stops part-way through a segment, which must be resumed
+  // from the right offset
+
+  ShortWriteStream stream(7);
+
+  CPPUNIT_ASSERT_EQUAL(expected.size(), chain.write(stream));
+  CPPUNIT_ASSERT(chain.isEmpty());
+
+  CPPUNIT_ASSERT_EQUAL(static_cast<int>((expected.size() + 6) / 7),
+                       stream.writes);
+  CPPUNIT_ASSERT(stream.data == expected);
+
+  // a stream that accepts nothing
+
+  chain.append(view, sizeof(view));
+  ShortWriteStream stuck(0);
+
+  try
+  {
+    chain.write(stuck);
+    CPPUNIT_FAIL("No IOException thrown");
+  }
+  catch(IOException &)
+  {
+  }
+}
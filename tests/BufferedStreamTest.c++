@@ -29,11 +29,81 @@
 #include "commonc++/Common.h++"
 #include "commonc++/BufferedStream.h++"
 #include "commonc++/File.h++"
+#include "commonc++/System.h++"
+#include "commonc++/Thread.h++"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
 
 using namespace ccxx;
 
 CPPUNIT_TEST_SUITE_REGISTRATION(BufferedStreamTest);
 
+static const char *testFile = "./testdata/bufstream.txt";
+
+/*
+ */
+
+static std::string lineText(int i)
+{
+  std::ostringstream ss;
+  ss << "This is line #" << i;
+  return(ss.str());
+}
+
+/*
+ */
+
+static void writeLines(int count)
+{
+  File f(testFile);
+  f.open(IOWrite, FileTruncateElseCreate);
+
+  BufferedStream strm(f);
+
+  for(int i = 0; i < count; ++i)
+    strm << lineText(i) << '\n';
+
+  strm.close();
+}
+
+/*
+ */
+
+// A file that is slow to read from, as a disk or network stream might be.
+
+class SlowFile : public File
+{
+ public:
+
+  SlowFile(const String& path)
+    : File(path)
+  { }
+
+  size_t read(byte_t* buffer, size_t buflen)
+  {
+    Thread::sleep(2);
+    return(File::read(buffer, buflen));
+  }
+};
+
+/*
+ */
+
+// A stream on the read end of a pipe.
+
+class PipeStream : public Stream
+{
+ public:
+
+  PipeStream(FileHandle handle)
+    : Stream(handle, false, true, false)
+  { }
+};
+
 /*
  */
 
@@ -41,6 +111,10 @@ CppUnit::Test *BufferedStreamTest::suite()
 {
   CCXX_TESTSUITE_BEGIN(BufferedStreamTest);
   CCXX_TESTSUITE_TEST(BufferedStreamTest, testBufferedStream);
+  CCXX_TESTSUITE_TEST(BufferedStreamTest, testRead);
+  CCXX_TESTSUITE_TEST(BufferedStreamTest, testBlockWrite);
+  CCXX_TESTSUITE_TEST(BufferedStreamTest, testReadahead);
+  CCXX_TESTSUITE_TEST(BufferedStreamTest, testReadaheadIdlePipe);
   CCXX_TESTSUITE_END();
 }
 
@@ -56,6 +130,7 @@ void BufferedStreamTest::setUp()
 
 void BufferedStreamTest::tearDown()
 {
+  File::remove(testFile);
 }
 
 /*
@@ -79,3 +154,209 @@ void BufferedStreamTest::testBufferedStream()
 
   // TODO
 }
+
+/*
+ */
+
+void BufferedStreamTest::testRead()
+{
+  static const BufferedStreamMode modes[] = { BufferedStreamNormal,
+                                              BufferedStreamBlock,
+                                              BufferedStreamReadahead };
+
+  const int lineCount = 20000;
+
+  writeLines(lineCount);
+
+  for(size_t m = 0; m < CCXX_LENGTHOF(modes); ++m)
+  {
+    File f(testFile);
+    f.open(IORead, FileOpen);
+
+    // small blocks, so that the data spans many of them
+    BufferedStream strm(f, modes[m], 8192);
+
+    std::string line;
+    int n = 0;
+    std::streampos mark;
+
+    while(std::getline(strm, line))
+    {
+      CPPUNIT_ASSERT_EQUAL(lineText(n), line);
+
+      if(++n == 1000)
+        mark = strm.tellg();
+    }
+
+    CPPUNIT_ASSERT_EQUAL(lineCount, n);
+
+    strm.clear();
+
+    // seek to a previously saved position
+
+    strm.seekg(mark);
+    CPPUNIT_ASSERT(std::getline(strm, line));
+    CPPUNIT_ASSERT_EQUAL(lineText(1000), line);
+
+    // seek within the buffered data; tellg() reports the position of the
+    // next character, not of the underlying file
+
+    std::streampos pos = strm.tellg();
+    strm.seekg(-static_cast<int>(line.length() + 1), std::ios::cur);
+    CPPUNIT_ASSERT(std::getline(strm, line));
+    CPPUNIT_ASSERT_EQUAL(lineText(1000), line);
+    CPPUNIT_ASSERT(pos == strm.tellg());
+
+    strm.seekg(0);
+    CPPUNIT_ASSERT(std::getline(strm, line));
+    CPPUNIT_ASSERT_EQUAL(lineText(0), line);
+
+    strm.seekg(-static_cast<int>(lineText(lineCount - 1).length() + 1),
+               std::ios::end);
+    CPPUNIT_ASSERT(std::getline(strm, line));
+    CPPUNIT_ASSERT_EQUAL(lineText(lineCount - 1), line);
+    CPPUNIT_ASSERT(! std::getline(strm, line));
+  }
+}
+
+/*
+ */
+
+void BufferedStreamTest::testBlockWrite()
+{
+  const int lineCount = 5000;
+  std::string expected;
+
+  {
+    File f(testFile);
+    f.open(IOWrite, FileTruncateElseCreate);
+
+    BufferedStream strm(f, BufferedStreamBlock, 4096);
+
+    for(int i = 0; i < lineCount; ++i)
+    {
+      std::string line = lineText(i) + '\n';
+      strm << line;
+      expected += line;
+    }
+
+    strm.close();
+  }
+
+  CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(expected.length()),
+                       File::getSize(testFile));
+
+  // read and write on the same stream
+
+  File f(testFile);
+  f.open(IOReadWrite, FileOpen);
+
+  BufferedStream strm(f, BufferedStreamBlock, 4096);
+
+  std::string line;
+  CPPUNIT_ASSERT(std::getline(strm, line));
+  CPPUNIT_ASSERT_EQUAL(lineText(0), line);
+
+  strm.seekp(0);
+  strm << "THIS";
+  strm.flush();
+
+  strm.seekg(0);
+  CPPUNIT_ASSERT(std::getline(strm, line));
+  CPPUNIT_ASSERT_EQUAL(std::string("THIS is line #0"), line);
+  CPPUNIT_ASSERT(std::getline(strm, line));
+  CPPUNIT_ASSERT_EQUAL(lineText(1), line);
+
+  strm.close();
+
+  CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(expected.length()),
+                       File::getSize(testFile));
+}
+
+/*
+ */
+
+void BufferedStreamTest::testReadahead()
+{
+  const int lineCount = 40000;
+
+  writeLines(lineCount);
+
+  static const BufferedStreamMode modes[] = { BufferedStreamBlock,
+                                              BufferedStreamReadahead };
+  static const char *names[] = { "block", "readahead" };
+
+  for(size_t m = 0; m < CCXX_LENGTHOF(modes); ++m)
+  {
+    SlowFile f(testFile);
+    f.open(IORead, FileOpen);
+
+    BufferedStream strm(f, modes[m], 16384);
+
+    int64_t start = System::nanoTime();
+
+    std::string line;
+    int n = 0;
+
+    while(std::getline(strm, line))
+    {
+      CPPUNIT_ASSERT_EQUAL(lineText(n), line);
+
+      // simulate the work of parsing each block
+      if((++n % 800) == 0)
+        Thread::sleep(2);
+    }
+
+    int64_t elapsed = System::nanoTime() - start;
+
+    CPPUNIT_ASSERT_EQUAL(lineCount, n);
+
+    std::cout << names[m] << ": " << (elapsed / 1000000) << " ms"
+              << std::endl;
+
+    strm.close();
+  }
+}
+
+/*
+ */
+
+void BufferedStreamTest::testReadaheadIdlePipe()
+{
+  // The reader thread is left blocked on a pipe that delivers no more
+  // data; closing or destroying the stream must not wait for it.
+
+  int fds[2];
+
+  CPPUNIT_ASSERT_EQUAL(0, ::pipe(fds));
+
+  {
+    PipeStream in(fds[0]);
+    BufferedStream strm(in, BufferedStreamReadahead, 4096);
+
+    static const char text[] = "hello\n";
+    CPPUNIT_ASSERT_EQUAL(static_cast<ssize_t>(sizeof(text) - 1),
+                         ::write(fds[1], text, sizeof(text) - 1));
+
+    std::string line;
+    CPPUNIT_ASSERT(std::getline(strm, line));
+    CPPUNIT_ASSERT_EQUAL(std::string("hello"), line);
+
+    Thread::sleep(50);
+    strm.close();
+  }
+
+  ::close(fds[1]);
+
+  CPPUNIT_ASSERT_EQUAL(0, ::pipe(fds));
+
+  {
+    PipeStream in(fds[0]);
+    BufferedStream strm(in, BufferedStreamReadahead, 4096);
+
+    Thread::sleep(50);
+  }
+
+  ::close(fds[1]);
+}
+
@@ -34,4 +34,8 @@ class BufferedStreamTest : public CppUnit::TestFixture
   void tearDown();
 
   void testBufferedStream();
+  void testRead();
+  void testBlockWrite();
+  void testReadahead();
+  void testReadaheadIdlePipe();
 };
@@ -0,0 +1,269 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "ChainDataWriterTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+#include "commonc++/ChainDataWriter.h++"
+#include "commonc++/File.h++"
+
+#include <cstring>
+
+using namespace ccxx;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ChainDataWriterTest);
+
+static const char *testFile = "./testdata/chainwriter.bin";
+
+/*
+ */
+
+static void copyChain(const BufferChain& chain, byte_t* buf)
+{
+  MemoryBlock vec[16];
+  uint_t index = 0;
+
+  for(;;)
+  {
+    uint_t n = chain.getSegments(vec, CCXX_LENGTHOF(vec), index);
+    if(n == 0)
+      break;
+
+    for(uint_t i = 0; i < n; ++i)
+    {
+      std::memcpy(buf, vec[i].getBase(), vec[i].getSize());
+      buf += vec[i].getSize();
+    }
+
+    index += n;
+  }
+}
+
+/*
+ */
+
+CppUnit::Test *ChainDataWriterTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(ChainDataWriterTest);
+  CCXX_TESTSUITE_TEST(ChainDataWriterTest, testChainDataWriter);
+  CCXX_TESTSUITE_TEST(ChainDataWriterTest, testFlush);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void ChainDataWriterTest::setUp()
+{
+  File::remove(testFile);
+}
+
+/*
+ */
+
+void ChainDataWriterTest::tearDown()
+{
+  File::remove(testFile);
+}
+
+/*
+ */
+
+void ChainDataWriterTest::testChainDataWriter()
+{
+  static const byte_t expected_buf[] =
+    { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xFF, 0xFF,
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0xEE, 0xEE, 0xEE, 0xEE, 0xEE, 0xEE, 0xEE, 0xEE,
+      0x00, 0x00, 0x00, 0x00, 0x41, 0x41, 0x41, 0x41,
+      0x00, 0x00, 0x00, 0x00, 0x42, 0x4C, 0x41, 0x48,
+      0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+  BufferChain chain(16);
+
+  // data already in the chain is left alone
+
+  static const byte_t header[] = { 'H', 'D', 'R', '!' };
+  chain.append(header, sizeof(header));
+
+  ChainDataWriter writer(chain);
+
+  try
+  {
+    writer.setLimit(64);
+
+    writer.pushContext();
+    writer.setLimit(32);
+
+    for(int i = 0; i < 32; ++i)
+      writer << byte_t(0xFF);
+
+    writer.setOffset(5);
+    writer << byte_t(0x00);
+    writer.setOffset(32);
+
+    writer.popContext();
+
+    CPPUNIT_ASSERT_EQUAL(int64_t(32), writer.getOffset());
+    CPPUNIT_ASSERT_EQUAL(int64_t(32), writer.getRemaining());
+
+    writer.pushContext();
+
+    for(int i = 0; i < 8; ++i)
+      writer << byte_t(0xEE);
+
+    writer.popContext();
+
+    CPPUNIT_ASSERT_EQUAL(int64_t(40), writer.getOffset());
+
+    writer.skip(4);
+
+    writer << DataWriter::SetLength(8) << "AAAA" << DataWriter::SetLength(0)
+           << "BLAH" << byte_t(0x11);
+
+    CPPUNIT_ASSERT_EQUAL(int64_t(57), writer.getOffset());
+    CPPUNIT_ASSERT_EQUAL(int64_t(7), writer.getRemaining());
+
+    // rewrite a value that spans two buffers
+
+    writer.setOffset(43);
+    writer.skip(2, 0x22);
+    writer.setOffset(43);
+    writer << byte_t(0x00) << byte_t(0x41);
+    writer.setOffset(57);
+
+    CPPUNIT_ASSERT_EQUAL(size_t(4 + 57), chain.getLength());
+    CPPUNIT_ASSERT_EQUAL(uint_t(4), chain.getSegmentCount());
+
+    byte_t buf[64];
+    copyChain(chain, buf);
+
+    CPPUNIT_ASSERT_EQUAL(0, std::memcmp(buf, header, sizeof(header)));
+    CPPUNIT_ASSERT_EQUAL(0, std::memcmp(buf + sizeof(header), expected_buf,
+                                        57));
+
+    // past the limit
+
+    try
+    {
+      writer.skip(8);
+      CPPUNIT_FAIL("No IOException thrown");
+    }
+    catch(IOException &)
+    {
+    }
+
+    try
+    {
+      writer.setOffset(61);
+      CPPUNIT_FAIL("No IOException thrown");
+    }
+    catch(IOException &)
+    {
+    }
+
+    // reset discards only what the writer wrote
+
+    writer.reset();
+    CPPUNIT_ASSERT_EQUAL(size_t(4), chain.getLength());
+    CPPUNIT_ASSERT_EQUAL(int64_t(0), writer.getOffset());
+  }
+  catch(IOException &ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void ChainDataWriterTest::testFlush()
+{
+  static const byte_t expected_buf[] =
+    { 0x00, 0x00, 0x00, 0x08, 0x41, 0x42, 0x43, 0x44,
+      0xCC, 0xCC, 0xCC, 0xCC, 0x00, 0x00, 0x00, 0x02,
+      0x58, 0x59 };
+
+  File file(testFile);
+
+  try
+  {
+    file.open(IOReadWrite, FileTruncateElseCreate);
+
+    BufferChain chain;
+    ChainDataWriter writer(chain, &file);
+    writer.setEndianness(BigEndian);
+
+    // a length-prefixed record, with the length filled in afterward
+
+    writer << uint32_t(0) << "ABCD";
+    writer.skip(4, 0xCC);
+    writer.setOffset(0);
+    writer << uint32_t(8);
+    writer.setOffset(12);
+
+    writer.flush();
+    CPPUNIT_ASSERT(chain.isEmpty());
+    CPPUNIT_ASSERT_EQUAL(int64_t(12), file.getSize());
+
+    writer << uint32_t(2) << "XY";
+
+    // data that has been flushed can't be overwritten
+
+    writer.setOffset(4);
+
+    try
+    {
+      writer << "ZZZZ";
+      CPPUNIT_FAIL("No IOException thrown");
+    }
+    catch(IOException &)
+    {
+    }
+
+    writer.setOffset(18);
+    writer.flush();
+
+    CPPUNIT_ASSERT_EQUAL(int64_t(18), writer.getOffset());
+    CPPUNIT_ASSERT_EQUAL(int64_t(sizeof(expected_buf)), file.getSize());
+
+    file.close();
+
+    byte_t buf[sizeof(expected_buf)];
+
+    file.open(IORead, FileOpen);
+    CPPUNIT_ASSERT_EQUAL(sizeof(buf), file.readFully(buf, sizeof(buf)));
+    file.close();
+
+    CPPUNIT_ASSERT_EQUAL(0, std::memcmp(buf, expected_buf, sizeof(buf)));
+  }
+  catch(IOException &ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
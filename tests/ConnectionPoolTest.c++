@@ -0,0 +1,318 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "ConnectionPoolTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+#include "commonc++/ConnectionPool.h++"
+#include "commonc++/Thread.h++"
+
+using namespace ccxx;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ConnectionPoolTest);
+
+/*
+ */
+
+CppUnit::Test *ConnectionPoolTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(ConnectionPoolTest);
+  CCXX_TESTSUITE_TEST(ConnectionPoolTest, testReuse);
+  CCXX_TESTSUITE_TEST(ConnectionPoolTest, testConnectFailure);
+  CCXX_TESTSUITE_TEST(ConnectionPoolTest, testEviction);
+  CCXX_TESTSUITE_TEST(ConnectionPoolTest, testIdleData);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void ConnectionPoolTest::setUp()
+{
+}
+
+/*
+ */
+
+void ConnectionPoolTest::tearDown()
+{
+}
+
+/*
+ */
+
+void ConnectionPoolTest::testReuse()
+{
+  try
+  {
+    ServerSocket ssock(40410);
+    ssock.init();
+    ssock.listen();
+
+    EchoSelector server;
+    server.init(&ssock);
+    server.start();
+
+    TestPool pool;
+    CPPUNIT_ASSERT(pool.init());
+    pool.start();
+
+    SocketAddress endpoint(InetAddress("127.0.0.1"), 40410);
+
+    AcquireHandler h1;
+    CPPUNIT_ASSERT(pool.acquire(endpoint, &h1));
+    CPPUNIT_ASSERT(h1.await(2000));
+    CPPUNIT_ASSERT(h1.connection != NULL);
+    CPPUNIT_ASSERT(h1.connection->getSocket()->isConnected());
+
+    pool.release(h1.connection);
+    CPPUNIT_ASSERT_EQUAL(1U, pool.getIdleCount(endpoint));
+
+    // the idle connection is handed out again, synchronously
+
+    AcquireHandler h2;
+    CPPUNIT_ASSERT(pool.acquire(endpoint, &h2));
+    CPPUNIT_ASSERT_EQUAL(1, h2.fired);
+    CPPUNIT_ASSERT(h2.connection == h1.connection);
+    CPPUNIT_ASSERT_EQUAL(0U, pool.getIdleCount());
+
+    pool.release(h2.connection);
+
+    pool.stop();
+    pool.join();
+
+    server.stop();
+    server.join();
+  }
+  catch(Exception& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void ConnectionPoolTest::testConnectFailure()
+{
+  try
+  {
+    TestPool pool;
+    CPPUNIT_ASSERT(pool.init());
+    pool.start();
+
+    // nothing is listening on this port; the connect may be refused
+    // immediately, or the handler is called with NULL
+
+    SocketAddress endpoint(InetAddress("127.0.0.1"), 40411);
+
+    AcquireHandler h;
+    if(pool.acquire(endpoint, &h))
+    {
+      CPPUNIT_ASSERT(h.await(3000));
+      CPPUNIT_ASSERT(h.connection == NULL);
+    }
+
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), pool.getConnectionCount());
+
+    pool.stop();
+    pool.join();
+  }
+  catch(Exception& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void ConnectionPoolTest::testEviction()
+{
+  try
+  {
+    ServerSocket ssock(40412);
+    ssock.init();
+    ssock.listen();
+
+    EchoSelector server;
+    server.init(&ssock);
+    server.start();
+
+    TestPool pool;
+    CPPUNIT_ASSERT(pool.init());
+    pool.start();
+
+    SocketAddress endpoint(InetAddress("127.0.0.1"), 40412);
+
+    AcquireHandler h;
+    CPPUNIT_ASSERT(pool.acquire(endpoint, &h));
+    CPPUNIT_ASSERT(h.await(2000));
+    CPPUNIT_ASSERT(h.connection != NULL);
+
+    pool.release(h.connection);
+    CPPUNIT_ASSERT_EQUAL(1U, pool.getIdleCount());
+
+    // shutting down the server closes the peer end of the idle connection
+
+    server.stop();
+    server.join();
+
+    Thread::sleep(300);
+
+    CPPUNIT_ASSERT_EQUAL(0U, pool.getIdleCount());
+    CPPUNIT_ASSERT_EQUAL(0, pool.lost);
+
+    pool.stop();
+    pool.join();
+  }
+  catch(Exception& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void ConnectionPoolTest::testIdleData()
+{
+  try
+  {
+    ServerSocket ssock(40413);
+    ssock.init();
+    ssock.listen();
+
+    TestPool pool;
+    CPPUNIT_ASSERT(pool.init());
+    pool.start();
+
+    SocketAddress endpoint(InetAddress("127.0.0.1"), 40413);
+
+    AcquireHandler h;
+    CPPUNIT_ASSERT(pool.acquire(endpoint, &h));
+    CPPUNIT_ASSERT(h.await(2000));
+    CPPUNIT_ASSERT(h.connection != NULL);
+
+    StreamSocket peer;
+    ssock.accept(peer);
+
+    pool.release(h.connection);
+    CPPUNIT_ASSERT_EQUAL(1U, pool.getIdleCount());
+
+    // unsolicited data evicts the idle connection, and is not passed to
+    // the subclass
+
+    const byte_t data[] = { 'x', 'y', 'z' };
+    peer.write(data, sizeof(data));
+
+    Thread::sleep(300);
+
+    CPPUNIT_ASSERT_EQUAL(0U, pool.getIdleCount());
+    CPPUNIT_ASSERT_EQUAL(0, pool.received);
+    CPPUNIT_ASSERT_EQUAL(0, pool.lost);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), pool.getConnectionCount());
+
+    peer.close();
+
+    pool.stop();
+    pool.join();
+  }
+  catch(Exception& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+Connection *EchoSelector::connectionReady(const SocketAddress& address)
+{
+  return(new PoolTestConnection());
+}
+
+/*
+ */
+
+void EchoSelector::dataReceived(Connection *conn)
+{
+  byte_t buf[256];
+  size_t n = conn->readData(buf, sizeof(buf), false);
+
+  conn->writeData(buf, n);
+}
+
+/*
+ */
+
+void EchoSelector::connectionTimedOut(Connection *conn)
+{
+  delete conn;
+}
+
+/*
+ */
+
+void EchoSelector::connectionClosed(Connection *conn)
+{
+  delete conn;
+}
+
+/*
+ */
+
+Connection *TestPool::createConnection(const SocketAddress& endpoint)
+{
+  return(new PoolTestConnection());
+}
+
+/*
+ */
+
+void TestPool::connectionDataReceived(Connection *conn)
+{
+  ++received;
+}
+
+/*
+ */
+
+void TestPool::connectionLost(Connection *conn)
+{
+  ++lost;
+}
+
+/*
+ */
+
+bool AcquireHandler::await(timespan_ms_t timeout)
+{
+  for(timespan_ms_t t = 0; (fired == 0) && (t < timeout); t += 10)
+    Thread::sleep(10);
+
+  return(fired > 0);
+}
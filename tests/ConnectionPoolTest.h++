@@ -0,0 +1,103 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/Test.h>
+#include <cppunit/TestSuite.h>
+
+#include "commonc++/ConnectionPool.h++"
+
+using namespace ccxx;
+
+class PoolTestConnection : public Connection
+{
+ public:
+
+  PoolTestConnection() { }
+};
+
+class EchoSelector : public SocketSelector
+{
+ public:
+
+  EchoSelector() { }
+
+  virtual Connection *connectionReady(const SocketAddress& address);
+  virtual void dataReceived(Connection *conn);
+  virtual void connectionTimedOut(Connection *conn);
+  virtual void connectionClosed(Connection *conn);
+};
+
+class TestPool : public ConnectionPool
+{
+ public:
+
+  TestPool()
+    : ConnectionPool(8, 2, 2000, 60000), lost(0), received(0)
+  { }
+
+  int lost;
+  int received;
+
+ protected:
+
+  virtual Connection *createConnection(const SocketAddress& endpoint);
+  virtual void connectionDataReceived(Connection *conn);
+  virtual void connectionLost(Connection *conn);
+};
+
+class AcquireHandler : public EventHandler<Connection *>
+{
+ public:
+
+  AcquireHandler()
+    : fired(0), connection(NULL)
+  { }
+
+  bool await(timespan_ms_t timeout);
+
+  int fired;
+  Connection *connection;
+
+ protected:
+
+  void invoke(Connection *conn)
+  {
+    connection = conn;
+    ++fired;
+  }
+};
+
+class ConnectionPoolTest : public CppUnit::TestFixture
+{
+ public:
+
+  static CppUnit::Test *suite();
+
+  void setUp();
+  void tearDown();
+
+  void testReuse();
+  void testConnectFailure();
+  void testEviction();
+  void testIdleData();
+};
@@ -0,0 +1,239 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "ConsoleLoggerTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+#include "commonc++/ConsoleLogger.h++"
+#include "commonc++/Thread.h++"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#ifdef CCXX_OS_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ConsoleLoggerTest);
+
+using namespace ccxx;
+
+#ifdef CCXX_OS_POSIX
+
+/*
+ */
+
+// Points the standard error stream at another file descriptor for the
+// lifetime of the object. ConsoleLogger checks whether the stream is a
+// terminal when it is constructed, so the logger must be created after,
+// and destroyed before, this object.
+
+class StderrRedirect
+{
+ public:
+
+  StderrRedirect(int fd)
+  {
+    std::fflush(stderr);
+    _saved = ::dup(STDERR_FILENO);
+    ::dup2(fd, STDERR_FILENO);
+  }
+
+  ~StderrRedirect()
+  {
+    std::fflush(stderr);
+    ::dup2(_saved, STDERR_FILENO);
+    ::close(_saved);
+  }
+
+ private:
+
+  int _saved;
+};
+
+/*
+ */
+
+static std::string __readAvailable(int fd)
+{
+  std::string text;
+  char buf[256];
+  ssize_t r;
+
+  while((r = ::read(fd, buf, sizeof(buf))) > 0)
+    text.append(buf, static_cast<size_t>(r));
+
+  return(text);
+}
+
+#endif
+
+/*
+ */
+
+CppUnit::Test *ConsoleLoggerTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(ConsoleLoggerTest);
+  CCXX_TESTSUITE_TEST(ConsoleLoggerTest, testTerminal);
+  CCXX_TESTSUITE_TEST(ConsoleLoggerTest, testNotTerminal);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void ConsoleLoggerTest::setUp()
+{
+}
+
+/*
+ */
+
+void ConsoleLoggerTest::tearDown()
+{
+}
+
+/*
+ */
+
+void ConsoleLoggerTest::testTerminal()
+{
+#ifdef CCXX_OS_POSIX
+
+  int master = ::posix_openpt(O_RDWR | O_NOCTTY);
+  if(master < 0)
+  {
+    std::cout << "no pseudo-terminals; skipping test" << std::endl;
+    return;
+  }
+
+  CPPUNIT_ASSERT_EQUAL(0, ::grantpt(master));
+  CPPUNIT_ASSERT_EQUAL(0, ::unlockpt(master));
+
+  int slave = ::open(::ptsname(master), O_RDWR | O_NOCTTY);
+  CPPUNIT_ASSERT(slave >= 0);
+
+  ::fcntl(master, F_SETFL, ::fcntl(master, F_GETFL, 0) | O_NONBLOCK);
+
+  std::string text;
+
+  {
+    StderrRedirect redirect(slave);
+    ConsoleLogger logger("%@%m%.");
+
+    CPPUNIT_ASSERT(logger.isTerminal());
+
+    // terminal output is styled, and written immediately
+
+    logger.log(LogInfo, __FILE__, __LINE__, "to the terminal");
+    Thread::sleep(100);
+    text = __readAvailable(master);
+  }
+
+  ::close(slave);
+  ::close(master);
+
+  CPPUNIT_ASSERT(text.find("to the terminal") != std::string::npos);
+  CPPUNIT_ASSERT(text.find('\033') != std::string::npos);
+
+#endif
+}
+
+/*
+ */
+
+void ConsoleLoggerTest::testNotTerminal()
+{
+#ifdef CCXX_OS_POSIX
+
+  int fds[2];
+  CPPUNIT_ASSERT_EQUAL(0, ::pipe(fds));
+
+  ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+
+  std::string buffered, flushed, warned, timed, crashed, unbuffered;
+
+  {
+    StderrRedirect redirect(fds[1]);
+    ConsoleLogger logger("%@%m%.");
+
+    CPPUNIT_ASSERT(! logger.isTerminal());
+    logger.setFlushInterval(60000);
+
+    // messages are buffered, without styles
+
+    logger.log(LogInfo, __FILE__, __LINE__, "first");
+    logger.log(LogInfo, __FILE__, __LINE__, "second");
+    buffered = __readAvailable(fds[0]);
+
+    logger.flush();
+    flushed = __readAvailable(fds[0]);
+
+    // a warning is written out immediately, along with anything before it
+
+    logger.log(LogInfo, __FILE__, __LINE__, "third");
+    logger.log(LogWarning, __FILE__, __LINE__, "fourth");
+    warned = __readAvailable(fds[0]);
+
+    // a buffered message is written out once the flush interval elapses
+
+    logger.setFlushInterval(100);
+    logger.log(LogInfo, __FILE__, __LINE__, "fifth");
+    Thread::sleep(500);
+    timed = __readAvailable(fds[0]);
+
+    // as it is by a crash flush, which bypasses stdio
+
+    logger.setFlushInterval(60000);
+    logger.log(LogInfo, __FILE__, __LINE__, "crash");
+    logger.flushOnCrash();
+    crashed = __readAvailable(fds[0]);
+
+    logger.setBufferSize(0);
+    logger.log(LogInfo, __FILE__, __LINE__, "sixth");
+    unbuffered = __readAvailable(fds[0]);
+  }
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+
+  CPPUNIT_ASSERT(buffered.empty());
+  CPPUNIT_ASSERT(flushed.find("first") != std::string::npos);
+  CPPUNIT_ASSERT(flushed.find("second") != std::string::npos);
+  CPPUNIT_ASSERT(flushed.find('\033') == std::string::npos);
+
+  CPPUNIT_ASSERT(warned.find("third") != std::string::npos);
+  CPPUNIT_ASSERT(warned.find("fourth") != std::string::npos);
+
+  CPPUNIT_ASSERT(timed.find("fifth") != std::string::npos);
+  CPPUNIT_ASSERT(crashed.find("crash") != std::string::npos);
+  CPPUNIT_ASSERT(unbuffered.find("sixth") != std::string::npos);
+
+#endif
+}
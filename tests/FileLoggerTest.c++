@@ -0,0 +1,269 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "FileLoggerTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+#include "commonc++/File.h++"
+#include "commonc++/FileLogger.h++"
+#include "commonc++/Thread.h++"
+
+#include <fstream>
+#include <string>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FileLoggerTest);
+
+using namespace ccxx;
+
+static const char *__logPaths[] = { "./fileloggertest.log",
+                                    "./fileloggertest.0.log",
+                                    "./fileloggertest.1.log",
+                                    "./fileloggertest.2.log",
+                                    "./fileloggertest.3.log" };
+
+/*
+ */
+
+static int __countLines(const char *path)
+{
+  std::ifstream in(path);
+  std::string text;
+  int lines = 0;
+
+  while(std::getline(in, text))
+    ++lines;
+
+  return(lines);
+}
+
+/*
+ */
+
+// A logger whose buffer can be marked as in use, as it is while another
+// call is writing to it.
+
+class BusyFileLogger : public FileLogger
+{
+ public:
+
+  BusyFileLogger()
+    : FileLogger("%m", 2048, 1)
+  { }
+
+  void setBusy(bool busy)
+  { _bufferBusy.set(busy ? 1 : 0); }
+};
+
+/*
+ */
+
+CppUnit::Test *FileLoggerTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(FileLoggerTest);
+  CCXX_TESTSUITE_TEST(FileLoggerTest, testBuffering);
+  CCXX_TESTSUITE_TEST(FileLoggerTest, testAppend);
+  CCXX_TESTSUITE_TEST(FileLoggerTest, testRotation);
+  CCXX_TESTSUITE_TEST(FileLoggerTest, testFlushOnCrash);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void FileLoggerTest::setUp()
+{
+  for(size_t i = 0; i < CCXX_LENGTHOF(__logPaths); ++i)
+    File::remove(__logPaths[i]);
+}
+
+/*
+ */
+
+void FileLoggerTest::tearDown()
+{
+  setUp();
+}
+
+/*
+ */
+
+void FileLoggerTest::testBuffering()
+{
+  FileLogger logger("%m", 2048, 1);
+  logger.setFlushInterval(60000);
+
+  CPPUNIT_ASSERT(logger.setFile(".", "fileloggertest"));
+
+  for(int i = 0; i < 10; ++i)
+    logger.log(LogInfo, __FILE__, __LINE__, "buffered record %d", i);
+
+  // nothing is written until the buffer is flushed
+
+  CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(0),
+                       File::getSize(__logPaths[0]));
+
+  logger.flush();
+  CPPUNIT_ASSERT_EQUAL(10, __countLines(__logPaths[0]));
+
+  // a zero flush interval writes each record immediately
+
+  logger.setFlushInterval(0);
+  logger.log(LogInfo, __FILE__, __LINE__, "immediate record");
+  CPPUNIT_ASSERT_EQUAL(11, __countLines(__logPaths[0]));
+
+  // as does disabling the buffer
+
+  logger.setFlushInterval(60000);
+  logger.setBufferSize(0);
+  logger.log(LogInfo, __FILE__, __LINE__, "unbuffered record");
+  CPPUNIT_ASSERT_EQUAL(12, __countLines(__logPaths[0]));
+
+  // a record larger than the buffer bypasses it
+
+  logger.setBufferSize(16);
+  logger.log(LogInfo, __FILE__, __LINE__, "a record that is larger than the "
+             "buffer");
+  CPPUNIT_ASSERT_EQUAL(13, __countLines(__logPaths[0]));
+
+  // a buffered record is written when the flush interval elapses, even if
+  // nothing else is logged
+
+  logger.setBufferSize(FileLogger::DEFAULT_BUFFER_SIZE);
+  logger.setFlushInterval(100);
+  logger.log(LogInfo, __FILE__, __LINE__, "timed record");
+  CPPUNIT_ASSERT_EQUAL(13, __countLines(__logPaths[0]));
+
+  Thread::sleep(500);
+  CPPUNIT_ASSERT_EQUAL(14, __countLines(__logPaths[0]));
+}
+
+/*
+ */
+
+void FileLoggerTest::testAppend()
+{
+  {
+    std::ofstream out(__logPaths[0]);
+    out << "existing record" << File::eol;
+  }
+
+  {
+    FileLogger logger("%m", 2048, 1);
+    CPPUNIT_ASSERT(logger.setFile(".", "fileloggertest"));
+
+    logger.log(LogInfo, __FILE__, __LINE__, "appended record");
+  }
+
+  // the destructor flushes the buffer
+
+  std::ifstream in(__logPaths[0]);
+  std::string text;
+
+  std::getline(in, text);
+  CPPUNIT_ASSERT(text == "existing record");
+
+  std::getline(in, text);
+  CPPUNIT_ASSERT(text == "appended record");
+}
+
+/*
+ */
+
+void FileLoggerTest::testRotation()
+{
+  // each record is 32 bytes (with the newline), so 32 of them fill a 1KB
+  // log file
+
+  FileLogger logger("%m", 1, 2);
+  logger.setFlushInterval(0);
+
+  CPPUNIT_ASSERT(logger.setFile(".", "fileloggertest"));
+
+  for(int i = 0; i < 32; ++i)
+    logger.log(LogInfo, __FILE__, __LINE__, "rotation test log record: #%04d", i);
+
+  CPPUNIT_ASSERT(! logger.hasDeferredWork());
+  CPPUNIT_ASSERT(! File::exists(__logPaths[2]));
+
+  // the next record rotates the file, but only moves it aside
+
+  logger.log(LogInfo, __FILE__, __LINE__, "rotation test log record: #%04d", 32);
+
+  CPPUNIT_ASSERT(logger.hasDeferredWork());
+  CPPUNIT_ASSERT_EQUAL(32, __countLines(__logPaths[1]));
+  CPPUNIT_ASSERT_EQUAL(1, __countLines(__logPaths[0]));
+  CPPUNIT_ASSERT(! File::exists(__logPaths[2]));
+
+  logger.completeDeferredWork();
+
+  CPPUNIT_ASSERT(! logger.hasDeferredWork());
+  CPPUNIT_ASSERT(! File::exists(__logPaths[1]));
+  CPPUNIT_ASSERT_EQUAL(32, __countLines(__logPaths[2]));
+
+  // a rotation that is still pending is completed before the next one
+
+  for(int i = 33; i < 200; ++i)
+    logger.log(LogInfo, __FILE__, __LINE__, "rotation test log record: #%04d", i);
+
+  logger.completeDeferredWork();
+
+  CPPUNIT_ASSERT(! File::exists(__logPaths[1]));
+  CPPUNIT_ASSERT(! File::exists(__logPaths[4]));
+  CPPUNIT_ASSERT_EQUAL(32, __countLines(__logPaths[2]));
+  CPPUNIT_ASSERT_EQUAL(32, __countLines(__logPaths[3]));
+  CPPUNIT_ASSERT_EQUAL(200 - (6 * 32), __countLines(__logPaths[0]));
+  CPPUNIT_ASSERT(File::getSize(__logPaths[0]) <= 1024);
+}
+
+/*
+ */
+
+void FileLoggerTest::testFlushOnCrash()
+{
+  BusyFileLogger logger;
+  logger.setFlushInterval(60000);
+
+  CPPUNIT_ASSERT(logger.setFile(".", "fileloggertest"));
+
+  logger.log(LogInfo, __FILE__, __LINE__, "first record");
+  CPPUNIT_ASSERT_EQUAL(0, __countLines(__logPaths[0]));
+
+  // nothing is written while the buffer is in use
+
+  logger.setBusy(true);
+  logger.flushOnCrash();
+  CPPUNIT_ASSERT_EQUAL(0, __countLines(__logPaths[0]));
+
+  logger.setBusy(false);
+  logger.flushOnCrash();
+  CPPUNIT_ASSERT_EQUAL(1, __countLines(__logPaths[0]));
+
+  // the buffer is still usable afterwards
+
+  logger.log(LogInfo, __FILE__, __LINE__, "second record");
+  logger.flush();
+  CPPUNIT_ASSERT_EQUAL(2, __countLines(__logPaths[0]));
+}
@@ -27,12 +27,20 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "commonc++/Common.h++"
+#include "commonc++/AlignedBuffer.h++"
 #include "commonc++/File.h++"
+#include "commonc++/UnsupportedOperationException.h++"
 
 #ifdef CCXX_OS_WINDOWS
 #include <commonc++/Windows.h++>
 #endif
 
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
 using namespace ccxx;
 
 CPPUNIT_TEST_SUITE_REGISTRATION(FileTest);
@@ -46,6 +54,10 @@ CppUnit::Test *FileTest::suite()
   CCXX_TESTSUITE_TEST(FileTest, testSymLinks);
   CCXX_TESTSUITE_TEST(FileTest, testDirs);
   CCXX_TESTSUITE_TEST(FileTest, testCopyMoveRenameDel);
+  CCXX_TESTSUITE_TEST(FileTest, testCopyMethods);
+  CCXX_TESTSUITE_TEST(FileTest, testReadToString);
+  CCXX_TESTSUITE_TEST(FileTest, testAllocateAdviseSync);
+  CCXX_TESTSUITE_TEST(FileTest, testDirectIO);
   CCXX_TESTSUITE_TEST(FileTest, testFilesystem);
   CCXX_TESTSUITE_TEST(FileTest, testPermissions);
   CCXX_TESTSUITE_TEST(FileTest, testTrimSeparators);
@@ -259,3 +271,319 @@ void FileTest::testTrimSeparators()
   }
 
 }
+
+/*
+ */
+
+static bool __readFile(const char* path, std::vector<char>& data)
+{
+  std::FILE *fp = std::fopen(path, "rb");
+  if(! fp)
+    return(false);
+
+  char buf[65536];
+  size_t n;
+
+  data.clear();
+  while((n = std::fread(buf, 1, sizeof(buf), fp)) > 0)
+    data.insert(data.end(), buf, buf + n);
+
+  std::fclose(fp);
+  return(true);
+}
+
+/*
+ */
+
+void FileTest::testCopyMethods()
+{
+  static const char *src = "./testdata/copy_src.bin";
+  static const char *dst = "./testdata/copy_dst.bin";
+
+  File::remove(src);
+  File::remove(dst);
+
+  // a file larger than the copy buffer, with an odd size
+
+  std::vector<char> data(3 * 1024 * 1024 + 17);
+  for(size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<char>((i * 31) ^ (i >> 11));
+
+  std::FILE *fp = std::fopen(src, "wb");
+  CPPUNIT_ASSERT(fp != NULL);
+  CPPUNIT_ASSERT_EQUAL(data.size(), std::fwrite(&data[0], 1, data.size(), fp));
+  std::fclose(fp);
+
+  FileCopyMethod method = FileCopyNone;
+  CPPUNIT_ASSERT(File::copy(src, dst, method));
+  CPPUNIT_ASSERT(method != FileCopyNone);
+
+  std::vector<char> copied;
+  CPPUNIT_ASSERT(__readFile(dst, copied));
+  CPPUNIT_ASSERT(copied == data);
+
+  // the target must not exist
+
+  CPPUNIT_ASSERT(! File::copy(src, dst, method));
+  CPPUNIT_ASSERT_EQUAL(FileCopyNone, method);
+
+  File::remove(dst);
+
+  // an empty file
+
+  fp = std::fopen(src, "wb");
+  std::fclose(fp);
+
+  CPPUNIT_ASSERT(File::copy(src, dst, method));
+  CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(0), File::getSize(dst));
+
+  File::remove(dst);
+
+#ifdef __linux__
+
+  // a file that reports a size of 0 but has content
+
+  CPPUNIT_ASSERT(File::copy("/proc/self/status", dst, method));
+  CPPUNIT_ASSERT_EQUAL(FileCopyBuffered, method);
+  CPPUNIT_ASSERT(File::getSize(dst) > 0);
+
+  File::remove(dst);
+
+#endif
+
+  File::remove(src);
+}
+
+/*
+ */
+
+static void __writeFile(const char *path, const char *data, size_t len)
+{
+  std::FILE *fp = std::fopen(path, "wb");
+  CPPUNIT_ASSERT(fp != NULL);
+  if(len > 0)
+    CPPUNIT_ASSERT_EQUAL(len, std::fwrite(data, 1, len, fp));
+  std::fclose(fp);
+}
+
+/*
+ */
+
+void FileTest::testReadToString()
+{
+  static const char *path = "./testdata/read_to_string.txt";
+
+  // mixed ASCII, 2-, 3- and 4-byte sequences
+
+  static const char text[] = "Hello, w\xC3\xB6rld! \xE2\x82\xAC 100 "
+    "\xF0\x9D\x84\x9E clef";
+
+  __writeFile(path, text, sizeof(text) - 1);
+
+  String s = File::readToString(path);
+  CPPUNIT_ASSERT(! s.isNull());
+  CPPUNIT_ASSERT_EQUAL(String(text), s);
+  CPPUNIT_ASSERT_EQUAL(static_cast<uint_t>(27), s.length());
+  const String& cs = s;
+  CPPUNIT_ASSERT_EQUAL(static_cast<char16_t>(0xD834), cs[20].toChar16());
+  CPPUNIT_ASSERT_EQUAL(static_cast<char16_t>(0xDD1E), cs[21].toChar16());
+
+  // a large file, with multibyte characters straddling the ASCII runs
+
+  std::string big;
+  for(int i = 0; i < 100000; ++i)
+  {
+    big += "line of text ";
+    if(i % 7 == 0)
+      big += "\xC3\xA9";
+    big += '\n';
+  }
+
+  __writeFile(path, big.data(), big.length());
+
+  s = File::readToString(path);
+  CPPUNIT_ASSERT(! s.isNull());
+  CPPUNIT_ASSERT_EQUAL(String(big.c_str()), s);
+
+  // an empty file
+
+  __writeFile(path, NULL, 0);
+
+  s = File::readToString(path);
+  CPPUNIT_ASSERT(! s.isNull());
+  CPPUNIT_ASSERT(s.isEmpty());
+
+  // invalid UTF-8
+
+  static const char bad[] = "abcdefghij\xC3(klmnop";
+  __writeFile(path, bad, sizeof(bad) - 1);
+
+  CPPUNIT_ASSERT(File::readToString(path).isNull());
+
+  // truncated sequence at EOF
+
+  static const char trunc[] = "abcdefghij\xE2\x82";
+  __writeFile(path, trunc, sizeof(trunc) - 1);
+
+  CPPUNIT_ASSERT(File::readToString(path).isNull());
+
+  File::remove(path);
+
+  // a missing file
+
+  CPPUNIT_ASSERT(File::readToString(path).isNull());
+
+#ifdef __linux__
+
+  // a file that reports a size of 0 but has content
+
+  s = File::readToString("/proc/self/status");
+  CPPUNIT_ASSERT(! s.isNull());
+  CPPUNIT_ASSERT(s.startsWith("Name:"));
+
+#endif
+}
+
+/*
+ */
+
+void FileTest::testAllocateAdviseSync()
+{
+  static const char *path = "./testdata/allocate.bin";
+
+  File::remove(path);
+
+  try
+  {
+    File file(path);
+    file.open(IOReadWrite, FileTruncateElseCreate);
+
+    // preallocate without changing the size, then with
+
+    try
+    {
+      file.allocate(0, 65536, FileAllocateKeepSize);
+      CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(0), file.getSize());
+    }
+    catch(UnsupportedOperationException&)
+    {
+    }
+
+    file.allocate(0, 65536);
+    CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(65536), file.getSize());
+
+    std::vector<byte_t> data(65536, 0xAB);
+    CPPUNIT_ASSERT_EQUAL(data.size(), file.writeFully(&data[0], data.size()));
+
+    file.syncRange(0, 0);
+    file.syncRange(0, 4096, true);
+
+    file.advise(0, 0, FileAdviseSequential);
+    file.advise(0, 4096, FileAdviseWillNeed);
+    file.advise(0, 0, FileAdviseDontNeed);
+    file.advise(0, 0, FileAdviseNoReuse);
+    file.advise(0, 0, FileAdviseNormal);
+
+    // punch a hole; not all file systems support this
+
+    try
+    {
+      file.allocate(4096, 8192, FileAllocatePunchHole);
+
+      CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(65536), file.getSize());
+
+      byte_t buf[16384];
+      file.seek(0);
+      CPPUNIT_ASSERT_EQUAL(sizeof(buf), file.readFully(buf, sizeof(buf)));
+
+      CPPUNIT_ASSERT_EQUAL(static_cast<byte_t>(0xAB), buf[4095]);
+      CPPUNIT_ASSERT_EQUAL(static_cast<byte_t>(0), buf[4096]);
+      CPPUNIT_ASSERT_EQUAL(static_cast<byte_t>(0), buf[12287]);
+      CPPUNIT_ASSERT_EQUAL(static_cast<byte_t>(0xAB), buf[12288]);
+    }
+    catch(UnsupportedOperationException&)
+    {
+    }
+    catch(IOException& ex)
+    {
+      std::cout << "\nhole punching unavailable: " << ex.getMessage()
+                << std::endl;
+    }
+
+    file.close();
+  }
+  catch(IOException& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+
+  File::remove(path);
+}
+
+/*
+ */
+
+void FileTest::testDirectIO()
+{
+  static const char *path = "./testdata/direct.bin";
+
+  File::remove(path);
+
+  size_t alignment = File::getDirectIOAlignment("./testdata");
+  CPPUNIT_ASSERT(alignment >= 512);
+  CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), alignment & (alignment - 1));
+
+  AlignedBuffer buf(alignment * 4 - 100, alignment);
+  CPPUNIT_ASSERT_EQUAL(alignment * 4, buf.getSize());
+  CPPUNIT_ASSERT_EQUAL(alignment, buf.getAlignment());
+  CPPUNIT_ASSERT_EQUAL(static_cast<uintptr_t>(0),
+                       reinterpret_cast<uintptr_t>(buf.getData())
+                       % alignment);
+
+  CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(alignment * 2),
+                       AlignedBuffer::alignUp(alignment + 1, alignment));
+  CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(alignment),
+                       AlignedBuffer::alignDown(alignment * 2 - 1, alignment));
+
+  for(size_t i = 0; i < buf.getSize(); ++i)
+    buf.getData()[i] = static_cast<byte_t>(i % 251);
+
+  File file(path);
+  file.setDirectIO(true);
+  CPPUNIT_ASSERT(file.isDirectIO());
+
+  try
+  {
+    file.open(IOReadWrite, FileTruncateElseCreate);
+  }
+  catch(IOException& ex)
+  {
+    // some file systems (e.g. tmpfs) do not support direct I/O
+
+    std::cout << "\ndirect I/O unavailable: " << ex.getMessage()
+              << std::endl;
+    File::remove(path);
+    return;
+  }
+
+  try
+  {
+    CPPUNIT_ASSERT_EQUAL(buf.getSize(),
+                         file.writeFully(buf.getData(), buf.getSize()));
+
+    AlignedBuffer buf2(buf.getSize(), alignment);
+    file.seek(0);
+    CPPUNIT_ASSERT_EQUAL(buf2.getSize(),
+                         file.readFully(buf2.getData(), buf2.getSize()));
+    CPPUNIT_ASSERT(std::memcmp(buf.getData(), buf2.getData(),
+                               buf.getSize()) == 0);
+
+    file.close();
+  }
+  catch(IOException& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+
+  File::remove(path);
+}
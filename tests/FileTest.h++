@@ -37,6 +37,10 @@ class FileTest : public CppUnit::TestFixture
   void testSymLinks();
   void testDirs();
   void testCopyMoveRenameDel();
+  void testCopyMethods();
+  void testReadToString();
+  void testAllocateAdviseSync();
+  void testDirectIO();
   void testFilesystem();
   void testPermissions();
   void testTrimSeparators();
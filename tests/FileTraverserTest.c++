@@ -27,7 +27,9 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "commonc++/Common.h++"
+#include "commonc++/File.h++"
 #include "commonc++/FileTraverser.h++"
+#include "commonc++/ScopedLock.h++"
 
 #include <iostream>
 
@@ -54,6 +56,7 @@ CppUnit::Test *FileTraverserTest::suite()
   CCXX_TESTSUITE_BEGIN(FileTraverserTest);
   CCXX_TESTSUITE_TEST(FileTraverserTest, testDepthFirst);
   CCXX_TESTSUITE_TEST(FileTraverserTest, testBreadthFirst);
+  CCXX_TESTSUITE_TEST(FileTraverserTest, testParallel);
   CCXX_TESTSUITE_END();
 }
 
@@ -113,6 +116,64 @@ void FileTraverserTest::testBreadthFirst()
   CPPUNIT_ASSERT_EQUAL(true, ok);
 }
 
+/*
+ */
+
+void FileTraverserTest::testParallel()
+{
+  static const char *base = "testdata/partree";
+
+  File::removeDirectoryTree(base);
+
+  // 8 directories of 3 subdirectories of 5 files each
+
+  for(int i = 0; i < 8; ++i)
+  {
+    for(int j = 0; j < 3; ++j)
+    {
+      String dir = base;
+      dir += "/d";
+      dir.append(i);
+      dir += "/s";
+      dir.append(j);
+
+      CPPUNIT_ASSERT(File::makeDirectory(dir, true));
+
+      for(int k = 0; k < 5; ++k)
+      {
+        String file = dir;
+        file += "/f";
+        file.append(k);
+
+        CPPUNIT_ASSERT(File::touch(file));
+      }
+    }
+  }
+
+  ParallelTraverser trav(base);
+  CPPUNIT_ASSERT(trav.traverseParallel(4));
+
+  CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1 + 8 + 24 + 120),
+                       trav.seen.size());
+  CPPUNIT_ASSERT_EQUAL(static_cast<uint_t>(1 + 8 + 24), trav.dirs);
+  CPPUNIT_ASSERT(trav.ordered);
+  CPPUNIT_ASSERT(trav.depthOK);
+
+  // the traversal can be stopped early
+
+  ParallelTraverser stopper(base, "s1");
+  CPPUNIT_ASSERT(! stopper.traverseParallel(4));
+  CPPUNIT_ASSERT(stopper.seen.size() < trav.seen.size());
+
+  // a single thread visits the same files
+
+  ParallelTraverser single(base);
+  CPPUNIT_ASSERT(single.traverseParallel(1));
+  CPPUNIT_ASSERT(single.seen == trav.seen);
+
+  File::removeDirectoryTree(base);
+}
+
 /*
  */
 
@@ -153,3 +214,62 @@ bool FileTraverserTest::TestTraverser::processFile(const FileName &name,
 
   return(true);
 }
+
+/*
+ */
+
+FileTraverserTest::ParallelTraverser::ParallelTraverser(
+  const String& path, const String& stopAt /* = "" */)
+  : FileTraverser(path),
+    dirs(0),
+    ordered(true),
+    depthOK(true),
+    _stopAt(stopAt)
+{
+}
+
+/*
+ */
+
+FileTraverserTest::ParallelTraverser::~ParallelTraverser() throw()
+{
+}
+
+/*
+ */
+
+bool FileTraverserTest::ParallelTraverser::processFile(const FileName &name,
+                                                       bool isDir,
+                                                       uint_t depth)
+{
+  std::string path = name.getPathName().toUTF8().data();
+  std::string parent = path.substr(0, path.rfind('/'));
+
+  uint_t slashes = 0;
+  for(size_t i = 0; i < path.length(); ++i)
+  {
+    if(path[i] == '/')
+      ++slashes;
+  }
+
+  synchronized(_lock)
+  {
+    // a directory is processed before its contents
+    if((depth > 0) && (seen.find(parent) == seen.end()))
+      ordered = false;
+
+    // "testdata/partree" is at depth 0
+    if(slashes != depth + 1)
+      depthOK = false;
+
+    if(isDir != File::isDirectory(name.getPathName()))
+      depthOK = false;
+
+    seen.insert(path);
+
+    if(isDir)
+      ++dirs;
+  }
+
+  return(name.getFileName() != _stopAt);
+}
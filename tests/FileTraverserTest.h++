@@ -25,8 +25,12 @@
 #include <cppunit/TestSuite.h>
 
 #include "commonc++/FileTraverser.h++"
+#include "commonc++/Mutex.h++"
 #include "commonc++/String.h++"
 
+#include <set>
+#include <string>
+
 using namespace ccxx;
 
 class FileTraverserTest : public CppUnit::TestFixture
@@ -40,6 +44,7 @@ class FileTraverserTest : public CppUnit::TestFixture
 
   void testBreadthFirst();
   void testDepthFirst();
+  void testParallel();
 
  private:
 
@@ -62,4 +67,26 @@ class FileTraverserTest : public CppUnit::TestFixture
     const char ** _expected;
   };
 
+  class ParallelTraverser : public FileTraverser
+  {
+   public:
+
+    ParallelTraverser(const String& path, const String& stopAt = "");
+    ~ParallelTraverser() throw();
+
+    std::set<std::string> seen;
+    uint_t dirs;
+    bool ordered;
+    bool depthOK;
+
+   protected:
+
+    bool processFile(const FileName &name, bool isDir, uint_t depth);
+
+   private:
+
+    Mutex _lock;
+    String _stopAt;
+  };
+
 };
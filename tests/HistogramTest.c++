@@ -0,0 +1,118 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "HistogramTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+#include "commonc++/Histogram.h++"
+
+using namespace ccxx;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HistogramTest);
+
+/*
+ */
+
+CppUnit::Test *HistogramTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(HistogramTest);
+  CCXX_TESTSUITE_TEST(HistogramTest, testHistogram);
+  CCXX_TESTSUITE_TEST(HistogramTest, testMerge);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void HistogramTest::setUp()
+{
+}
+
+/*
+ */
+
+void HistogramTest::tearDown()
+{
+}
+
+/*
+ */
+
+void HistogramTest::testHistogram()
+{
+  Histogram h;
+
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(0), h.getCount());
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(0), h.getMin());
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(0), h.getPercentile(50.0));
+
+  h.record(0);
+  h.record(1);
+  h.record(5);
+  h.record(7);
+  h.record(1000);
+
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(5), h.getCount());
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(1013), h.getSum());
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(0), h.getMin());
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(1000), h.getMax());
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(202.6, h.getMean(), 0.001);
+
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(1), h.getBucketCount(0));
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(1), h.getBucketCount(1));
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(2), h.getBucketCount(3));
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(1), h.getBucketCount(10));
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(0), h.getBucketCount(64));
+
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(8), Histogram::getBucketLimit(3));
+
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(8), h.getPercentile(50.0));
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(1000), h.getPercentile(99.0));
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(1000), h.getPercentile(100.0));
+
+  h.reset();
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(0), h.getCount());
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(0), h.getMax());
+}
+
+/*
+ */
+
+void HistogramTest::testMerge()
+{
+  Histogram a, b;
+
+  a.record(3);
+  b.record(100);
+  b.record(2);
+
+  a.merge(b);
+
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(3), a.getCount());
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(2), a.getMin());
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(100), a.getMax());
+  CPPUNIT_ASSERT_EQUAL(UINT64_CONST(2), a.getBucketCount(2));
+}
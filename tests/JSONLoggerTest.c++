@@ -0,0 +1,224 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "JSONLoggerTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(JSONLoggerTest);
+
+/*
+ */
+
+bool StringLogger::write(CharBuffer& buffer)
+{
+  text.append(buffer.getPointer(), buffer.getRemaining());
+
+  return(true);
+}
+
+/*
+ */
+
+std::string StringLogger::last() const
+{
+  size_t end = text.rfind('\n', text.length() - 2);
+  std::string rec = text.substr(end == std::string::npos ? 0 : end + 1);
+
+  // {"ts":1234567890123,"level":...
+  size_t comma = rec.find(',');
+  if((rec.compare(0, 6, "{\"ts\":") != 0) || (comma == std::string::npos))
+    return("");
+
+  for(size_t i = 6; i < comma; ++i)
+  {
+    if((rec[i] < '0') || (rec[i] > '9'))
+      return("");
+  }
+
+  return("{" + rec.substr(comma + 1));
+}
+
+/*
+ */
+
+CppUnit::Test *JSONLoggerTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(JSONLoggerTest);
+  CCXX_TESTSUITE_TEST(JSONLoggerTest, testFields);
+  CCXX_TESTSUITE_TEST(JSONLoggerTest, testEscaping);
+  CCXX_TESTSUITE_TEST(JSONLoggerTest, testMessage);
+  CCXX_TESTSUITE_TEST(JSONLoggerTest, testTruncation);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void JSONLoggerTest::setUp()
+{
+}
+
+/*
+ */
+
+void JSONLoggerTest::tearDown()
+{
+}
+
+/*
+ */
+
+void JSONLoggerTest::testFields()
+{
+  StringLogger target;
+  JSONLogger logger(&target);
+
+  LogField fields[] = {
+    LogField("user", "alice"),
+    LogField("count", 42),
+    LogField("offset", INT64_CONST(-9223372036854775807) - 1),
+    LogField("bytes", UINT64_CONST(18446744073709551615)),
+    LogField("ratio", 0.5),
+    LogField("cached", true),
+    LogField("elapsed", TimeSpan(1500)),
+    LogField("missing", static_cast<const char *>(NULL)),
+    LogField("prefix", "abcdef", 3)
+  };
+
+  logger.logFields(LogInfo, "main.c++", 17, "request done", fields,
+                   CCXX_LENGTHOF(fields));
+
+  CPPUNIT_ASSERT_EQUAL(std::string(
+    "{\"level\":\"info\",\"line\":17,\"file\":\"main.c++\","
+    "\"msg\":\"request done\",\"user\":\"alice\",\"count\":42,"
+    "\"offset\":-9223372036854775808,\"bytes\":18446744073709551615,"
+    "\"ratio\":0.5,\"cached\":true,\"elapsed\":1500,\"missing\":null,"
+    "\"prefix\":\"abc\"}\n"), target.last());
+
+  // the macro captures the source location
+
+  LogField more[] = { LogField("ok", false) };
+  Log_fields(logger, LogWarning, "again", more);
+
+  std::string rec = target.last();
+  CPPUNIT_ASSERT(rec.find("\"level\":\"warning\"") != std::string::npos);
+  CPPUNIT_ASSERT(rec.find("JSONLoggerTest.c++") != std::string::npos);
+  CPPUNIT_ASSERT(rec.find(",\"ok\":false}\n") != std::string::npos);
+
+  // disabled levels are dropped
+
+  size_t len = target.text.length();
+  logger.disableLogLevel(LogDebug);
+  logger.logFields(LogDebug, "main.c++", 1, "hidden", fields, 1);
+  CPPUNIT_ASSERT_EQUAL(len, target.text.length());
+}
+
+/*
+ */
+
+void JSONLoggerTest::testEscaping()
+{
+  StringLogger target;
+  JSONLogger logger(&target);
+
+  LogField fields[] = {
+    LogField("quote", "say \"hi\"\\"),
+    LogField("ctrl", "a\tb\nc\r\x01"),
+    LogField("utf8", "caf\xc3\xa9")
+  };
+
+  logger.logFields(LogError, "x", 1, "line\nbreak", fields,
+                   CCXX_LENGTHOF(fields));
+
+  CPPUNIT_ASSERT_EQUAL(std::string(
+    "{\"level\":\"error\",\"line\":1,\"file\":\"x\","
+    "\"msg\":\"line\\nbreak\",\"quote\":\"say \\\"hi\\\"\\\\\","
+    "\"ctrl\":\"a\\tb\\nc\\r\\u0001\",\"utf8\":\"caf\xc3\xa9\"}\n"),
+                       target.last());
+}
+
+/*
+ */
+
+void JSONLoggerTest::testMessage()
+{
+  StringLogger target;
+  JSONLogger logger(&target);
+
+  logger.log(LogDebug, "y", 2, "%d \"items\" in %s", 3, "queue");
+
+  CPPUNIT_ASSERT_EQUAL(std::string(
+    "{\"level\":\"debug\",\"line\":2,\"file\":\"y\","
+    "\"msg\":\"3 \\\"items\\\" in queue\"}\n"), target.last());
+}
+
+/*
+ */
+
+void JSONLoggerTest::testTruncation()
+{
+  StringLogger target;
+  JSONLogger logger(&target, 128);
+
+  // a field that doesn't fit is dropped whole
+
+  LogField fields[] = {
+    LogField("a", 1),
+    LogField("long", "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"),
+    LogField("b", 2)
+  };
+
+  logger.logFields(LogInfo, "z", 3, "m", fields, CCXX_LENGTHOF(fields));
+
+  CPPUNIT_ASSERT_EQUAL(std::string(
+    "{\"level\":\"info\",\"line\":3,\"file\":\"z\",\"msg\":\"m\",\"a\":1,"
+    "\"truncated\":true}\n"), target.last());
+
+  // a long message is clipped, but not within a UTF-8 sequence
+
+  std::string msg = "\t";
+  for(int i = 0; i < 60; ++i)
+    msg += "\xc3\xa9";
+
+  logger.logFields(LogInfo, "z", 3, msg.c_str(), fields, 0);
+
+  std::string rec = target.text.substr(target.text.rfind('\n',
+                                       target.text.length() - 2) + 1);
+  CPPUNIT_ASSERT(rec.length() <= 128);
+
+  const std::string tail = "\",\"truncated\":true}\n";
+  CPPUNIT_ASSERT_EQUAL(tail, rec.substr(rec.length() - tail.length()));
+
+  size_t body = rec.find("\"msg\":\"") + 7;
+  std::string clipped = rec.substr(body, rec.length() - tail.length() - body);
+  CPPUNIT_ASSERT(clipped.length() > 2);
+  CPPUNIT_ASSERT_EQUAL(std::string("\\t"), clipped.substr(0, 2));
+  CPPUNIT_ASSERT(clipped.length() % 2 == 0);
+
+  for(size_t i = 2; i < clipped.length(); i += 2)
+    CPPUNIT_ASSERT_EQUAL(std::string("\xc3\xa9"), clipped.substr(i, 2));
+}
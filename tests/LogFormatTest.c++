@@ -27,15 +27,65 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "commonc++/Common.h++"
+#include "commonc++/Buffer.h++"
+#include "commonc++/DateTimeFormat.h++"
 #include "commonc++/Log.h++"
 #include "commonc++/LogFormat.h++"
+#include "commonc++/System.h++"
 
+#include <cstdarg>
+#include <cstring>
 #include <iostream>
 
 CPPUNIT_TEST_SUITE_REGISTRATION(LogFormatTest);
 
 using namespace ccxx;
 
+/*
+ */
+
+static void formatInto(LogFormat& format, CharBuffer& buf, time_ms_t time,
+                       const char* message, ...)
+{
+  va_list args;
+
+  buf.clear();
+  va_start(args, message);
+  format.format(buf, LogInfo, time, "file.c++", 1, message, args);
+  va_end(args);
+  buf.flip();
+}
+
+/*
+ */
+
+static String formatLine(LogFormat& format, time_ms_t time,
+                         const char* message, ...)
+{
+  CharBuffer buf(256);
+  va_list args;
+
+  va_start(args, message);
+  format.format(buf, LogInfo, time, "file.c++", 1, message, args);
+  va_end(args);
+
+  buf.flip();
+  return(String(buf.getPointer(), 0,
+                static_cast<uint_t>(buf.getRemaining())));
+}
+
+/*
+ */
+
+static String formatDirect(const char* format, time_ms_t time)
+{
+  DateTimeFormat dtf(format);
+  char buf[128];
+
+  dtf.format(DateTime(time), buf, sizeof(buf));
+  return(String(buf));
+}
+
 /*
  */
 
@@ -43,6 +93,9 @@ CppUnit::Test *LogFormatTest::suite()
 {
   CCXX_TESTSUITE_BEGIN(LogFormatTest);
   CCXX_TESTSUITE_TEST(LogFormatTest, testLogFormat);
+  CCXX_TESTSUITE_TEST(LogFormatTest, testTimestampCache);
+  CCXX_TESTSUITE_TEST(LogFormatTest, testTimestampBenchmark);
+  CCXX_TESTSUITE_TEST(LogFormatTest, testStylesDisabled);
   CCXX_TESTSUITE_END();
 }
 
@@ -105,3 +158,147 @@ void LogFormatTest::testLogFormat()
   std::cin >> c;
   CPPUNIT_ASSERT(tolower(c) == 'y');
 }
+
+/*
+ */
+
+void LogFormatTest::testTimestampCache()
+{
+  static const char* timeFormat = "%_H:%0M:%0S.%0s [%_s] %s";
+  static const char* dateFormat = "%0d-%$m-%0Y";
+
+  LogFormat format("%T|%D|%t|%m");
+  format.setLongTimeFormat(timeFormat);
+  format.setLongDateFormat(dateFormat);
+
+  // successive milliseconds within a second, then across a second and a
+  // date boundary, and then back in time
+
+  const time_ms_t base = INT64_CONST(1400000000000);
+  const time_ms_t times[] = { base, base + 1, base + 9, base + 10,
+                              base + 99, base + 100, base + 999,
+                              base + 1000, base + 1005, base + 86400000,
+                              base + 86400123, base + 7, base + 999 };
+
+  for(size_t i = 0; i < (sizeof(times) / sizeof(times[0])); ++i)
+  {
+    String expected = formatDirect(timeFormat, times[i]);
+    expected += '|';
+    expected += formatDirect(dateFormat, times[i]);
+    expected += '|';
+    expected += formatDirect("%_H:%0M:%0S", times[i]);
+    expected += "|msg ";
+    expected.append(static_cast<int>(i));
+    expected += File::eol;
+
+    String actual = formatLine(format, times[i], "msg %d", (int)i);
+
+    CPPUNIT_ASSERT_EQUAL(expected, actual);
+  }
+
+  // changing a format must not reuse the cached text
+
+  format.setLongTimeFormat("%0S:%0s");
+  String actual = formatLine(format, base + 42, "x");
+  String expected = formatDirect("%0S:%0s", base + 42);
+  expected += '|';
+  expected += formatDirect(dateFormat, base + 42);
+  expected += '|';
+  expected += formatDirect("%_H:%0M:%0S", base + 42);
+  expected += "|x";
+  expected += File::eol;
+
+  CPPUNIT_ASSERT_EQUAL(expected, actual);
+
+  // a buffer too small for the whole timestamp is truncated consistently
+
+  LogFormat narrow("%T");
+  CharBuffer small(6 + std::strlen(File::eol));
+  formatInto(narrow, small, base + 123, "");
+
+  // (one byte of the remaining space is consumed by the terminator)
+
+  expected = formatDirect("%_H:%0M:%0S.%0s", base + 123).substring(0, 5);
+  expected += File::eol;
+  CPPUNIT_ASSERT_EQUAL(expected,
+                       String(small.getPointer(), 0,
+                              static_cast<uint_t>(small.getRemaining())));
+}
+
+/*
+ */
+
+void LogFormatTest::testTimestampBenchmark()
+{
+  static const int iterations = 200000;
+
+  const char* timeFormat = "%_H:%0M:%0S.%0s";
+  const char* dateFormat = "%0d-%$m-%0Y";
+  DateTimeFormat longTime(timeFormat);
+  DateTimeFormat longDate(dateFormat);
+  LogFormat format("[%D %T] %m");
+  char buf[128];
+  size_t total = 0;
+
+  time_ms_t base = System::currentTimeMillis();
+
+  // direct formatting: every line renders the whole date and time
+
+  time_ms_t start = System::currentTimeMillis();
+  for(int i = 0; i < iterations; ++i)
+  {
+    DateTime dt(base + (i / 50));
+    total += longDate.format(dt, buf, sizeof(buf));
+    total += longTime.format(dt, buf, sizeof(buf));
+  }
+  time_ms_t direct = System::currentTimeMillis() - start;
+
+  // cached formatting: once per second, then only the milliseconds
+
+  CharBuffer line(256);
+  start = System::currentTimeMillis();
+  for(int i = 0; i < iterations; ++i)
+  {
+    formatInto(format, line, base + (i / 50), "m");
+    total += line.getRemaining();
+  }
+  time_ms_t cached = System::currentTimeMillis() - start;
+
+  CPPUNIT_ASSERT(total > 0);
+
+  std::cout << "\ndate/time formatting: direct "
+            << (direct * 1000000 / iterations) << " ns/line, "
+            << "LogFormat (cached, whole line) "
+            << (cached * 1000000 / iterations) << " ns/line" << std::endl;
+}
+
+/*
+ */
+
+void LogFormatTest::testStylesDisabled()
+{
+  LogFormat format("%@%*%_%#%2%l%-%0 %m%8%.");
+  const time_ms_t base = INT64_CONST(1400000000000);
+
+  CPPUNIT_ASSERT(format.isStylesEnabled());
+
+  String styled = formatLine(format, base, "plain");
+  CPPUNIT_ASSERT(styled.indexOf("\033") >= 0);
+
+  // the styled line carries the same text, wrapped in escape sequences
+
+  int level = styled.indexOf("I");
+  CPPUNIT_ASSERT(level >= 0);
+  CPPUNIT_ASSERT(styled.indexOf(" plain", level) > level);
+  CPPUNIT_ASSERT(styled.endsWith(File::eol));
+
+  format.setStylesEnabled(false);
+  CPPUNIT_ASSERT(! format.isStylesEnabled());
+
+  String expected = "I plain";
+  expected += File::eol;
+
+  String unstyled = formatLine(format, base, "plain");
+  CPPUNIT_ASSERT_EQUAL(expected, unstyled);
+  CPPUNIT_ASSERT(styled.getLength() > unstyled.getLength());
+}
@@ -34,4 +34,7 @@ class LogFormatTest : public CppUnit::TestFixture
   void tearDown();
 
   void testLogFormat();
+  void testTimestampCache();
+  void testTimestampBenchmark();
+  void testStylesDisabled();
 };
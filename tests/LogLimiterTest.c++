@@ -0,0 +1,178 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "LogLimiterTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+#include "commonc++/Log.h++"
+#include "commonc++/LogLimiter.h++"
+#include "commonc++/Thread.h++"
+
+#include <cstdio>
+#include <cstring>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LogLimiterTest);
+
+/*
+ */
+
+bool CaptureConsoleLogger::write(CharBuffer& buffer)
+{
+  const char *p = buffer.getPointer();
+  int n = 0;
+
+  if(std::sscanf(p, "*** %d similar", &n) == 1)
+  {
+    ++reports;
+    suppressed += n;
+  }
+  else
+    ++messages;
+
+  return(true);
+}
+
+/*
+ */
+
+CppUnit::Test *LogLimiterTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(LogLimiterTest);
+  CCXX_TESTSUITE_TEST(LogLimiterTest, testSampling);
+  CCXX_TESTSUITE_TEST(LogLimiterTest, testRateLimit);
+  CCXX_TESTSUITE_TEST(LogLimiterTest, testMacros);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void LogLimiterTest::setUp()
+{
+}
+
+/*
+ */
+
+void LogLimiterTest::tearDown()
+{
+}
+
+/*
+ */
+
+void LogLimiterTest::testSampling()
+{
+  LogLimiter limiter(0, 10);
+  int passed = 0;
+
+  for(int i = 0; i < 100; ++i)
+  {
+    if(limiter.allow())
+    {
+      // the first of every ten is passed
+      CPPUNIT_ASSERT_EQUAL(0, i % 10);
+      ++passed;
+    }
+  }
+
+  CPPUNIT_ASSERT_EQUAL(10, passed);
+  CPPUNIT_ASSERT_EQUAL(90, limiter.getSuppressedCount());
+}
+
+/*
+ */
+
+void LogLimiterTest::testRateLimit()
+{
+  LogLimiter limiter(5);
+  int passed = 0;
+
+  // the calls may straddle a second boundary, but never two
+
+  for(int i = 0; i < 1000; ++i)
+  {
+    if(limiter.allow())
+      ++passed;
+  }
+
+  CPPUNIT_ASSERT((passed >= 5) && (passed <= 10));
+  CPPUNIT_ASSERT_EQUAL(1000 - passed, limiter.getSuppressedCount());
+
+  // a new second starts a new window
+
+  Thread::sleep(1100);
+
+  int more = 0;
+  for(int i = 0; i < 100; ++i)
+  {
+    if(limiter.allow())
+      ++more;
+  }
+
+  CPPUNIT_ASSERT((more >= 5) && (more <= 10));
+}
+
+/*
+ */
+
+void LogLimiterTest::testMacros()
+{
+  CaptureConsoleLogger *capture = new CaptureConsoleLogger();
+  Log::setConsoleLogger(capture);
+  Log::setUseConsoleLog(true);
+
+  for(int i = 0; i < 100; ++i)
+    Log_sampled(LogError, 10, "sampled message %d", i);
+
+  // each message after the first is preceded by a report of the nine
+  // that were suppressed in between
+
+  CPPUNIT_ASSERT_EQUAL(10, capture->messages);
+  CPPUNIT_ASSERT_EQUAL(9, capture->reports);
+  CPPUNIT_ASSERT_EQUAL(81, capture->suppressed);
+
+  capture->messages = capture->reports = capture->suppressed = 0;
+
+  for(int i = 0; i < 1000; ++i)
+    Log_limited(LogError, 3, "limited message %d", i);
+
+  CPPUNIT_ASSERT((capture->messages >= 3) && (capture->messages <= 6));
+  CPPUNIT_ASSERT(capture->reports <= 1);
+
+  // disabled levels are not counted at all
+
+  Log::disableLogLevel(LogDebug);
+
+  capture->messages = 0;
+  for(int i = 0; i < 10; ++i)
+    Log_sampled(LogDebug, 2, "disabled message %d", i);
+
+  CPPUNIT_ASSERT_EQUAL(0, capture->messages);
+
+  Log::enableLogLevel(LogDebug);
+  Log::setConsoleLogger(new ConsoleLogger());
+}
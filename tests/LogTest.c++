@@ -27,9 +27,12 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "commonc++/Common.h++"
+#include "commonc++/File.h++"
 #include "commonc++/Log.h++"
 
+#include <fstream>
 #include <iostream>
+#include <string>
 
 using namespace ccxx;
 
@@ -44,6 +47,8 @@ CppUnit::Test *LogTest::suite()
   CCXX_TESTSUITE_TEST(LogTest, testLog);
   CCXX_TESTSUITE_TEST(LogTest, testLogRotate);
   CCXX_TESTSUITE_TEST(LogTest, testLogMacros);
+  CCXX_TESTSUITE_TEST(LogTest, testAsyncFileLog);
+  CCXX_TESTSUITE_TEST(LogTest, testLogLevels);
   CCXX_TESTSUITE_END();
 }
 
@@ -117,3 +122,104 @@ void LogTest::testLogRotate()
 void LogTest::testLogMacros()
 {
 }
+
+/*
+ */
+
+void LogTest::testAsyncFileLog()
+{
+  Log::setUseConsoleLog(false);
+
+  FileLogger *logger = new FileLogger("%m", 4096, 0);
+  Log::setFileLogger(logger);
+
+  Log::setUseFileLog(true);
+  Log::setLogFile(".", "asynclogtest");
+  File::remove("./asynclogtest.log");
+  Log::setLogFile(".", "asynclogtest");
+
+  Log::setAsyncFileLog(true);
+  CPPUNIT_ASSERT(Log::isAsyncFileLog());
+
+  for(int i = 0; i < 1000; i++)
+    Log_info("async record %d", i);
+
+  // disabling drains the buffered records
+
+  Log::setAsyncFileLog(false);
+  CPPUNIT_ASSERT(! Log::isAsyncFileLog());
+
+  Log::setUseFileLog(false);
+  Log::setUseConsoleLog(true);
+  Log::setFileLogger(new FileLogger());
+
+  std::ifstream in("./asynclogtest.log");
+  std::string text, first;
+  int lines = 0;
+
+  while(std::getline(in, text))
+  {
+    if(lines++ == 0)
+      first = text;
+  }
+
+  in.close();
+
+  CPPUNIT_ASSERT_EQUAL(1000, lines);
+  CPPUNIT_ASSERT(first == "async record 0");
+
+  File::remove("./asynclogtest.log");
+}
+
+/*
+ */
+
+static int __bump(int &count)
+{
+  return(++count);
+}
+
+/*
+ */
+
+void LogTest::testLogLevels()
+{
+  int count = 0;
+
+  CPPUNIT_ASSERT(Log::isLogLevelEnabled(LogInfo));
+
+  // arguments are not evaluated for disabled levels
+
+  Log::setMinLogLevel(LogWarning);
+  CPPUNIT_ASSERT(! Log::isLogLevelEnabled(LogDebug));
+  CPPUNIT_ASSERT(! Log::isLogLevelEnabled(LogInfo));
+  CPPUNIT_ASSERT(Log::isLogLevelEnabled(LogWarning));
+  CPPUNIT_ASSERT(Log::isLogLevelEnabled(LogError));
+
+  Log_info("not logged %d", __bump(count));
+  CPPUNIT_ASSERT_EQUAL(0, count);
+
+  Log_warning("logged %d", __bump(count));
+  CPPUNIT_ASSERT_EQUAL(1, count);
+
+  Log::disableLogLevel(LogWarning);
+  Log_warning("not logged %d", __bump(count));
+  CPPUNIT_ASSERT_EQUAL(1, count);
+
+  // nor if there is nowhere to log to
+
+  Log::setMinLogLevel(LogDebug);
+  Log::setUseConsoleLog(false);
+  Log::setUseFileLog(false);
+  CPPUNIT_ASSERT(! Log::isLogLevelEnabled(LogError));
+
+  Log_error("not logged %d", __bump(count));
+  CPPUNIT_ASSERT_EQUAL(1, count);
+
+  Log::setUseConsoleLog(true);
+
+#if CCXX_LOG_MIN_LEVEL <= 1
+  Log_debug("logged %d", __bump(count));
+  CPPUNIT_ASSERT_EQUAL(2, count);
+#endif
+}
@@ -36,4 +36,6 @@ class LogTest : public CppUnit::TestFixture
   void testLog();
   void testLogRotate();
   void testLogMacros();
+  void testAsyncFileLog();
+  void testLogLevels();
 };
@@ -0,0 +1,295 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "MappedFileLoggerTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+#include "commonc++/File.h++"
+#include "commonc++/MappedFileLogger.h++"
+#include "commonc++/Thread.h++"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MappedFileLoggerTest);
+
+using namespace ccxx;
+
+static const int __numThreads = 4;
+
+/*
+ */
+
+static String __segmentPath(int index)
+{
+  char buf[64];
+  std::snprintf(buf, sizeof(buf), "./mappedlogtest-%06d.log", index);
+  return(String(buf));
+}
+
+/*
+ */
+
+static int __readSegments(std::string& text)
+{
+  int segments = 0;
+
+  for(int i = 1; File::exists(__segmentPath(i)); ++i)
+  {
+    std::ifstream in(__segmentPath(i).toUTF8().data(), std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+
+    text += data;
+    ++segments;
+  }
+
+  return(segments);
+}
+
+/*
+ */
+
+class MappedLoggingThread : public Thread
+{
+ public:
+
+  MappedLoggingThread(Logger* logger, int id, int count)
+    : _logger(logger), _id(id), _count(count)
+  { }
+
+ protected:
+
+  void run()
+  {
+    for(int i = 0; i < _count; ++i)
+      _logger->log(LogInfo, __FILE__, __LINE__, "thread %d record %06d", _id,
+                   i);
+  }
+
+ private:
+
+  Logger* _logger;
+  int _id;
+  int _count;
+};
+
+/*
+ */
+
+CppUnit::Test *MappedFileLoggerTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(MappedFileLoggerTest);
+  CCXX_TESTSUITE_TEST(MappedFileLoggerTest, testAppend);
+  CCXX_TESTSUITE_TEST(MappedFileLoggerTest, testRollover);
+  CCXX_TESTSUITE_TEST(MappedFileLoggerTest, testConcurrent);
+  CCXX_TESTSUITE_TEST(MappedFileLoggerTest, testRetry);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void MappedFileLoggerTest::setUp()
+{
+  for(int i = 1; File::exists(__segmentPath(i)); ++i)
+    File::remove(__segmentPath(i));
+}
+
+/*
+ */
+
+void MappedFileLoggerTest::tearDown()
+{
+  setUp();
+}
+
+/*
+ */
+
+void MappedFileLoggerTest::testAppend()
+{
+  {
+    MappedFileLogger logger("%m", 64);
+    CPPUNIT_ASSERT(logger.setFile(".", "mappedlogtest"));
+    CPPUNIT_ASSERT(logger.getCurrentPath() == __segmentPath(1));
+
+    // the segment is preallocated
+
+    CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(64 * 1024),
+                         File::getSize(__segmentPath(1)));
+
+    for(int i = 0; i < 100; ++i)
+      logger.log(LogInfo, __FILE__, __LINE__, "record %d", i);
+  }
+
+  // closing the segment trims it to the data that was written
+
+  std::string text;
+  CPPUNIT_ASSERT_EQUAL(1, __readSegments(text));
+  CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(text.length()),
+                       File::getSize(__segmentPath(1)));
+
+  std::string expected;
+  for(int i = 0; i < 100; ++i)
+  {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "record %d%s", i, File::eol);
+    expected += buf;
+  }
+
+  CPPUNIT_ASSERT(text == expected);
+
+  // a new logger doesn't overwrite the existing segment
+
+  MappedFileLogger logger("%m", 64);
+  CPPUNIT_ASSERT(logger.setFile(".", "mappedlogtest"));
+  CPPUNIT_ASSERT(logger.getCurrentPath() == __segmentPath(2));
+}
+
+/*
+ */
+
+void MappedFileLoggerTest::testRollover()
+{
+  // each record is 64 bytes (with the newline), so 1024 of them fill a
+  // 64KB segment
+
+  int count = 3000;
+
+  {
+    MappedFileLogger logger("%m", 64);
+    CPPUNIT_ASSERT(logger.setFile(".", "mappedlogtest"));
+
+    for(int i = 0; i < count; ++i)
+      logger.log(LogInfo, __FILE__, __LINE__, "%063d", i);
+  }
+
+  std::string text;
+  CPPUNIT_ASSERT_EQUAL(3, __readSegments(text));
+  CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(64 * 1024),
+                       File::getSize(__segmentPath(1)));
+  CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(64 * 1024),
+                       File::getSize(__segmentPath(2)));
+  CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(64 * count), text.length());
+  CPPUNIT_ASSERT(text.find('\0') == std::string::npos);
+}
+
+/*
+ */
+
+void MappedFileLoggerTest::testConcurrent()
+{
+  const int count = 20000;
+
+  {
+    MappedFileLogger logger("%m", 64);
+    CPPUNIT_ASSERT(logger.setFile(".", "mappedlogtest"));
+
+    MappedLoggingThread *threads[__numThreads];
+
+    for(int i = 0; i < __numThreads; ++i)
+    {
+      threads[i] = new MappedLoggingThread(&logger, i, count);
+      threads[i]->start();
+    }
+
+    for(int i = 0; i < __numThreads; ++i)
+    {
+      threads[i]->join();
+      delete threads[i];
+    }
+  }
+
+  // every record must be present and intact, and each thread's records
+  // must appear in order
+
+  std::string text;
+  CPPUNIT_ASSERT(__readSegments(text) > 1);
+  CPPUNIT_ASSERT(text.find('\0') == std::string::npos);
+
+  int next[__numThreads] = { 0 };
+  int lines = 0;
+  size_t pos = 0;
+
+  while(pos < text.length())
+  {
+    size_t eol = text.find('\n', pos);
+    CPPUNIT_ASSERT(eol != std::string::npos);
+
+    int id = -1, seq = -1;
+    CPPUNIT_ASSERT_EQUAL(2, std::sscanf(text.c_str() + pos,
+                                        "thread %d record %d", &id, &seq));
+    CPPUNIT_ASSERT((id >= 0) && (id < __numThreads));
+    CPPUNIT_ASSERT_EQUAL(next[id], seq);
+
+    ++next[id];
+    ++lines;
+    pos = eol + 1;
+  }
+
+  CPPUNIT_ASSERT_EQUAL(__numThreads * count, lines);
+}
+
+/*
+ */
+
+void MappedFileLoggerTest::testRetry()
+{
+  String dir = "./mappedlogretry";
+  File::removeDirectoryTree(dir);
+
+  {
+    // the directory doesn't exist, so no segment can be created
+
+    MappedFileLogger logger("%m", 64);
+    CPPUNIT_ASSERT(! logger.setFile(dir, "mappedlogtest"));
+
+    CPPUNIT_ASSERT(File::makeDirectory(dir));
+
+    // retries are rate-limited
+
+    logger.log(LogInfo, __FILE__, __LINE__, "dropped");
+    CPPUNIT_ASSERT(logger.getCurrentPath().isEmpty());
+
+    Thread::sleep(MappedFileLogger::RETRY_INTERVAL + 100);
+
+    logger.log(LogInfo, __FILE__, __LINE__, "recovered");
+    CPPUNIT_ASSERT(! logger.getCurrentPath().isEmpty());
+  }
+
+  String path = dir + "/mappedlogtest-000002.log";
+  std::ifstream in(path.toUTF8().data(), std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+
+  CPPUNIT_ASSERT_EQUAL(std::string("recovered\n"), data);
+
+  File::removeDirectoryTree(dir);
+}
@@ -27,14 +27,19 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "commonc++/Common.h++"
+#include "commonc++/File.h++"
 #include "commonc++/MemoryMappedFile.h++"
+#include "commonc++/System.h++"
 
 #include <cstring>
+#include <iostream>
 
 using namespace ccxx;
 
 CPPUNIT_TEST_SUITE_REGISTRATION(MemoryMappedFileTest);
 
+static const char *__benchPath = "./testdata/mmap_bench.bin";
+
 /*
  */
 
@@ -42,6 +47,8 @@ CppUnit::Test *MemoryMappedFileTest::suite()
 {
   CCXX_TESTSUITE_BEGIN(MemoryMappedFileTest);
   CCXX_TESTSUITE_TEST(MemoryMappedFileTest, testMemoryMappedFile);
+  CCXX_TESTSUITE_TEST(MemoryMappedFileTest, testAccessHints);
+  CCXX_TESTSUITE_TEST(MemoryMappedFileTest, testAccessBenchmark);
   CCXX_TESTSUITE_END();
 }
 
@@ -57,6 +64,7 @@ void MemoryMappedFileTest::setUp()
 
 void MemoryMappedFileTest::tearDown()
 {
+  File::remove(__benchPath);
 }
 
 /*
@@ -98,3 +106,227 @@ void MemoryMappedFileTest::testMemoryMappedFile()
     CCXX_TEST_FAIL_EXCEPTION(ex);
   }
 }
+
+
+/*
+ */
+
+static void createFile(const char *path, size_t size)
+{
+  MemoryMappedFile mmf(path);
+  mmf.create(size);
+
+  byte_t *base = mmf.getBase();
+  for(size_t i = 0; i < size; ++i)
+    base[i] = static_cast<byte_t>(i * 7);
+
+  mmf.close();
+}
+
+/*
+ */
+
+static void evictFile(const char *path)
+{
+  // dirty pages can't be dropped, so write them back first
+
+  File file(path);
+  file.open(IOReadWrite, FileOpen);
+  file.syncRange(0, 0, true);
+  file.advise(0, 0, FileAdviseDontNeed);
+  file.close();
+}
+
+/*
+ */
+
+static uint64_t scan(const MemoryMappedFile& mmf, bool random)
+{
+  const byte_t *base = mmf.getBase();
+  size_t pageSize = System::getPageSize();
+  size_t pages = static_cast<size_t>(mmf.getSize()) / pageSize;
+  size_t stride = random ? 7919 : 1; // prime, so coprime with the page count
+  uint64_t sum = 0;
+
+  // read every page once, in order or in a scattered order
+
+  for(size_t i = 0, p = 0; i < pages; ++i, p = (p + stride) % pages)
+  {
+    const byte_t *page = base + (p * pageSize);
+    for(size_t j = 0; j < pageSize; j += sizeof(uint64_t))
+    {
+      uint64_t word;
+      std::memcpy(&word, page + j, sizeof(word));
+      sum += word;
+    }
+  }
+
+  return(sum);
+}
+
+/*
+ */
+
+void MemoryMappedFileTest::testAccessHints()
+{
+  static const char *path = "./testdata/mmap_hints.bin";
+
+  size_t pageSize = System::getPageSize();
+  size_t size = pageSize * 16 + 100;
+
+  try
+  {
+    createFile(path, size);
+
+    MemoryMappedFile mmf(path);
+
+    // not mapped yet
+
+    try
+    {
+      mmf.advise(MemoryMappedFile::AdviseRandom);
+      CPPUNIT_FAIL("No IOException thrown");
+    }
+    catch(IOException&)
+    {
+    }
+
+    mmf.setPrefault(true);
+    mmf.setHugePages(true);
+    CPPUNIT_ASSERT(mmf.isPrefault());
+    CPPUNIT_ASSERT(mmf.isHugePages());
+
+    mmf.open(0, true);
+    CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(size), mmf.getSize());
+    CPPUNIT_ASSERT_EQUAL(static_cast<byte_t>(7 * 5), mmf.getBase()[5]);
+
+    mmf.advise(MemoryMappedFile::AdviseSequential);
+    mmf.advise(MemoryMappedFile::AdviseNormal);
+
+    // unaligned ranges are widened to page boundaries
+
+    mmf.advise(pageSize + 10, 100, MemoryMappedFile::AdviseWillNeed);
+    mmf.advise(pageSize * 16, 0, MemoryMappedFile::AdviseRandom);
+
+    try
+    {
+      mmf.advise(size - 10, 11, MemoryMappedFile::AdviseRandom);
+      CPPUNIT_FAIL("No OutOfBoundsException thrown");
+    }
+    catch(OutOfBoundsException&)
+    {
+    }
+
+    try
+    {
+      mmf.advise(size + 1, 0, MemoryMappedFile::AdviseRandom);
+      CPPUNIT_FAIL("No OutOfBoundsException thrown");
+    }
+    catch(OutOfBoundsException&)
+    {
+    }
+
+    // the contents survive dropping the pages
+
+    mmf.advise(MemoryMappedFile::AdviseDontNeed);
+    CPPUNIT_ASSERT_EQUAL(static_cast<byte_t>(7 * 5), mmf.getBase()[5]);
+
+    // locking may be refused if the locked memory limit is very low
+
+    try
+    {
+      mmf.lock(0, pageSize);
+      mmf.unlock(0, pageSize);
+    }
+    catch(IOException& ex)
+    {
+      std::cout << "\nmlock unavailable: " << ex.getMessage() << std::endl;
+    }
+
+    try
+    {
+      mmf.lock(0, size + 1);
+      CPPUNIT_FAIL("No OutOfBoundsException thrown");
+    }
+    catch(OutOfBoundsException&)
+    {
+    }
+
+    mmf.close();
+  }
+  catch(IOException& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void MemoryMappedFileTest::testAccessBenchmark()
+{
+  const char *path = __benchPath;
+  static const size_t size = 64 * 1024 * 1024;
+
+  static const struct
+  {
+    const char *name;
+    MemoryMappedFile::AccessAdvice advice;
+    bool prefault;
+    bool hugePages;
+  } cases[] = {
+    { "normal", MemoryMappedFile::AdviseNormal, false, false },
+    { "sequential", MemoryMappedFile::AdviseSequential, false, false },
+    { "random", MemoryMappedFile::AdviseRandom, false, false },
+    { "willneed", MemoryMappedFile::AdviseWillNeed, false, false },
+    { "prefault", MemoryMappedFile::AdviseNormal, true, false },
+    { "hugepages", MemoryMappedFile::AdviseNormal, false, true }
+  };
+
+  try
+  {
+    createFile(path, size);
+
+    uint64_t expected = 0;
+
+    std::cout << std::endl;
+
+    for(uint_t i = 0; i < CCXX_LENGTHOF(cases); ++i)
+    {
+      for(int random = 0; random < 2; ++random)
+      {
+        // each run maps the file afresh, with the file evicted from the
+        // page cache, so that every page must be read from the disk again
+
+        evictFile(path);
+
+        MemoryMappedFile mmf(path);
+        mmf.setPrefault(cases[i].prefault);
+        mmf.setHugePages(cases[i].hugePages);
+
+        int64_t start = System::nanoTime();
+
+        mmf.open(0, true);
+        mmf.advise(cases[i].advice);
+        uint64_t sum = scan(mmf, random != 0);
+
+        int64_t elapsed = System::nanoTime() - start;
+
+        if(expected == 0)
+          expected = sum;
+        else
+          CPPUNIT_ASSERT_EQUAL(expected, sum);
+
+        std::cout << "mapped scan, " << cases[i].name
+                  << (random ? " (random): " : " (sequential): ")
+                  << (INT64_CONST(1000000000) * (size / 1024 / 1024)
+                      / (elapsed ? elapsed : 1))
+                  << " MB/s" << std::endl;
+      }
+    }
+  }
+  catch(IOException& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
@@ -34,4 +34,6 @@ class MemoryMappedFileTest : public CppUnit::TestFixture
   void tearDown();
 
   void testMemoryMappedFile();
+  void testAccessHints();
+  void testAccessBenchmark();
 };
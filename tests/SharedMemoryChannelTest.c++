@@ -0,0 +1,199 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "SharedMemoryChannelTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+#include "commonc++/Runnable.h++"
+#include "commonc++/Thread.h++"
+
+#include <cstring>
+
+using namespace ccxx;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SharedMemoryChannelTest);
+
+/*
+ */
+
+CppUnit::Test *SharedMemoryChannelTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(SharedMemoryChannelTest);
+  CCXX_TESTSUITE_TEST(SharedMemoryChannelTest, testSendReceive);
+  CCXX_TESTSUITE_TEST(SharedMemoryChannelTest, testFull);
+  CCXX_TESTSUITE_TEST(SharedMemoryChannelTest, testWakeup);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void SharedMemoryChannelTest::setUp()
+{
+  _chan = new SharedMemoryChannel("chantest", 6, 32);
+}
+
+/*
+ */
+
+void SharedMemoryChannelTest::tearDown()
+{
+  delete _chan;
+}
+
+/*
+ */
+
+void SharedMemoryChannelTest::testSendReceive()
+{
+  try
+  {
+    _chan->init();
+
+    CPPUNIT_ASSERT_EQUAL(8U, _chan->getCapacity());
+    CPPUNIT_ASSERT(_chan->isEmpty());
+
+    // a second handle on the same name rendezvous with the first
+    SharedMemoryChannel peer("chantest", 8, 32);
+    peer.init();
+
+    const char *msg = "hello, world";
+    CPPUNIT_ASSERT(_chan->send((const byte_t *)msg, std::strlen(msg)));
+    CPPUNIT_ASSERT_EQUAL(1U, peer.getSize());
+
+    byte_t buf[32];
+    size_t n = peer.tryReceive(buf, sizeof(buf));
+    CPPUNIT_ASSERT_EQUAL(std::strlen(msg), n);
+    CPPUNIT_ASSERT(std::memcmp(buf, msg, n) == 0);
+
+    // too long for a slot
+    byte_t big[33];
+    CPPUNIT_ASSERT(! _chan->send(big, sizeof(big)));
+
+    // truncated on receive
+    CPPUNIT_ASSERT(_chan->send((const byte_t *)msg, std::strlen(msg)));
+    n = peer.tryReceive(buf, 5);
+    CPPUNIT_ASSERT_EQUAL((size_t)5, n);
+    CPPUNIT_ASSERT(std::memcmp(buf, "hello", 5) == 0);
+
+    try
+    {
+      peer.tryReceive(buf, sizeof(buf), 10);
+      CPPUNIT_FAIL("expected TimeoutException");
+    }
+    catch(TimeoutException& ex)
+    {
+    }
+  }
+  catch(SystemException& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void SharedMemoryChannelTest::testFull()
+{
+  try
+  {
+    _chan->init();
+
+    for(int round = 0; round < 3; ++round)
+    {
+      for(uint32_t i = 0; i < 8; ++i)
+        CPPUNIT_ASSERT(_chan->send((const byte_t *)&i, sizeof(i)));
+
+      uint32_t extra = 99;
+      CPPUNIT_ASSERT(! _chan->send((const byte_t *)&extra, sizeof(extra)));
+      CPPUNIT_ASSERT_EQUAL(8U, _chan->getSize());
+
+      for(uint32_t i = 0; i < 8; ++i)
+      {
+        uint32_t val = 0;
+        _chan->receive((byte_t *)&val, sizeof(val));
+        CPPUNIT_ASSERT_EQUAL(i, val);
+      }
+
+      CPPUNIT_ASSERT(_chan->isEmpty());
+    }
+  }
+  catch(SystemException& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void SharedMemoryChannelTest::testWakeup()
+{
+  try
+  {
+    _chan->init();
+
+    RunnableDelegate<SharedMemoryChannelTest> r(
+      this, &SharedMemoryChannelTest::_sender);
+    Thread t(&r);
+    t.start();
+
+    uint32_t expected = 0;
+    while(expected < 1000)
+    {
+      uint32_t val = 0;
+      size_t n = _chan->receive((byte_t *)&val, sizeof(val));
+      CPPUNIT_ASSERT_EQUAL(sizeof(val), n);
+      CPPUNIT_ASSERT_EQUAL(expected, val);
+      ++expected;
+    }
+
+    t.join();
+  }
+  catch(SystemException& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void SharedMemoryChannelTest::_sender()
+{
+  SharedMemoryChannel chan("chantest", 8, 32);
+  chan.init();
+
+  for(uint32_t i = 0; i < 1000; ++i)
+  {
+    while(! chan.send((const byte_t *)&i, sizeof(i)))
+      Thread::sleep(1);
+
+    if((i % 100) == 0)
+      Thread::sleep(5);
+  }
+}
@@ -27,7 +27,18 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "commonc++/Common.h++"
+#include "commonc++/Coroutine.h++"
+#include "commonc++/File.h++"
 #include "commonc++/SocketSelector.h++"
+#include "commonc++/Thread.h++"
+
+#include <cstring>
+
+#ifdef CCXX_OS_POSIX
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
 
 using namespace ccxx;
 
@@ -40,6 +51,13 @@ CppUnit::Test *SocketSelectorTest::suite()
 {
   CCXX_TESTSUITE_BEGIN(SocketSelectorTest);
   CCXX_TESTSUITE_TEST(SocketSelectorTest, testSocketSelector);
+  CCXX_TESTSUITE_TEST(SocketSelectorTest, testStats);
+  CCXX_TESTSUITE_TEST(SocketSelectorTest, testIdleTimeout);
+  CCXX_TESTSUITE_TEST(SocketSelectorTest, testSchedule);
+  CCXX_TESTSUITE_TEST(SocketSelectorTest, testAwaitReadWrite);
+  CCXX_TESTSUITE_TEST(SocketSelectorTest, testReadRateLimit);
+  CCXX_TESTSUITE_TEST(SocketSelectorTest, testFlowControl);
+  CCXX_TESTSUITE_TEST(SocketSelectorTest, testEventSources);
   CCXX_TESTSUITE_END();
 }
 
@@ -88,6 +106,323 @@ void SocketSelectorTest::testSocketSelector()
   }
 }
 
+/*
+ */
+
+void SocketSelectorTest::testStats()
+{
+  try
+  {
+    ServerSocket ssock(40406);
+    ssock.init();
+
+    ssock.listen();
+
+    TestSelector tmux;
+    tmux.setStatsEnabled(true);
+    tmux.init(&ssock);
+    tmux.start();
+
+    StreamSocket client;
+    client.init();
+    client.setTimeout(5000);
+    client.connect("127.0.0.1", 40406);
+
+    const char *msg = "hello\r\n";
+    client.write((const byte_t *)msg, 7);
+
+    byte_t buf[64];
+    size_t n = client.read(buf, sizeof(buf));
+    CPPUNIT_ASSERT(n > 0);
+
+    Thread::sleep(100);
+
+    CPPUNIT_ASSERT_EQUAL(UINT64_CONST(1),
+                         tmux.getDispatchDelayHistogram().getCount());
+    CPPUNIT_ASSERT(tmux.getCallbackTimeHistogram().getCount() >= 1);
+    CPPUNIT_ASSERT_EQUAL(UINT64_CONST(1),
+                         tmux.getWriteQueueTimeHistogram().getCount());
+
+    client.close();
+
+    tmux.stop();
+    tmux.join();
+  }
+  catch(Exception& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void SocketSelectorTest::testIdleTimeout()
+{
+  try
+  {
+    // the timings below are tight, so don't wait for a fixed port
+
+    ServerSocket ssock(0);
+    ssock.init();
+
+    ssock.listen();
+
+    uint16_t port = ssock.getLocalAddress().getPort();
+    CPPUNIT_ASSERT(port != 0);
+
+    TestSelector tmux(300);
+    tmux.init(&ssock);
+    tmux.start();
+
+    StreamSocket idle, active;
+    idle.init();
+    idle.setTimeout(5000);
+    idle.connect("127.0.0.1", port);
+    active.init();
+    active.setTimeout(5000);
+    active.connect("127.0.0.1", port);
+
+    // keep one connection busy while the other goes idle
+
+    const char *msg = "hello\r\n";
+    byte_t buf[64];
+
+    Thread::sleep(150);
+    active.write((const byte_t *)msg, 7);
+    active.read(buf, sizeof(buf));
+
+    Thread::sleep(100);
+    CPPUNIT_ASSERT_EQUAL(0, tmux.getTimedOutCount());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), tmux.getConnectionCount());
+
+    // the deadline determines the select() timeout, so the idle
+    // connection should be expired promptly
+
+    Thread::sleep(150);
+    CPPUNIT_ASSERT_EQUAL(1, tmux.getTimedOutCount());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), tmux.getConnectionCount());
+
+    Thread::sleep(300);
+    CPPUNIT_ASSERT_EQUAL(2, tmux.getTimedOutCount());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), tmux.getConnectionCount());
+
+    idle.close();
+    active.close();
+
+    tmux.stop();
+    tmux.join();
+  }
+  catch(Exception& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void SocketSelectorTest::testSchedule()
+{
+  try
+  {
+    ServerSocket ssock(40408);
+    ssock.init();
+
+    ssock.listen();
+
+    TestSelector tmux;
+    tmux.init(&ssock);
+    tmux.start();
+
+    TestTimerHandler soon, late;
+    tmux.schedule(100, &soon);
+    tmux.schedule(60000, &late);
+
+    Thread::sleep(50);
+    CPPUNIT_ASSERT_EQUAL(0, soon.fired);
+
+    Thread::sleep(200);
+    CPPUNIT_ASSERT_EQUAL(1, soon.fired);
+    CPPUNIT_ASSERT(soon.result);
+
+    // pending timers are cancelled when the selector shuts down
+
+    tmux.stop();
+    tmux.join();
+
+    CPPUNIT_ASSERT_EQUAL(1, late.fired);
+    CPPUNIT_ASSERT(! late.result);
+  }
+  catch(Exception& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void SocketSelectorTest::testAwaitReadWrite()
+{
+  bool modes[] = { false, true };
+  uint_t modeCount = CCXX_LENGTHOF(modes);
+
+#if ! ((__cplusplus >= 202002L) && defined(__cpp_impl_coroutine))
+  modeCount = 1; // the coroutine layer requires C++20
+#endif
+
+  for(uint_t m = 0; m < modeCount; ++m)
+  {
+    try
+    {
+      ServerSocket ssock(40409);
+      ssock.init();
+
+      ssock.listen();
+
+      AwaitSelector tmux(modes[m]);
+      tmux.init(&ssock);
+      tmux.start();
+
+      StreamSocket client;
+      client.init();
+      client.setTimeout(5000);
+      client.connect("127.0.0.1", 40409);
+
+      // the read handler must not fire until a whole frame has arrived
+
+      client.write((const byte_t *)"abc", 3);
+      Thread::sleep(100);
+
+      CPPUNIT_ASSERT(tmux.connection != NULL);
+      CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(tmux.connection->frames));
+
+      client.write((const byte_t *)"defghijk", 8);
+
+      byte_t buf[16];
+      size_t got = 0;
+      while(got < 8)
+        got += client.read(buf + got, 8 - got);
+
+      CPPUNIT_ASSERT_EQUAL(0, std::memcmp(buf, "DCBAHGFE", 8));
+      CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(tmux.connection->frames));
+
+      // closing the connection cancels the read of the partial frame
+
+      client.close();
+      Thread::sleep(200);
+
+      CPPUNIT_ASSERT(tmux.connection == NULL);
+
+      tmux.stop();
+      tmux.join();
+    }
+    catch(Exception& ex)
+    {
+      CCXX_TEST_FAIL_EXCEPTION(ex);
+    }
+  }
+}
+
+/*
+ */
+
+void SocketSelectorTest::testReadRateLimit()
+{
+  try
+  {
+    ServerSocket ssock(40409);
+    ssock.init();
+
+    ssock.listen();
+
+    SinkSelector tmux(2000);
+    tmux.setReadQuantum(512);
+    tmux.init(&ssock);
+    tmux.start();
+
+    StreamSocket client;
+    client.init();
+    client.setTimeout(5000);
+    client.connect("127.0.0.1", 40409);
+
+    byte_t buf[8000];
+    ::memset(buf, 'x', sizeof(buf));
+    client.write(buf, sizeof(buf));
+
+    // a full burst (2000 bytes) plus 2000 bytes per second
+
+    Thread::sleep(500);
+    size_t n = tmux.received;
+    CPPUNIT_ASSERT(n >= 2000);
+    CPPUNIT_ASSERT(n <= 3500);
+
+    Thread::sleep(1500);
+    n = tmux.received;
+    CPPUNIT_ASSERT(n >= 5000);
+    CPPUNIT_ASSERT(n <= 6500);
+
+    client.close();
+
+    tmux.stop();
+    tmux.join();
+  }
+  catch(Exception& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void SocketSelectorTest::testFlowControl()
+{
+  try
+  {
+    ServerSocket ssock(40413);
+    ssock.init();
+
+    ssock.listen();
+
+    BoundedQueue<int> queue(4);
+    queue.setHighWaterMark(1);
+    queue.put(1);
+
+    SinkSelector tmux(0, &queue);
+    tmux.init(&ssock);
+    tmux.start();
+
+    StreamSocket client;
+    client.init();
+    client.setTimeout(5000);
+    client.connect("127.0.0.1", 40413);
+    client.write((const byte_t *)"hello", 5);
+
+    // nothing is read while the downstream queue is congested
+
+    Thread::sleep(200);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0),
+                        static_cast<size_t>(tmux.received));
+
+    queue.take();
+
+    Thread::sleep(200);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5),
+                         static_cast<size_t>(tmux.received));
+
+    client.close();
+
+    tmux.stop();
+    tmux.join();
+  }
+  catch(Exception& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
 /*
  */
 
@@ -107,9 +442,10 @@ TestConnection::~TestConnection() throw()
 /*
  */
 
-TestSelector::TestSelector()
-  : SocketSelector(64, 10000),
-    _counter(0)
+TestSelector::TestSelector(timespan_ms_t idleLimit /* = 10000 */)
+  : SocketSelector(64, idleLimit),
+    _counter(0),
+    _timedOut(0)
 {
 }
 
@@ -158,6 +494,7 @@ void TestSelector::connectionTimedOut(Connection *conn)
   TestConnection *tconn = static_cast<TestConnection *>(conn);
 
   std::cout << "conn #" << tconn->getID() << " timed out" << std::endl;
+  ++_timedOut;
   delete conn;
 }
 
@@ -171,3 +508,298 @@ void TestSelector::connectionClosed(Connection *conn)
   std::cout << "conn #" << tconn->getID() << " closed" << std::endl;
   delete conn;
 }
+
+/*
+ */
+
+Connection *SinkSelector::connectionReady(const SocketAddress& address)
+{
+  Connection *conn = new TestConnection(0);
+
+  conn->setReadRateLimit(_rate);
+  conn->setFlowControl(_flowControl);
+
+  return(conn);
+}
+
+/*
+ */
+
+void SinkSelector::dataReceived(Connection *conn)
+{
+  byte_t buf[1024];
+  size_t n;
+
+  while((n = conn->readData(buf, sizeof(buf), false)) > 0)
+    received += n;
+}
+
+/*
+ */
+
+void SinkSelector::connectionTimedOut(Connection *conn)
+{
+  delete conn;
+}
+
+/*
+ */
+
+void SinkSelector::connectionClosed(Connection *conn)
+{
+  delete conn;
+}
+
+/*
+ */
+
+void SocketSelectorTest::testEventSources()
+{
+#ifdef CCXX_OS_POSIX
+
+  sigset_t oldMask;
+  ::pthread_sigmask(SIG_SETMASK, NULL, &oldMask);
+
+  try
+  {
+    TestEventNotifier notifier;
+    notifier.init();
+
+#ifdef __linux__
+    TestTimerNotifier timer;
+    timer.init();
+
+    // the signal must be blocked before the selector thread is started, so
+    // that the thread inherits the mask
+    TestSignalNotifier signals;
+    signals.addSignal(SIGUSR1);
+    signals.init();
+
+    String watchDir = "/tmp/ccxx_selector_watch";
+    File::removeDirectoryTree(watchDir);
+    CPPUNIT_ASSERT(File::makeDirectory(watchDir));
+
+    TestSelectorWatcher watcher(watchDir);
+    watcher.init();
+#endif
+
+    TestSelector tmux;
+    CPPUNIT_ASSERT(tmux.init());
+    CPPUNIT_ASSERT(tmux.addEventSource(&notifier));
+    CPPUNIT_ASSERT(! tmux.addEventSource(&notifier));
+    tmux.start();
+
+    // notifications posted before the selector wakes up are coalesced
+
+    notifier.notify();
+    notifier.notify();
+    notifier.notify();
+
+    Thread::sleep(200);
+    CPPUNIT_ASSERT(notifier.calls >= 1);
+    CPPUNIT_ASSERT_EQUAL(UINT64_CONST(3),
+                         static_cast<uint64_t>(notifier.count));
+
+#ifdef __linux__
+    CPPUNIT_ASSERT(tmux.addEventSource(&timer));
+    timer.start(50, 50);
+
+    // direct the signal at the selector thread, which blocks it and so
+    // receives it through the signalfd
+
+    CPPUNIT_ASSERT(tmux.addEventSource(&signals));
+    ::pthread_kill(notifier.thread, SIGUSR1);
+
+    CPPUNIT_ASSERT(tmux.addEventSource(&watcher));
+    {
+      File file(watchDir + "/a");
+      file.open(IOReadWrite, FileTruncateElseCreate);
+      file.close();
+    }
+    CPPUNIT_ASSERT(File::rename(watchDir + "/a", watchDir + "/b"));
+    CPPUNIT_ASSERT(File::remove(watchDir + "/b"));
+
+    Thread::sleep(300);
+    timer.stop();
+
+    CPPUNIT_ASSERT(timer.count >= 2);
+    CPPUNIT_ASSERT_EQUAL(SIGUSR1, static_cast<int>(signals.lastSignal));
+
+    CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(watcher.created));
+    CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(watcher.renamed));
+    CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(watcher.deleted));
+    CPPUNIT_ASSERT(tmux.removeEventSource(&watcher));
+#endif
+
+    // a removed source is no longer serviced
+
+    CPPUNIT_ASSERT(tmux.removeEventSource(&notifier));
+    CPPUNIT_ASSERT(! tmux.removeEventSource(&notifier));
+
+    notifier.notify();
+    Thread::sleep(100);
+    CPPUNIT_ASSERT_EQUAL(UINT64_CONST(3),
+                         static_cast<uint64_t>(notifier.count));
+
+    tmux.stop();
+    tmux.join();
+
+#ifdef __linux__
+    File::removeDirectory(watchDir);
+#endif
+  }
+  catch(Exception& ex)
+  {
+    ::pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+  catch(...)
+  {
+    ::pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+    throw;
+  }
+
+  ::pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+
+#endif
+}
+
+/*
+ */
+
+const size_t AwaitConnection::FRAME_SIZE = 4;
+
+/*
+ */
+
+AwaitConnection::AwaitConnection()
+  : frames(0),
+    closed(false),
+    _readHandler(this, &AwaitConnection::onRead),
+    _writeHandler(this, &AwaitConnection::onWrite)
+{
+}
+
+/*
+ */
+
+void AwaitConnection::start()
+{
+  awaitRead(FRAME_SIZE, &_readHandler);
+}
+
+/*
+ */
+
+void AwaitConnection::onRead(bool ok)
+{
+  if(! ok)
+  {
+    closed = true;
+    return;
+  }
+
+  readData(_frame, FRAME_SIZE);
+  awaitWrite(FRAME_SIZE, &_writeHandler);
+}
+
+/*
+ */
+
+void AwaitConnection::onWrite(bool ok)
+{
+  if(! ok)
+  {
+    closed = true;
+    return;
+  }
+
+  // reverse the frame, and make it upper case
+
+  byte_t out[FRAME_SIZE];
+  for(size_t i = 0; i < FRAME_SIZE; ++i)
+    out[i] = static_cast<byte_t>(std::toupper(_frame[FRAME_SIZE - 1 - i]));
+
+  ++frames;
+  writeData(out, FRAME_SIZE);
+
+  awaitRead(FRAME_SIZE, &_readHandler);
+}
+
+#if (__cplusplus >= 202002L) && defined(__cpp_impl_coroutine)
+
+/*
+ */
+
+static AsyncTask echoFrames(AwaitConnection* conn)
+{
+  const size_t size = AwaitConnection::FRAME_SIZE;
+  byte_t frame[size], out[size];
+
+  try
+  {
+    for(;;)
+    {
+      co_await asyncRead(*conn, frame, size);
+
+      for(size_t i = 0; i < size; ++i)
+        out[i] = static_cast<byte_t>(std::toupper(frame[size - 1 - i]));
+
+      ++conn->frames;
+      co_await asyncWrite(*conn, out, size);
+    }
+  }
+  catch(EOFException &)
+  {
+    conn->closed = true;
+  }
+}
+
+#endif
+
+/*
+ */
+
+Connection *AwaitSelector::connectionReady(const SocketAddress& address)
+{
+  AwaitConnection *conn = new AwaitConnection();
+
+#if (__cplusplus >= 202002L) && defined(__cpp_impl_coroutine)
+  if(_useCoroutines)
+    echoFrames(conn);
+  else
+#endif
+    conn->start();
+
+  connection = conn;
+
+  return(conn);
+}
+
+/*
+ */
+
+void AwaitSelector::dataReceived(Connection *conn)
+{
+  // all reads go through the awaited handlers
+}
+
+/*
+ */
+
+void AwaitSelector::connectionTimedOut(Connection *conn)
+{
+}
+
+/*
+ */
+
+void AwaitSelector::connectionClosed(Connection *conn)
+{
+  AwaitConnection *aconn = static_cast<AwaitConnection *>(conn);
+
+  if(aconn->closed)
+    connection = NULL;
+
+  delete conn;
+}
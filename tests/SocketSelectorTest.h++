@@ -24,7 +24,12 @@
 #include <cppunit/Test.h>
 #include <cppunit/TestSuite.h>
 
+#include "commonc++/BoundedQueue.h++"
+#include "commonc++/DirectoryWatcher.h++"
+#include "commonc++/EventNotifier.h++"
+#include "commonc++/SignalNotifier.h++"
 #include "commonc++/SocketSelector.h++"
+#include "commonc++/TimerNotifier.h++"
 
 using namespace ccxx;
 
@@ -53,9 +58,12 @@ class TestSelector : public SocketSelector
 {
  public:
 
-  TestSelector();
+  TestSelector(timespan_ms_t idleLimit = 10000);
   ~TestSelector() throw();
 
+  inline int getTimedOutCount() const
+  { return(_timedOut); }
+
   virtual Connection *connectionReady(const SocketAddress& address);
   virtual void dataReceived(Connection *conn);
   virtual void connectionTimedOut(Connection *conn);
@@ -64,6 +72,178 @@ class TestSelector : public SocketSelector
  private:
 
   int _counter;
+  int _timedOut;
+};
+
+class SinkSelector : public SocketSelector
+{
+ public:
+
+  SinkSelector(uint_t rate, const FlowControl *flowControl = NULL)
+    : _rate(rate), _flowControl(flowControl), received(0)
+  { }
+
+  virtual Connection *connectionReady(const SocketAddress& address);
+  virtual void dataReceived(Connection *conn);
+  virtual void connectionTimedOut(Connection *conn);
+  virtual void connectionClosed(Connection *conn);
+
+ private:
+
+  uint_t _rate;
+  const FlowControl *_flowControl;
+
+ public:
+
+  volatile size_t received;
+};
+
+class TestTimerHandler : public EventHandler<bool>
+{
+ public:
+
+  TestTimerHandler()
+    : fired(0), result(false)
+  { }
+
+  int fired;
+  bool result;
+
+ protected:
+
+  void invoke(bool ok)
+  {
+    ++fired;
+    result = ok;
+  }
+};
+
+// Echoes fixed-size frames using only awaitRead() and awaitWrite(); with
+// useCoroutines, via the awaitables in Coroutine.h++ instead, when they
+// are available.
+
+class AwaitConnection : public Connection
+{
+ public:
+
+  AwaitConnection();
+
+  void start();
+
+  void onRead(bool ok);
+  void onWrite(bool ok);
+
+  static const size_t FRAME_SIZE;
+
+  volatile int frames;
+  volatile bool closed;
+
+ private:
+
+  EventHandlerDelegate<AwaitConnection, bool> _readHandler;
+  EventHandlerDelegate<AwaitConnection, bool> _writeHandler;
+  byte_t _frame[8];
+};
+
+class AwaitSelector : public SocketSelector
+{
+ public:
+
+  AwaitSelector(bool useCoroutines = false)
+    : connection(NULL), _useCoroutines(useCoroutines)
+  { }
+
+  virtual Connection *connectionReady(const SocketAddress& address);
+  virtual void dataReceived(Connection *conn);
+  virtual void connectionTimedOut(Connection *conn);
+  virtual void connectionClosed(Connection *conn);
+
+  AwaitConnection * volatile connection;
+
+ private:
+
+  bool _useCoroutines;
+};
+
+class TestEventNotifier : public EventNotifier
+{
+ public:
+
+  TestEventNotifier()
+    : calls(0), count(0)
+  { }
+
+  volatile int calls;
+  volatile uint64_t count;
+  ThreadID thread;
+
+ protected:
+
+  void notified(uint64_t n)
+  {
+    thread = Thread::currentThreadID();
+    ++calls;
+    count += n;
+  }
+};
+
+class TestTimerNotifier : public TimerNotifier
+{
+ public:
+
+  TestTimerNotifier()
+    : count(0)
+  { }
+
+  volatile uint64_t count;
+
+ protected:
+
+  void timerExpired(uint64_t n)
+  { count += n; }
+};
+
+class TestSignalNotifier : public SignalNotifier
+{
+ public:
+
+  TestSignalNotifier()
+    : lastSignal(0)
+  { }
+
+  volatile int lastSignal;
+
+ protected:
+
+  void signalReceived(int signal)
+  { lastSignal = signal; }
+};
+
+class TestSelectorWatcher : public DirectoryWatcher
+{
+ public:
+
+  TestSelectorWatcher(const String& directory)
+    : DirectoryWatcher(directory), created(0), deleted(0), renamed(0)
+  { }
+
+  volatile int created;
+  volatile int deleted;
+  volatile int renamed;
+
+ protected:
+
+  void fileCreated(const String& path)
+  { ++created; }
+
+  void fileDeleted(const String& path)
+  { ++deleted; }
+
+  void fileModified(const String& path)
+  { }
+
+  void fileRenamed(const String& oldPath, const String& newPath)
+  { ++renamed; }
 };
 
 class SocketSelectorTest : public CppUnit::TestFixture
@@ -76,4 +256,11 @@ class SocketSelectorTest : public CppUnit::TestFixture
   void tearDown();
 
   void testSocketSelector();
+  void testStats();
+  void testIdleTimeout();
+  void testSchedule();
+  void testAwaitReadWrite();
+  void testReadRateLimit();
+  void testFlowControl();
+  void testEventSources();
 };
@@ -29,6 +29,9 @@
 #include "commonc++/Common.h++"
 #include "commonc++/File.h++"
 #include "commonc++/TempFile.h++"
+#include "commonc++/UnsupportedOperationException.h++"
+
+#include <cstring>
 
 using namespace ccxx;
 
@@ -41,6 +44,8 @@ CppUnit::Test *TempFileTest::suite()
 {
   CCXX_TESTSUITE_BEGIN(TempFileTest);
   CCXX_TESTSUITE_TEST(TempFileTest, testTempFile);
+  CCXX_TESTSUITE_TEST(TempFileTest, testAnonymous);
+  CCXX_TESTSUITE_TEST(TempFileTest, testMemory);
   CCXX_TESTSUITE_END();
 }
 
@@ -85,3 +90,148 @@ void TempFileTest::testTempFile()
 
   // TODO
 }
+
+/*
+ */
+
+static size_t readAll(Stream& stream, char* buf, size_t len)
+{
+  stream.seek(0);
+  return(stream.read(reinterpret_cast<byte_t *>(buf), len));
+}
+
+/*
+ */
+
+void TempFileTest::testAnonymous()
+{
+  static const char *path = "./testdata/anon.txt";
+  static const char *link = "./testdata/anon_link.txt";
+  static const char text[] = "anonymous";
+
+  File::remove(path);
+  File::remove(link);
+
+  try
+  {
+    // shadowing: the file appears only once it is completely written
+
+    TempFile tmp(path, TempFileAnonymous);
+    tmp.open();
+    CPPUNIT_ASSERT(tmp.getMode() != TempFileMemory);
+
+    tmp.write(reinterpret_cast<const byte_t *>(text), sizeof(text) - 1);
+    CPPUNIT_ASSERT(! File::exists(path));
+
+    tmp.close();
+    CPPUNIT_ASSERT(File::exists(path));
+    CPPUNIT_ASSERT_EQUAL(String(text), File::readToString(path));
+
+    // not shadowing: the file can be given a name while it is open
+
+    TempFile tmp2(String::null, TempFileAnonymous);
+    tmp2.open();
+    tmp2.write(reinterpret_cast<const byte_t *>(text), sizeof(text) - 1);
+
+    bool linked = true;
+
+    try
+    {
+      tmp2.link(link);
+    }
+    catch(IOException& ex)
+    {
+      // the temp directory may be on another file system
+
+      std::cout << "\nlink unavailable: " << ex.getMessage() << std::endl;
+      linked = false;
+    }
+
+    if(linked)
+      CPPUNIT_ASSERT_EQUAL(String(text), File::readToString(link));
+
+    tmp2.close();
+
+    if(linked)
+      CPPUNIT_ASSERT(File::exists(link));
+  }
+  catch(IOException& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+
+  File::remove(path);
+  File::remove(link);
+}
+
+/*
+ */
+
+void TempFileTest::testMemory()
+{
+  static const char text[] = "in memory";
+
+  try
+  {
+    TempFile tmp(String::null, TempFileMemory);
+    tmp.open();
+
+    tmp.write(reinterpret_cast<const byte_t *>(text), sizeof(text) - 1);
+
+    char buf[32];
+    CPPUNIT_ASSERT_EQUAL(sizeof(text) - 1, readAll(tmp, buf, sizeof(buf)));
+    CPPUNIT_ASSERT(std::memcmp(buf, text, sizeof(text) - 1) == 0);
+
+    if(tmp.getMode() == TempFileMemory)
+    {
+      tmp.seal();
+
+      // writes now fail
+
+      try
+      {
+        tmp.seek(0);
+        tmp.write(reinterpret_cast<const byte_t *>(text), 1);
+        CPPUNIT_FAIL("No IOException thrown");
+      }
+      catch(IOException&)
+      {
+      }
+
+      try
+      {
+        tmp.link("./testdata/memory.txt");
+        CPPUNIT_FAIL("No UnsupportedOperationException thrown");
+      }
+      catch(UnsupportedOperationException&)
+      {
+      }
+    }
+
+    TempFileMode mode = tmp.getMode();
+    tmp.close();
+
+    // reopening requests the same storage again
+
+    tmp.open();
+    CPPUNIT_ASSERT(tmp.getMode() == mode);
+    tmp.close();
+
+    // memory-backed files cannot shadow a file
+
+    TempFile tmp2("./testdata/memory.txt", TempFileMemory);
+
+    try
+    {
+      tmp2.open();
+      CPPUNIT_FAIL("No UnsupportedOperationException thrown");
+    }
+    catch(UnsupportedOperationException&)
+    {
+    }
+  }
+  catch(IOException& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
@@ -34,4 +34,6 @@ class TempFileTest : public CppUnit::TestFixture
   void tearDown();
 
   void testTempFile();
+  void testAnonymous();
+  void testMemory();
 };
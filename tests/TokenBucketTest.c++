@@ -0,0 +1,136 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "TokenBucketTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+#include "commonc++/TokenBucket.h++"
+
+using namespace ccxx;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TokenBucketTest);
+
+/*
+ */
+
+CppUnit::Test *TokenBucketTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(TokenBucketTest);
+  CCXX_TESTSUITE_TEST(TokenBucketTest, testUnlimited);
+  CCXX_TESTSUITE_TEST(TokenBucketTest, testRefill);
+  CCXX_TESTSUITE_TEST(TokenBucketTest, testDelay);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void TokenBucketTest::setUp()
+{
+}
+
+/*
+ */
+
+void TokenBucketTest::tearDown()
+{
+}
+
+/*
+ */
+
+void TokenBucketTest::testUnlimited()
+{
+  TokenBucket bucket;
+
+  CPPUNIT_ASSERT(! bucket.isLimited());
+  bucket.consume(1000000);
+  CPPUNIT_ASSERT(bucket.getAvailable(1000) > 1000000);
+  CPPUNIT_ASSERT_EQUAL(0, bucket.getDelay(1000, 1000000));
+}
+
+/*
+ */
+
+void TokenBucketTest::testRefill()
+{
+  TokenBucket bucket(1000, 500);
+
+  CPPUNIT_ASSERT(bucket.isLimited());
+  CPPUNIT_ASSERT_EQUAL(500U, bucket.getBurst());
+
+  // starts out full
+
+  CPPUNIT_ASSERT_EQUAL(500U, bucket.getAvailable(10000));
+
+  bucket.consume(500);
+  CPPUNIT_ASSERT_EQUAL(0U, bucket.getAvailable(10000));
+
+  // 1000 tokens/s is one per millisecond
+
+  CPPUNIT_ASSERT_EQUAL(100U, bucket.getAvailable(10100));
+  CPPUNIT_ASSERT_EQUAL(350U, bucket.getAvailable(10350));
+
+  // capped at the burst size
+
+  CPPUNIT_ASSERT_EQUAL(500U, bucket.getAvailable(20000));
+
+  // overdrawing empties the bucket
+
+  bucket.consume(800);
+  CPPUNIT_ASSERT_EQUAL(0U, bucket.getAvailable(20000));
+
+  // fractional tokens accumulate
+
+  TokenBucket slow(3, 3);
+  slow.getAvailable(1000);
+  slow.consume(3);
+
+  CPPUNIT_ASSERT_EQUAL(0U, slow.getAvailable(1200));
+  CPPUNIT_ASSERT_EQUAL(0U, slow.getAvailable(1300));
+  CPPUNIT_ASSERT_EQUAL(1U, slow.getAvailable(1334));
+}
+
+/*
+ */
+
+void TokenBucketTest::testDelay()
+{
+  TokenBucket bucket(100, 100);
+
+  bucket.getAvailable(5000);
+  bucket.consume(100);
+
+  // 100 tokens/s is one per 10 milliseconds
+
+  CPPUNIT_ASSERT_EQUAL(10, bucket.getDelay(5000));
+  CPPUNIT_ASSERT_EQUAL(500, bucket.getDelay(5000, 50));
+  CPPUNIT_ASSERT_EQUAL(0, bucket.getDelay(5010));
+
+  // requests beyond the burst size are limited to it
+
+  CPPUNIT_ASSERT_EQUAL(990, bucket.getDelay(5010, 1000));
+}
@@ -40,6 +40,7 @@ CppUnit::Test *UTF8DecoderTest::suite()
 {
   CCXX_TESTSUITE_BEGIN(UTF8DecoderTest);
   CCXX_TESTSUITE_TEST(UTF8DecoderTest, testDecode);
+  CCXX_TESTSUITE_TEST(UTF8DecoderTest, testDecodedLength);
   CCXX_TESTSUITE_END();
 }
 
@@ -62,5 +63,90 @@ void UTF8DecoderTest::tearDown()
 
 void UTF8DecoderTest::testDecode()
 {
-  // TODO
+  // long ASCII runs around multibyte sequences, decoded through a small
+  // output buffer so that runs are split across calls
+
+  static const char text[] = "abcdefghijklmnopqrstuvwxyz0123"
+    "\xC3\xA9" "ABCDEFGHIJKLMNOPQRS" "\xF0\x9D\x84\x9E" "tail";
+
+  static const char16_t expected[] = {
+    'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n',
+    'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', '0', '1',
+    '2', '3', 0x00E9, 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K',
+    'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 0xD834, 0xDD1E, 't', 'a', 'i',
+    'l' };
+
+  UTF8Decoder decoder;
+  const char *input = text;
+  int inputLeft = sizeof(text) - 1;
+  char16_t result[64];
+  int count = 0;
+
+  for(;;)
+  {
+    char16_t buf[5];
+    char16_t *output = buf;
+    int outputLeft = CCXX_LENGTHOF(buf);
+
+    int status = decoder.decode(&input, &inputLeft, &output, &outputLeft);
+
+    int n = CCXX_LENGTHOF(buf) - outputLeft;
+    for(int i = 0; i < n; ++i)
+      result[count++] = buf[i];
+
+    if(status == UTF8Decoder::STATUS_OK)
+      break;
+
+    CPPUNIT_ASSERT_EQUAL(static_cast<int>(UTF8Decoder::STATUS_OUTPUT_BUFFER_FULL),
+                         status);
+  }
+
+  CPPUNIT_ASSERT_EQUAL(static_cast<int>(CCXX_LENGTHOF(expected)), count);
+  for(int i = 0; i < count; ++i)
+    CPPUNIT_ASSERT_EQUAL(expected[i], result[i]);
+
+  // invalid continuation byte after an ASCII run
+
+  static const char bad[] = "abcdefghij\xC3(";
+
+  decoder.reset();
+  input = bad;
+  inputLeft = sizeof(bad) - 1;
+  char16_t *output = result;
+  int outputLeft = CCXX_LENGTHOF(result);
+
+  CPPUNIT_ASSERT_EQUAL(static_cast<int>(UTF8Decoder::STATUS_INVALID_INPUT),
+                       decoder.decode(&input, &inputLeft, &output,
+                                      &outputLeft));
+}
+
+/*
+ */
+
+void UTF8DecoderTest::testDecodedLength()
+{
+  CPPUNIT_ASSERT_EQUAL(0, UTF8Decoder::decodedLength(NULL, 10));
+  CPPUNIT_ASSERT_EQUAL(0, UTF8Decoder::decodedLength("abc", 0));
+  CPPUNIT_ASSERT_EQUAL(26, UTF8Decoder::decodedLength(
+                         "abcdefghijklmnopqrstuvwxyz", 26));
+
+  // 2- and 3-byte sequences decode to one unit, 4-byte ones to a
+  // surrogate pair
+
+  CPPUNIT_ASSERT_EQUAL(3, UTF8Decoder::decodedLength("a\xC3\xA9\xE2\x82\xAC",
+                                                     6));
+  CPPUNIT_ASSERT_EQUAL(3, UTF8Decoder::decodedLength("\xF0\x9D\x84\x9Ex", 5));
+
+  // maximum length
+
+  CPPUNIT_ASSERT_EQUAL(10, UTF8Decoder::decodedLength(
+                         "abcdefghijklmnopqrstuvwxyz", 26, 10));
+  CPPUNIT_ASSERT_EQUAL(1, UTF8Decoder::decodedLength("x\xF0\x9D\x84\x9E", 5,
+                                                     2));
+
+  // invalid input
+
+  CPPUNIT_ASSERT(UTF8Decoder::decodedLength("abc\xC3(", 5) < 0);
+  CPPUNIT_ASSERT(UTF8Decoder::decodedLength("abc\xE2\x82", 5) < 0);
+  CPPUNIT_ASSERT(UTF8Decoder::decodedLength("\xF8\x88\x80\x80\x80", 5) < 0);
 }
@@ -38,4 +38,5 @@ class UTF8DecoderTest : public CppUnit::TestFixture
   void tearDown();
 
   void testDecode();
+  void testDecodedLength();
 };
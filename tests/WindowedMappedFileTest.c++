@@ -0,0 +1,282 @@
+/* ---------------------------------------------------------------------------
+   commonc++ - A C++ Common Class Library
+   Copyright (C) 2005-2012  Mark A Lindner
+
+   This file is part of commonc++.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+   ---------------------------------------------------------------------------
+ */
+
+#include "WindowedMappedFileTest.h++"
+#include "TestUtils.h++"
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "commonc++/Common.h++"
+#include "commonc++/File.h++"
+#include "commonc++/System.h++"
+#include "commonc++/WindowedMappedFile.h++"
+
+#include <cstring>
+#include <vector>
+
+using namespace ccxx;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(WindowedMappedFileTest);
+
+static const char *testFile = "./testdata/windowed.bin";
+
+/*
+ */
+
+static byte_t expectedByte(uint64_t offset)
+{
+  return(static_cast<byte_t>((offset * 13) ^ (offset >> 12)));
+}
+
+/*
+ */
+
+CppUnit::Test *WindowedMappedFileTest::suite()
+{
+  CCXX_TESTSUITE_BEGIN(WindowedMappedFileTest);
+  CCXX_TESTSUITE_TEST(WindowedMappedFileTest, testViews);
+  CCXX_TESTSUITE_TEST(WindowedMappedFileTest, testReadWrite);
+  CCXX_TESTSUITE_TEST(WindowedMappedFileTest, testEviction);
+  CCXX_TESTSUITE_END();
+}
+
+/*
+ */
+
+void WindowedMappedFileTest::setUp()
+{
+  File::remove(testFile);
+}
+
+/*
+ */
+
+void WindowedMappedFileTest::tearDown()
+{
+  File::remove(testFile);
+}
+
+/*
+ */
+
+void WindowedMappedFileTest::testViews()
+{
+  size_t pageSize = System::getPageSize();
+
+  try
+  {
+    WindowedMappedFile file(testFile, pageSize + 1, 2);
+
+    // the window size is rounded up to the page size
+
+    CPPUNIT_ASSERT_EQUAL(pageSize * 2, file.getWindowSize());
+    size_t windowSize = file.getWindowSize();
+    uint64_t size = windowSize * 5 + 123;
+
+    file.create(size);
+    CPPUNIT_ASSERT(file.isOpen());
+    CPPUNIT_ASSERT_EQUAL(size, file.getSize());
+
+    // a view that straddles a window boundary
+
+    {
+      WindowedMappedFile::View view(file, windowSize - 10, windowSize);
+      CPPUNIT_ASSERT_EQUAL(windowSize, view.getLength());
+      CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(windowSize - 10),
+                           view.getOffset());
+
+      for(size_t i = 0; i < view.getLength(); ++i)
+        view.getData()[i] = expectedByte(view.getOffset() + i);
+    }
+
+    // a view at the very end of the file
+
+    {
+      WindowedMappedFile::View view(file, size - 23, 23);
+      std::memset(view.getData(), 0x5A, view.getLength());
+    }
+
+    try
+    {
+      WindowedMappedFile::View view(file, size - 23, 24);
+      CPPUNIT_FAIL("No OutOfBoundsException thrown");
+    }
+    catch(OutOfBoundsException&)
+    {
+    }
+
+    try
+    {
+      WindowedMappedFile::View view(file, 0, windowSize + 1);
+      CPPUNIT_FAIL("No OutOfBoundsException thrown");
+    }
+    catch(OutOfBoundsException&)
+    {
+    }
+
+    file.close();
+    CPPUNIT_ASSERT(! file.isOpen());
+
+    // the data persists
+
+    WindowedMappedFile file2(testFile, windowSize);
+    file2.open(true);
+    CPPUNIT_ASSERT(file2.isReadOnly());
+
+    WindowedMappedFile::View view(file2, windowSize - 10, windowSize);
+    for(size_t i = 0; i < view.getLength(); ++i)
+      CPPUNIT_ASSERT_EQUAL(expectedByte(view.getOffset() + i),
+                           view.getData()[i]);
+
+    WindowedMappedFile::View tail(file2, size - 1, 1);
+    CPPUNIT_ASSERT_EQUAL(static_cast<byte_t>(0x5A), *(tail.getData()));
+  }
+  catch(IOException& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void WindowedMappedFileTest::testReadWrite()
+{
+  size_t pageSize = System::getPageSize();
+
+  try
+  {
+    WindowedMappedFile file(testFile, pageSize, 3);
+
+    uint64_t size = pageSize * 40 + 7;
+    std::vector<byte_t> data(static_cast<size_t>(size));
+    for(size_t i = 0; i < data.size(); ++i)
+      data[i] = expectedByte(i);
+
+    file.create(size);
+
+    // write in odd-sized chunks that cross window boundaries
+
+    uint64_t offset = 0;
+    while(offset < size)
+    {
+      size_t n = file.write(offset, &data[static_cast<size_t>(offset)],
+                            pageSize * 3 + 11);
+      CPPUNIT_ASSERT(n > 0);
+      offset += n;
+    }
+
+    CPPUNIT_ASSERT(file.getWindowCount() <= file.getMaxWindows());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), file.write(size, &data[0],
+                                                            1));
+
+    file.sync();
+    file.close();
+
+    file.open(true);
+
+    std::vector<byte_t> result(data.size());
+    CPPUNIT_ASSERT_EQUAL(data.size(), file.read(0, &result[0],
+                                                result.size() + 100));
+    CPPUNIT_ASSERT(result == data);
+
+    // reads past the end are short
+
+    byte_t buf[16];
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(7),
+                         file.read(size - 7, buf, sizeof(buf)));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0),
+                         file.read(size, buf, sizeof(buf)));
+
+    try
+    {
+      file.write(0, buf, 1);
+      CPPUNIT_FAIL("No IOException thrown");
+    }
+    catch(IOException&)
+    {
+    }
+  }
+  catch(IOException& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}
+
+/*
+ */
+
+void WindowedMappedFileTest::testEviction()
+{
+  size_t pageSize = System::getPageSize();
+
+  try
+  {
+    WindowedMappedFile file(testFile, pageSize, 2);
+    file.create(pageSize * 10);
+
+    CPPUNIT_ASSERT_EQUAL(0U, file.getWindowCount());
+
+    {
+      WindowedMappedFile::View v0(file, 0, 1);
+      WindowedMappedFile::View v1(file, pageSize, 1);
+      CPPUNIT_ASSERT_EQUAL(2U, file.getWindowCount());
+
+      // views in the same window share its mapping
+
+      WindowedMappedFile::View v0b(file, 10, 1);
+      CPPUNIT_ASSERT_EQUAL(2U, file.getWindowCount());
+      CPPUNIT_ASSERT(v0b.getData() == v0.getData() + 10);
+
+      // all windows are in use, so the limit is exceeded temporarily
+
+      WindowedMappedFile::View v2(file, pageSize * 2, 1);
+      CPPUNIT_ASSERT_EQUAL(3U, file.getWindowCount());
+    }
+
+    CPPUNIT_ASSERT_EQUAL(2U, file.getWindowCount());
+
+    // the least recently used window is evicted
+
+    {
+      WindowedMappedFile::View v(file, pageSize * 5, 1);
+      CPPUNIT_ASSERT_EQUAL(2U, file.getWindowCount());
+    }
+
+    file.close();
+    CPPUNIT_ASSERT_EQUAL(0U, file.getWindowCount());
+
+    try
+    {
+      WindowedMappedFile::View v(file, 0, 1);
+      CPPUNIT_FAIL("No IOException thrown");
+    }
+    catch(IOException&)
+    {
+    }
+  }
+  catch(IOException& ex)
+  {
+    CCXX_TEST_FAIL_EXCEPTION(ex);
+  }
+}